@@ -23,6 +23,9 @@ Application::Application(void)
 
    terminateApp = false;
 
+   framesPerSecond = 0;
+   renderBackend = RB_DIRECTDRAW;
+
    //Default window class settings
    windowClass.cbSize = sizeof(WNDCLASSEX);
    windowClass.style = CS_DBLCLKS | CS_OWNDC |
@@ -82,6 +85,7 @@ void Application::RunApp(void)
    char fps[33];
    sprintf(fps, "0 FPS");
    Font fpsFont("MS Sans Serif", 16);
+   Area fpsArea(0, 0, 101, 51);
 
    while(!terminateApp)
    {
@@ -102,6 +106,10 @@ void Application::RunApp(void)
 
          PreGUIDraw();
 
+         //The frame rate is drawn over the GUI every frame, so the area
+         //under it has to be redrawn
+         gui.InvalidateArea(fpsArea);
+
          //Have gui draw itself
          gui.DrawGUI();
 
@@ -132,7 +140,8 @@ void Application::RunApp(void)
       if(totalTime > 1000)
       {
          totalTime = 0;
-         sprintf(fps, "%i FPS", numOfFrames);
+         framesPerSecond = numOfFrames;
+         sprintf(fps, "%i FPS", framesPerSecond);
          numOfFrames = 0;
       }
    }
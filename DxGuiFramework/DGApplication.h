@@ -38,6 +38,14 @@ namespace DG
       {frameRate = framesPerSecond;}
 
       UINT GetFrameRate(void) {return frameRate;}
+
+      //The render backend can only be set in PreInitApp(), as the
+      //DG::Graphics object is created right after it
+      void SetRenderBackend(UINT backend) {renderBackend = backend;}
+      UINT GetRenderBackend(void) {return renderBackend;}
+
+      //The number of frames actually drawn during the last second
+      UINT GetFramesPerSecond(void) {return framesPerSecond;}
       Gui* const GetGUI(void) {return &gui;}
       HINSTANCE GetWindowsInstance(void) {return hInstance;}
       HWND GetWindowsHandle(void) {return hWnd;}
@@ -65,6 +73,12 @@ namespace DG
 
       //Number of frames executed each second
       UINT frameRate;
+
+      //Number of frames that were drawn in the last second
+      UINT framesPerSecond;
+
+      //The backend that DG::Graphics is created with
+      UINT renderBackend;
       
       //The pointer to the GUI object
       Gui gui;
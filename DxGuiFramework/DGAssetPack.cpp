@@ -0,0 +1,511 @@
+/*------------------------------------------------------------------------
+File Name: DGAssetPack.cpp
+Description: This file contains the implementation of the DG::AssetPack
+   class, which reads and builds files of pre-converted bitmaps.
+Version:
+   1.0.0    24.11.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+
+using namespace DG;
+
+//The size in bytes of a pixel of each layout
+static const int layoutPixelSizes[AP_NUM_OF_LAYOUTS] = {2, 2, 3, 4};
+
+//Constructor
+AssetPack::AssetPack()
+{
+   fileName[0] = '\0';
+   fileHandle = INVALID_HANDLE_VALUE;
+   mappingHandle = NULL;
+   data = NULL;
+   size = 0;
+
+   entries = NULL;
+   numOfEntries = 0;
+}
+
+//Destructor
+AssetPack::~AssetPack()
+{
+   Close();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Open
+Parameters:
+   const char* packFileName : the name of the pack file
+Description:
+   This function maps a pack file into memory and checks that its
+   directory and pixels are all inside the file. A pack that is already
+   open is closed first.
+------------------------------------------------------------------------*/
+
+void FC AssetPack::Open(const char* packFileName)
+{
+   char message[MAX_PATH + 64];
+
+   Close();
+
+   if(strlen(packFileName) < MAX_PATH)
+   {
+      strcpy(fileName, packFileName);
+
+      fileHandle = CreateFile(fileName, GENERIC_READ, FILE_SHARE_READ,
+         NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   }
+
+   if(fileHandle != INVALID_HANDLE_VALUE)
+   {
+      size = GetFileSize(fileHandle, NULL);
+
+      if(size != 0 && size != 0xFFFFFFFF)
+         mappingHandle = CreateFileMapping(fileHandle, NULL,
+            PAGE_READONLY, 0, 0, NULL);
+   }
+
+   if(mappingHandle != NULL)
+      data = (UCHAR*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+   if(data == NULL)
+   {
+      Close();
+
+      sprintf(message, "The asset pack %s could not be opened.",
+         packFileName);
+      throw new Exception(message, EC_BMASSETPACK, ET_BITMAP,
+         __FILE__, __LINE__);
+   }
+
+   try
+   {
+      Check();
+   }
+   catch(...)
+   {
+      Close();
+      throw;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Close
+Parameters:
+Description:
+   This function unmaps the pack file. The bitmaps that were loaded from
+   it have copies of their pixels, so they are not affected.
+------------------------------------------------------------------------*/
+
+void FC AssetPack::Close()
+{
+   if(data != NULL)
+   {
+      UnmapViewOfFile(data);
+      data = NULL;
+   }
+
+   if(mappingHandle != NULL)
+   {
+      CloseHandle(mappingHandle);
+      mappingHandle = NULL;
+   }
+
+   if(fileHandle != INVALID_HANDLE_VALUE)
+   {
+      CloseHandle(fileHandle);
+      fileHandle = INVALID_HANDLE_VALUE;
+   }
+
+   size = 0;
+   entries = NULL;
+   numOfEntries = 0;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Find
+Parameters:
+   const char* bitmapFileName : the name of a bitmap file
+Returns:
+   The directory entry of the bitmap, or NULL if it isn't in the pack
+Description:
+   This function looks the file name up in the directory with a binary
+   search. Names are compared like Windows compares file names, so the
+   case and the kind of slash don't matter.
+------------------------------------------------------------------------*/
+
+AssetPackEntry* FC AssetPack::Find(const char* bitmapFileName)
+{
+   int low = 0;
+   int high = numOfEntries - 1;
+
+   while(low <= high)
+   {
+      int middle = (low + high) / 2;
+      int result = CompareNames(bitmapFileName, entries[middle].fileName);
+
+      if(result == 0)
+         return &entries[middle];
+
+      if(result < 0)
+         high = middle - 1;
+      else
+         low = middle + 1;
+   }
+
+   return NULL;
+}
+
+/*------------------------------------------------------------------------
+Function Name: SelectLayout
+Parameters:
+   int pixelSize : the size of a pixel of the screen in bytes
+   DDPIXELFORMAT& pixelFormat : the pixel format of the screen
+Returns:
+   The layout of the pack that has the pixel format of the screen, or
+   -1 if none of them do
+------------------------------------------------------------------------*/
+
+int FC AssetPack::SelectLayout(int pixelSize, DDPIXELFORMAT& pixelFormat)
+{
+   bool standardBlue = pixelFormat.dwBBitMask == 0x001F;
+   bool standard32 = pixelFormat.dwRBitMask == 0xFF0000 &&
+      pixelFormat.dwGBitMask == 0xFF00 && pixelFormat.dwBBitMask == 0xFF;
+
+   switch(pixelSize)
+   {
+      case 2:
+         if(standardBlue && pixelFormat.dwGBitMask == 0x07E0 &&
+            pixelFormat.dwRBitMask == 0xF800)
+            return AP_LAYOUT_565;
+         if(standardBlue && pixelFormat.dwGBitMask == 0x03E0 &&
+            pixelFormat.dwRBitMask == 0x7C00)
+            return AP_LAYOUT_555;
+         return -1;
+      case 3:
+         return standard32 ? AP_LAYOUT_888 : -1;
+      case 4:
+         return standard32 ? AP_LAYOUT_8888 : -1;
+      default:
+         return -1;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Build
+Parameters:
+   const char* packFileName : the name of the pack file to write
+   const char** fileNames : the bitmap files to put in the pack
+   int numOfFiles : the number of bitmap files
+Description:
+   This function writes a pack of 24-bit bitmap files, each of them
+   converted to every layout. The conversion gives the same pixels as
+   the convert kernels do when the file itself is loaded. It doesn't
+   need a graphics mode, so it can be run by a tool when the program is
+   built. Bitmaps with an alpha channel are always blended from 32-bit
+   pixels, so they are left out of packs.
+------------------------------------------------------------------------*/
+
+void FC AssetPack::Build(const char* packFileName,
+   const char** fileNames, int numOfFiles)
+{
+   static ConvertKernel packLine[AP_NUM_OF_LAYOUTS] = {PackLine565,
+      PackLine555, ConvertKernels::Copy24, PackLine8888};
+
+   char message[MAX_PATH + 64];
+
+   AssetPackEntry* packEntries = new AssetPackEntry[numOfFiles];
+   memset(packEntries, 0, numOfFiles * sizeof(AssetPackEntry));
+
+   HANDLE packHandle = INVALID_HANDLE_VALUE;
+   UCHAR* lines = NULL;
+
+   try
+   {
+      for(int i = 0; i < numOfFiles; i++)
+      {
+         if(strlen(fileNames[i]) >= AP_MAX_NAME_LENGTH)
+         {
+            sprintf(message, "The file name %.64s... is too long.",
+               fileNames[i]);
+            throw new Exception(message, EC_BMASSETPACK, ET_BITMAP,
+               __FILE__, __LINE__);
+         }
+
+         strcpy(packEntries[i].fileName, fileNames[i]);
+      }
+
+      qsort(packEntries, numOfFiles, sizeof(AssetPackEntry),
+         CompareEntries);
+
+      //Find() would only ever find one of two entries with the same name
+      for(int k = 1; k < numOfFiles; k++)
+      {
+         if(CompareNames(packEntries[k - 1].fileName, 
+            packEntries[k].fileName) == 0)
+         {
+            sprintf(message, "The file %.64s is in the pack twice.",
+               packEntries[k].fileName);
+            throw new Exception(message, EC_BMASSETPACK, ET_BITMAP,
+               __FILE__, __LINE__);
+         }
+      }
+
+      //The directory follows the header, and the pixels of each layout
+      //start on a 16 byte boundary after it
+      UINT offset = sizeof(AssetPackHeader) +
+         (numOfFiles * sizeof(AssetPackEntry));
+      UINT maxLinesSize = 0;
+
+      for(int j = 0; j < numOfFiles; j++)
+      {
+         AssetPackEntry& entry = packEntries[j];
+         BitmapFile* file = BitmapFile::Open(entry.fileName);
+         Point bitmapSize = file->GetBitmapSize();
+         Area rect(0, 0, bitmapSize.x, bitmapSize.y);
+         WORD bitCount = file->GetInfoHeader().biBitCount;
+
+         try
+         {
+            Bitmap::CheckFile(*file, rect);
+         }
+         catch(...)
+         {
+            BitmapFile::Close(file);
+            throw;
+         }
+
+         BitmapFile::Close(file);
+
+         if(bitCount != 24)
+         {
+            sprintf(message, "%s: only 24-bit bitmaps can be packed.",
+               entry.fileName);
+            throw new Exception(message, EC_BMASSETPACK, ET_BITMAP,
+               __FILE__, __LINE__);
+         }
+
+         entry.width = bitmapSize.x;
+         entry.height = bitmapSize.y;
+
+         for(int layout = 0; layout < AP_NUM_OF_LAYOUTS; layout++)
+         {
+            offset = (offset + 15) & ~15;
+
+            entry.pitches[layout] =
+               ((entry.width * layoutPixelSizes[layout]) + 3) & ~3;
+            entry.offsets[layout] = offset;
+
+            UINT linesSize = entry.pitches[layout] * entry.height;
+            offset += linesSize;
+
+            if(linesSize > maxLinesSize)
+               maxLinesSize = linesSize;
+         }
+      }
+
+      packHandle = CreateFile(packFileName, GENERIC_WRITE, 0, NULL,
+         CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+      if(packHandle == INVALID_HANDLE_VALUE)
+      {
+         sprintf(message, "The asset pack %s could not be created.",
+            packFileName);
+         throw new Exception(message, EC_BMASSETPACK, ET_BITMAP,
+            __FILE__, __LINE__);
+      }
+
+      AssetPackHeader header;
+      header.signature = AP_SIGNATURE;
+      header.version = AP_VERSION;
+      header.numOfEntries = numOfFiles;
+      header.reserved = 0;
+
+      DWORD written;
+      BOOL result = WriteFile(packHandle, &header, sizeof(header),
+         &written, NULL);
+      result = result && WriteFile(packHandle, packEntries,
+         numOfFiles * sizeof(AssetPackEntry), &written, NULL);
+
+      //The pixels are converted a layout at a time with the same loop
+      //that loads bitmaps from their files. The gaps between them are
+      //filled with zeros when the file pointer is moved past the end.
+      lines = new UCHAR[(maxLinesSize > 0) ? maxLinesSize : 1];
+
+      for(int k = 0; k < numOfFiles && result; k++)
+      {
+         AssetPackEntry& entry = packEntries[k];
+         BitmapFile* file = BitmapFile::Open(entry.fileName);
+         Area rect(0, 0, entry.width, entry.height);
+
+         for(int layout = 0; layout < AP_NUM_OF_LAYOUTS && result;
+            layout++)
+         {
+            UINT linesSize = entry.pitches[layout] * entry.height;
+
+            memset(lines, 0, linesSize);
+            Bitmap::DecodeLines(*file, rect, lines,
+               entry.pitches[layout], packLine[layout], NULL);
+
+            SetFilePointer(packHandle, LONG(entry.offsets[layout]), NULL,
+               FILE_BEGIN);
+            result = WriteFile(packHandle, lines, linesSize, &written,
+               NULL);
+         }
+
+         BitmapFile::Close(file);
+      }
+
+      if(!result)
+      {
+         sprintf(message, "The asset pack %s could not be written.",
+            packFileName);
+         throw new Exception(message, EC_BMASSETPACK, ET_BITMAP,
+            __FILE__, __LINE__);
+      }
+   }
+   catch(...)
+   {
+      if(packHandle != INVALID_HANDLE_VALUE)
+      {
+         CloseHandle(packHandle);
+         DeleteFile(packFileName);
+      }
+
+      if(lines != NULL)
+         delete[] lines;
+
+      delete[] packEntries;
+      throw;
+   }
+
+   CloseHandle(packHandle);
+
+   delete[] lines;
+   delete[] packEntries;
+}
+
+//Throws an exception unless the mapped file is a pack whose directory
+//and pixels are all inside the file. The directory must be sorted by
+//name, since Find() searches it by halves, and a line may not be padded
+//by more than 15 bytes, which is more than Build() pads it.
+void FC AssetPack::Check()
+{
+   char message[MAX_PATH + 64];
+   AssetPackHeader* header = (AssetPackHeader*)data;
+   bool valid = size >= sizeof(AssetPackHeader) &&
+      header->signature == AP_SIGNATURE && header->version == AP_VERSION;
+
+   if(valid)
+   {
+      valid = header->numOfEntries <=
+         (size - sizeof(AssetPackHeader)) / sizeof(AssetPackEntry);
+   }
+
+   if(valid)
+   {
+      entries = (AssetPackEntry*)(data + sizeof(AssetPackHeader));
+      numOfEntries = int(header->numOfEntries);
+   }
+
+   for(int i = 0; i < numOfEntries && valid; i++)
+   {
+      AssetPackEntry& entry = entries[i];
+
+      valid = entry.fileName[AP_MAX_NAME_LENGTH - 1] == '\0' &&
+         entry.width > 0 && entry.height > 0 &&
+         entry.width <= 0x8000 && entry.height <= 0x8000;
+
+      if(valid && i > 0)
+         valid = CompareNames(entries[i - 1].fileName, entry.fileName) < 0;
+
+      for(int layout = 0; layout < AP_NUM_OF_LAYOUTS && valid; layout++)
+      {
+         LONG lineSize = entry.width * layoutPixelSizes[layout];
+         LONG pitch = entry.pitches[layout];
+
+         //The size is worked out in 64 bits so that it can't wrap
+         valid = pitch >= lineSize && pitch <= lineSize + 15 &&
+            entry.offsets[layout] <= size &&
+            __int64(pitch) * entry.height <= 
+            __int64(size - entry.offsets[layout]);
+      }
+   }
+
+   if(!valid)
+   {
+      sprintf(message, "The file %s is not a valid asset pack.",
+         fileName);
+      throw new Exception(message, EC_BMASSETPACK, ET_BITMAP,
+         __FILE__, __LINE__);
+   }
+}
+
+//Compares two file names the way Windows does, without case and with
+//both kinds of slash
+int AssetPack::CompareNames(const char* name1, const char* name2)
+{
+   for(;; name1++, name2++)
+   {
+      int char1 = UCHAR(*name1);
+      int char2 = UCHAR(*name2);
+
+      if(char1 >= 'A' && char1 <= 'Z')
+         char1 += 'a' - 'A';
+      else if(char1 == '/')
+         char1 = '\\';
+
+      if(char2 >= 'A' && char2 <= 'Z')
+         char2 += 'a' - 'A';
+      else if(char2 == '/')
+         char2 = '\\';
+
+      if(char1 != char2 || char1 == '\0')
+         return char1 - char2;
+   }
+}
+
+//Orders directory entries by file name for qsort()
+int AssetPack::CompareEntries(const void* entry1, const void* entry2)
+{
+   return CompareNames(((AssetPackEntry*)entry1)->fileName,
+      ((AssetPackEntry*)entry2)->fileName);
+}
+
+//Pack Kernels
+//The layouts of the pack are fixed, so they don't use the color lookup
+//tables, which depend on the graphics mode, and are given none. Each 
+//channel is rounded down like the tables round it.
+
+void FC AssetPack::PackLine565(UCHAR* dest, UCHAR* source, int width,
+   ConvertTables* tables)
+{
+   USHORT* destLine = (USHORT*)dest;
+
+   for(int x = 0; x < width; x++, source += 3)
+   {
+      destLine[x] = USHORT((((source[2] * 31) / 255) << 11) |
+         (((source[1] * 63) / 255) << 5) | ((source[0] * 31) / 255));
+   }
+}
+
+void FC AssetPack::PackLine555(UCHAR* dest, UCHAR* source, int width,
+   ConvertTables* tables)
+{
+   USHORT* destLine = (USHORT*)dest;
+
+   for(int x = 0; x < width; x++, source += 3)
+   {
+      destLine[x] = USHORT((((source[2] * 31) / 255) << 10) |
+         (((source[1] * 31) / 255) << 5) | ((source[0] * 31) / 255));
+   }
+}
+
+void FC AssetPack::PackLine8888(UCHAR* dest, UCHAR* source, int width,
+   ConvertTables* tables)
+{
+   UINT* destLine = (UINT*)dest;
+
+   for(int x = 0; x < width; x++, source += 3)
+      destLine[x] = (source[2] << 16) | (source[1] << 8) | source[0];
+}
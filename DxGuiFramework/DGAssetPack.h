@@ -0,0 +1,93 @@
+/*------------------------------------------------------------------------
+File Name: DGAssetPack.h
+Description: This file contains the DG::AssetPack class, which reads a
+   file that holds many bitmaps already converted to each of the common
+   pixel layouts, so that they can be copied straight into surfaces.
+   The pack is built ahead of time from the bitmap files by Build().
+Version:
+   1.0.0    24.11.2002  Created the file
+------------------------------------------------------------------------*/
+
+#pragma once
+
+//The first bytes of a pack file, "DGAP", and the version of the format
+#define AP_SIGNATURE          0x50414744
+#define AP_VERSION            1
+
+//The pixel layouts that the bitmaps are stored in
+#define AP_LAYOUT_565         0
+#define AP_LAYOUT_555         1
+#define AP_LAYOUT_888         2
+#define AP_LAYOUT_8888        3
+#define AP_NUM_OF_LAYOUTS     4
+
+//The longest file name a bitmap in the pack can have, including the
+//terminating null character
+#define AP_MAX_NAME_LENGTH    128
+
+namespace DG
+{
+   //The start of a pack file, which is followed by the directory
+   class AssetPackHeader
+   {
+   public:
+      DWORD signature;
+      DWORD version;
+      DWORD numOfEntries;
+      DWORD reserved;
+   };
+
+   //An entry of the directory of a pack, which is sorted by file name.
+   //The pixels of each layout start at an offset from the start of the
+   //file and go from the top line down.
+   class AssetPackEntry
+   {
+   public:
+      char fileName[AP_MAX_NAME_LENGTH];
+      LONG width;
+      LONG height;
+      DWORD offsets[AP_NUM_OF_LAYOUTS];
+      LONG pitches[AP_NUM_OF_LAYOUTS];
+   };
+
+   class AssetPack
+   {
+   public:
+      AssetPack();
+      virtual ~AssetPack();
+
+      void FC Open(const char* packFileName);
+      void FC Close(void);
+      bool IsOpen(void) {return data != NULL;}
+
+      AssetPackEntry* FC Find(const char* bitmapFileName);
+      UCHAR* GetPixels(AssetPackEntry& entry, int layout, LONG& pitch)
+      {pitch = entry.pitches[layout]; return data + entry.offsets[layout];}
+
+      static int FC SelectLayout(int pixelSize, DDPIXELFORMAT& pixelFormat);
+      static void FC Build(const char* packFileName,
+         const char** fileNames, int numOfFiles);
+
+   private:
+      void FC Check(void);
+
+      static int CompareNames(const char* name1, const char* name2);
+      static int CompareEntries(const void* entry1, const void* entry2);
+
+      static void FC PackLine565(UCHAR* dest, UCHAR* source, int width,
+         ConvertTables* tables);
+      static void FC PackLine555(UCHAR* dest, UCHAR* source, int width,
+         ConvertTables* tables);
+      static void FC PackLine8888(UCHAR* dest, UCHAR* source, int width,
+         ConvertTables* tables);
+
+      char fileName[MAX_PATH];
+      HANDLE fileHandle;
+      HANDLE mappingHandle;
+      UCHAR* data;
+      UINT size;
+
+      AssetPackEntry* entries;
+      int numOfEntries;
+   };
+}
@@ -0,0 +1,214 @@
+/*------------------------------------------------------------------------
+File Name: DGBackingStore.cpp
+Description: This file contains the implementation of the
+   DG::BackingStore class, which keeps a copy of what a window has drawn.
+Version:
+   1.0.0    11.08.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+
+using namespace DG;
+
+/*Constructor*/
+BackingStore::BackingStore()
+{
+   width = 0;
+   height = 0;
+   memoryUsage = 0;
+
+   lpDDSStore = NULL;
+   storeBuffer = NULL;
+
+   lastUsedFrame = 0;
+}
+
+/*Destructor*/
+BackingStore::~BackingStore()
+{
+   Destroy();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Create
+Parameters:
+   int storeWidth : the width of the store, which is the window width
+   int storeHeight : the height of the store, which is the window height
+Description:
+   This function creates the surface that the copy of the window is kept
+   in: a DirectDraw surface or, with the software backend, a pixel
+   buffer. Nothing in the new store is valid.
+------------------------------------------------------------------------*/
+
+void FC BackingStore::Create(int storeWidth, int storeHeight)
+{
+   assert(storeWidth > 0 && storeHeight > 0);
+
+   Destroy();
+
+   width = storeWidth;
+   height = storeHeight;
+
+   if(dgGraphics->GetRenderBackend() == RB_SOFTWARE)
+   {
+      storeBuffer = new PixelBuffer(width, height,
+         dgGraphics->bytesPerPixel);
+
+      memoryUsage = storeBuffer->GetMemoryUsage();
+      return;
+   }
+
+   HRESULT result;
+
+   DDSURFACEDESC2 ddsd;
+   memset(&ddsd, 0, sizeof(ddsd));
+   ddsd.dwSize = sizeof(ddsd);
+   ddsd.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH;
+   ddsd.ddsCaps.dwCaps = DDSCAPS_OFFSCREENPLAIN;
+   ddsd.dwWidth = width;
+   ddsd.dwHeight = height;
+
+   result = dgGraphics->lpDD->CreateSurface(&ddsd, &lpDDSStore, NULL);
+
+   if(result != DD_OK)
+      dgGraphics->HandleDDrawError(EC_DDBACKINGSTORE, result,
+         __FILE__, __LINE__);
+
+   memset(&ddsd, 0, sizeof(ddsd));
+   ddsd.dwSize = sizeof(ddsd);
+   lpDDSStore->GetSurfaceDesc(&ddsd);
+
+   memoryUsage = ddsd.lPitch * ddsd.dwHeight;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Destroy
+Parameters:
+Description:
+   This function frees the surface of the store.
+------------------------------------------------------------------------*/
+
+void FC BackingStore::Destroy()
+{
+   if(lpDDSStore != NULL)
+   {
+      lpDDSStore->Release();
+      lpDDSStore = NULL;
+   }
+
+   if(storeBuffer != NULL)
+   {
+      //Recorded drawing may still copy from the buffer
+      if(dgGraphics != NULL)
+         dgGraphics->FlushDrawing();
+
+      delete storeBuffer;
+      storeBuffer = NULL;
+   }
+
+   memoryUsage = 0;
+   validRegion.Clear();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Restore
+Parameters:
+Description:
+   This function is called when the surface of the store has been lost.
+   The surface is restored, but what was on it is gone.
+------------------------------------------------------------------------*/
+
+void FC BackingStore::Restore()
+{
+   validRegion.Clear();
+
+   //Pixel buffers are never lost
+   if(lpDDSStore == NULL)
+      return;
+
+   HRESULT result = lpDDSStore->Restore();
+
+   switch(result)
+   {
+      case DD_OK:
+         break;
+      //The surface can't be restored in this mode, so it will be
+      //created again the next time it is needed
+      case DDERR_WRONGMODE:
+         lpDDSStore->Release();
+         lpDDSStore = NULL;
+         break;
+      default:
+         dgGraphics->HandleDDrawError(EC_DDRESTORESURFACES, result,
+            __FILE__, __LINE__);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Invalidate
+Parameters:
+Description:
+   This function marks everything in the store as out of date.
+------------------------------------------------------------------------*/
+
+void FC BackingStore::Invalidate()
+{
+   validRegion.Clear();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Invalidate
+Parameters:
+   RECT& rect : the rectangle that is out of date, relative to the
+      upper-left corner of the window, with an exclusive right and bottom
+Description:
+   This function marks part of the store as out of date.
+------------------------------------------------------------------------*/
+
+void FC BackingStore::Invalidate(RECT& rect)
+{
+   validRegion.Subtract(rect);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Validate
+Parameters:
+   ClipRegion& region : the part of the screen that has been copied into
+      the store, in absolute coordinates
+   Point& origin : the upper-left corner of the window on the screen
+Description:
+   This function marks part of the store as holding what the window drew.
+------------------------------------------------------------------------*/
+
+void FC BackingStore::Validate(ClipRegion& region, Point& origin)
+{
+   ClipRegion storeRegion(region);
+   storeRegion.Offset(-origin.x, -origin.y);
+
+   validRegion.Union(storeRegion);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Covers
+Parameters:
+   ClipRegion& region : a part of the screen, in absolute coordinates
+   Point& origin : the upper-left corner of the window on the screen
+Returns:
+   true if the store holds what the window drew everywhere within the
+   region, false if it doesn't
+Description:
+   This function finds out if the window can be drawn within a region
+   by drawing the store.
+------------------------------------------------------------------------*/
+
+bool FC BackingStore::Covers(ClipRegion& region, Point& origin)
+{
+   if(!IsCreated())
+      return false;
+
+   ClipRegion missingRegion(region);
+   missingRegion.Offset(-origin.x, -origin.y);
+   missingRegion.Subtract(validRegion);
+
+   return missingRegion.IsEmpty();
+}
@@ -0,0 +1,62 @@
+/*------------------------------------------------------------------------
+File Name: DGBackingStore.h
+Description: This file contains the DG::BackingStore class, which keeps
+   a copy of what a window has drawn, so that the window can be drawn
+   again without calling its OnDrawWindow function.
+Version:
+   1.0.0    11.08.2002  Created the file
+------------------------------------------------------------------------*/
+
+#pragma once
+
+namespace DG
+{
+   class BackingStore
+   {
+   public:
+      BackingStore();
+      virtual ~BackingStore();
+
+      void FC Create(int storeWidth, int storeHeight);
+      void FC Destroy(void);
+      void FC Restore(void);
+
+      bool IsCreated(void)
+      {return lpDDSStore != NULL || storeBuffer != NULL;}
+      int GetWidth(void) {return width;}
+      int GetHeight(void) {return height;}
+      UINT GetMemoryUsage(void) {return memoryUsage;}
+
+      LPDIRECTDRAWSURFACE7 GetDDSurface(void) {return lpDDSStore;}
+      PixelBuffer* GetPixelBuffer(void) {return storeBuffer;}
+
+      //The part of the store that holds what the window drew, in
+      //coordinates relative to the upper-left corner of the window
+      ClipRegion& GetValidRegion(void) {return validRegion;}
+      void FC Invalidate(void);
+      void FC Invalidate(RECT& rect);
+      void FC Validate(ClipRegion& region, Point& origin);
+      bool FC Covers(ClipRegion& region, Point& origin);
+
+      void SetLastUsedFrame(UINT frame) {lastUsedFrame = frame;}
+      UINT GetLastUsedFrame(void) {return lastUsedFrame;}
+
+   private:
+      int width;
+      int height;
+      UINT memoryUsage;
+
+      //DirectDraw surface: stores the copy of the window
+      LPDIRECTDRAWSURFACE7 lpDDSStore;
+
+      //Pixel buffer: stores the copy of the window with the software
+      //backend
+      PixelBuffer* storeBuffer;
+
+      ClipRegion validRegion;
+
+      //The frame in which the store was last drawn or updated, which
+      //decides which stores are destroyed first
+      UINT lastUsedFrame;
+   };
+}
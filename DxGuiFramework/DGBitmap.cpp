@@ -7,12 +7,27 @@ Version:
    1.0.0    24.02.2001  Created the file
    2.0.0    02.06.2002  Changed the file to use namespaces and adapt
       to Visual Studio .NET
+   2.1.0    18.08.2002  Added bitmaps with an alpha channel, which are
+      loaded from 32-bit files
+   2.2.0    01.09.2002  Pixel buffers are run-length encoded when their
+      transparent color is set
+   2.3.0    13.10.2002  24-bit files are read a block of lines at a time
+      and converted a line at a time by the convert kernels
+   2.4.0    20.10.2002  Bitmaps are loaded straight from the files that
+      DG::BitmapFile maps into memory
+   2.5.0    27.10.2002  Bitmaps can be decoded on another thread and
+      handed over when they are done
+   2.6.0    03.11.2002  Small bitmaps can be packed into the shared 
+      surface of a DG::BitmapAtlas
+   2.7.0    01.12.2002  Areas of a file can be views of a sheet instead
+      of copies
+   2.8.0    08.12.2002  Added scaled copies, which cache the bitmap scaled
+      to the sizes it is drawn at
+   2.9.0    15.12.2002  Added tiled bitmaps
 ------------------------------------------------------------------------*/
 
-#include <fstream>
 #include "DxGuiFramework.h"
 
-using namespace std;
 using namespace DG;
 
 Bitmap::Bitmap()
@@ -32,6 +47,31 @@ Bitmap::Bitmap()
    transparentColor.SetColor(255, 0, 255);
 
    lpDDSBitmap = NULL;
+   bitmapBuffer = NULL;
+   runLengthSprite = NULL;
+   alphaBuffer = NULL;
+   alphaChannel = false;
+   premultipliedAlpha = false;
+   loadPending = false;
+   packed = false;
+   view = false;
+   atlas = NULL;
+
+   lastUsedFrame = 0;
+   numOfUses = 0;
+   usageIndex = -1;
+   countedMemory = 0;
+
+   numOfScaledCopies = 0;
+   numOfMissedSizes = 0;
+   nextMissedSize = 0;
+
+   tiled = false;
+   tiles = NULL;
+   numOfTileColumns = 0;
+   numOfTileRows = 0;
+   numOfLoadedTiles = 0;
+   tileFile = NULL;
 
    memoryUsage = 0;
 }
@@ -53,6 +93,31 @@ Bitmap::Bitmap(UINT bitmapID, UINT bitmapPriority)
    transparentColor.SetColor(255, 0, 255);
 
    lpDDSBitmap = NULL;
+   bitmapBuffer = NULL;
+   runLengthSprite = NULL;
+   alphaBuffer = NULL;
+   alphaChannel = false;
+   premultipliedAlpha = false;
+   loadPending = false;
+   packed = false;
+   view = false;
+   atlas = NULL;
+
+   lastUsedFrame = 0;
+   numOfUses = 0;
+   usageIndex = -1;
+   countedMemory = 0;
+
+   numOfScaledCopies = 0;
+   numOfMissedSizes = 0;
+   nextMissedSize = 0;
+
+   tiled = false;
+   tiles = NULL;
+   numOfTileColumns = 0;
+   numOfTileRows = 0;
+   numOfLoadedTiles = 0;
+   tileFile = NULL;
 
    memoryUsage = 0;
 }
@@ -79,6 +144,33 @@ Bitmap::Bitmap(UINT bitmapID, UINT bitmapPriority,
    //Default transparent color is magenta
    transparentColor.SetColor(255, 0, 255);
 
+   lpDDSBitmap = NULL;
+   bitmapBuffer = NULL;
+   runLengthSprite = NULL;
+   alphaBuffer = NULL;
+   alphaChannel = false;
+   premultipliedAlpha = false;
+   loadPending = false;
+   packed = false;
+   view = false;
+   atlas = NULL;
+
+   lastUsedFrame = 0;
+   numOfUses = 0;
+   usageIndex = -1;
+   countedMemory = 0;
+
+   numOfScaledCopies = 0;
+   numOfMissedSizes = 0;
+   nextMissedSize = 0;
+
+   tiled = false;
+   tiles = NULL;
+   numOfTileColumns = 0;
+   numOfTileRows = 0;
+   numOfLoadedTiles = 0;
+   tileFile = NULL;
+
    LoadBitmap(bitmapFileName);
 }
 
@@ -91,6 +183,33 @@ Bitmap::Bitmap(UINT bitmapID, UINT bitmapPriority,
    //Default transparent color is magenta
    transparentColor.SetColor(255, 0, 255);
 
+   lpDDSBitmap = NULL;
+   bitmapBuffer = NULL;
+   runLengthSprite = NULL;
+   alphaBuffer = NULL;
+   alphaChannel = false;
+   premultipliedAlpha = false;
+   loadPending = false;
+   packed = false;
+   view = false;
+   atlas = NULL;
+
+   lastUsedFrame = 0;
+   numOfUses = 0;
+   usageIndex = -1;
+   countedMemory = 0;
+
+   numOfScaledCopies = 0;
+   numOfMissedSizes = 0;
+   nextMissedSize = 0;
+
+   tiled = false;
+   tiles = NULL;
+   numOfTileColumns = 0;
+   numOfTileRows = 0;
+   numOfLoadedTiles = 0;
+   tileFile = NULL;
+
    LoadBitmap(bitmapFileName, bitmapDimensions);
 }
  
@@ -98,19 +217,129 @@ Bitmap::~Bitmap()
 {
    if(lpDDSBitmap != NULL)
       lpDDSBitmap->Release();
+
+   if(bitmapBuffer != NULL)
+      delete bitmapBuffer;
+
+   if(alphaBuffer != NULL)
+      delete alphaBuffer;
+
+   if(runLengthSprite != NULL)
+      delete runLengthSprite;
+
+   if(atlas != NULL)
+      atlas->Release(atlasRect);
+
+   DestroyScaledCopies();
+
+   if(tiles != NULL)
+   {
+      DestroyTiles();
+      delete[] tiles;
+   }
+
+   if(tileFile != NULL)
+      BitmapFile::Close(tileFile);
+
+   SetMemoryUsage(0);
 }
 
 LPDIRECTDRAWSURFACE7 Bitmap::GetDDSurface(void)
 {
-   if(lpDDSBitmap == NULL)
+   //The tiles of a tiled bitmap are drawn instead
+   assert(!tiled);
+
+   if(lpDDSBitmap == NULL && atlas == NULL)
       ReloadBitmap();
 
+   //A packed bitmap is the source rectangle of the atlas surface
+   if(atlas != NULL)
+      return atlas->GetDDSurface();
+
    return lpDDSBitmap;
 }
 
+PixelBuffer* Bitmap::GetPixelBuffer(void)
+{
+   assert(!tiled);
+
+   if(bitmapBuffer == NULL && atlas == NULL)
+      ReloadBitmap();
+
+   if(atlas != NULL)
+      return atlas->GetPixelBuffer();
+
+   return bitmapBuffer;
+}
+
+RunLengthSprite* Bitmap::GetRunLengthSprite(void)
+{
+   assert(!tiled);
+
+   if(bitmapBuffer == NULL && atlas == NULL)
+      ReloadBitmap();
+
+   //Packed bitmaps are drawn transparently with their transparent 
+   //color, since the runs would have to be found in part of the atlas
+   return runLengthSprite;
+}
+
+PixelBuffer* Bitmap::GetAlphaBuffer(void)
+{
+   if(alphaBuffer == NULL)
+      ReloadBitmap();
+
+   return alphaBuffer;
+}
+
 void FC Bitmap::SetTransparentColor(Color& color)
 {
    transparentColor = color;
+
+   //The tiles that are loaded later get the color when they are loaded
+   if(tiled)
+   {
+      for(int i = 0; tiles != NULL && i < numOfTileColumns * numOfTileRows;
+         i++)
+      {
+         if(tiles[i] != NULL)
+            tiles[i]->SetTransparentColor(transparentColor);
+      }
+      return;
+   }
+
+   //The alpha channel says which pixels are transparent, and the color
+   //key of an atlas can't belong to one of the bitmaps in it
+   if(alphaChannel || atlas != NULL)
+      return;
+
+   //A pixel buffer just remembers the key for the transparent blits
+   if(bitmapBuffer != NULL)
+   {
+      switch(dgGraphics->colorDepth)
+      {
+         case CD_16BIT:
+            bitmapBuffer->SetColorKey(transparentColor.To16Bit());
+            break;
+         case CD_24BIT:
+            bitmapBuffer->SetColorKey(transparentColor.To24Bit());
+            break;
+         default:
+            bitmapBuffer->SetColorKey(transparentColor.To32Bit());
+            break;
+      }
+
+      //Precompile the runs of opaque pixels, so that the transparent
+      //blits don't have to test every pixel
+      if(runLengthSprite == NULL)
+         runLengthSprite = new RunLengthSprite();
+
+      runLengthSprite->Encode(bitmapBuffer, bitmapBuffer->GetColorKey());
+
+      SetMemoryUsage(bitmapBuffer->GetMemoryUsage() + 
+         runLengthSprite->GetMemoryUsage());
+   }
+
    if(lpDDSBitmap != NULL)
    {
       UINT colorDepth = dgGraphics->colorDepth;
@@ -162,27 +391,38 @@ void FC Bitmap::LoadBitmap(UINT resourceID, Area& bitmapDimensions)
 
 void FC Bitmap::LoadBitmap(const char* bitmapFileName)
 {
-   HRESULT result;
-
-   Point bitmapSize = FindBitmapSize(bitmapFileName);
+   Point bitmapSize;
+   LONG packPitch;
+   UCHAR* packPixels = dgGraphics->FindPackedPixels(bitmapFileName, 
+      bitmapSize, packPitch);
+
+   //A bitmap that is in the asset pack is already in the pixel format 
+   //of the screen
+   if(packPixels != NULL)
+   {
+      Area rect(0, 0, bitmapSize.x, bitmapSize.y);
+      LoadFromPack(packPixels, packPitch, rect);
+   }
 
-   //Create the DirectDraw surface for the bitmap
-   DDSURFACEDESC2 ddsd;
-   memset(&ddsd, 0, sizeof(ddsd));
-   ddsd.dwSize = sizeof(ddsd);    
-   ddsd.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH; 
-   ddsd.ddsCaps.dwCaps = DDSCAPS_OFFSCREENPLAIN; 
-   ddsd.dwWidth = bitmapSize.x; 
-   ddsd.dwHeight = bitmapSize.y; 
-   
-   result = dgGraphics->lpDD->CreateSurface(&ddsd, &lpDDSBitmap, NULL); 
+   else
+   {
+      BitmapFile* file = BitmapFile::Open(bitmapFileName);
+      bitmapSize = file->GetBitmapSize();
+      Area rect(0, 0, bitmapSize.x, bitmapSize.y);
 
-   if(result != DD_OK)
-      dgGraphics->HandleDDrawError(EC_DDSETGRAPHMODE, result, 
-         __FILE__, __LINE__);
+      //The file is closed even if the bitmap can't be loaded from it
+      try
+      {
+         LoadFromFile(*file, rect);
+      }
+      catch(...)
+      {
+         BitmapFile::Close(file);
+         throw;
+      }
 
-   LoadBitmapFromFile(Area(0, 0, bitmapSize.x, bitmapSize.y),
-      bitmapFileName);
+      BitmapFile::Close(file);
+   }
 
    isLoaded = true;
    useDimensions = false;
@@ -192,20 +432,44 @@ void FC Bitmap::LoadBitmap(const char* bitmapFileName)
    width = bitmapSize.x;
    height = bitmapSize.y;
 
-   memset(&ddsd, 0, sizeof(ddsd));
-   ddsd.dwSize = sizeof(ddsd); 
-   lpDDSBitmap->GetSurfaceDesc(&ddsd);
-
-   memoryUsage = ddsd.lPitch * ddsd.dwHeight;
-
    SetTransparentColor(transparentColor);
 }
 
 void FC Bitmap::LoadBitmap(const char* bitmapFileName, Area& bitmapDimensions)
 {
-   HRESULT result;
+   //A view only needs a surface of its own if the sheet can't hold it
+   if(!view || !LoadView(bitmapFileName, bitmapDimensions))
+      LoadArea(bitmapFileName, bitmapDimensions);
+
+   isLoaded = true;
+   useDimensions = true;
+   resourceBitmap = false;
+   strcpy(fileName, bitmapFileName);
+
+   dimensions = bitmapDimensions;
+
+   width = bitmapDimensions.width;
+   height = bitmapDimensions.height;
 
-   Point bitmapSize = FindBitmapSize(bitmapFileName);
+   SetTransparentColor(transparentColor);
+}
+
+//Loads an area of a file, or of the asset pack, into a surface of its
+//own or into an atlas
+void Bitmap::LoadArea(const char* bitmapFileName, Area& bitmapDimensions)
+{
+   Point bitmapSize;
+   LONG packPitch;
+   UCHAR* packPixels = dgGraphics->FindPackedPixels(bitmapFileName, 
+      bitmapSize, packPitch);
+   BitmapFile* file = NULL;
+
+   //A file that many bitmaps are cut out of stays mapped between them
+   if(packPixels == NULL)
+   {
+      file = BitmapFile::Open(bitmapFileName);
+      bitmapSize = file->GetBitmapSize();
+   }
 
    assert(bitmapDimensions.left >= 0 && bitmapDimensions.left < bitmapSize.x &&
       bitmapDimensions.top >= 0 && bitmapDimensions.top < bitmapSize.y &&
@@ -215,40 +479,104 @@ void FC Bitmap::LoadBitmap(const char* bitmapFileName, Area& bitmapDimensions)
       bitmapDimensions.Bottom() >= 0 && 
       bitmapDimensions.Bottom() <= bitmapSize.y);
 
-   //Create the DirectDraw surface for the bitmap
-   DDSURFACEDESC2 ddsd;
-   memset(&ddsd, 0, sizeof(ddsd));
-   ddsd.dwSize = sizeof(ddsd);    
-   ddsd.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH; 
-   ddsd.ddsCaps.dwCaps = DDSCAPS_OFFSCREENPLAIN; 
-   ddsd.dwWidth = bitmapDimensions.width; 
-   ddsd.dwHeight = bitmapDimensions.height; 
-   
-   result = dgGraphics->lpDD->CreateSurface(&ddsd, &lpDDSBitmap, NULL); 
+   if(packPixels != NULL)
+   {
+      //The area has to be inside the bitmap, just like it has to be 
+      //inside the file
+      if(bitmapDimensions.left < 0 || bitmapDimensions.top < 0 ||
+         bitmapDimensions.width < 0 || bitmapDimensions.height < 0 ||
+         bitmapDimensions.Right() > bitmapSize.x ||
+         bitmapDimensions.Bottom() > bitmapSize.y)
+      {
+         char message[MAX_PATH + 64];
+         sprintf(message, "%s: the area is outside of the bitmap.", 
+            bitmapFileName);
+         throw new Exception(message, EC_BMBITMAPSIZE, ET_BITMAP,
+            __FILE__, __LINE__);
+      }
 
-   if(result != DD_OK)
-      dgGraphics->HandleDDrawError(EC_DDSETGRAPHMODE, result, 
-         __FILE__, __LINE__);
+      LoadFromPack(packPixels, packPitch, bitmapDimensions);
+   }
 
-   LoadBitmapFromFile(bitmapDimensions, bitmapFileName);
+   else
+   {
+      try
+      {
+         LoadFromFile(*file, bitmapDimensions);
+      }
+      catch(...)
+      {
+         BitmapFile::Close(file);
+         throw;
+      }
 
-   isLoaded = true;
-   useDimensions = true;
-   resourceBitmap = false;
-   strcpy(fileName, bitmapFileName);
+      BitmapFile::Close(file);
+   }
+}
 
-   dimensions = bitmapDimensions;
+//Makes the bitmap a view of an area of the sheet of a file, which uses
+//as much memory as the pixels of the area. Returns false if the file 
+//can't have views.
+bool Bitmap::LoadView(const char* bitmapFileName, Area& rect)
+{
+   BitmapAtlas* sheet = dgGraphics->FindBitmapSheet(bitmapFileName);
 
-   width = bitmapDimensions.width;
-   height = bitmapDimensions.height;
+   if(!sheet->AddView(rect, atlasRect))
+      return false;
 
-   memset(&ddsd, 0, sizeof(ddsd));
-   ddsd.dwSize = sizeof(ddsd); 
-   lpDDSBitmap->GetSurfaceDesc(&ddsd);
+   atlas = sheet;
+   alphaChannel = false;
+   SetMemoryUsage(rect.width * rect.height * dgGraphics->bytesPerPixel);
 
-   memoryUsage = ddsd.lPitch * ddsd.dwHeight;
+   return true;
+}
 
-   SetTransparentColor(transparentColor);
+/*------------------------------------------------------------------------
+Function Name: LoadTiledBitmap
+Parameters:
+   const char* bitmapFileName : the name of the bitmap file
+Description:
+   This function makes the bitmap a tiled bitmap of a file. Only the 
+   size of the bitmap is read and the file is checked, and the tiles are
+   loaded from the file by GetTile() when they are drawn.
+------------------------------------------------------------------------*/
+
+void FC Bitmap::LoadTiledBitmap(const char* bitmapFileName)
+{
+   BitmapFile* file = BitmapFile::Open(bitmapFileName);
+   Point bitmapSize = file->GetBitmapSize();
+   Area rect(0, 0, bitmapSize.x, bitmapSize.y);
+
+   try
+   {
+      CheckFile(*file, rect);
+   }
+   catch(...)
+   {
+      BitmapFile::Close(file);
+      throw;
+   }
+
+   alphaChannel = (file->GetInfoHeader().biBitCount == 32);
+   tileFile = file;
+   tiled = true;
+
+   numOfTileColumns = (bitmapSize.x + BM_TILE_SIZE - 1) / BM_TILE_SIZE;
+   numOfTileRows = (bitmapSize.y + BM_TILE_SIZE - 1) / BM_TILE_SIZE;
+   numOfLoadedTiles = 0;
+
+   tiles = new Bitmap*[numOfTileColumns * numOfTileRows];
+   memset(tiles, 0, numOfTileColumns * numOfTileRows * sizeof(Bitmap*));
+
+   isLoaded = true;
+   useDimensions = false;
+   resourceBitmap = false;
+   strcpy(fileName, bitmapFileName);
+
+   width = bitmapSize.x;
+   height = bitmapSize.y;
+
+   SetMemoryUsage(0);
 }
 
 void FC Bitmap::DestroyBitmap()
@@ -259,15 +587,68 @@ void FC Bitmap::DestroyBitmap()
       lpDDSBitmap = NULL;
    }
 
+   if(bitmapBuffer != NULL)
+   {
+      delete bitmapBuffer;
+      bitmapBuffer = NULL;
+   }
+
+   if(alphaBuffer != NULL)
+   {
+      delete alphaBuffer;
+      alphaBuffer = NULL;
+   }
+
+   if(runLengthSprite != NULL)
+   {
+      delete runLengthSprite;
+      runLengthSprite = NULL;
+   }
+
+   if(atlas != NULL)
+   {
+      atlas->Release(atlasRect);
+      atlas = NULL;
+   }
+
+   DestroyScaledCopies();
+
+   //A tiled bitmap stays tiled, so that it is loaded as tiles again
+   if(tiles != NULL)
+   {
+      DestroyTiles();
+      delete[] tiles;
+      tiles = NULL;
+   }
+
+   if(tileFile != NULL)
+   {
+      BitmapFile::Close(tileFile);
+      tileFile = NULL;
+   }
+
    isLoaded = false;
-   memoryUsage = 0;
+   SetMemoryUsage(0);
 }
 
 void FC Bitmap::ReloadBitmap()
 {
+   //The bitmap loader is already loading the bitmap
+   if(loadPending)
+      return;
+
+   //The tiles of a tiled bitmap are loaded when they are drawn
+   if(tiled)
+   {
+      if(!isLoaded)
+         LoadTiledBitmap(fileName);
+      return;
+   }
+
    //If the surface is NULL, is means it was lost and
    //needs to be reloaded.
-   if(isLoaded && lpDDSBitmap != NULL)
+   if(isLoaded && (lpDDSBitmap != NULL || bitmapBuffer != NULL ||
+      alphaBuffer != NULL || atlas != NULL))
       return;
 
    if(resourceBitmap)
@@ -292,6 +673,28 @@ void FC Bitmap::ReloadBitmap()
 //This function is to be called when surfaces are lost
 void FC Bitmap::RestoreBitmap()
 {
+   //The tiles are loaded again when they are drawn
+   if(tiled)
+   {
+      DestroyTiles();
+      return;
+   }
+
+   //Pixel buffers are never lost
+   if(bitmapBuffer != NULL || alphaBuffer != NULL)
+      return;
+
+   //The scaled copies are made again when they are drawn
+   DestroyScaledCopies();
+
+   //The atlas loads the areas of all its bitmaps again when it is 
+   //restored, which the first of its bitmaps to be restored does
+   if(atlas != NULL)
+   {
+      atlas->Restore();
+      return;
+   }
+
    HRESULT result;
    
    result = lpDDSBitmap->Restore();
@@ -311,208 +714,803 @@ void FC Bitmap::RestoreBitmap()
    ReloadBitmap();
 }
 
-void Bitmap::LoadBitmapFromFile(Area& rect, const char* bitmapFileName)
+/*------------------------------------------------------------------------
+Function Name: ReloadAtlasArea
+Parameters:
+Description:
+   This function loads a packed bitmap or a view again into its area of
+   its atlas, after the surface of the atlas has been restored or made
+   again in the pixel format of a new graphics mode.
+------------------------------------------------------------------------*/
+
+void FC Bitmap::ReloadAtlasArea(void)
 {
-   char message[256];
+   assert(atlas != NULL);
 
-   //Reads the bitmap file into the buffer
-   fstream bitmapFile(bitmapFileName, ios::in | ios::binary);
+   SetMemoryUsage((atlasRect.right - atlasRect.left) * 
+      (atlasRect.bottom - atlasRect.top) * dgGraphics->bytesPerPixel);
 
-   //If file cannot be opened, Error
-   if(bitmapFile.fail())
+   Point packSize;
+   LONG packPitch;
+   UCHAR* packPixels = dgGraphics->FindPackedPixels(fileName, packSize,
+      packPitch);
+
+   if(packPixels != NULL)
    {
-      sprintf(message, "The file %s could not be opened.", bitmapFileName);
-      throw new Exception(message, EC_BMBITMAPLOAD, ET_BITMAP,
-         __FILE__, __LINE__);
+      Area packRect = useDimensions ? dimensions : 
+         Area(0, 0, packSize.x, packSize.y);
+      LONG atlasPitch;
+      UCHAR* bits = atlas->Lock(atlasPitch);
+
+      CopyFromPack(packPixels, packPitch, packRect, bits + 
+         (atlasRect.top * atlasPitch) + 
+         (atlasRect.left * dgGraphics->bytesPerPixel), atlasPitch);
+
+      atlas->Unlock();
+      return;
    }
 
-   //If file is not a bitmap, Error
-   BITMAPFILEHEADER bmfh;
-   bitmapFile.read((char*)&bmfh, sizeof(bmfh));
-   if(bmfh.bfType != 0x4D42)
+   BitmapFile* file = BitmapFile::Open(fileName);
+   Point bitmapSize = file->GetBitmapSize();
+   Area rect = useDimensions ? dimensions : 
+      Area(0, 0, bitmapSize.x, bitmapSize.y);
+
+   try
    {
-      sprintf(message, "The file %s is not a bitmap file.", bitmapFileName);
-      throw new Exception(message, EC_BMBITMAPLOAD, ET_BITMAP,
-         __FILE__, __LINE__);
+      CopyToAtlas(*file, rect);
+   }
+   catch(...)
+   {
+      BitmapFile::Close(file);
+      throw;
    }
 
-   BITMAPINFOHEADER bmih;
-   bitmapFile.read((char*)&bmih, sizeof(bmih));
+   BitmapFile::Close(file);
+}
 
-   //We are only interested in 24-bit bitmaps
-   if(bmih.biBitCount != 24)
+//Creates the surface that the bitmap is loaded into: a DirectDraw
+//surface or, with the software backend, a pixel buffer. A bitmap with
+//an alpha channel always gets a 32-bit pixel buffer.
+void Bitmap::CreateSurface(int surfaceWidth, int surfaceHeight, bool alpha)
+{
+   if(alpha)
    {
-      sprintf(message, "The file %s is not a 24-bit bitmap.", bitmapFileName);
-      throw new Exception(message, EC_BMBITMAPLOAD, ET_BITMAP,
-         __FILE__, __LINE__);
+      alphaBuffer = new PixelBuffer(surfaceWidth, surfaceHeight, 4);
+
+      SetMemoryUsage(alphaBuffer->GetMemoryUsage());
+      return;
    }
 
-   //We don't want compressed bitmaps
-   if(bmih.biCompression != BI_RGB)
+   if(dgGraphics->GetRenderBackend() == RB_SOFTWARE)
    {
-      sprintf(message, "%s: compressed bitmaps cannot be loaded.", 
-         bitmapFileName);
-      throw new Exception(message, EC_BMBITMAPLOAD, ET_BITMAP,
-         __FILE__, __LINE__);
-   }
+      bitmapBuffer = new PixelBuffer(surfaceWidth, surfaceHeight,
+         dgGraphics->bytesPerPixel);
 
-   int bytesPerLine = bmih.biWidth * 3;
-   RGBTRIPLE pixel;
-   UCHAR* videoBuffer;
-   int bufferPitch;
-   int bufferPosition = 0;
-   Color color;
+      SetMemoryUsage(bitmapBuffer->GetMemoryUsage());
+      return;
+   }
 
-   //Lock the surface for drawing
    HRESULT result;
+
+   //Create the DirectDraw surface for the bitmap
    DDSURFACEDESC2 ddsd;
    memset(&ddsd, 0, sizeof(ddsd));
-   ddsd.dwSize = sizeof(ddsd);
+   ddsd.dwSize = sizeof(ddsd);    
+   ddsd.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH; 
+   ddsd.ddsCaps.dwCaps = DDSCAPS_OFFSCREENPLAIN; 
+   ddsd.dwWidth = surfaceWidth; 
+   ddsd.dwHeight = surfaceHeight; 
+   
+   result = dgGraphics->lpDD->CreateSurface(&ddsd, &lpDDSBitmap, NULL); 
 
-   result = lpDDSBitmap->Lock(NULL, &ddsd, DDLOCK_SURFACEMEMORYPTR |
-      DDLOCK_WAIT, NULL);
+   if(result != DD_OK)
+      dgGraphics->HandleDDrawError(EC_DDSETGRAPHMODE, result, 
+         __FILE__, __LINE__);
 
-   switch(result)
+   memset(&ddsd, 0, sizeof(ddsd));
+   ddsd.dwSize = sizeof(ddsd); 
+   lpDDSBitmap->GetSurfaceDesc(&ddsd);
+
+   SetMemoryUsage(ddsd.lPitch * ddsd.dwHeight);
+}
+
+/*------------------------------------------------------------------------
+Function Name: FindScaledCopy
+Parameters:
+   int scaledWidth, int scaledHeight : the size the bitmap is drawn at
+   UINT filter : the filter the bitmap is scaled with
+Returns:
+   The scaled copy of that size and filter, or NULL if there isn't one
+Description:
+   This function finds a scaled copy of the bitmap and marks it as used,
+   so that it is the last copy to be replaced.
+------------------------------------------------------------------------*/
+
+Bitmap* FC Bitmap::FindScaledCopy(int scaledWidth, int scaledHeight,
+   UINT filter)
+{
+   for(int i = 0; i < numOfScaledCopies; i++)
    {
-      case DDERR_SURFACELOST:
-         lpDDSBitmap->Restore();
-         result = lpDDSBitmap->Lock(NULL, &ddsd, DDLOCK_SURFACEMEMORYPTR |
-            DDLOCK_WAIT, NULL);
-         if(result != DD_OK)
-            dgGraphics->HandleDDrawError(EC_DDLOCKSURFACE, result, 
-               __FILE__, __LINE__);
-         break;
-      case DD_OK:
-         videoBuffer = (UCHAR*)ddsd.lpSurface;
-         bufferPitch = ddsd.lPitch;
-         break;
-      default:
-         lpDDSBitmap->Unlock(NULL);
-         dgGraphics->HandleDDrawError(EC_DDLOCKSURFACE, result, 
-            __FILE__, __LINE__);
-         break;
+      Bitmap* copy = scaledCopies[i];
+
+      if(copy->width == scaledWidth && copy->height == scaledHeight &&
+         scaledFilters[i] == filter)
+      {
+         copy->MarkUsed(dgGraphics->bitmapList.GetCurrentFrame());
+         return copy;
+      }
    }
-   
-#ifdef _DEBUG
-   lpDDSBitmap->Unlock(NULL);
-#endif
 
-   //Bitmaps have padding so that the end of each scanline is on the
-   //32-bit boundary.  Necessary padding for this bitmap is calculated
-   int padding = bmih.biWidth % 4;
+   return NULL;
+}
 
-   //Find initial buffer position
-   switch(dgGraphics->colorDepth)
+/*------------------------------------------------------------------------
+Function Name: IsScaledCopyWanted
+Parameters:
+   int scaledWidth, int scaledHeight : the size the bitmap is drawn at
+   UINT filter : the filter the bitmap is scaled with
+Returns:
+   true if a copy of this size should be made, false if not yet
+Description:
+   This function is called when a scaled draw had no copy. A copy is 
+   wanted if one of the last BM_MAX_SCALED_COPIES scaled draws without
+   one had the same size and filter, so that a bitmap that is drawn at
+   a few sizes in turn gets a copy for each of them. Otherwise the size
+   is remembered in place of the oldest one.
+------------------------------------------------------------------------*/
+
+bool FC Bitmap::IsScaledCopyWanted(int scaledWidth, int scaledHeight,
+   UINT filter)
+{
+   for(int i = 0; i < numOfMissedSizes; i++)
    {
-      case CD_16BIT:
-         bufferPosition = (rect.height - 1) * (bufferPitch >> 1);
-         break;
-      case CD_24BIT:
-         bufferPosition = (rect.height - 1) * bufferPitch;
-         break;
-      case CD_32BIT:
-         bufferPosition = (rect.height - 1) * (bufferPitch >> 2);
-         break;
+      if(missedWidths[i] == scaledWidth && 
+         missedHeights[i] == scaledHeight && missedFilters[i] == filter)
+         return true;
    }
 
-   //Find initial position in file
-   bitmapFile.ignore((bytesPerLine + padding) * 
-      (bmih.biHeight - (rect.top + rect.height)));
-   
-   for(int y = rect.height - 1; y >= 0; y--)
+   missedWidths[nextMissedSize] = scaledWidth;
+   missedHeights[nextMissedSize] = scaledHeight;
+   missedFilters[nextMissedSize] = filter;
+
+   nextMissedSize = (nextMissedSize + 1) % BM_MAX_SCALED_COPIES;
+
+   if(numOfMissedSizes < BM_MAX_SCALED_COPIES)
+      numOfMissedSizes++;
+
+   return false;
+}
+
+/*------------------------------------------------------------------------
+Function Name: AddScaledCopy
+Parameters:
+   int scaledWidth, int scaledHeight : the size of the copy
+   UINT filter : the filter the bitmap is scaled with
+   ScaleSetup& setup : the source of the scaling, which is the locked
+      pixels of this bitmap
+Returns:
+   The new copy
+Description:
+   This function scales the bitmap into a new copy with the scale kernel
+   of the filter. The copy has a surface of its own in the pixel format
+   of the screen. If the bitmap already has as many copies as it can
+   keep, the one that was drawn the longest time ago is destroyed.
+------------------------------------------------------------------------*/
+
+Bitmap* FC Bitmap::AddScaledCopy(int scaledWidth, int scaledHeight,
+   UINT filter, ScaleSetup& setup)
+{
+   Bitmap* copy = new Bitmap(id, priority);
+
+   try
+   {
+      copy->CreateSurface(scaledWidth, scaledHeight);
+   }
+   catch(...)
+   {
+      delete copy;
+      throw;
+   }
+
+   copy->width = scaledWidth;
+   copy->height = scaledHeight;
+   copy->isLoaded = true;
+   copy->MarkUsed(dgGraphics->bitmapList.GetCurrentFrame());
+
+   int index = numOfScaledCopies;
+
+   if(numOfScaledCopies == BM_MAX_SCALED_COPIES)
    {
-      //Ignore the first pixels in the row if necessary
-      bitmapFile.ignore(rect.left * 3);
-      for(int x = 0; x < rect.width; x++)
+      index = 0;
+      for(int i = 1; i < numOfScaledCopies; i++)
       {
-         //Read the pixel from the file
-         bitmapFile.read((char *)&pixel, sizeof(pixel));
-         color.r = pixel.rgbtRed;
-         color.g = pixel.rgbtGreen;
-         color.b = pixel.rgbtBlue;
-         //Write the pixel on the bitmap surface
-         switch(dgGraphics->colorDepth)
-         {
-            case CD_16BIT:
-            {
-               ((USHORT*)videoBuffer)[bufferPosition] = color.To16Bit();
-               bufferPosition++;
-               break;
-            }
-            case CD_24BIT:
-            {
-               UINT colorValue = color.To24Bit();
-         
-               //Copy the 3 bytes into video memory
-			      ((UCHAR*)videoBuffer)[bufferPosition++] = ((UCHAR*)&colorValue)[0];
-			      ((UCHAR*)videoBuffer)[bufferPosition++] = ((UCHAR*)&colorValue)[1];
-			      ((UCHAR*)videoBuffer)[bufferPosition++] = ((UCHAR*)&colorValue)[2];
-
-               break;
-            }
-            case CD_32BIT:
-            {
-               ((UINT*)videoBuffer)[bufferPosition] = color.To32Bit();
-               bufferPosition++;
-               break;
-            }
-         }  
+         if(scaledCopies[i]->GetLastUsedFrame() < 
+            scaledCopies[index]->GetLastUsedFrame())
+            index = i;
       }
 
-      //Move the file pointer to the beginning of the next bitmap line
-      bitmapFile.ignore(bytesPerLine - ((rect.left + rect.width) * 3) + 
-         padding);
+      //Drawing that hasn't been flushed may still use the copy
+      dgGraphics->FlushDrawing();
+      delete scaledCopies[index];
+   }
 
-      //Move the bufferPosition variable to the next line
-      switch(dgGraphics->colorDepth)
+   else
+      numOfScaledCopies++;
+
+   scaledCopies[index] = copy;
+   scaledFilters[index] = filter;
+
+   ScaleKernel scaleKernel = (filter == SF_BILINEAR) ? 
+      dgGraphics->spanKernels.ScaleBilinear : 
+      dgGraphics->spanKernels.ScaleNearest;
+
+   RECT destRect = {0, 0, scaledWidth, scaledHeight};
+   setup.transparent = false;
+   setup.SetArea(destRect, 0, 0, filter);
+
+   LONG pitch;
+   UCHAR* bits = copy->LockBits(pitch);
+   scaleKernel(bits, pitch, scaledWidth, scaledHeight, setup);
+   copy->UnlockBits();
+
+   return copy;
+}
+
+/*------------------------------------------------------------------------
+Function Name: DestroyScaledCopies
+Parameters:
+Description:
+   This function destroys the scaled copies of the bitmap. They are made
+   again when the bitmap is drawn scaled.
+------------------------------------------------------------------------*/
+
+void FC Bitmap::DestroyScaledCopies(void)
+{
+   for(int i = 0; i < numOfScaledCopies; i++)
+      delete scaledCopies[i];
+
+   numOfScaledCopies = 0;
+}
+
+//Sets the memory of the bitmap and keeps the total of the graphics 
+//object up to date. Only a surface of the bitmap's own is counted in the
+//total: an atlas counts its surface itself, and the tiles and scaled
+//copies are bitmaps that count their own surfaces.
+void FC Bitmap::SetMemoryUsage(UINT memory)
+{
+   memoryUsage = memory;
+
+   UINT counted = (atlas == NULL && !tiled) ? memory : 0;
+   dgGraphics->bitmapMemory += counted - countedMemory;
+   countedMemory = counted;
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetTile
+Parameters:
+   int column, int row : the position of the tile in the tiled bitmap
+Returns:
+   The tile, which is loaded
+Description:
+   This function finds a tile of a tiled bitmap, loading it from the file
+   if it isn't loaded, and marks it as used in the current frame. When
+   BM_MAX_TILES tiles are loaded, the tile that was drawn the longest
+   time ago is destroyed first, unless all of them were drawn in the 
+   current frame.
+------------------------------------------------------------------------*/
+
+Bitmap* FC Bitmap::GetTile(int column, int row)
+{
+   assert(tiled && isLoaded && column >= 0 && column < numOfTileColumns &&
+      row >= 0 && row < numOfTileRows);
+
+   UINT frame = dgGraphics->bitmapList.GetCurrentFrame();
+   Bitmap*& tile = tiles[(row * numOfTileColumns) + column];
+
+   if(tile == NULL)
+   {
+      while(numOfLoadedTiles >= BM_MAX_TILES && 
+         RemoveLeastRecentlyUsedTile(frame));
+
+      int left = column * BM_TILE_SIZE;
+      int top = row * BM_TILE_SIZE;
+      Area area(left, top, min(BM_TILE_SIZE, width - left), 
+         min(BM_TILE_SIZE, height - top));
+
+      //A tile is never a view, since the sheet would hold the whole file
+      Bitmap* newTile = new Bitmap(id, priority);
+      newTile->SetView(false);
+      newTile->transparentColor = transparentColor;
+      newTile->premultipliedAlpha = premultipliedAlpha;
+
+      try
       {
-         case CD_16BIT:
-            bufferPosition = bufferPosition - ((bufferPitch >> 1) + rect.width);
-            break;
-         case CD_24BIT:
-            bufferPosition = bufferPosition - (bufferPitch + (rect.width * 3));
-            break;
-         case CD_32BIT:
-            bufferPosition = bufferPosition - ((bufferPitch >> 2) + rect.width);
-            break;
+         newTile->LoadBitmap(fileName, area);
+      }
+      catch(...)
+      {
+         delete newTile;
+         throw;
       }
+
+      tile = newTile;
+      numOfLoadedTiles++;
+      SetMemoryUsage(memoryUsage + tile->GetMemoryUsage());
    }
 
-#ifndef _DEBUG
-   lpDDSBitmap->Unlock(NULL);
-#endif
+   tile->MarkUsed(frame);
+   return tile;
+}
 
-   bitmapFile.close();
+//Destroys the loaded tile that was drawn the longest time ago. Returns 
+//false if all the loaded tiles were drawn in the frame, since they may
+//still be waiting to be drawn.
+bool Bitmap::RemoveLeastRecentlyUsedTile(UINT frame)
+{
+   Bitmap** oldest = NULL;
+
+   for(int i = 0; i < numOfTileColumns * numOfTileRows; i++)
+   {
+      if(tiles[i] != NULL && (oldest == NULL || 
+         tiles[i]->GetLastUsedFrame() < (*oldest)->GetLastUsedFrame()))
+         oldest = &tiles[i];
+   }
+
+   if(oldest == NULL || (*oldest)->GetLastUsedFrame() == frame)
+      return false;
+
+   SetMemoryUsage(memoryUsage - (*oldest)->GetMemoryUsage());
+   delete *oldest;
+   *oldest = NULL;
+   numOfLoadedTiles--;
+
+   return true;
 }
 
-Point Bitmap::FindBitmapSize(const char* bitmapFileName)
+//Destroys all the loaded tiles of a tiled bitmap
+void Bitmap::DestroyTiles(void)
 {
-   char message[256];
+   if(tiles == NULL)
+      return;
+
+   for(int i = 0; i < numOfTileColumns * numOfTileRows; i++)
+   {
+      if(tiles[i] != NULL)
+      {
+         delete tiles[i];
+         tiles[i] = NULL;
+      }
+   }
+
+   numOfLoadedTiles = 0;
+   SetMemoryUsage(0);
+}
+
+/*------------------------------------------------------------------------
+Function Name: BeginAsyncLoad
+Parameters:
+   const char* bitmapFileName : the name of the bitmap file
+Returns:
+   The load, which the bitmap loader decodes the bitmap with
+Description:
+   This function opens the file and checks that the bitmap can be
+   loaded from it, so that the size of the bitmap is known right away 
+   and errors are thrown by the thread that asked for the bitmap. The
+   bitmap is a placeholder until FinishAsyncLoad() is called.
+------------------------------------------------------------------------*/
 
-   //Reads the bitmap file into the buffer
-   fstream bitmapFile(bitmapFileName, ios::in | ios::binary);
+BitmapLoad* FC Bitmap::BeginAsyncLoad(const char* bitmapFileName)
+{
+   BitmapFile* file = BitmapFile::Open(bitmapFileName);
+   Point bitmapSize = file->GetBitmapSize();
+   Area rect(0, 0, bitmapSize.x, bitmapSize.y);
 
-   //If file cannot be opened, Error
-   if(bitmapFile.fail())
+   try
+   {
+      CheckFile(*file, rect);
+   }
+   catch(...)
    {
-      sprintf(message, "The file %s could not be opened.", bitmapFileName);
-      throw new Exception(message, EC_BMBITMAPSIZE, ET_BITMAP,
+      BitmapFile::Close(file);
+      throw;
+   }
+
+   alphaChannel = (file->GetInfoHeader().biBitCount == 32);
+
+   isLoaded = false;
+   loadPending = true;
+   useDimensions = false;
+   resourceBitmap = false;
+   strcpy(fileName, bitmapFileName);
+
+   width = bitmapSize.x;
+   height = bitmapSize.y;
+
+   BitmapLoad* load = new BitmapLoad;
+   load->bitmap = this;
+   load->file = file;
+   load->rect = rect;
+   load->alpha = alphaChannel;
+   load->premultiplied = premultipliedAlpha;
+   load->pixels = NULL;
+
+   return load;
+}
+
+/*------------------------------------------------------------------------
+Function Name: FinishAsyncLoad
+Parameters:
+   PixelBuffer* pixels : the pixels that the bitmap loader decoded, 
+      which the bitmap takes over, or NULL if they couldn't be decoded
+Description:
+   A pixel buffer becomes the surface of the bitmap as it is. With the
+   DirectDraw backend the pixels are copied into a DirectDraw surface,
+   which is created here, since only the thread that draws may do that.
+   Without pixels the bitmap is loaded the usual way when it is drawn.
+------------------------------------------------------------------------*/
+
+void FC Bitmap::FinishAsyncLoad(PixelBuffer* pixels)
+{
+   loadPending = false;
+
+   if(pixels == NULL)
+      return;
+
+   if(alphaChannel)
+   {
+      alphaBuffer = pixels;
+      SetMemoryUsage(alphaBuffer->GetMemoryUsage());
+   }
+
+   else if(dgGraphics->GetRenderBackend() == RB_SOFTWARE)
+   {
+      bitmapBuffer = pixels;
+      SetMemoryUsage(bitmapBuffer->GetMemoryUsage());
+   }
+
+   else
+   {
+      try
+      {
+         CreateSurface(width, height);
+
+         LONG pitch;
+         UCHAR* bits = LockBits(pitch);
+
+         for(int y = 0; y < height; y++)
+         {
+            memcpy(bits + (y * pitch), pixels->GetScanLine(y), 
+               width * pixels->GetBytesPerPixel());
+         }
+
+         UnlockBits();
+      }
+      catch(...)
+      {
+         delete pixels;
+         throw;
+      }
+
+      delete pixels;
+   }
+
+   isLoaded = true;
+
+   SetTransparentColor(transparentColor);
+}
+
+//Creates the surface for an area of a mapped file and loads the area
+//into it
+void Bitmap::LoadFromFile(BitmapFile& file, Area& rect)
+{
+   CheckFile(file, rect);
+
+   alphaChannel = (file.GetInfoHeader().biBitCount == 32);
+
+   //A small bitmap that is meant to be packed shares an atlas surface
+   //with others, and uses as much memory as its pixels
+   if(packed && !alphaChannel && rect.width <= BA_MAX_BITMAP_SIZE &&
+      rect.height <= BA_MAX_BITMAP_SIZE)
+   {
+      atlas = dgGraphics->AllocateAtlasArea(rect.width, rect.height, 
+         atlasRect);
+      CopyToAtlas(file, rect);
+
+      SetMemoryUsage(rect.width * rect.height * 
+         dgGraphics->bytesPerPixel);
+      return;
+   }
+
+   CreateSurface(rect.width, rect.height, alphaChannel);
+
+   if(alphaChannel)
+   {
+      DecodeAlphaLines(file, rect, alphaBuffer, premultipliedAlpha);
+      return;
+   }
+
+   //Each line is converted to the pixel format of the screen by the
+   //kernel that was chosen when the graphics mode was set
+   LONG pitch;
+   UCHAR* bits = LockBits(pitch);
+
+   DecodeLines(file, rect, bits, pitch, 
+      dgGraphics->spanKernels.ConvertLine, 
+      &dgGraphics->spanKernels.convertTables);
+
+   UnlockBits();
+}
+
+//Copies an area of the pixels of the asset pack into a new surface or
+//into an atlas, like LoadFromFile() does with an area of a file. The
+//pack never has bitmaps with an alpha channel.
+void Bitmap::LoadFromPack(UCHAR* pixels, LONG pitch, Area& rect)
+{
+   alphaChannel = false;
+
+   LONG destPitch;
+   UCHAR* bits;
+
+   if(packed && rect.width <= BA_MAX_BITMAP_SIZE &&
+      rect.height <= BA_MAX_BITMAP_SIZE)
+   {
+      atlas = dgGraphics->AllocateAtlasArea(rect.width, rect.height, 
+         atlasRect);
+
+      bits = atlas->Lock(destPitch);
+      CopyFromPack(pixels, pitch, rect, bits + (atlasRect.top * destPitch) +
+         (atlasRect.left * dgGraphics->bytesPerPixel), destPitch);
+      atlas->Unlock();
+
+      SetMemoryUsage(rect.width * rect.height * 
+         dgGraphics->bytesPerPixel);
+      return;
+   }
+
+   CreateSurface(rect.width, rect.height);
+
+   bits = LockBits(destPitch);
+   CopyFromPack(pixels, pitch, rect, bits, destPitch);
+   UnlockBits();
+}
+
+//Copies the lines of an area of the pixels of the asset pack to dest
+void Bitmap::CopyFromPack(UCHAR* pixels, LONG pitch, Area& rect, 
+   UCHAR* dest, LONG destPitch)
+{
+   int pixelSize = dgGraphics->bytesPerPixel;
+   UCHAR* source = pixels + (rect.top * pitch) + (rect.left * pixelSize);
+
+   for(int i = 0; i < rect.height; i++)
+   {
+      memcpy(dest, source, rect.width * pixelSize);
+
+      dest += destPitch;
+      source += pitch;
+   }
+}
+
+//Converts an area of a file into the area of the bitmap in its atlas
+void Bitmap::CopyToAtlas(BitmapFile& file, Area& rect)
+{
+   LONG pitch;
+   UCHAR* bits = atlas->Lock(pitch);
+
+   DecodeLines(file, rect, bits + (atlasRect.top * pitch) + 
+      (atlasRect.left * dgGraphics->bytesPerPixel), pitch, 
+      dgGraphics->spanKernels.ConvertLine, 
+      &dgGraphics->spanKernels.convertTables);
+
+   atlas->Unlock();
+}
+
+//Throws an exception if an area of a file can't be loaded. The file 
+//must have 24-bit pixels, or 32-bit pixels with an alpha channel which
+//can be uncompressed or use bit fields, as long as the bit fields are 
+//the usual 8 bits per channel.
+void Bitmap::CheckFile(BitmapFile& file, Area& rect)
+{
+   char message[MAX_PATH + 64];
+   BITMAPINFOHEADER& bmih = file.GetInfoHeader();
+
+   //We are only interested in 24-bit and 32-bit bitmaps
+   if(bmih.biBitCount != 24 && bmih.biBitCount != 32)
+   {
+      sprintf(message, "The file %s is not a 24-bit or 32-bit bitmap.", 
+         file.GetFileName());
+      throw new Exception(message, EC_BMBITMAPLOAD, ET_BITMAP,
          __FILE__, __LINE__);
    }
 
-   //If file is not a bitmap, Error
-   BITMAPFILEHEADER bmfh;
-   bitmapFile.read((char*)&bmfh, sizeof(bmfh));
-   if(bmfh.bfType != 0x4D42)
+   //The bit fields follow the header, and are part of the header in
+   //the newer versions of it. Either way they start at the same place.
+   if(bmih.biBitCount == 32 && bmih.biCompression == BI_BITFIELDS)
    {
-      sprintf(message, "The file %s is not a bitmap file.", bitmapFileName);
-      throw new Exception(message, EC_BMBITMAPSIZE, ET_BITMAP,
+      UINT masksOffset = sizeof(BITMAPFILEHEADER) + 
+         sizeof(BITMAPINFOHEADER);
+      DWORD masks[3];
+
+      if(!file.Contains(masksOffset, sizeof(masks)))
+      {
+         sprintf(message, "The file %s is incomplete.", file.GetFileName());
+         throw new Exception(message, EC_BMBITMAPLOAD, ET_BITMAP,
+            __FILE__, __LINE__);
+      }
+
+      memcpy(masks, file.GetData() + masksOffset, sizeof(masks));
+
+      if(masks[0] != 0x00FF0000 || masks[1] != 0x0000FF00 || 
+         masks[2] != 0x000000FF)
+      {
+         sprintf(message, "%s: the pixel format cannot be loaded.", 
+            file.GetFileName());
+         throw new Exception(message, EC_BMBITMAPLOAD, ET_BITMAP,
+            __FILE__, __LINE__);
+      }
+   }
+
+   //We don't want compressed bitmaps
+   else if(bmih.biCompression != BI_RGB)
+   {
+      sprintf(message, "%s: compressed bitmaps cannot be loaded.", 
+         file.GetFileName());
+      throw new Exception(message, EC_BMBITMAPLOAD, ET_BITMAP,
+         __FILE__, __LINE__);
+   }
+
+   LONG bytesPerLine;
+   UINT length;
+   UINT offset = FindFileLines(file, rect, bytesPerLine, length);
+
+   if(!file.Contains(offset, length))
+   {
+      sprintf(message, "The file %s is incomplete.", file.GetFileName());
+      throw new Exception(message, EC_BMBITMAPLOAD, ET_BITMAP,
          __FILE__, __LINE__);
    }
+}
+
+//Finds where the lines of an area start in a file and how many bytes
+//there are from one line to the next. The lines are next to each other,
+//and length is the number of bytes from the first pixel of the first 
+//line in the file to the last pixel of the last line.
+UINT Bitmap::FindFileLines(BitmapFile& file, Area& rect, 
+   LONG& bytesPerLine, UINT& length)
+{
+   BITMAPINFOHEADER& bmih = file.GetInfoHeader();
+   int pixelSize = bmih.biBitCount / 8;
+
+   //Bitmaps have padding so that the end of each scanline is on the
+   //32-bit boundary
+   bytesPerLine = ((bmih.biWidth * pixelSize) + 3) & ~3;
+
+   int firstFileLine = file.IsTopDown() ? rect.top : 
+      abs(bmih.biHeight) - (rect.top + rect.height);
+
+   length = ((rect.height - 1) * bytesPerLine) + (rect.width * pixelSize);
+
+   return file.GetFileHeader().bfOffBits + (firstFileLine * bytesPerLine) +
+      (rect.left * pixelSize);
+}
+
+//Converts the 24-bit pixels of an area of a file straight from the 
+//mapped file. This doesn't use the bitmap or the graphics object, so it
+//can run on any thread that has its own convert tables.
+void Bitmap::DecodeLines(BitmapFile& file, Area& rect, UCHAR* dest, 
+   LONG destPitch, ConvertKernel convertLine, ConvertTables* tables)
+{
+   LONG bytesPerLine;
+   UINT length;
+   UCHAR* fileLines = file.GetData() + 
+      FindFileLines(file, rect, bytesPerLine, length);
+   bool topDown = file.IsTopDown();
+
+   for(int i = 0; i < rect.height; i++)
+   {
+      int y = topDown ? i : (rect.height - 1) - i;
+
+      convertLine(dest + (y * destPitch), fileLines + (i * bytesPerLine), 
+         rect.width, tables);
+   }
+}
+
+//Multiplies the color channels of a 32-bit pixel by its alpha, rounding
+//to the nearest integer
+static inline UINT PremultiplyPixel(UINT pixel)
+{
+   UINT alpha = pixel >> 24;
+   UINT result = pixel & 0xFF000000;
+
+   for(int shift = 0; shift < 24; shift += 8)
+   {
+      UINT channel = (((pixel >> shift) & 0xFF) * alpha) + 128;
+      result |= ((channel + (channel >> 8)) >> 8) << shift;
+   }
+
+   return result;
+}
+
+//Copies the 32-bit pixels of an area of a file into a 32-bit pixel 
+//buffer, multiplying the colors by the alpha unless the file has been
+//saved that way. Like DecodeLines(), this can run on any thread.
+void Bitmap::DecodeAlphaLines(BitmapFile& file, Area& rect, 
+   PixelBuffer* dest, bool premultiplied)
+{
+   LONG bytesPerLine;
+   UINT length;
+   UCHAR* fileLines = file.GetData() + 
+      FindFileLines(file, rect, bytesPerLine, length);
+   bool topDown = file.IsTopDown();
+
+   //The pixels in the file are laid out like the pixels of the buffer
+   for(int i = 0; i < rect.height; i++)
+   {
+      int y = topDown ? i : (rect.height - 1) - i;
+
+      UINT* line = (UINT*)dest->GetScanLine(y);
+      UINT* source = (UINT*)(fileLines + (i * bytesPerLine));
+
+      if(premultiplied)
+         memcpy(line, source, rect.width * 4);
+      else
+      {
+         for(int x = 0; x < rect.width; x++)
+            line[x] = PremultiplyPixel(source[x]);
+      }
+   }
+}
 
-   BITMAPINFOHEADER bmih;
-   bitmapFile.read((char*)&bmih, sizeof(bmih));
-   bitmapFile.close();
+//Locks the DirectDraw surface or returns the bits of the pixel buffer
+//that the bitmap is loaded into
+UCHAR* Bitmap::LockBits(LONG& pitch)
+{
+   HRESULT result = DD_OK;
+   DDSURFACEDESC2 ddsd;
+   memset(&ddsd, 0, sizeof(ddsd));
+   ddsd.dwSize = sizeof(ddsd);
 
-   return Point(bmih.biWidth, bmih.biHeight);
-}
\ No newline at end of file
+   if(bitmapBuffer != NULL)
+   {
+      ddsd.lpSurface = bitmapBuffer->GetBits();
+      ddsd.lPitch = bitmapBuffer->GetPitch();
+   }
+
+   else
+      result = lpDDSBitmap->Lock(NULL, &ddsd, DDLOCK_SURFACEMEMORYPTR |
+         DDLOCK_WAIT, NULL);
+
+   switch(result)
+   {
+      case DDERR_SURFACELOST:
+         lpDDSBitmap->Restore();
+         result = lpDDSBitmap->Lock(NULL, &ddsd, DDLOCK_SURFACEMEMORYPTR |
+            DDLOCK_WAIT, NULL);
+         if(result != DD_OK)
+            dgGraphics->HandleDDrawError(EC_DDLOCKSURFACE, result, 
+               __FILE__, __LINE__);
+         break;
+      case DD_OK:
+         break;
+      default:
+         lpDDSBitmap->Unlock(NULL);
+         dgGraphics->HandleDDrawError(EC_DDLOCKSURFACE, result, 
+            __FILE__, __LINE__);
+         break;
+   }
+
+#ifdef _DEBUG
+   if(lpDDSBitmap != NULL)
+      lpDDSBitmap->Unlock(NULL);
+#endif
+
+   pitch = ddsd.lPitch;
+   return (UCHAR*)ddsd.lpSurface;
+}
+
+void Bitmap::UnlockBits(void)
+{
+#ifndef _DEBUG
+   if(lpDDSBitmap != NULL)
+      lpDDSBitmap->Unlock(NULL);
+#endif
+}
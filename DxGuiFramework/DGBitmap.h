@@ -7,12 +7,42 @@ Version:
    1.0.0    25.02.2001  Created the file
    2.0.0    02.06.2002  Changed the file to use namespaces and adapt
       to Visual Studio .NET
+   2.1.0    18.08.2002  Added bitmaps with an alpha channel
+   2.2.0    01.09.2002  Added the run-length encoded copy of the pixel
+      buffer, which is used for transparent blits
+   2.3.0    20.10.2002  Bitmaps are loaded from mapped bitmap files
+   2.4.0    27.10.2002  Bitmaps can be loaded on the threads of the 
+      bitmap loader
+   2.5.0    03.11.2002  Small bitmaps can be packed into bitmap atlases
+   2.6.0    17.11.2002  Bitmaps keep track of when and how often they
+      are drawn
+   2.7.0    24.11.2002  Bitmaps are copied from the asset pack when it
+      has them
+   2.8.0    01.12.2002  Areas of a file can be loaded as views of a 
+      sheet that holds the whole file
+   2.9.0    08.12.2002  Bitmaps keep scaled copies of themselves for the
+      sizes they are drawn at
+   2.10.0   15.12.2002  Added tiled bitmaps, which only load the tiles
+      that are drawn
 ------------------------------------------------------------------------*/
 
 #pragma once
 
+//The most scaled copies a bitmap keeps. When another size is needed,
+//the copy that hasn't been drawn for the longest time is replaced.
+#define BM_MAX_SCALED_COPIES     4
+
+//The width and height of the tiles of a tiled bitmap, and how many tiles
+//it keeps loaded. More tiles stay loaded if they are all drawn in the
+//same frame.
+#define BM_TILE_SIZE             128
+#define BM_MAX_TILES             32
+
 namespace DG
 {
+   class BitmapLoad;
+   class BitmapAtlas;
+
    class Bitmap
    {
    public:
@@ -35,29 +65,126 @@ namespace DG
       char* const GetFileName(void) {return fileName;}
       Point GetDimensions(void) {return Point(width, height);}
       bool IsLoaded(void) {return isLoaded;}
+      bool IsLoadPending(void) {return loadPending;}
       int GetWidth(void) {return width;}
       int GetHeight(void) {return height;}
+      UINT GetMemoryUsage(void) {return memoryUsage;}
+
+      //Packed bitmaps are loaded into a shared atlas if they are small
+      //enough. The surface of a packed bitmap is the surface of its 
+      //atlas, and the source rectangle is where the bitmap is in it.
+      void SetPacked(bool pack) {packed = pack;}
+      bool IsPacked(void) {return packed;}
+      BitmapAtlas* GetAtlas(void) {return atlas;}
+      RECT* GetSourceRect(void) {return (atlas != NULL) ? &atlasRect : NULL;}
+
+      //A view is an area of a file that is drawn from the sheet of the
+      //file, which all the views of the file share instead of each 
+      //copying its area. Like a packed bitmap, its atlas is the sheet
+      //and the source rectangle is the area.
+      void SetView(bool isView) {view = isView;}
+      bool IsView(void) {return view;}
+
+      //The bitmap list marks a bitmap as used whenever it is drawn, and
+      //removes the bitmaps that haven't been used for the longest time
+      //first. The usage index is the position of the bitmap in the usage
+      //heap of the list, or -1 if the bitmap is not in it.
+      void MarkUsed(UINT frame) {lastUsedFrame = frame; numOfUses++;}
+      void SetLastUsedFrame(UINT frame) {lastUsedFrame = frame;}
+      UINT GetLastUsedFrame(void) {return lastUsedFrame;}
+      UINT GetNumOfUses(void) {return numOfUses;}
+      void SetUsageIndex(int index) {usageIndex = index;}
+      int GetUsageIndex(void) {return usageIndex;}
+
+      //Scaled copies are bitmaps that hold this bitmap scaled to a size
+      //with a filter, so that drawing it at that size again is a plain
+      //blit. A copy is only made once the same size has been asked for
+      //twice within the last few sizes that had no copy, so that a 
+      //bitmap that is scaled to a new size every frame, such as while a
+      //window is being resized, doesn't make copies that are never drawn
+      //again.
+      Bitmap* FC FindScaledCopy(int scaledWidth, int scaledHeight,
+         UINT filter);
+      bool FC IsScaledCopyWanted(int scaledWidth, int scaledHeight,
+         UINT filter);
+      Bitmap* FC AddScaledCopy(int scaledWidth, int scaledHeight,
+         UINT filter, ScaleSetup& setup);
+      void FC DestroyScaledCopies(void);
+
+      //A tiled bitmap has no surface of its own. It is split into tiles
+      //of BM_TILE_SIZE pixels, which are bitmaps that are loaded from 
+      //the file when they are drawn, so that only the part of a large
+      //bitmap that can be seen is in memory. The memory of the bitmap is
+      //the memory of its loaded tiles.
+      bool IsTiled(void) {return tiled;}
+      int GetNumOfTileColumns(void) {return numOfTileColumns;}
+      int GetNumOfTileRows(void) {return numOfTileRows;}
+      Bitmap* FC GetTile(int column, int row);
 
       LPDIRECTDRAWSURFACE7 GetDDSurface(void);
+      PixelBuffer* GetPixelBuffer(void);
+      RunLengthSprite* GetRunLengthSprite(void);
       void FC SetTransparentColor(Color& color);
+      Color& GetTransparentColor(void) {return transparentColor;}
+
+      //Bitmaps with an alpha channel, which are loaded from 32-bit files
+      bool HasAlpha(void) {return alphaChannel;}
+      PixelBuffer* GetAlphaBuffer(void);
+      void SetPremultipliedAlpha(bool premultiplied)
+      {premultipliedAlpha = premultiplied;}
+      bool IsPremultipliedAlpha(void) {return premultipliedAlpha;}
 
       void FC LoadBitmap(UINT resourceID);
       void FC LoadBitmap(UINT resourceID, Area& bitmapDimensions);
       void FC LoadBitmap(const char* bitmapFileName);
       void FC LoadBitmap(const char* bitmapFileName, 
          Area& bitmapDimensions);
+      void FC LoadTiledBitmap(const char* bitmapFileName);
       void FC DestroyBitmap(void);
       void FC ReloadBitmap(void);
       void FC RestoreBitmap(void);
+      void FC ReloadAtlasArea(void);
+
+      //Loading a bitmap on another thread: BeginAsyncLoad() reads the
+      //size of the bitmap and makes the load for the bitmap loader, and
+      //FinishAsyncLoad() takes the pixels that the loader decoded
+      BitmapLoad* FC BeginAsyncLoad(const char* bitmapFileName);
+      void FC FinishAsyncLoad(PixelBuffer* pixels);
+
+      static void CheckFile(BitmapFile& file, Area& rect);
+      static void DecodeLines(BitmapFile& file, Area& rect, UCHAR* dest,
+         LONG destPitch, ConvertKernel convertLine, 
+         ConvertTables* tables);
+      static void DecodeAlphaLines(BitmapFile& file, Area& rect, 
+         PixelBuffer* dest, bool premultiplied);
 
    private:
-      void LoadBitmapFromFile(Area& rect, const char* bitmapFileName);
-      Point FindBitmapSize(const char* bitmapFileName);
+      void CreateSurface(int surfaceWidth, int surfaceHeight, 
+         bool alpha = false);
+      void LoadFromFile(BitmapFile& file, Area& rect);
+      void LoadArea(const char* bitmapFileName, Area& rect);
+      bool LoadView(const char* bitmapFileName, Area& rect);
+      void LoadFromPack(UCHAR* pixels, LONG pitch, Area& rect);
+      void CopyToAtlas(BitmapFile& file, Area& rect);
+      void CopyFromPack(UCHAR* pixels, LONG pitch, Area& rect, 
+         UCHAR* dest, LONG destPitch);
+      UCHAR* LockBits(LONG& pitch);
+      void UnlockBits(void);
+      bool RemoveLeastRecentlyUsedTile(UINT frame);
+      void DestroyTiles(void);
+      void FC SetMemoryUsage(UINT memory);
+
+      static UINT FindFileLines(BitmapFile& file, Area& rect, 
+         LONG& bytesPerLine, UINT& length);
 
       UINT id;
       UINT priority;
 
       bool isLoaded;
+
+      //Whether the bitmap loader is decoding the bitmap, which is drawn
+      //as a placeholder until it is done
+      bool loadPending;
       bool useDimensions;
       bool resourceBitmap;
       char fileName[128];
@@ -76,6 +203,63 @@ namespace DG
       //DirectDraw surface: stores the loaded bitmap
       LPDIRECTDRAWSURFACE7 lpDDSBitmap;
 
+      //Pixel buffer: stores the loaded bitmap with the software backend
+      PixelBuffer* bitmapBuffer;
+
+      //The runs of opaque pixels in the pixel buffer, which are found 
+      //whenever the transparent color is set
+      RunLengthSprite* runLengthSprite;
+
+      //Pixel buffer: stores a bitmap with an alpha channel as 
+      //premultiplied 32-bit pixels. Blending has to read the destination,
+      //so these bitmaps are always kept in system memory.
+      PixelBuffer* alphaBuffer;
+      bool alphaChannel;
+
+      //Whether the colors in the file have already been multiplied by
+      //the alpha
+      bool premultipliedAlpha;
+
+      //The atlas that the bitmap is packed into and its area in the 
+      //atlas, with an exclusive right and bottom, or NULL if the bitmap
+      //has a surface of its own
+      bool packed;
+      bool view;
+      BitmapAtlas* atlas;
+      RECT atlasRect;
+
+      //The bytes of the surface of the bitmap, or of its share of an
+      //atlas, and how much of it is counted in the bitmap memory of the
+      //graphics object
       UINT memoryUsage;
+      UINT countedMemory;
+
+      //The frame the bitmap was last drawn in and how many times it has
+      //been drawn
+      UINT lastUsedFrame;
+      UINT numOfUses;
+      int usageIndex;
+
+      //The scaled copies and their filters, and the sizes and filters of
+      //the last scaled draws that had no copy, with the oldest one 
+      //replaced next
+      Bitmap* scaledCopies[BM_MAX_SCALED_COPIES];
+      UINT scaledFilters[BM_MAX_SCALED_COPIES];
+      int numOfScaledCopies;
+      int missedWidths[BM_MAX_SCALED_COPIES];
+      int missedHeights[BM_MAX_SCALED_COPIES];
+      UINT missedFilters[BM_MAX_SCALED_COPIES];
+      int numOfMissedSizes;
+      int nextMissedSize;
+
+      //The tiles of a tiled bitmap, row by row, which are NULL until 
+      //they are loaded. The file stays open while the bitmap is loaded,
+      //so that it is only mapped once for all the tiles.
+      bool tiled;
+      Bitmap** tiles;
+      int numOfTileColumns;
+      int numOfTileRows;
+      int numOfLoadedTiles;
+      BitmapFile* tileFile;
    };
 }
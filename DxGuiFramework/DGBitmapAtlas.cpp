@@ -0,0 +1,457 @@
+/*------------------------------------------------------------------------
+File Name: DGBitmapAtlas.cpp
+Description: This file contains the implementation of the 
+   DG::BitmapAtlas class, which is a surface that many small bitmaps are
+   packed into, or a sheet that bitmaps are views of.
+Version:
+   1.0.0    03.11.2002  Created the file
+   1.1.0    01.12.2002  Added sheets
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+
+using namespace DG;
+
+/*Constructor*/
+BitmapAtlas::BitmapAtlas()
+{
+   lpDDSAtlas = NULL;
+   atlasBuffer = NULL;
+
+   atlasWidth = BA_ATLAS_SIZE;
+   atlasHeight = BA_ATLAS_SIZE;
+   fileName[0] = '\0';
+
+   maxNumOfShelves = 16;
+   shelves = new AtlasShelf[maxNumOfShelves];
+   numOfShelves = 0;
+
+   maxNumOfFreeRects = 16;
+   freeRects = new RECT[maxNumOfFreeRects];
+   numOfFreeRects = 0;
+
+   bottom = 0;
+   numOfBitmaps = 0;
+   memoryUsage = 0;
+}
+
+/*Constructor: a sheet of the given bitmap file, whose size is known once
+it is loaded*/
+BitmapAtlas::BitmapAtlas(const char* sheetFileName)
+{
+   lpDDSAtlas = NULL;
+   atlasBuffer = NULL;
+
+   atlasWidth = 0;
+   atlasHeight = 0;
+   strcpy(fileName, sheetFileName);
+
+   //Nothing is packed into a sheet
+   maxNumOfShelves = 1;
+   shelves = new AtlasShelf[maxNumOfShelves];
+   numOfShelves = 0;
+
+   maxNumOfFreeRects = 0;
+   freeRects = NULL;
+   numOfFreeRects = 0;
+
+   bottom = 0;
+   numOfBitmaps = 0;
+   memoryUsage = 0;
+}
+
+/*Destructor*/
+BitmapAtlas::~BitmapAtlas()
+{
+   DestroySurface();
+   delete[] shelves;
+   delete[] freeRects;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Allocate
+Parameters:
+   int width : the width of the bitmap
+   int height : the height of the bitmap
+   RECT& rect : receives the area of the bitmap in the atlas, with an 
+      exclusive right and bottom
+Returns:
+   true if the bitmap was given an area, false if the atlas is too full
+Description:
+   This function packs a bitmap into the atlas. The bitmap goes into the
+   smallest released area that it fits in, so that a bitmap that is 
+   unloaded and loaded again gets its old area back. Otherwise it goes
+   into the shelf with the least height that it fits in, so that little
+   space is left over above it, or into a new shelf if none of them has
+   room. The surface of the atlas is created when the first bitmap is 
+   packed. Nothing is packed into a sheet.
+------------------------------------------------------------------------*/
+
+bool FC BitmapAtlas::Allocate(int width, int height, RECT& rect)
+{
+   if(IsSheet())
+      return false;
+
+   assert(width > 0 && width <= BA_ATLAS_SIZE && 
+      height > 0 && height <= BA_ATLAS_SIZE);
+
+   if(!IsCreated())
+      CreateSurface();
+
+   int bestFree = -1;
+   int bestFreeSize = 0;
+
+   for(int i = 0; i < numOfFreeRects; i++)
+   {
+      RECT& free = freeRects[i];
+      int freeWidth = free.right - free.left;
+      int freeHeight = free.bottom - free.top;
+
+      if(freeWidth >= width && freeHeight >= height &&
+         (bestFree == -1 || freeWidth * freeHeight < bestFreeSize))
+      {
+         bestFree = i;
+         bestFreeSize = freeWidth * freeHeight;
+      }
+   }
+
+   if(bestFree != -1)
+   {
+      RECT& free = freeRects[bestFree];
+      SetRect(&rect, free.left, free.top, free.left + width, 
+         free.top + height);
+
+      freeRects[bestFree] = freeRects[--numOfFreeRects];
+      numOfBitmaps++;
+
+      return true;
+   }
+
+   AtlasShelf* best = NULL;
+
+   for(int i = 0; i < numOfShelves; i++)
+   {
+      AtlasShelf& shelf = shelves[i];
+
+      if(shelf.height >= height && shelf.right + width <= BA_ATLAS_SIZE &&
+         (best == NULL || shelf.height < best->height))
+         best = &shelf;
+   }
+
+   if(best == NULL)
+   {
+      if(bottom + height > BA_ATLAS_SIZE)
+         return false;
+
+      if(numOfShelves == maxNumOfShelves)
+      {
+         AtlasShelf* newShelves = new AtlasShelf[maxNumOfShelves * 2];
+         memcpy(newShelves, shelves, maxNumOfShelves * sizeof(AtlasShelf));
+         delete[] shelves;
+
+         shelves = newShelves;
+         maxNumOfShelves *= 2;
+      }
+
+      best = &shelves[numOfShelves++];
+      best->top = bottom;
+      best->height = height;
+      best->right = 0;
+
+      bottom += height;
+   }
+
+   SetRect(&rect, best->right, best->top, best->right + width, 
+      best->top + height);
+   best->right += width;
+
+   numOfBitmaps++;
+
+   return true;
+}
+
+/*------------------------------------------------------------------------
+Function Name: AddView
+Parameters:
+   Area& area : the area of the file that the bitmap is
+   RECT& rect : receives the area of the bitmap in the sheet, with an 
+      exclusive right and bottom
+Returns:
+   true if the bitmap is a view of the sheet, false if the file has an
+   alpha channel or the area is not inside it
+Description:
+   This function makes a bitmap a view of an area of the sheet, so that
+   it is drawn from the surface of the sheet like a packed bitmap is
+   drawn from its atlas. The whole file is loaded into the surface when
+   the first view is added, and every view of the sheet shares it. A 
+   bitmap that can't be a view has to be loaded into a surface of its 
+   own.
+------------------------------------------------------------------------*/
+
+bool FC BitmapAtlas::AddView(Area& area, RECT& rect)
+{
+   assert(IsSheet());
+
+   if(!IsCreated() && !LoadSheet())
+      return false;
+
+   //The right and bottom of an area are inclusive
+   int right = area.left + area.width;
+   int bottom = area.top + area.height;
+
+   if(area.left < 0 || area.top < 0 || area.width <= 0 || 
+      area.height <= 0 || right > atlasWidth || bottom > atlasHeight)
+   {
+      if(numOfBitmaps == 0)
+         DestroySurface();
+
+      return false;
+   }
+
+   SetRect(&rect, area.left, area.top, right, bottom);
+   numOfBitmaps++;
+
+   return true;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Release
+Parameters:
+   RECT& rect : the area of the bitmap in the atlas
+Description:
+   This function is called when a bitmap in the atlas is destroyed. Its
+   area is kept so that another bitmap can be packed into it. When the
+   last bitmap is gone, the surface is freed and the atlas is packed 
+   from the start again.
+------------------------------------------------------------------------*/
+
+void FC BitmapAtlas::Release(RECT& rect)
+{
+   assert(numOfBitmaps > 0);
+
+   if(--numOfBitmaps == 0)
+   {
+      DestroySurface();
+
+      numOfShelves = 0;
+      numOfFreeRects = 0;
+      bottom = 0;
+      return;
+   }
+
+   //The views of a sheet don't take up any of it
+   if(IsSheet())
+      return;
+
+   if(numOfFreeRects == maxNumOfFreeRects)
+   {
+      RECT* newFreeRects = new RECT[maxNumOfFreeRects * 2];
+      memcpy(newFreeRects, freeRects, maxNumOfFreeRects * sizeof(RECT));
+      delete[] freeRects;
+
+      freeRects = newFreeRects;
+      maxNumOfFreeRects *= 2;
+   }
+
+   freeRects[numOfFreeRects++] = rect;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Lock
+Parameters:
+   LONG& pitch : receives the number of bytes from one line to the next
+Returns:
+   The pixels of the atlas
+Description:
+   This function locks the DirectDraw surface of the atlas or returns
+   the bits of its pixel buffer, so that a bitmap can be loaded into it.
+------------------------------------------------------------------------*/
+
+UCHAR* FC BitmapAtlas::Lock(LONG& pitch)
+{
+   if(atlasBuffer != NULL)
+   {
+      pitch = atlasBuffer->GetPitch();
+      return atlasBuffer->GetBits();
+   }
+
+   DDSURFACEDESC2 ddsd;
+   memset(&ddsd, 0, sizeof(ddsd));
+   ddsd.dwSize = sizeof(ddsd);
+
+   HRESULT result = lpDDSAtlas->Lock(NULL, &ddsd, DDLOCK_SURFACEMEMORYPTR |
+      DDLOCK_WAIT, NULL);
+
+   if(result == DDERR_SURFACELOST)
+   {
+      Restore();
+      result = lpDDSAtlas->Lock(NULL, &ddsd, DDLOCK_SURFACEMEMORYPTR |
+         DDLOCK_WAIT, NULL);
+   }
+
+   if(result != DD_OK)
+      dgGraphics->HandleDDrawError(EC_DDLOCKSURFACE, result, 
+         __FILE__, __LINE__);
+
+   pitch = ddsd.lPitch;
+   return (UCHAR*)ddsd.lpSurface;
+}
+
+void FC BitmapAtlas::Unlock(void)
+{
+   if(lpDDSAtlas != NULL)
+      lpDDSAtlas->Unlock(NULL);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Restore
+Parameters:
+Description:
+   This function restores the DirectDraw surface of the atlas after it
+   has been lost. After the graphics mode has changed, the surface can't
+   be restored, so it is made again in the pixel format of the new mode.
+   Either way the bitmaps in the atlas are loaded into it again, which
+   for a sheet loads the areas of the file that are still used.
+------------------------------------------------------------------------*/
+
+void FC BitmapAtlas::Restore(void)
+{
+   if(lpDDSAtlas == NULL || lpDDSAtlas->IsLost() != DDERR_SURFACELOST)
+      return;
+
+   HRESULT result = lpDDSAtlas->Restore();
+
+   switch(result)
+   {
+      case DD_OK:
+         break;
+      case DDERR_WRONGMODE:
+         DestroySurface();
+         CreateSurface();
+         break;
+      default:
+         dgGraphics->HandleDDrawError(EC_DDRESTORESURFACES, result, 
+            __FILE__, __LINE__);
+   }
+
+   dgGraphics->ReloadAtlasBitmaps(this);
+}
+
+//Loads the whole file of a sheet into a new surface, from the asset 
+//pack if it has the file. Returns false if the file has an alpha 
+//channel, since the views of it would have to be blended.
+bool FC BitmapAtlas::LoadSheet(void)
+{
+   Point size;
+   LONG packPitch;
+   UCHAR* packPixels = dgGraphics->FindPackedPixels(fileName, size, 
+      packPitch);
+
+   LONG pitch;
+   UCHAR* bits;
+
+   if(packPixels != NULL)
+   {
+      atlasWidth = size.x;
+      atlasHeight = size.y;
+      CreateSurface();
+
+      int lineSize = atlasWidth * dgGraphics->bytesPerPixel;
+      bits = Lock(pitch);
+
+      for(int i = 0; i < atlasHeight; i++)
+         memcpy(bits + (i * pitch), packPixels + (i * packPitch), lineSize);
+
+      Unlock();
+      return true;
+   }
+
+   BitmapFile* file = BitmapFile::Open(fileName);
+   size = file->GetBitmapSize();
+   Area rect(0, 0, size.x, size.y);
+
+   //The file is closed even if the sheet can't be loaded from it
+   try
+   {
+      Bitmap::CheckFile(*file, rect);
+
+      if(file->GetInfoHeader().biBitCount != 24)
+      {
+         BitmapFile::Close(file);
+         return false;
+      }
+
+      atlasWidth = size.x;
+      atlasHeight = size.y;
+      CreateSurface();
+
+      bits = Lock(pitch);
+      Bitmap::DecodeLines(*file, rect, bits, pitch, 
+         dgGraphics->spanKernels.ConvertLine, 
+         &dgGraphics->spanKernels.convertTables);
+      Unlock();
+   }
+   catch(...)
+   {
+      DestroySurface();
+      BitmapFile::Close(file);
+      throw;
+   }
+
+   BitmapFile::Close(file);
+   return true;
+}
+
+//Creates the surface of the atlas in the pixel format of the screen
+void FC BitmapAtlas::CreateSurface(void)
+{
+   if(dgGraphics->GetRenderBackend() == RB_SOFTWARE)
+   {
+      atlasBuffer = new PixelBuffer(atlasWidth, atlasHeight,
+         dgGraphics->GetBytesPerPixel());
+
+      memoryUsage = atlasBuffer->GetMemoryUsage();
+      dgGraphics->bitmapMemory += memoryUsage;
+      return;
+   }
+
+   DDSURFACEDESC2 ddsd;
+   memset(&ddsd, 0, sizeof(ddsd));
+   ddsd.dwSize = sizeof(ddsd);    
+   ddsd.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH; 
+   ddsd.ddsCaps.dwCaps = DDSCAPS_OFFSCREENPLAIN; 
+   ddsd.dwWidth = atlasWidth; 
+   ddsd.dwHeight = atlasHeight; 
+   
+   HRESULT result = dgGraphics->lpDD->CreateSurface(&ddsd, &lpDDSAtlas, 
+      NULL); 
+
+   if(result != DD_OK)
+      dgGraphics->HandleDDrawError(EC_DDSETGRAPHMODE, result, 
+         __FILE__, __LINE__);
+
+   memset(&ddsd, 0, sizeof(ddsd));
+   ddsd.dwSize = sizeof(ddsd); 
+   lpDDSAtlas->GetSurfaceDesc(&ddsd);
+
+   memoryUsage = ddsd.lPitch * ddsd.dwHeight;
+   dgGraphics->bitmapMemory += memoryUsage;
+}
+
+void FC BitmapAtlas::DestroySurface(void)
+{
+   if(lpDDSAtlas != NULL)
+   {
+      lpDDSAtlas->Release();
+      lpDDSAtlas = NULL;
+   }
+
+   if(atlasBuffer != NULL)
+   {
+      delete atlasBuffer;
+      atlasBuffer = NULL;
+   }
+
+   dgGraphics->bitmapMemory -= memoryUsage;
+   memoryUsage = 0;
+}
@@ -0,0 +1,98 @@
+/*------------------------------------------------------------------------
+File Name: DGBitmapAtlas.h
+Description: This file contains the DG::BitmapAtlas class, which is a
+   surface that many small bitmaps are packed into, so that they don't
+   each need a surface of their own. An atlas can also be a sheet, which
+   holds a whole bitmap file that bitmaps are views of.
+Version:
+   1.0.0    03.11.2002  Created the file
+   1.1.0    01.12.2002  Added sheets, whose bitmaps are areas of one file
+      that share its surface instead of each having a copy
+------------------------------------------------------------------------*/
+
+#pragma once
+
+//The width and height of an atlas in pixels
+#define BA_ATLAS_SIZE         256
+
+//The largest width or height of a bitmap that is packed into an atlas.
+//Larger bitmaps get a surface of their own.
+#define BA_MAX_BITMAP_SIZE    64
+
+namespace DG
+{
+   //A row of the atlas that bitmaps are placed in from left to right.
+   //Each bitmap goes into the lowest shelf that it fits in.
+   class AtlasShelf
+   {
+   public:
+      int top;
+      int height;
+
+      //Where the next bitmap on the shelf goes
+      int right;
+   };
+
+   class BitmapAtlas
+   {
+   public:
+      BitmapAtlas();
+      BitmapAtlas(const char* sheetFileName);
+      virtual ~BitmapAtlas();
+
+      bool FC Allocate(int width, int height, RECT& rect);
+      bool FC AddView(Area& area, RECT& rect);
+      void FC Release(RECT& rect);
+
+      //A sheet is loaded from its file when the first view of it is
+      //added, and has the size of the file
+      bool IsSheet(void) {return fileName[0] != '\0';}
+      const char* GetFileName(void) {return fileName;}
+
+      int GetNumOfBitmaps(void) {return numOfBitmaps;}
+      bool IsCreated(void) {return lpDDSAtlas != NULL || atlasBuffer != NULL;}
+      UINT GetMemoryUsage(void) {return memoryUsage;}
+
+      LPDIRECTDRAWSURFACE7 GetDDSurface(void) {return lpDDSAtlas;}
+      PixelBuffer* GetPixelBuffer(void) {return atlasBuffer;}
+
+      UCHAR* FC Lock(LONG& pitch);
+      void FC Unlock(void);
+      void FC Restore(void);
+
+   private:
+      bool FC LoadSheet(void);
+      void FC CreateSurface(void);
+      void FC DestroySurface(void);
+
+      //The surface of the atlas: a DirectDraw surface or, with the 
+      //software backend, a pixel buffer
+      LPDIRECTDRAWSURFACE7 lpDDSAtlas;
+      PixelBuffer* atlasBuffer;
+
+      //The size of the surface, and the file of a sheet, which is empty
+      //for an atlas that bitmaps are packed into
+      int atlasWidth;
+      int atlasHeight;
+      char fileName[MAX_PATH];
+
+      AtlasShelf* shelves;
+      int numOfShelves;
+      int maxNumOfShelves;
+
+      //Where the next shelf starts
+      int bottom;
+
+      //The areas of released bitmaps, which are given to bitmaps that 
+      //fit in them before the shelves are used
+      RECT* freeRects;
+      int numOfFreeRects;
+      int maxNumOfFreeRects;
+
+      //The number of bitmaps that have an area in the atlas. The surface
+      //is freed when no bitmaps are left.
+      int numOfBitmaps;
+
+      UINT memoryUsage;
+   };
+}
@@ -0,0 +1,299 @@
+/*------------------------------------------------------------------------
+File Name: DGBitmapFile.cpp
+Description: This file contains the implementation of the DG::BitmapFile
+   class, which maps a bitmap file into memory.
+Version:
+   1.0.0    20.10.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+
+using namespace DG;
+
+BitmapFile* BitmapFile::firstFile = NULL;
+UINT BitmapFile::numOfUnusedFiles = 0;
+UINT BitmapFile::releaseCount = 0;
+
+//Constructor
+BitmapFile::BitmapFile()
+{
+   fileName[0] = '\0';
+   fileHandle = INVALID_HANDLE_VALUE;
+   mappingHandle = NULL;
+   data = NULL;
+   size = 0;
+
+   memset(&fileHeader, 0, sizeof(fileHeader));
+   memset(&infoHeader, 0, sizeof(infoHeader));
+
+   refCount = 0;
+   releaseTime = 0;
+   next = NULL;
+}
+
+//Destructor
+BitmapFile::~BitmapFile()
+{
+   if(data != NULL)
+      UnmapViewOfFile(data);
+
+   if(mappingHandle != NULL)
+      CloseHandle(mappingHandle);
+
+   if(fileHandle != INVALID_HANDLE_VALUE)
+      CloseHandle(fileHandle);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Open
+Parameters:
+   const char* fileName : the name of the bitmap file
+Returns:
+   The mapped file, which must be given to Close() when the bitmap has
+   been loaded
+Description:
+   This function finds the file among the files that are already 
+   mapped, or maps it and reads its headers. An exception is thrown if
+   the file can't be opened or isn't a bitmap file.
+------------------------------------------------------------------------*/
+
+BitmapFile* FC BitmapFile::Open(const char* fileName)
+{
+   BitmapFile* file = Find(fileName);
+
+   if(file == NULL)
+   {
+      file = Map(fileName);
+
+      if(file == NULL)
+      {
+         char message[MAX_PATH + 64];
+         sprintf(message, "The file %s could not be opened.", fileName);
+         throw new Exception(message, EC_BMBITMAPLOAD, ET_BITMAP,
+            __FILE__, __LINE__);
+      }
+   }
+
+   Reference(file);
+
+   //If file is not a bitmap, Error
+   if(file->fileHeader.bfType != 0x4D42)
+   {
+      Close(file);
+
+      char message[MAX_PATH + 64];
+      sprintf(message, "The file %s is not a bitmap file.", fileName);
+      throw new Exception(message, EC_BMBITMAPLOAD, ET_BITMAP,
+         __FILE__, __LINE__);
+   }
+
+   return file;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Close
+Parameters:
+   BitmapFile* file : a file returned by Open()
+Description:
+   This function lets go of a file. When nothing is loading from it, it
+   stays mapped until too many unused files are mapped, and then the one
+   that was closed first is unmapped.
+------------------------------------------------------------------------*/
+
+void FC BitmapFile::Close(BitmapFile* file)
+{
+   assert(file->refCount > 0);
+
+   file->refCount--;
+
+   if(file->refCount > 0)
+      return;
+
+   file->releaseTime = ++releaseCount;
+   numOfUnusedFiles++;
+
+   if(numOfUnusedFiles <= BMPFILE_MAX_UNUSED)
+      return;
+
+   BitmapFile* oldestFile = NULL;
+
+   for(BitmapFile* unusedFile = firstFile; unusedFile != NULL; 
+      unusedFile = unusedFile->next)
+   {
+      if(unusedFile->refCount == 0 && (oldestFile == NULL || 
+         unusedFile->releaseTime < oldestFile->releaseTime))
+         oldestFile = unusedFile;
+   }
+
+   Unmap(oldestFile);
+}
+
+/*------------------------------------------------------------------------
+Function Name: CloseUnusedFiles
+Parameters:
+Description:
+   This function unmaps the files that are kept even though nothing is
+   loading from them, which also lets other programs write to them.
+------------------------------------------------------------------------*/
+
+void FC BitmapFile::CloseUnusedFiles(void)
+{
+   BitmapFile* file = firstFile;
+
+   while(file != NULL)
+   {
+      BitmapFile* nextFile = file->next;
+
+      if(file->refCount == 0)
+         Unmap(file);
+
+      file = nextFile;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Exists
+Parameters:
+   const char* fileName : the name of a bitmap file
+Returns:
+   true if the file exists, false if it does not
+Description:
+   A file that exists is usually loaded right afterwards, so it is 
+   mapped and kept with the unused files.
+------------------------------------------------------------------------*/
+
+bool FC BitmapFile::Exists(const char* fileName)
+{
+   if(Find(fileName) != NULL)
+      return true;
+
+   BitmapFile* file = Map(fileName);
+
+   if(file != NULL)
+   {
+      Reference(file);
+      Close(file);
+      return true;
+   }
+
+   //Empty files can't be mapped, but they still exist
+   DWORD attributes = GetFileAttributes(fileName);
+
+   return attributes != 0xFFFFFFFF && 
+      (attributes & FILE_ATTRIBUTE_DIRECTORY) == 0;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Reference
+Parameters:
+   BitmapFile* file : a mapped file
+Description:
+   This function counts one more load that is reading from the file.
+------------------------------------------------------------------------*/
+
+void FC BitmapFile::Reference(BitmapFile* file)
+{
+   if(file->refCount == 0)
+      numOfUnusedFiles--;
+
+   file->refCount++;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Find
+Parameters:
+   const char* fileName : the name of a bitmap file
+Returns:
+   The mapped file with that name, or NULL if it isn't mapped
+------------------------------------------------------------------------*/
+
+BitmapFile* FC BitmapFile::Find(const char* fileName)
+{
+   for(BitmapFile* file = firstFile; file != NULL; file = file->next)
+   {
+      if(_stricmp(file->fileName, fileName) == 0)
+         return file;
+   }
+
+   return NULL;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Map
+Parameters:
+   const char* fileName : the name of a bitmap file
+Returns:
+   The file, mapped and added to the mapped files as an unused file, or
+   NULL if it could not be mapped
+Description:
+   The headers are copied if the file is large enough to hold them. 
+   Whether they describe a bitmap is left to Open().
+------------------------------------------------------------------------*/
+
+BitmapFile* FC BitmapFile::Map(const char* fileName)
+{
+   if(strlen(fileName) >= MAX_PATH)
+      return NULL;
+
+   BitmapFile* file = new BitmapFile;
+   strcpy(file->fileName, fileName);
+
+   file->fileHandle = CreateFile(fileName, GENERIC_READ, FILE_SHARE_READ,
+      NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+   if(file->fileHandle != INVALID_HANDLE_VALUE)
+   {
+      file->size = GetFileSize(file->fileHandle, NULL);
+
+      if(file->size != 0 && file->size != 0xFFFFFFFF)
+         file->mappingHandle = CreateFileMapping(file->fileHandle, NULL,
+            PAGE_READONLY, 0, 0, NULL);
+   }
+
+   if(file->mappingHandle != NULL)
+      file->data = (UCHAR*)MapViewOfFile(file->mappingHandle, 
+         FILE_MAP_READ, 0, 0, 0);
+
+   if(file->data == NULL)
+   {
+      delete file;
+      return NULL;
+   }
+
+   if(file->size >= sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER))
+   {
+      memcpy(&file->fileHeader, file->data, sizeof(BITMAPFILEHEADER));
+      memcpy(&file->infoHeader, file->data + sizeof(BITMAPFILEHEADER),
+         sizeof(BITMAPINFOHEADER));
+   }
+
+   file->next = firstFile;
+   firstFile = file;
+   numOfUnusedFiles++;
+
+   return file;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Unmap
+Parameters:
+   BitmapFile* file : an unused mapped file
+Description:
+   This function removes the file from the mapped files and unmaps it.
+------------------------------------------------------------------------*/
+
+void FC BitmapFile::Unmap(BitmapFile* file)
+{
+   assert(file->refCount == 0);
+
+   BitmapFile** link = &firstFile;
+
+   while(*link != file)
+      link = &(*link)->next;
+
+   *link = file->next;
+
+   delete file;
+
+   numOfUnusedFiles--;
+}
@@ -0,0 +1,78 @@
+/*------------------------------------------------------------------------
+File Name: DGBitmapFile.h
+Description: This file contains the DG::BitmapFile class, which maps a
+   bitmap file into memory so that bitmaps can be decoded straight from
+   it. The mapped files are shared, so a file that many bitmaps are cut
+   out of is only opened and parsed once.
+Version:
+   1.0.0    20.10.2002  Created the file
+------------------------------------------------------------------------*/
+
+#pragma once
+
+//The number of mapped files that no bitmap is loading from which are
+//kept, so that the next bitmap cut out of the same file finds it mapped
+#define BMPFILE_MAX_UNUSED    4
+
+namespace DG
+{
+   class BitmapFile
+   {
+   public:
+      static BitmapFile* FC Open(const char* fileName);
+      static void FC Close(BitmapFile* file);
+      static void FC CloseUnusedFiles(void);
+      static bool FC Exists(const char* fileName);
+
+      const char* GetFileName(void) {return fileName;}
+      BITMAPFILEHEADER& GetFileHeader(void) {return fileHeader;}
+      BITMAPINFOHEADER& GetInfoHeader(void) {return infoHeader;}
+
+      //The size of the bitmap, which has a negative height in the file 
+      //when it is stored top-down
+      Point GetBitmapSize(void)
+      {return Point(infoHeader.biWidth, abs(infoHeader.biHeight));}
+      bool IsTopDown(void) {return infoHeader.biHeight < 0;}
+
+      //The bytes of the file, which can be read for as long as the file
+      //is open
+      UCHAR* GetData(void) {return data;}
+      UINT GetSize(void) {return size;}
+      bool Contains(UINT offset, UINT length)
+      {return offset <= size && length <= size - offset;}
+
+   private:
+      BitmapFile();
+      ~BitmapFile();
+
+      static void FC Reference(BitmapFile* file);
+      static BitmapFile* FC Find(const char* fileName);
+      static BitmapFile* FC Map(const char* fileName);
+      static void FC Unmap(BitmapFile* file);
+
+      char fileName[MAX_PATH];
+      HANDLE fileHandle;
+      HANDLE mappingHandle;
+      UCHAR* data;
+      UINT size;
+
+      //The headers, copied out of the file since the info header isn't
+      //aligned in it
+      BITMAPFILEHEADER fileHeader;
+      BITMAPINFOHEADER infoHeader;
+
+      //The number of loads that are reading from the file
+      UINT refCount;
+
+      //When the file was last closed, which decides which unused file
+      //is unmapped first
+      UINT releaseTime;
+
+      BitmapFile* next;
+
+      //The files that are mapped
+      static BitmapFile* firstFile;
+      static UINT numOfUnusedFiles;
+      static UINT releaseCount;
+   };
+}
@@ -17,8 +17,14 @@ BitmapList::BitmapList() : LinkedList<Bitmap>()
 {
    highestPriority = 1;
    lowestPriority = 1;
-   totalMemory = 0;
-   numOfLoadedBitmaps = 0;
+   prioritiesChanged = false;
+
+   maxNumOfUsageEntries = 64;
+   usageHeap = new Bitmap*[maxNumOfUsageEntries];
+   numOfUsageEntries = 0;
+   currentFrame = 0;
+
+   CreateIndex();
 }
 
 /*------------------------------------------------------------------------
@@ -33,8 +39,37 @@ BitmapList::BitmapList(bool destroyItems) :
 {
    highestPriority = 1;
    lowestPriority = 1;
-   totalMemory = 0;
-   numOfLoadedBitmaps = 0;
+   prioritiesChanged = false;
+
+   maxNumOfUsageEntries = 64;
+   usageHeap = new Bitmap*[maxNumOfUsageEntries];
+   numOfUsageEntries = 0;
+   currentFrame = 0;
+
+   CreateIndex();
+}
+
+/*Destructor*/
+BitmapList::~BitmapList()
+{
+   delete[] idIndex;
+   delete[] usageHeap;
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetItemById
+Parameters:
+   int id : the ID of the bitmap to retrieve
+Returns:
+   The first bitmap in the list with the ID, or NULL if there is none
+Description:
+   This function looks the bitmap up in the ID index, so it takes the
+   same time however many bitmaps are in the list.
+------------------------------------------------------------------------*/
+
+Bitmap* BitmapList::GetItemById(int id)
+{
+   return idIndex[FindIndexSlot(id)].bitmap;
 }
 
 /*------------------------------------------------------------------------
@@ -61,9 +96,9 @@ void BitmapList::RemoveFirstBitmapByPriority(UINT priority)
       if(bitmap->IsLoaded() &&
          bitmap->GetPriority() == priority)
       {
+         RemoveFromUsageHeap(bitmap);
          bitmap->DestroyBitmap();
          done = true;
-         numOfLoadedBitmaps--;
       }
 
       nodePtr = nodePtr->next;
@@ -94,8 +129,8 @@ void BitmapList::RemoveAllBitmapsByPriority(UINT priority)
       if(bitmap->IsLoaded() &&
          bitmap->GetPriority() == priority)
       {
+         RemoveFromUsageHeap(bitmap);
          bitmap->DestroyBitmap();
-         numOfLoadedBitmaps--;
       }
 
       nodePtr = nodePtr->next;
@@ -118,6 +153,9 @@ void BitmapList::RemoveFirstLowestPriorityBitmap()
    if(numOfItems == 0)
       return;
 
+   if(prioritiesChanged)
+      UpdatePriorities();
+
    bool done = false;
 
    Node<Bitmap>* nodePtr = first;
@@ -127,9 +165,9 @@ void BitmapList::RemoveFirstLowestPriorityBitmap()
       if(bitmap->IsLoaded() &&
          bitmap->GetPriority() == lowestPriority)
       {
+         RemoveFromUsageHeap(bitmap);
          bitmap->DestroyBitmap();
          done = true;
-         numOfLoadedBitmaps--;
       }
 
       nodePtr = nodePtr->next;
@@ -152,6 +190,9 @@ void BitmapList::RemoveAllLowestPriorityBitmaps()
    if(numOfItems == 0)
       return;
 
+   if(prioritiesChanged)
+      UpdatePriorities();
+
    Node<Bitmap>* nodePtr = first;
    for(int i = 0; i < numOfItems; i++)
    {
@@ -159,8 +200,8 @@ void BitmapList::RemoveAllLowestPriorityBitmaps()
       if(bitmap->IsLoaded() &&
          bitmap->GetPriority() == lowestPriority)
       {
+         RemoveFromUsageHeap(bitmap);
          bitmap->DestroyBitmap();
-         numOfLoadedBitmaps--;
       }
 
       nodePtr = nodePtr->next;
@@ -194,9 +235,10 @@ void BitmapList::RemoveAllBitmaps()
       nodePtr = nodePtr->next;
    }
 
-   numOfLoadedBitmaps = 0;
+   ClearUsageHeap();
    highestPriority = 1;
    lowestPriority = 1;
+   prioritiesChanged = false;
 }
 
 /*------------------------------------------------------------------------
@@ -225,6 +267,214 @@ void BitmapList::RestoreBitmaps()
    }
 }
 
+/*------------------------------------------------------------------------
+Function Name: DestroyScaledCopies()
+Parameters:
+Description:
+   This function destroys the scaled copies of all the bitmaps, which 
+   frees memory without removing any bitmap.
+------------------------------------------------------------------------*/
+
+void BitmapList::DestroyScaledCopies()
+{
+   Node<Bitmap>* nodePtr = first;
+   for(int i = 0; i < numOfItems; i++)
+   {
+      nodePtr->data->DestroyScaledCopies();
+      nodePtr = nodePtr->next;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: AddLoadedBitmap
+Parameters:
+   Bitmap* bitmap : a bitmap in the list that has just been loaded
+Description:
+   This function counts a bitmap that was added to the list before it
+   was loaded, such as one that the bitmap loader has finished.
+------------------------------------------------------------------------*/
+
+void BitmapList::AddLoadedBitmap(Bitmap* bitmap)
+{
+   AddToUsageHeap(bitmap);
+   ProcessNewPriority(bitmap->GetPriority());
+}
+
+/*------------------------------------------------------------------------
+Function Name: RemoveBitmap
+Parameters:
+   Bitmap* bitmap : a bitmap in the list
+Description:
+   This function removes a bitmap from memory, leaving the bitmap object
+   in the list.
+------------------------------------------------------------------------*/
+
+void BitmapList::RemoveBitmap(Bitmap* bitmap)
+{
+   RemoveFromUsageHeap(bitmap);
+   bitmap->DestroyBitmap();
+   prioritiesChanged = true;
+}
+
+/*------------------------------------------------------------------------
+Function Name: UseBitmap
+Parameters:
+   Bitmap* bitmap : a bitmap in the list that is about to be drawn
+Description:
+   This function marks a bitmap as used in the current frame, which
+   moves it away from the top of the usage heap. A bitmap that was
+   removed from memory is loaded again here, before anything is drawn
+   with it, and goes back into the heap.
+------------------------------------------------------------------------*/
+
+void BitmapList::UseBitmap(Bitmap* bitmap)
+{
+   bitmap->MarkUsed(currentFrame);
+
+   if(bitmap->GetUsageIndex() != -1)
+   {
+      MoveDownUsageHeap(bitmap->GetUsageIndex());
+      return;
+   }
+
+   if(!bitmap->IsLoadPending())
+      bitmap->ReloadBitmap();
+
+   if(bitmap->IsLoaded())
+   {
+      AddToUsageHeap(bitmap);
+      ProcessNewPriority(bitmap->GetPriority());
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: RemoveLeastRecentlyUsedBitmap
+Parameters:
+Description:
+   This function removes from memory the bitmap at the top of the usage
+   heap, which is the bitmap that has gone unused the longest for its 
+   priority. It takes O(log n) time, since the highest and lowest 
+   priorities are only found again when they are needed.
+------------------------------------------------------------------------*/
+
+void BitmapList::RemoveLeastRecentlyUsedBitmap()
+{
+   while(numOfUsageEntries > 0)
+   {
+      Bitmap* bitmap = usageHeap[0];
+
+      //The bitmaps that are never removed are below all the others
+      if(bitmap->GetPriority() == 0)
+         return;
+
+      RemoveFromUsageHeap(bitmap);
+      prioritiesChanged = true;
+
+      //A bitmap that was removed from memory through the bitmap itself
+      //is only taken out of the heap
+      if(bitmap->IsLoaded())
+      {
+         bitmap->DestroyBitmap();
+         return;
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: RemoveLeastRecentlyUsedMemory
+Parameters:
+Returns:
+   true if a bitmap was removed, false if none of them can be removed in
+   a way that frees memory
+Description:
+   This function removes from memory the bitmap that has gone unused the
+   longest for its priority, like RemoveLeastRecentlyUsedBitmap, but 
+   passes over the bitmaps whose removal frees no memory. These are the
+   bitmaps in an atlas or sheet that still holds other bitmaps, since its
+   surface is kept. The bitmaps that are passed over keep their place in
+   the usage heap.
+------------------------------------------------------------------------*/
+
+bool BitmapList::RemoveLeastRecentlyUsedMemory()
+{
+   Bitmap** skipped = new Bitmap*[numOfUsageEntries + 1];
+   int numOfSkipped = 0;
+   bool removed = false;
+
+   while(numOfUsageEntries > 0)
+   {
+      Bitmap* bitmap = usageHeap[0];
+
+      if(bitmap->GetPriority() == 0)
+         break;
+
+      RemoveFromUsageHeap(bitmap);
+
+      if(!bitmap->IsLoaded())
+      {
+         prioritiesChanged = true;
+         continue;
+      }
+
+      BitmapAtlas* atlas = bitmap->GetAtlas();
+
+      if(atlas != NULL && atlas->GetNumOfBitmaps() > 1)
+      {
+         skipped[numOfSkipped++] = bitmap;
+         continue;
+      }
+
+      prioritiesChanged = true;
+      bitmap->DestroyBitmap();
+      removed = true;
+      break;
+   }
+
+   //Adding a bitmap to the heap counts it as used now, so the frame it
+   //was last used in is put back
+   for(int i = 0; i < numOfSkipped; i++)
+   {
+      UINT lastUsedFrame = skipped[i]->GetLastUsedFrame();
+
+      AddToUsageHeap(skipped[i]);
+      skipped[i]->SetLastUsedFrame(lastUsedFrame);
+      MoveUpUsageHeap(skipped[i]->GetUsageIndex());
+   }
+
+   delete[] skipped;
+   return removed;
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetHighestPriority
+Parameters:
+Returns:
+   The highest priority of the loaded bitmaps
+------------------------------------------------------------------------*/
+
+UINT BitmapList::GetHighestPriority()
+{
+   if(prioritiesChanged)
+      UpdatePriorities();
+
+   return highestPriority;
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetLowestPriority
+Parameters:
+Returns:
+   The lowest priority of the loaded bitmaps
+------------------------------------------------------------------------*/
+
+UINT BitmapList::GetLowestPriority()
+{
+   if(prioritiesChanged)
+      UpdatePriorities();
+
+   return lowestPriority;
+}
+
 /*------------------------------------------------------------------------
 Function Name: ProcessNewPriority
 Parameters:
@@ -256,6 +506,8 @@ Description:
 
 void BitmapList::UpdatePriorities()
 {
+   prioritiesChanged = false;
+
    //If the list is empty
    if(numOfItems == 0)
       return;
@@ -286,139 +538,491 @@ void BitmapList::UpdatePriorities()
 }
 
 /*------------------------------------------------------------------------
-Function Name: UpdateLoadedBitmaps
+Function Name: IsRemovedBefore
 Parameters:
+   Bitmap* bitmap1, Bitmap* bitmap2 : two loaded bitmaps
+Returns:
+   true if bitmap1 should be removed from memory before bitmap2
 Description:
-   This function iterates through the list of bitmaps, updating the
-   number of loaded bitmaps. This function should be called if
-   a bitmap is removed from the list.
+   Each step of priority counts as BL_FRAMES_PER_PRIORITY frames of
+   use, so a lower priority bitmap that is drawn all the time stays in
+   memory, while a higher priority one that hasn't been drawn for a long
+   time doesn't. Of two bitmaps that come out even, the one that has 
+   been drawn fewer times is removed first.
 ------------------------------------------------------------------------*/
 
-void BitmapList::UpdateLoadedBitmaps()
+bool BitmapList::IsRemovedBefore(Bitmap* bitmap1, Bitmap* bitmap2)
 {
-   //If the list is empty
-   if(numOfItems == 0)
+   UINT priority1 = bitmap1->GetPriority();
+   UINT priority2 = bitmap2->GetPriority();
+
+   if(priority1 == 0 || priority2 == 0)
+      return priority1 != 0 && priority2 == 0;
+
+   __int64 age1 = __int64(bitmap1->GetLastUsedFrame()) - 
+      (__int64(priority1) * BL_FRAMES_PER_PRIORITY);
+   __int64 age2 = __int64(bitmap2->GetLastUsedFrame()) - 
+      (__int64(priority2) * BL_FRAMES_PER_PRIORITY);
+
+   if(age1 != age2)
+      return age1 < age2;
+
+   return bitmap1->GetNumOfUses() < bitmap2->GetNumOfUses();
+}
+
+/*------------------------------------------------------------------------
+Function Name: AddToUsageHeap
+Parameters:
+   Bitmap* bitmap : a bitmap that has been loaded
+Description:
+   This function adds a bitmap to the usage heap, if it isn't in it
+   already. A bitmap that has just been loaded counts as used in the
+   current frame, so that it isn't the first to be removed again.
+------------------------------------------------------------------------*/
+
+void BitmapList::AddToUsageHeap(Bitmap* bitmap)
+{
+   if(bitmap->GetUsageIndex() != -1)
       return;
 
-   numOfLoadedBitmaps = 0;
+   if(numOfUsageEntries == maxNumOfUsageEntries)
+   {
+      Bitmap** newUsageHeap = new Bitmap*[maxNumOfUsageEntries * 2];
+      memcpy(newUsageHeap, usageHeap, 
+         maxNumOfUsageEntries * sizeof(Bitmap*));
+      delete[] usageHeap;
 
-   Node<Bitmap>* nodePtr = first;
-   for(int i = 0; i < numOfItems; i++)
+      usageHeap = newUsageHeap;
+      maxNumOfUsageEntries *= 2;
+   }
+
+   bitmap->SetLastUsedFrame(currentFrame);
+
+   usageHeap[numOfUsageEntries] = bitmap;
+   bitmap->SetUsageIndex(numOfUsageEntries);
+   numOfUsageEntries++;
+
+   MoveUpUsageHeap(numOfUsageEntries - 1);
+}
+
+/*------------------------------------------------------------------------
+Function Name: RemoveFromUsageHeap
+Parameters:
+   Bitmap* bitmap : the bitmap to take out of the usage heap
+Description:
+   This function takes a bitmap out of the usage heap, if it is in it,
+   and puts the last entry of the heap in its place.
+------------------------------------------------------------------------*/
+
+void BitmapList::RemoveFromUsageHeap(Bitmap* bitmap)
+{
+   int position = bitmap->GetUsageIndex();
+   if(position == -1)
+      return;
+
+   bitmap->SetUsageIndex(-1);
+   numOfUsageEntries--;
+
+   if(position != numOfUsageEntries)
    {
-      Bitmap* bitmap = nodePtr->data;
-      
-      if(bitmap->IsLoaded())
-         numOfLoadedBitmaps++;
+      Bitmap* lastBitmap = usageHeap[numOfUsageEntries];
+      usageHeap[position] = lastBitmap;
+      lastBitmap->SetUsageIndex(position);
 
-      nodePtr = nodePtr->next;
+      MoveUpUsageHeap(position);
+      MoveDownUsageHeap(lastBitmap->GetUsageIndex());
    }
 }
 
+//Moves the entry at a position of the usage heap up until its parent
+//is to be removed before it
+void BitmapList::MoveUpUsageHeap(int position)
+{
+   while(position > 0)
+   {
+      int parent = (position - 1) / 2;
+      if(!IsRemovedBefore(usageHeap[position], usageHeap[parent]))
+         break;
+
+      SwapUsageEntries(position, parent);
+      position = parent;
+   }
+}
+
+//Moves the entry at a position of the usage heap down until it is to
+//be removed before both of its children
+void BitmapList::MoveDownUsageHeap(int position)
+{
+   for(;;)
+   {
+      int child = (position * 2) + 1;
+      if(child >= numOfUsageEntries)
+         break;
+
+      if(child + 1 < numOfUsageEntries &&
+         IsRemovedBefore(usageHeap[child + 1], usageHeap[child]))
+         child++;
+
+      if(!IsRemovedBefore(usageHeap[child], usageHeap[position]))
+         break;
+
+      SwapUsageEntries(position, child);
+      position = child;
+   }
+}
+
+void BitmapList::SwapUsageEntries(int position1, int position2)
+{
+   Bitmap* bitmap = usageHeap[position1];
+   usageHeap[position1] = usageHeap[position2];
+   usageHeap[position2] = bitmap;
+
+   usageHeap[position1]->SetUsageIndex(position1);
+   usageHeap[position2]->SetUsageIndex(position2);
+}
+
+/*------------------------------------------------------------------------
+Function Name: ClearUsageHeap
+Parameters:
+Description:
+   This function empties the usage heap. It is called when all the
+   bitmaps are removed from memory or from the list.
+------------------------------------------------------------------------*/
+
+void BitmapList::ClearUsageHeap()
+{
+   for(int i = 0; i < numOfUsageEntries; i++)
+      usageHeap[i]->SetUsageIndex(-1);
+
+   numOfUsageEntries = 0;
+}
+
+//Spreads the bits of an ID over the ID index, so that IDs that are
+//close together do not fill neighbouring slots
+static inline UINT HashBitmapID(int id)
+{
+   UINT hash = UINT(id) * 2654435761U;
+   return hash ^ (hash >> 16);
+}
+
+/*------------------------------------------------------------------------
+Function Name: CreateIndex
+Parameters:
+Description:
+   This function creates the empty ID index of the list.
+------------------------------------------------------------------------*/
+
+void BitmapList::CreateIndex()
+{
+   idIndexSize = BL_INITIAL_INDEX_SIZE;
+   idIndex = new BitmapIndexEntry[idIndexSize];
+   ClearIndex();
+}
+
+/*------------------------------------------------------------------------
+Function Name: FindIndexSlot
+Parameters:
+   int id : the ID to look for
+Returns:
+   The slot of the ID index that holds the ID, or the empty slot where
+   the ID would be added
+Description:
+   This function probes the ID index from the slot the ID hashes to
+   until it finds the ID or an empty slot. The index is never more than
+   half full, so there is always an empty slot.
+------------------------------------------------------------------------*/
+
+int BitmapList::FindIndexSlot(int id)
+{
+   int mask = idIndexSize - 1;
+   int slot = int(HashBitmapID(id)) & mask;
+
+   while(idIndex[slot].bitmap != NULL && idIndex[slot].id != id)
+      slot = (slot + 1) & mask;
+
+   return slot;
+}
+
+/*------------------------------------------------------------------------
+Function Name: AddToIndex
+Parameters:
+   int id : the ID of the bitmap
+   Bitmap* bitmap : the bitmap
+   bool replace : whether the bitmap takes the place of a bitmap that is
+      already indexed with the same ID
+Description:
+   This function adds a bitmap to the ID index. The index is doubled in
+   size when it would become more than half full.
+------------------------------------------------------------------------*/
+
+void BitmapList::AddToIndex(int id, Bitmap* bitmap, bool replace)
+{
+   if((numOfIndexEntries + 1) * 2 > idIndexSize)
+   {
+      BitmapIndexEntry* oldIndex = idIndex;
+      int oldIndexSize = idIndexSize;
+
+      idIndexSize *= 2;
+      idIndex = new BitmapIndexEntry[idIndexSize];
+      ClearIndex();
+
+      for(int i = 0; i < oldIndexSize; i++)
+      {
+         if(oldIndex[i].bitmap != NULL)
+         {
+            BitmapIndexEntry& entry = idIndex[FindIndexSlot(oldIndex[i].id)];
+            entry = oldIndex[i];
+            numOfIndexEntries++;
+         }
+      }
+
+      delete[] oldIndex;
+   }
+
+   BitmapIndexEntry& entry = idIndex[FindIndexSlot(id)];
+
+   if(entry.bitmap == NULL)
+   {
+      entry.id = id;
+      entry.bitmap = bitmap;
+      numOfIndexEntries++;
+   }
+   else if(replace)
+      entry.bitmap = bitmap;
+}
+
+/*------------------------------------------------------------------------
+Function Name: RemoveFromIndex
+Parameters:
+   int id : the ID to remove
+Description:
+   This function removes an ID from the ID index. The entries after it
+   that were pushed along by it are moved back, so that no probe ends
+   early at the slot it leaves empty.
+------------------------------------------------------------------------*/
+
+void BitmapList::RemoveFromIndex(int id)
+{
+   int mask = idIndexSize - 1;
+   int hole = FindIndexSlot(id);
+
+   if(idIndex[hole].bitmap == NULL)
+      return;
+
+   int slot = (hole + 1) & mask;
+   while(idIndex[slot].bitmap != NULL)
+   {
+      int home = int(HashBitmapID(idIndex[slot].id)) & mask;
+
+      //The entry can fill the hole if the hole is between the slot the
+      //entry hashes to and the slot it is in
+      if(((slot - home) & mask) >= ((slot - hole) & mask))
+      {
+         idIndex[hole] = idIndex[slot];
+         hole = slot;
+      }
+
+      slot = (slot + 1) & mask;
+   }
+
+   idIndex[hole].bitmap = NULL;
+   numOfIndexEntries--;
+}
+
+/*------------------------------------------------------------------------
+Function Name: UpdateIndex
+Parameters:
+   int id : the ID of a bitmap that has been taken out of the list
+Description:
+   This function takes an ID out of the ID index, and puts it back with
+   the first bitmap of the list that still has the ID, if there is one.
+   This function should be called if a bitmap is removed from the list.
+------------------------------------------------------------------------*/
+
+void BitmapList::UpdateIndex(int id)
+{
+   RemoveFromIndex(id);
+
+   Bitmap* bitmap = LinkedList<Bitmap>::GetItemById(id);
+   if(bitmap != NULL)
+      AddToIndex(id, bitmap, false);
+}
+
+/*------------------------------------------------------------------------
+Function Name: ClearIndex
+Parameters:
+Description:
+   This function empties the ID index, keeping its size.
+------------------------------------------------------------------------*/
+
+void BitmapList::ClearIndex()
+{
+   for(int i = 0; i < idIndexSize; i++)
+      idIndex[i].bitmap = NULL;
+
+   numOfIndexEntries = 0;
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetNodeByIndex
+Parameters:
+   int index : the index of an item in the list
+Returns:
+   The node of the item
+------------------------------------------------------------------------*/
+
+Node<Bitmap>* BitmapList::GetNodeByIndex(int index)
+{
+   assert(index >= 0 && index < numOfItems);
+
+   Node<Bitmap>* nodePtr = first;
+   for(int i = 0; i < index; i++)
+      nodePtr = nodePtr->next;
+
+   return nodePtr;
+}
+
 /*The following are just wrapper functions. They are overridden merely
-  so the list can keep track of the lowest and highest priorities*/
+  so the list can keep track of the lowest and highest priorities, the
+  loaded bitmaps and the IDs of the bitmaps*/
 
 void BitmapList::Insert(Bitmap* data, int id)
 {
    if(data->IsLoaded())
-      numOfLoadedBitmaps++;
+      AddToUsageHeap(data);
    LinkedList<Bitmap>::Insert(data, id);
+   AddToIndex(id, data, true);
    ProcessNewPriority(data->GetPriority());
 }
 
 void BitmapList::Append(Bitmap* data, int id)
 {
    if(data->IsLoaded())
-      numOfLoadedBitmaps++;
+      AddToUsageHeap(data);
    LinkedList<Bitmap>::Append(data, id);
+   AddToIndex(id, data, false);
    ProcessNewPriority(data->GetPriority());
 }
 
 void BitmapList::InsertAtPosition(int index, Bitmap* data, int id)
 {
    if(data->IsLoaded())
-      numOfLoadedBitmaps++;
+      AddToUsageHeap(data);
    LinkedList<Bitmap>::InsertAtPosition(index, data, id);
+   AddToIndex(id, LinkedList<Bitmap>::GetItemById(id), true);
    ProcessNewPriority(data->GetPriority());
 }
 
 void BitmapList::DeleteByIndex(int index)
 {
+   Node<Bitmap>* node = GetNodeByIndex(index);
+   int id = node->id;
+   RemoveFromUsageHeap(node->data);
    LinkedList<Bitmap>::DeleteByIndex(index);
+   UpdateIndex(id);
    UpdatePriorities();
-   UpdateLoadedBitmaps();
 }
 
 void BitmapList::DeleteById(int id)
 {
+   Bitmap* bitmap = GetItemById(id);
+   if(bitmap == NULL)
+      return;
+
+   RemoveFromUsageHeap(bitmap);
    LinkedList<Bitmap>::DeleteById(id);
+   UpdateIndex(id);
    UpdatePriorities();
-   UpdateLoadedBitmaps();
 }
 
 void BitmapList::DeleteFirst()
 {
+   if(numOfItems == 0)
+      return;
+
+   int id = first->id;
+   RemoveFromUsageHeap(first->data);
    LinkedList<Bitmap>::DeleteFirst();
+   UpdateIndex(id);
    UpdatePriorities();
-   UpdateLoadedBitmaps();
 }
 
 void BitmapList::DeleteLast()
 {
+   if(numOfItems == 0)
+      return;
+
+   int id = last->id;
+   RemoveFromUsageHeap(last->data);
    LinkedList<Bitmap>::DeleteLast();
+   UpdateIndex(id);
    UpdatePriorities();
-   UpdateLoadedBitmaps();
 }
 
 void BitmapList::DeleteAll()
 {
+   ClearUsageHeap();
    LinkedList<Bitmap>::DeleteAll();
+   ClearIndex();
    highestPriority = 1;
    lowestPriority = 1;
-   totalMemory = 0;
-   numOfLoadedBitmaps = 0;
+   prioritiesChanged = false;
 }
 
 Bitmap* BitmapList::RemoveByIndex(int index)
 {
+   int id = GetNodeByIndex(index)->id;
    Bitmap* bitmap = LinkedList<Bitmap>::RemoveByIndex(index);
+   UpdateIndex(id);
+   RemoveFromUsageHeap(bitmap);
    UpdatePriorities();   
-   if(bitmap->IsLoaded())
-      numOfLoadedBitmaps--;
    return bitmap;
 }
 
 Bitmap* BitmapList::RemoveById(int id)
 {
    Bitmap* bitmap = LinkedList<Bitmap>::RemoveById(id);
-   if(bitmap->IsLoaded())
-      numOfLoadedBitmaps--;
+   if(bitmap == NULL)
+      return NULL;
+
+   UpdateIndex(id);
+   RemoveFromUsageHeap(bitmap);
    UpdatePriorities();   
    return bitmap;
 }
 
 Bitmap* BitmapList::RemoveFirst()
 {
+   if(numOfItems == 0)
+      return NULL;
+
+   int id = first->id;
    Bitmap* bitmap = LinkedList<Bitmap>::RemoveFirst();
+   UpdateIndex(id);
+   RemoveFromUsageHeap(bitmap);
    UpdatePriorities();
-   if(bitmap->IsLoaded())
-      numOfLoadedBitmaps--;
    return bitmap;
 }
 
 Bitmap* BitmapList::RemoveLast()
 {
+   if(numOfItems == 0)
+      return NULL;
+
+   int id = last->id;
    Bitmap* bitmap = LinkedList<Bitmap>::RemoveLast();
+   UpdateIndex(id);
+   RemoveFromUsageHeap(bitmap);
    UpdatePriorities();   
-   if(bitmap->IsLoaded())
-      numOfLoadedBitmaps--;
    return bitmap;
 }
 
 void BitmapList::RemoveAll()
 {
+   ClearUsageHeap();
    LinkedList<Bitmap>::RemoveAll();
+   ClearIndex();
    highestPriority = 1;
    lowestPriority = 1;
-   totalMemory = 0;
-   numOfLoadedBitmaps = 0;
-}
\ No newline at end of file
+   prioritiesChanged = false;
+}
@@ -6,12 +6,35 @@ Version:
    1.0.0    25.02.2001  Created the file
    2.0.0    02.06.2002  Changed the file to use namespaces and adapt
       to Visual Studio .NET
+   2.1.0    03.11.2002  The memory of the bitmaps is counted
+   2.2.0    10.11.2002  The bitmaps are found through a hash index of
+      their IDs instead of by walking the list
+   2.3.0    17.11.2002  Bitmaps are removed from memory by how long ago
+      they were drawn as well as by their priority
+   2.4.0    08.12.2002  The scaled copies of the bitmaps are counted and
+      can be destroyed on their own
 ------------------------------------------------------------------------*/
 
 #pragma once
 
+//The number of slots the ID index starts with. It must be a power of 2.
+#define BL_INITIAL_INDEX_SIZE          64
+
+//How many frames a bitmap has to have been drawn more recently than a
+//bitmap of one priority higher to stay in memory longer than it
+#define BL_FRAMES_PER_PRIORITY         600
+
 namespace DG
 {
+   //A slot of the ID index of a bitmap list. A slot with a NULL bitmap is
+   //empty.
+   class BitmapIndexEntry
+   {
+   public:
+      int id;
+      Bitmap* bitmap;
+   };
+
    class BitmapList : public LinkedList<Bitmap>
    {
    public:
@@ -21,13 +44,15 @@ namespace DG
       BitmapList();
 
       //Destructor
-      ~BitmapList() {}
+      ~BitmapList();
 
       //Wrapper Functions
       void Insert(Bitmap* data, int id = NO_ID);
       void Append(Bitmap* data, int id = NO_ID);
       void InsertAtPosition(int index, Bitmap* data, int id = NO_ID);
 
+      Bitmap* GetItemById(int id);
+
       void DeleteByIndex(int index);
       void DeleteById(int id);
       void DeleteFirst(void);
@@ -47,20 +72,62 @@ namespace DG
       void RemoveAllLowestPriorityBitmaps(void);
       void RemoveAllBitmaps(void);
       void RestoreBitmaps(void);
+      void DestroyScaledCopies(void);
+      void AddLoadedBitmap(Bitmap* bitmap);
+      void RemoveBitmap(Bitmap* bitmap);
 
-      UINT GetHighestPriority(void) {return highestPriority;}
-      UINT GetLowestPriority(void) {return lowestPriority;}
-      UINT GetTotalMemory(void) {return totalMemory;}
-      UINT GetNumOfLoadedBitmaps(void) {return numOfLoadedBitmaps;}
+      //The loaded bitmaps are kept in a heap ordered by which one should
+      //be removed from memory first: the one with the oldest last use
+      //once BL_FRAMES_PER_PRIORITY frames are taken off for each step of
+      //priority. Bitmaps with a priority of 0 are never removed.
+      void UseBitmap(Bitmap* bitmap);
+      void RemoveLeastRecentlyUsedBitmap(void);
+      bool RemoveLeastRecentlyUsedMemory(void);
+      void NextFrame(void) {currentFrame++;}
+      UINT GetCurrentFrame(void) {return currentFrame;}
+
+      UINT GetHighestPriority(void);
+      UINT GetLowestPriority(void);
+      UINT GetNumOfLoadedBitmaps(void) {return UINT(numOfUsageEntries);}
 
    private:
       void ProcessNewPriority(UINT priority);
       void UpdatePriorities(void);
-      void UpdateLoadedBitmaps(void);
+
+      bool IsRemovedBefore(Bitmap* bitmap1, Bitmap* bitmap2);
+      void AddToUsageHeap(Bitmap* bitmap);
+      void RemoveFromUsageHeap(Bitmap* bitmap);
+      void MoveUpUsageHeap(int position);
+      void MoveDownUsageHeap(int position);
+      void SwapUsageEntries(int position1, int position2);
+      void ClearUsageHeap(void);
+
+      void CreateIndex(void);
+      int FindIndexSlot(int id);
+      void AddToIndex(int id, Bitmap* bitmap, bool replace);
+      void RemoveFromIndex(int id);
+      void UpdateIndex(int id);
+      void ClearIndex(void);
+      Node<Bitmap>* GetNodeByIndex(int index);
 
       UINT highestPriority;
       UINT lowestPriority;
-      UINT numOfLoadedBitmaps;
-      UINT totalMemory;
+
+      //Whether a bitmap has been removed from memory since the highest
+      //and lowest priorities were found
+      bool prioritiesChanged;
+
+      //The loaded bitmaps as a binary heap, with the bitmap to remove
+      //first at the top
+      Bitmap** usageHeap;
+      int numOfUsageEntries;
+      int maxNumOfUsageEntries;
+      UINT currentFrame;
+
+      //An open addressing hash table of the IDs in the list, holding the
+      //first bitmap with each ID
+      BitmapIndexEntry* idIndex;
+      int idIndexSize;
+      int numOfIndexEntries;
    };
 }
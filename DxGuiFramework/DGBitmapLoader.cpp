@@ -0,0 +1,354 @@
+/*------------------------------------------------------------------------
+File Name: DGBitmapLoader.cpp
+Description: This file contains the implementation of the 
+   DG::BitmapLoader class, which decodes bitmap files on background 
+   threads.
+Version:
+   1.0.0    27.10.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+#include <process.h>
+
+using namespace DG;
+
+/*------------------------------------------------------------------------
+Function Name: Constructor
+Parameters:
+   int threads : the number of threads to decode with, or 0 for one for
+      each processor besides the one that draws
+Description:
+   The worker threads are started here and wait until there is a bitmap
+   to decode.
+------------------------------------------------------------------------*/
+
+BitmapLoader::BitmapLoader(int threads)
+{
+   if(threads <= 0)
+   {
+      SYSTEM_INFO systemInfo;
+      GetSystemInfo(&systemInfo);
+      threads = int(systemInfo.dwNumberOfProcessors) - 1;
+   }
+
+   if(threads < 1)
+      threads = 1;
+
+   if(threads > BL_MAX_THREADS)
+      threads = BL_MAX_THREADS;
+
+   waiting = NULL;
+   decoding = NULL;
+   finished = NULL;
+   terminate = false;
+
+   InitializeCriticalSection(&listLock);
+   waitingSemaphore = CreateSemaphore(NULL, 0, MAXLONG, NULL);
+
+   if(waitingSemaphore == NULL)
+   {
+      DeleteCriticalSection(&listLock);
+      throw new Exception("The bitmap loader could not be created.", 
+         EC_BMBITMAPLOAD, ET_BITMAP, __FILE__, __LINE__);
+   }
+
+   numOfThreads = 0;
+
+   for(int i = 0; i < threads; i++)
+   {
+      unsigned threadID;
+      HANDLE thread = (HANDLE)_beginthreadex(NULL, 0, WorkerThread, 
+         this, 0, &threadID);
+
+      //Load with the threads that could be started
+      if(thread == NULL)
+         break;
+
+      workerThreads[numOfThreads++] = thread;
+   }
+
+   if(numOfThreads == 0)
+   {
+      CloseHandle(waitingSemaphore);
+      DeleteCriticalSection(&listLock);
+      throw new Exception("The bitmap loader could not start a thread.", 
+         EC_BMBITMAPLOAD, ET_BITMAP, __FILE__, __LINE__);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Destructor
+Description:
+   The worker threads are told to end and waited for. The loads that
+   haven't been taken are thrown away, and their files are closed.
+------------------------------------------------------------------------*/
+
+BitmapLoader::~BitmapLoader()
+{
+   terminate = true;
+   ReleaseSemaphore(waitingSemaphore, numOfThreads, NULL);
+
+   for(int i = 0; i < numOfThreads; i++)
+   {
+      WaitForSingleObject(workerThreads[i], INFINITE);
+      CloseHandle(workerThreads[i]);
+   }
+
+   DeleteList(waiting);
+   DeleteList(finished);
+
+   CloseHandle(waitingSemaphore);
+   DeleteCriticalSection(&listLock);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Queue
+Parameters:
+   BitmapLoad* load : the bitmap to be decoded, which the loader takes
+      over until GetFinishedLoad() returns it
+Description:
+   This function adds a bitmap to the end of the loads that are waiting
+   and wakes up a worker to decode it.
+------------------------------------------------------------------------*/
+
+void FC BitmapLoader::Queue(BitmapLoad* load)
+{
+   load->pixels = NULL;
+
+   EnterCriticalSection(&listLock);
+   AddToList(waiting, load);
+   LeaveCriticalSection(&listLock);
+
+   ReleaseSemaphore(waitingSemaphore, 1, NULL);
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetFinishedLoad
+Parameters:
+Returns:
+   The first load that has been decoded, or NULL if none have. The 
+   caller takes over the load and its pixels, and must close its file.
+------------------------------------------------------------------------*/
+
+BitmapLoad* FC BitmapLoader::GetFinishedLoad(void)
+{
+   EnterCriticalSection(&listLock);
+
+   BitmapLoad* load = finished;
+   if(load != NULL)
+   {
+      finished = load->next;
+      load->next = NULL;
+   }
+
+   LeaveCriticalSection(&listLock);
+
+   return load;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Cancel
+Parameters:
+   Bitmap* bitmap : the bitmap that is being deleted
+Description:
+   This function forgets the bitmap in all of its loads, so that the 
+   loader never touches it again. A load that is waiting is not decoded,
+   and a load that is being decoded is thrown away when it finishes.
+------------------------------------------------------------------------*/
+
+void FC BitmapLoader::Cancel(Bitmap* bitmap)
+{
+   EnterCriticalSection(&listLock);
+
+   CancelList(waiting, bitmap);
+   CancelList(decoding, bitmap);
+   CancelList(finished, bitmap);
+
+   LeaveCriticalSection(&listLock);
+}
+
+/*------------------------------------------------------------------------
+Function Name: CancelAll
+Parameters:
+Description:
+   This function forgets the bitmaps of all the loads.
+------------------------------------------------------------------------*/
+
+void FC BitmapLoader::CancelAll(void)
+{
+   EnterCriticalSection(&listLock);
+
+   CancelList(waiting, NULL);
+   CancelList(decoding, NULL);
+   CancelList(finished, NULL);
+
+   LeaveCriticalSection(&listLock);
+}
+
+/*------------------------------------------------------------------------
+Function Name: WorkerThread
+Parameters:
+   void* parameter : the loader that the thread belongs to
+Description:
+   Each worker moves the first load that is waiting to the loads that
+   are being decoded, decodes it without holding the lock and moves it
+   to the finished loads. The bitmap of a load is never touched here,
+   since it can be deleted at any time: Cancel() only clears the pointer
+   and the thread that draws checks it when the load is finished. Each
+   worker makes its own convert tables for the pixel format of a load,
+   since the thread that draws makes its tables again when the graphics
+   mode changes.
+------------------------------------------------------------------------*/
+
+unsigned __stdcall BitmapLoader::WorkerThread(void* parameter)
+{
+   BitmapLoader* loader = (BitmapLoader*)parameter;
+
+   ConvertTables tables;
+   bool tablesCreated = false;
+   UINT tablesGeneration = 0;
+
+   for(;;)
+   {
+      WaitForSingleObject(loader->waitingSemaphore, INFINITE);
+
+      if(loader->terminate)
+         break;
+
+      EnterCriticalSection(&loader->listLock);
+
+      BitmapLoad* load = loader->waiting;
+      if(load != NULL)
+      {
+         loader->waiting = load->next;
+         AddToList(loader->decoding, load);
+      }
+
+      bool cancelled = (load != NULL && load->bitmap == NULL);
+
+      LeaveCriticalSection(&loader->listLock);
+
+      if(load == NULL)
+         continue;
+
+      if(!cancelled)
+      {
+         if(!tablesCreated || tablesGeneration != load->surfaceGeneration)
+         {
+            tables.Create(load->pixelFormat);
+            tablesCreated = true;
+            tablesGeneration = load->surfaceGeneration;
+         }
+
+         try
+         {
+            Decode(load, &tables);
+         }
+         catch(Exception* exception)
+         {
+            //The file was checked when the load was queued, so this can
+            //only be running out of memory. The bitmap is loaded the 
+            //usual way when it is drawn.
+            delete exception;
+            delete load->pixels;
+            load->pixels = NULL;
+         }
+         catch(...)
+         {
+            delete load->pixels;
+            load->pixels = NULL;
+         }
+      }
+
+      EnterCriticalSection(&loader->listLock);
+      RemoveFromList(loader->decoding, load);
+      AddToList(loader->finished, load);
+      LeaveCriticalSection(&loader->listLock);
+   }
+
+   return 0;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Decode
+Parameters:
+   BitmapLoad* load : the load to be decoded
+   ConvertTables* tables : the convert tables of the worker, made for 
+      the pixel format of the load
+Description:
+   This function decodes the area of the file of a load into a new pixel
+   buffer. Bitmaps with an alpha channel are always 32-bit, others are
+   converted to the pixel format that the load was queued with.
+------------------------------------------------------------------------*/
+
+void FC BitmapLoader::Decode(BitmapLoad* load, ConvertTables* tables)
+{
+   Area& rect = load->rect;
+
+   if(load->alpha)
+   {
+      load->pixels = new PixelBuffer(rect.width, rect.height, 4);
+      Bitmap::DecodeAlphaLines(*load->file, rect, load->pixels, 
+         load->premultiplied);
+   }
+
+   else
+   {
+      load->pixels = new PixelBuffer(rect.width, rect.height, 
+         load->pixelSize);
+      Bitmap::DecodeLines(*load->file, rect, load->pixels->GetBits(),
+         load->pixels->GetPitch(), load->convertLine, tables);
+   }
+}
+
+//Adds a load to the end of a list. The lists are short, so walking 
+//them is cheaper than keeping a pointer to the last load.
+void FC BitmapLoader::AddToList(BitmapLoad*& list, BitmapLoad* load)
+{
+   load->next = NULL;
+
+   BitmapLoad** link = &list;
+   while(*link != NULL)
+      link = &(*link)->next;
+
+   *link = load;
+}
+
+//Takes a load out of a list
+void FC BitmapLoader::RemoveFromList(BitmapLoad*& list, BitmapLoad* load)
+{
+   BitmapLoad** link = &list;
+   while(*link != load)
+      link = &(*link)->next;
+
+   *link = load->next;
+   load->next = NULL;
+}
+
+//Forgets a bitmap, or all the bitmaps if it is NULL, in the loads of a
+//list
+void FC BitmapLoader::CancelList(BitmapLoad* list, Bitmap* bitmap)
+{
+   for(BitmapLoad* load = list; load != NULL; load = load->next)
+   {
+      if(bitmap == NULL || load->bitmap == bitmap)
+         load->bitmap = NULL;
+   }
+}
+
+//Deletes all the loads of a list and closes their files. Only the
+//thread that draws may do this, since the files are opened there.
+void FC BitmapLoader::DeleteList(BitmapLoad*& list)
+{
+   while(list != NULL)
+   {
+      BitmapLoad* load = list;
+      list = load->next;
+
+      if(load->pixels != NULL)
+         delete load->pixels;
+
+      BitmapFile::Close(load->file);
+      delete load;
+   }
+}
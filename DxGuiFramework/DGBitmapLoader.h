@@ -0,0 +1,99 @@
+/*------------------------------------------------------------------------
+File Name: DGBitmapLoader.h
+Description: This file contains the DG::BitmapLoader class, which 
+   decodes bitmap files on background threads, so that the thread that
+   draws doesn't have to wait for them.
+Version:
+   1.0.0    27.10.2002  Created the file
+------------------------------------------------------------------------*/
+
+#pragma once
+
+//The most threads that a bitmap loader can have
+#define BL_MAX_THREADS        4
+
+namespace DG
+{
+   class Bitmap;
+
+   //A bitmap that is waiting to be decoded or has been decoded. The 
+   //loader only reads the file and writes the pixels, everything else
+   //is done by the thread that draws.
+   class BitmapLoad
+   {
+   public:
+      //The bitmap that is being loaded, or NULL if it was deleted while
+      //it was loading
+      Bitmap* bitmap;
+      UINT bitmapID;
+
+      //The window that is told when the bitmap has been loaded, or 
+      //IDW_NONE
+      UINT windowID;
+
+      //The file and the area of it that is decoded
+      BitmapFile* file;
+      Area rect;
+
+      bool alpha;
+      bool premultiplied;
+
+      //The kernel that converts the lines to the pixel format of the 
+      //screen, the size of the pixels it writes and the pixel format 
+      //that the worker makes its convert tables from. If the surfaces 
+      //have been made again by the time the bitmap is decoded, which
+      //the surface generation of the graphics object tells, it is 
+      //decoded again for the new graphics mode.
+      ConvertKernel convertLine;
+      int pixelSize;
+      DDPIXELFORMAT pixelFormat;
+      UINT surfaceGeneration;
+
+      //The decoded pixels, or NULL if the bitmap hasn't been decoded
+      PixelBuffer* pixels;
+
+      BitmapLoad* next;
+   };
+
+   class BitmapLoader
+   {
+   public:
+      BitmapLoader(int threads = 0);
+      virtual ~BitmapLoader();
+
+      int GetNumOfThreads(void) {return numOfThreads;}
+
+      void FC Queue(BitmapLoad* load);
+      BitmapLoad* FC GetFinishedLoad(void);
+      void FC Cancel(Bitmap* bitmap);
+      void FC CancelAll(void);
+
+   private:
+      static unsigned __stdcall WorkerThread(void* parameter);
+      static void FC Decode(BitmapLoad* load, ConvertTables* tables);
+      static void FC AddToList(BitmapLoad*& list, BitmapLoad* load);
+      static void FC RemoveFromList(BitmapLoad*& list, BitmapLoad* load);
+      static void FC CancelList(BitmapLoad* list, Bitmap* bitmap);
+      static void FC DeleteList(BitmapLoad*& list);
+
+      HANDLE workerThreads[BL_MAX_THREADS];
+      int numOfThreads;
+
+      //Counts the loads that are waiting, so that a worker sleeps until
+      //there is one
+      HANDLE waitingSemaphore;
+
+      //Guards the lists
+      CRITICAL_SECTION listLock;
+
+      //The loads that haven't been decoded, the loads that the workers
+      //are decoding and the loads that have been decoded, in the order
+      //they were queued
+      BitmapLoad* waiting;
+      BitmapLoad* decoding;
+      BitmapLoad* finished;
+
+      //Tells the worker threads to end
+      volatile bool terminate;
+   };
+}
@@ -0,0 +1,606 @@
+/*------------------------------------------------------------------------
+File Name: DGBlendKernels.cpp
+Description: This file contains the implementation of the blend kernels,
+   which draw bitmaps with an alpha channel into a locked surface or
+   pixel buffer. There is a plain version and an SSE2 version for every
+   pixel format, and both give exactly the same results.
+Version:
+   1.0.0    18.08.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+#include <emmintrin.h>
+
+using namespace DG;
+
+//The source pixels are premultiplied 32-bit pixels, with the alpha in
+//the highest byte followed by red, green, and blue. Each color channel
+//of the destination becomes
+//
+//    source + (destination * (255 - alpha)) / 255
+//
+//where the division is rounded to the nearest integer. The result is
+//limited to 255 in case the source wasn't premultiplied correctly.
+
+/*------------------------------------------------------------------------
+Function Name: Divide255
+Parameters:
+   UINT value : a value from 0 to 255 * 255
+Returns:
+   value / 255, rounded to the nearest integer
+Description:
+   This function divides by 255 without a division. The SSE2 kernels
+   use the same shifts and additions, so they round the same way.
+------------------------------------------------------------------------*/
+
+static inline UINT Divide255(UINT value)
+{
+   value += 128;
+   return (value + (value >> 8)) >> 8;
+}
+
+/*------------------------------------------------------------------------
+Function Name: BlendChannel
+Parameters:
+   UINT source : the premultiplied source channel
+   UINT dest : the destination channel
+   UINT inverseAlpha : 255 minus the alpha of the source pixel
+Returns:
+   The blended channel
+------------------------------------------------------------------------*/
+
+static inline UINT BlendChannel(UINT source, UINT dest, UINT inverseAlpha)
+{
+   UINT result = source + Divide255(dest * inverseAlpha);
+   return (result > 255) ? 255 : result;
+}
+
+/*------------------------------------------------------------------------
+Function Name: ApplyOpacity
+Parameters:
+   UINT pixel : a premultiplied source pixel
+   UINT opacity : the opacity to draw the bitmap with, from 0 to 255
+Returns:
+   The source pixel with all 4 channels multiplied by the opacity
+------------------------------------------------------------------------*/
+
+static inline UINT ApplyOpacity(UINT pixel, UINT opacity)
+{
+   return Divide255((pixel & 0xFF) * opacity) |
+      (Divide255(((pixel >> 8) & 0xFF) * opacity) << 8) |
+      (Divide255(((pixel >> 16) & 0xFF) * opacity) << 16) |
+      (Divide255((pixel >> 24) * opacity) << 24);
+}
+
+/*------------------------------------------------------------------------
+Function Name: BlendPixel32
+Parameters:
+   UINT source : the premultiplied source pixel
+   UINT dest : the destination pixel
+Returns:
+   The blended pixel. All 4 bytes are blended, so the highest byte of
+   the result is the same no matter which kernel blends the pixel.
+------------------------------------------------------------------------*/
+
+static inline UINT BlendPixel32(UINT source, UINT dest)
+{
+   UINT inverseAlpha = 255 - (source >> 24);
+
+   return BlendChannel(source & 0xFF, dest & 0xFF, inverseAlpha) |
+      (BlendChannel((source >> 8) & 0xFF, (dest >> 8) & 0xFF,
+         inverseAlpha) << 8) |
+      (BlendChannel((source >> 16) & 0xFF, (dest >> 16) & 0xFF,
+         inverseAlpha) << 16) |
+      (BlendChannel(source >> 24, dest >> 24, inverseAlpha) << 24);
+}
+
+/*------------------------------------------------------------------------
+Function Name: BlendPixel16
+Parameters:
+   UINT source : the premultiplied source pixel
+   UINT dest : the 16-bit destination pixel
+   int greenBits : the number of bits of green in the destination,
+      which is 6 for 5-6-5 pixels and 5 for 5-5-5 pixels
+Returns:
+   The blended 16-bit pixel
+Description:
+   The channels of the destination are widened to 8 bits by repeating
+   their highest bits, blended, and cut back to their own size. The
+   unused highest bit of a 5-5-5 pixel is kept as it was.
+------------------------------------------------------------------------*/
+
+static inline UINT BlendPixel16(UINT source, UINT dest, int greenBits)
+{
+   UINT inverseAlpha = 255 - (source >> 24);
+   int redShift = 5 + greenBits;
+   UINT greenMask = (1 << greenBits) - 1;
+
+   UINT red = (dest >> redShift) & 0x1F;
+   UINT green = (dest >> 5) & greenMask;
+   UINT blue = dest & 0x1F;
+
+   red = (red << 3) | (red >> 2);
+   green = (green << (8 - greenBits)) | (green >> ((2 * greenBits) - 8));
+   blue = (blue << 3) | (blue >> 2);
+
+   red = BlendChannel((source >> 16) & 0xFF, red, inverseAlpha);
+   green = BlendChannel((source >> 8) & 0xFF, green, inverseAlpha);
+   blue = BlendChannel(source & 0xFF, blue, inverseAlpha);
+
+   return ((red >> 3) << redShift) | ((green >> (8 - greenBits)) << 5) |
+      (blue >> 3) | (dest & ~((1 << (redShift + 5)) - 1));
+}
+
+/*------------------------------------------------------------------------
+Function Name: Select
+Parameters:
+   int pixelSize : the size of a pixel in bytes, which is 2, 3, or 4
+   DWORD greenBitMask : the green bits of a pixel, which tell 5-6-5
+      pixels from 5-5-5 pixels
+Returns:
+   The fastest blend kernel for the pixel format that the processor
+   supports
+Description:
+   This function chooses the blend kernel for a pixel format. The 24-
+   and 32-bit kernels expect red, green, and blue from the highest to
+   the lowest byte, which is how DirectDraw and the software backend lay
+   out those pixels.
+------------------------------------------------------------------------*/
+
+BlendKernel FC BlendKernels::Select(int pixelSize, DWORD greenBitMask)
+{
+   bool sse2 = FillKernels::IsSSE2Supported();
+
+   switch(pixelSize)
+   {
+      case 2:
+         if(greenBitMask == 0x03E0)
+            return sse2 ? Blend555SSE2 : Blend555;
+         return sse2 ? Blend565SSE2 : Blend565;
+      case 3:
+         return sse2 ? Blend24SSE2 : Blend24;
+      default:
+         return sse2 ? Blend32SSE2 : Blend32;
+   }
+}
+
+//Plain Kernels
+
+/*------------------------------------------------------------------------
+Function Name: Blend565
+Parameters:
+   UCHAR* dest : the first destination pixel
+   LONG destPitch : the number of bytes from one destination line to
+      the next
+   UCHAR* source : the first source pixel
+   LONG sourcePitch : the number of bytes from one source line to the
+      next
+   int width : the width of the area in pixels
+   int height : the height of the area in pixels
+   UINT opacity : the opacity of the whole bitmap, from 0 to 255
+Description:
+   This function blends premultiplied 32-bit pixels into 5-6-5 pixels.
+   Transparent source pixels are skipped.
+------------------------------------------------------------------------*/
+
+void FC BlendKernels::Blend565(UCHAR* dest, LONG destPitch, UCHAR* source,
+   LONG sourcePitch, int width, int height, UINT opacity)
+{
+   for(int y = 0; y < height; y++, dest += destPitch, source += sourcePitch)
+   {
+      USHORT* destLine = (USHORT*)dest;
+      UINT* sourceLine = (UINT*)source;
+
+      for(int x = 0; x < width; x++)
+      {
+         UINT pixel = sourceLine[x];
+
+         if(opacity != 255)
+            pixel = ApplyOpacity(pixel, opacity);
+
+         if(pixel != 0)
+            destLine[x] = USHORT(BlendPixel16(pixel, destLine[x], 6));
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Blend555
+Parameters:
+   The same as Blend565
+Description:
+   This function blends premultiplied 32-bit pixels into 5-5-5 pixels.
+------------------------------------------------------------------------*/
+
+void FC BlendKernels::Blend555(UCHAR* dest, LONG destPitch, UCHAR* source,
+   LONG sourcePitch, int width, int height, UINT opacity)
+{
+   for(int y = 0; y < height; y++, dest += destPitch, source += sourcePitch)
+   {
+      USHORT* destLine = (USHORT*)dest;
+      UINT* sourceLine = (UINT*)source;
+
+      for(int x = 0; x < width; x++)
+      {
+         UINT pixel = sourceLine[x];
+
+         if(opacity != 255)
+            pixel = ApplyOpacity(pixel, opacity);
+
+         if(pixel != 0)
+            destLine[x] = USHORT(BlendPixel16(pixel, destLine[x], 5));
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Blend24
+Parameters:
+   The same as Blend565
+Description:
+   This function blends premultiplied 32-bit pixels into 24-bit pixels.
+------------------------------------------------------------------------*/
+
+void FC BlendKernels::Blend24(UCHAR* dest, LONG destPitch, UCHAR* source,
+   LONG sourcePitch, int width, int height, UINT opacity)
+{
+   for(int y = 0; y < height; y++, dest += destPitch, source += sourcePitch)
+   {
+      UCHAR* destPixel = dest;
+      UINT* sourceLine = (UINT*)source;
+
+      for(int x = 0; x < width; x++, destPixel += 3)
+      {
+         UINT pixel = sourceLine[x];
+
+         if(opacity != 255)
+            pixel = ApplyOpacity(pixel, opacity);
+
+         if(pixel != 0)
+         {
+            UINT result = BlendPixel32(pixel, destPixel[0] |
+               (destPixel[1] << 8) | (destPixel[2] << 16));
+
+            destPixel[0] = UCHAR(result);
+            destPixel[1] = UCHAR(result >> 8);
+            destPixel[2] = UCHAR(result >> 16);
+         }
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Blend32
+Parameters:
+   The same as Blend565
+Description:
+   This function blends premultiplied 32-bit pixels into 32-bit pixels.
+------------------------------------------------------------------------*/
+
+void FC BlendKernels::Blend32(UCHAR* dest, LONG destPitch, UCHAR* source,
+   LONG sourcePitch, int width, int height, UINT opacity)
+{
+   for(int y = 0; y < height; y++, dest += destPitch, source += sourcePitch)
+   {
+      UINT* destLine = (UINT*)dest;
+      UINT* sourceLine = (UINT*)source;
+
+      for(int x = 0; x < width; x++)
+      {
+         UINT pixel = sourceLine[x];
+
+         if(opacity != 255)
+            pixel = ApplyOpacity(pixel, opacity);
+
+         if(pixel != 0)
+            destLine[x] = BlendPixel32(pixel, destLine[x]);
+      }
+   }
+}
+
+//SSE2 Kernels
+
+/*------------------------------------------------------------------------
+Function Name: Divide255SSE2
+Parameters:
+   __m128i value : 8 16-bit values from 0 to 255 * 255
+Returns:
+   Each value / 255, rounded the same way as Divide255
+------------------------------------------------------------------------*/
+
+static inline __m128i Divide255SSE2(__m128i value)
+{
+   value = _mm_add_epi16(value, _mm_set1_epi16(128));
+   return _mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 8);
+}
+
+/*------------------------------------------------------------------------
+Function Name: BlendChannelsSSE2
+Parameters:
+   __m128i source : 8 16-bit premultiplied source channels
+   __m128i dest : 8 16-bit destination channels
+   __m128i inverseAlpha : 8 16-bit values of 255 minus the source alpha
+Returns:
+   The 8 blended channels, limited to 255
+------------------------------------------------------------------------*/
+
+static inline __m128i BlendChannelsSSE2(__m128i source, __m128i dest,
+   __m128i inverseAlpha)
+{
+   __m128i result = _mm_add_epi16(source,
+      Divide255SSE2(_mm_mullo_epi16(dest, inverseAlpha)));
+   return _mm_min_epi16(result, _mm_set1_epi16(255));
+}
+
+/*------------------------------------------------------------------------
+Function Name: BlendPixels32SSE2
+Parameters:
+   __m128i source : 4 premultiplied source pixels
+   __m128i dest : 4 32-bit destination pixels
+   UINT opacity : the opacity of the whole bitmap, from 0 to 255
+Returns:
+   The 4 blended pixels
+Description:
+   The pixels are widened to 16 bits per channel, so that each half of
+   the register holds 2 pixels while they are blended.
+------------------------------------------------------------------------*/
+
+static inline __m128i BlendPixels32SSE2(__m128i source, __m128i dest,
+   UINT opacity)
+{
+   __m128i zero = _mm_setzero_si128();
+   __m128i sourceLow = _mm_unpacklo_epi8(source, zero);
+   __m128i sourceHigh = _mm_unpackhi_epi8(source, zero);
+
+   if(opacity != 255)
+   {
+      __m128i opacities = _mm_set1_epi16(short(opacity));
+      sourceLow = Divide255SSE2(_mm_mullo_epi16(sourceLow, opacities));
+      sourceHigh = Divide255SSE2(_mm_mullo_epi16(sourceHigh, opacities));
+   }
+
+   //Copy the alpha of each pixel into all 4 of its channels
+   __m128i alphaLow = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sourceLow,
+      _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+   __m128i alphaHigh = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sourceHigh,
+      _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+   __m128i full = _mm_set1_epi16(255);
+
+   __m128i resultLow = BlendChannelsSSE2(sourceLow,
+      _mm_unpacklo_epi8(dest, zero), _mm_sub_epi16(full, alphaLow));
+   __m128i resultHigh = BlendChannelsSSE2(sourceHigh,
+      _mm_unpackhi_epi8(dest, zero), _mm_sub_epi16(full, alphaHigh));
+
+   return _mm_packus_epi16(resultLow, resultHigh);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Blend16SSE2
+Parameters:
+   The same as Blend565, plus
+   int greenBits : the number of bits of green in the destination
+Description:
+   This function blends 8 pixels at a time into 16-bit pixels. The
+   channels of the source and the destination are separated into their
+   own registers of 8 16-bit values.
+------------------------------------------------------------------------*/
+
+static inline void Blend16SSE2(UCHAR* dest, LONG destPitch, UCHAR* source,
+   LONG sourcePitch, int width, int height, UINT opacity, int greenBits)
+{
+   int redShift = 5 + greenBits;
+   __m128i channelMask = _mm_set1_epi32(0xFF);
+   __m128i fiveBitMask = _mm_set1_epi16(0x1F);
+   __m128i greenMask = _mm_set1_epi16(short((1 << greenBits) - 1));
+   __m128i unusedMask = _mm_set1_epi16(short(~((1 << (redShift + 5)) - 1)));
+   __m128i opacities = _mm_set1_epi16(short(opacity));
+   __m128i full = _mm_set1_epi16(255);
+
+   for(int y = 0; y < height; y++, dest += destPitch, source += sourcePitch)
+   {
+      USHORT* destLine = (USHORT*)dest;
+      UINT* sourceLine = (UINT*)source;
+      int x = 0;
+
+      for(; x + 8 <= width; x += 8)
+      {
+         __m128i source1 = _mm_loadu_si128((__m128i*)(sourceLine + x));
+         __m128i source2 = _mm_loadu_si128((__m128i*)(sourceLine + x + 4));
+
+         //A run of transparent pixels leaves the destination alone
+         __m128i zero = _mm_setzero_si128();
+         if(_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_or_si128(source1,
+            source2), zero)) == 0xFFFF)
+            continue;
+
+         //Separate the source channels, 8 16-bit values for each
+         __m128i sourceBlue = _mm_packs_epi32(
+            _mm_and_si128(source1, channelMask),
+            _mm_and_si128(source2, channelMask));
+         __m128i sourceGreen = _mm_packs_epi32(
+            _mm_and_si128(_mm_srli_epi32(source1, 8), channelMask),
+            _mm_and_si128(_mm_srli_epi32(source2, 8), channelMask));
+         __m128i sourceRed = _mm_packs_epi32(
+            _mm_and_si128(_mm_srli_epi32(source1, 16), channelMask),
+            _mm_and_si128(_mm_srli_epi32(source2, 16), channelMask));
+         __m128i sourceAlpha = _mm_packs_epi32(_mm_srli_epi32(source1, 24),
+            _mm_srli_epi32(source2, 24));
+
+         if(opacity != 255)
+         {
+            sourceBlue = Divide255SSE2(_mm_mullo_epi16(sourceBlue,
+               opacities));
+            sourceGreen = Divide255SSE2(_mm_mullo_epi16(sourceGreen,
+               opacities));
+            sourceRed = Divide255SSE2(_mm_mullo_epi16(sourceRed,
+               opacities));
+            sourceAlpha = Divide255SSE2(_mm_mullo_epi16(sourceAlpha,
+               opacities));
+         }
+
+         __m128i inverseAlpha = _mm_sub_epi16(full, sourceAlpha);
+
+         //Separate the destination channels and widen them to 8 bits
+         __m128i pixels = _mm_loadu_si128((__m128i*)(destLine + x));
+         __m128i red = _mm_and_si128(_mm_srli_epi16(pixels, redShift),
+            fiveBitMask);
+         __m128i green = _mm_and_si128(_mm_srli_epi16(pixels, 5),
+            greenMask);
+         __m128i blue = _mm_and_si128(pixels, fiveBitMask);
+
+         red = _mm_or_si128(_mm_slli_epi16(red, 3), _mm_srli_epi16(red, 2));
+         green = _mm_or_si128(_mm_slli_epi16(green, 8 - greenBits),
+            _mm_srli_epi16(green, (2 * greenBits) - 8));
+         blue = _mm_or_si128(_mm_slli_epi16(blue, 3),
+            _mm_srli_epi16(blue, 2));
+
+         red = BlendChannelsSSE2(sourceRed, red, inverseAlpha);
+         green = BlendChannelsSSE2(sourceGreen, green, inverseAlpha);
+         blue = BlendChannelsSSE2(sourceBlue, blue, inverseAlpha);
+
+         pixels = _mm_or_si128(_mm_or_si128(
+            _mm_slli_epi16(_mm_srli_epi16(red, 3), redShift),
+            _mm_slli_epi16(_mm_srli_epi16(green, 8 - greenBits), 5)),
+            _mm_or_si128(_mm_srli_epi16(blue, 3),
+            _mm_and_si128(pixels, unusedMask)));
+
+         _mm_storeu_si128((__m128i*)(destLine + x), pixels);
+      }
+
+      for(; x < width; x++)
+      {
+         UINT pixel = sourceLine[x];
+
+         if(opacity != 255)
+            pixel = ApplyOpacity(pixel, opacity);
+
+         if(pixel != 0)
+            destLine[x] = USHORT(BlendPixel16(pixel, destLine[x],
+               greenBits));
+      }
+   }
+}
+
+void FC BlendKernels::Blend565SSE2(UCHAR* dest, LONG destPitch,
+   UCHAR* source, LONG sourcePitch, int width, int height, UINT opacity)
+{
+   Blend16SSE2(dest, destPitch, source, sourcePitch, width, height,
+      opacity, 6);
+}
+
+void FC BlendKernels::Blend555SSE2(UCHAR* dest, LONG destPitch,
+   UCHAR* source, LONG sourcePitch, int width, int height, UINT opacity)
+{
+   Blend16SSE2(dest, destPitch, source, sourcePitch, width, height,
+      opacity, 5);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Blend24SSE2
+Parameters:
+   The same as Blend565
+Description:
+   This function blends 4 pixels at a time into 24-bit pixels. SSE2
+   can't shuffle bytes, so the 3-byte pixels are gathered into 32-bit
+   pixels before they are blended and scattered again afterwards.
+------------------------------------------------------------------------*/
+
+void FC BlendKernels::Blend24SSE2(UCHAR* dest, LONG destPitch,
+   UCHAR* source, LONG sourcePitch, int width, int height, UINT opacity)
+{
+   for(int y = 0; y < height; y++, dest += destPitch, source += sourcePitch)
+   {
+      UCHAR* destPixel = dest;
+      UINT* sourceLine = (UINT*)source;
+      int x = 0;
+
+      for(; x + 4 <= width; x += 4, destPixel += 12)
+      {
+         __m128i pixels = _mm_loadu_si128((__m128i*)(sourceLine + x));
+
+         if(_mm_movemask_epi8(_mm_cmpeq_epi32(pixels,
+            _mm_setzero_si128())) == 0xFFFF)
+            continue;
+
+         __m128i destPixels = _mm_setr_epi32(
+            destPixel[0] | (destPixel[1] << 8) | (destPixel[2] << 16),
+            destPixel[3] | (destPixel[4] << 8) | (destPixel[5] << 16),
+            destPixel[6] | (destPixel[7] << 8) | (destPixel[8] << 16),
+            destPixel[9] | (destPixel[10] << 8) | (destPixel[11] << 16));
+
+         UINT results[4];
+         _mm_storeu_si128((__m128i*)results,
+            BlendPixels32SSE2(pixels, destPixels, opacity));
+
+         for(int i = 0; i < 4; i++)
+         {
+            destPixel[(i * 3)] = UCHAR(results[i]);
+            destPixel[(i * 3) + 1] = UCHAR(results[i] >> 8);
+            destPixel[(i * 3) + 2] = UCHAR(results[i] >> 16);
+         }
+      }
+
+      for(; x < width; x++, destPixel += 3)
+      {
+         UINT pixel = sourceLine[x];
+
+         if(opacity != 255)
+            pixel = ApplyOpacity(pixel, opacity);
+
+         if(pixel != 0)
+         {
+            UINT result = BlendPixel32(pixel, destPixel[0] |
+               (destPixel[1] << 8) | (destPixel[2] << 16));
+
+            destPixel[0] = UCHAR(result);
+            destPixel[1] = UCHAR(result >> 8);
+            destPixel[2] = UCHAR(result >> 16);
+         }
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Blend32SSE2
+Parameters:
+   The same as Blend565
+Description:
+   This function blends 4 pixels at a time into 32-bit pixels.
+------------------------------------------------------------------------*/
+
+void FC BlendKernels::Blend32SSE2(UCHAR* dest, LONG destPitch,
+   UCHAR* source, LONG sourcePitch, int width, int height, UINT opacity)
+{
+   for(int y = 0; y < height; y++, dest += destPitch, source += sourcePitch)
+   {
+      UINT* destLine = (UINT*)dest;
+      UINT* sourceLine = (UINT*)source;
+      int x = 0;
+
+      for(; x + 4 <= width; x += 4)
+      {
+         __m128i pixels = _mm_loadu_si128((__m128i*)(sourceLine + x));
+
+         if(_mm_movemask_epi8(_mm_cmpeq_epi32(pixels,
+            _mm_setzero_si128())) == 0xFFFF)
+            continue;
+
+         __m128i destPixels = _mm_loadu_si128((__m128i*)(destLine + x));
+
+         _mm_storeu_si128((__m128i*)(destLine + x),
+            BlendPixels32SSE2(pixels, destPixels, opacity));
+      }
+
+      for(; x < width; x++)
+      {
+         UINT pixel = sourceLine[x];
+
+         if(opacity != 255)
+            pixel = ApplyOpacity(pixel, opacity);
+
+         if(pixel != 0)
+            destLine[x] = BlendPixel32(pixel, destLine[x]);
+      }
+   }
+}
@@ -190,6 +190,7 @@ Parameters:
 void Button::SetState(UINT state)
 {
    buttonState = state;
+   Invalidate();
 }
 
 /*------------------------------------------------------------------------
@@ -206,6 +207,7 @@ void Button::SetType(UINT type)
    //Change the display window depending on the type of button
 
    buttonType = type;
+   Invalidate();
 }
 
 /*------------------------------------------------------------------------
@@ -234,6 +236,7 @@ Parameters: Color& color - the color to be used in drawing the button
 void Button::SetButtonColor(Color& color)
 {
    buttonColor = color;
+   Invalidate();
 }
 
 /*------------------------------------------------------------------------
@@ -402,6 +405,7 @@ void FC Button::OnLButtonDown(int x, int y, BYTE* keyboardState)
          delete msg;
 
          pressure = true;
+         Invalidate();
       }
 
       //Send a button pressure message to the parent
@@ -435,6 +439,8 @@ void FC Button::OnLButtonUp(int x, int y, BYTE* keyboardState)
             buttonState = BS_NORMAL;
       }
 
+      Invalidate();
+
       //Tell the parent that the button was clicked
       GetGui()->PostMessage(new Message(GM_BUTTON_CLICKED,
          GetParent()->GetWindowID(), 0, 0, GetWindowID()));
@@ -445,7 +451,11 @@ void FC Button::OnMouseLeave(int x, int y, BYTE* keyboardState)
 {
    //When the mouse leaves the window, any pressure is automatically
    //removed
-   pressure = false;
+   if(pressure)
+   {
+      pressure = false;
+      Invalidate();
+   }
 }
 
 void FC Button::OnWindowSizing()
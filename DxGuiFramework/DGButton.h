@@ -61,7 +61,8 @@ namespace DG
       void SetType(UINT type);
       UINT GetType(void) {return buttonType;}
 
-      void SetEnabled(bool buttonEnabled) {enabled = buttonEnabled;}
+      void SetEnabled(bool buttonEnabled)
+      {enabled = buttonEnabled; Invalidate();}
       bool GetEnabled(void) {return enabled;}
 
       void SetTextColor(Color& color);
@@ -0,0 +1,652 @@
+/*------------------------------------------------------------------------
+File Name: DGClipRegion.cpp
+Description: This file contains the implementation of the DG::ClipRegion
+   class, which is an area of the screen made up of any number of
+   rectangles.
+Version:
+   1.0.0    04.08.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+
+using namespace DG;
+
+//Returns true if a rectangle with an exclusive right and bottom has no
+//pixels in it
+static inline bool IsEmptyRect(RECT& rect)
+{
+   return rect.right <= rect.left || rect.bottom <= rect.top;
+}
+
+//Returns true if two rectangles with an exclusive right and bottom have
+//pixels in common
+static inline bool RectsOverlap(RECT& rect1, RECT& rect2)
+{
+   return rect1.left < rect2.right && rect2.left < rect1.right &&
+      rect1.top < rect2.bottom && rect2.top < rect1.bottom;
+}
+
+/*Default Constructor*/
+ClipRegion::ClipRegion()
+{
+   maxNumOfRects = CR_DEFAULT_SIZE;
+   regionData = (RGNDATA*)new char[sizeof(RGNDATAHEADER) +
+      (maxNumOfRects * sizeof(RECT))];
+
+   regionData->rdh.dwSize = sizeof(RGNDATAHEADER);
+   regionData->rdh.iType = RDH_RECTANGLES;
+   regionData->rdh.nCount = 0;
+   regionData->rdh.nRgnSize = 0;
+
+   CalculateBounds();
+}
+
+/*Copy Constructor*/
+ClipRegion::ClipRegion(ClipRegion& region)
+{
+   maxNumOfRects = CR_DEFAULT_SIZE;
+   if(region.GetNumOfRects() > maxNumOfRects)
+      maxNumOfRects = region.GetNumOfRects();
+
+   regionData = (RGNDATA*)new char[sizeof(RGNDATAHEADER) +
+      (maxNumOfRects * sizeof(RECT))];
+
+   memcpy(regionData, region.regionData, region.GetRegionDataSize());
+}
+
+/*Constructor*/
+ClipRegion::ClipRegion(RECT& rect)
+{
+   maxNumOfRects = CR_DEFAULT_SIZE;
+   regionData = (RGNDATA*)new char[sizeof(RGNDATAHEADER) +
+      (maxNumOfRects * sizeof(RECT))];
+
+   regionData->rdh.dwSize = sizeof(RGNDATAHEADER);
+   regionData->rdh.iType = RDH_RECTANGLES;
+   regionData->rdh.nCount = 0;
+   regionData->rdh.nRgnSize = 0;
+
+   SetRect(rect);
+}
+
+/*Destructor*/
+ClipRegion::~ClipRegion()
+{
+   if(regionData != NULL)
+      delete[] (char*)regionData;
+}
+
+/*Assignment Operator*/
+ClipRegion& ClipRegion::operator=(ClipRegion& region)
+{
+   if(&region != this)
+   {
+      Reserve(region.GetNumOfRects());
+      memcpy(regionData, region.regionData, region.GetRegionDataSize());
+   }
+
+   return *this;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Clear
+Parameters:
+Description:
+   This function removes all the rectangles from the region, leaving it
+   empty.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::Clear()
+{
+   regionData->rdh.nCount = 0;
+   regionData->rdh.nRgnSize = 0;
+
+   CalculateBounds();
+}
+
+/*------------------------------------------------------------------------
+Function Name: SetRect
+Parameters:
+   RECT& rect : the rectangle that the region is to consist of
+Description:
+   This function replaces the region with a single rectangle.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::SetRect(RECT& rect)
+{
+   regionData->rdh.nCount = 0;
+   regionData->rdh.nRgnSize = 0;
+
+   if(!IsEmptyRect(rect))
+      AddRect(rect);
+
+   CalculateBounds();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Union
+Parameters:
+   RECT& rect : the rectangle to be added to the region
+Description:
+   This function adds a rectangle to the region. The part of the region
+   that the rectangle overlaps is cut out first, so that the rectangles
+   in the region still don't overlap.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::Union(RECT& rect)
+{
+   if(IsEmptyRect(rect))
+      return;
+
+   Cut(rect);
+   AddRect(rect);
+
+   Coalesce();
+   CalculateBounds();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Union
+Parameters:
+   ClipRegion& region : the region to be added to this region
+Description:
+   This function adds all the rectangles of another region to the
+   region.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::Union(ClipRegion& region)
+{
+   if(&region == this)
+      return;
+
+   RECT* rects = region.GetRects();
+   int numOfRects = region.GetNumOfRects();
+
+   for(int i = 0; i < numOfRects; i++)
+   {
+      Cut(rects[i]);
+      AddRect(rects[i]);
+   }
+
+   Coalesce();
+   CalculateBounds();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Intersect
+Parameters:
+   RECT& rect : the rectangle to intersect the region with
+Description:
+   This function removes everything outside of the rectangle from the
+   region.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::Intersect(RECT& rect)
+{
+   RECT* rects = GetRects();
+   int i = 0;
+
+   while(i < GetNumOfRects())
+   {
+      RECT& current = rects[i];
+
+      if(current.left < rect.left)
+         current.left = rect.left;
+      if(current.top < rect.top)
+         current.top = rect.top;
+      if(current.right > rect.right)
+         current.right = rect.right;
+      if(current.bottom > rect.bottom)
+         current.bottom = rect.bottom;
+
+      if(IsEmptyRect(current))
+         RemoveRect(i);
+      else
+         i++;
+   }
+
+   Coalesce();
+   CalculateBounds();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Intersect
+Parameters:
+   ClipRegion& region : the region to intersect this region with
+Description:
+   This function removes everything outside of another region from the
+   region. Since the rectangles of both regions don't overlap, the
+   intersections of every pair of rectangles don't overlap either.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::Intersect(ClipRegion& region)
+{
+   if(&region == this)
+      return;
+
+   ClipRegion result;
+   RECT* rects = GetRects();
+   RECT* otherRects = region.GetRects();
+   RECT intersection;
+
+   for(int i = 0; i < GetNumOfRects(); i++)
+   {
+      //Skip the rectangles that are outside the other region entirely
+      if(!RectsOverlap(rects[i], region.GetBounds()))
+         continue;
+
+      for(int j = 0; j < region.GetNumOfRects(); j++)
+      {
+         if(!RectsOverlap(rects[i], otherRects[j]))
+            continue;
+
+         intersection = rects[i];
+
+         if(intersection.left < otherRects[j].left)
+            intersection.left = otherRects[j].left;
+         if(intersection.top < otherRects[j].top)
+            intersection.top = otherRects[j].top;
+         if(intersection.right > otherRects[j].right)
+            intersection.right = otherRects[j].right;
+         if(intersection.bottom > otherRects[j].bottom)
+            intersection.bottom = otherRects[j].bottom;
+
+         result.AddRect(intersection);
+      }
+   }
+
+   Swap(result);
+
+   Coalesce();
+   CalculateBounds();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Subtract
+Parameters:
+   RECT& rect : the rectangle to be cut out of the region
+Description:
+   This function removes everything inside the rectangle from the
+   region.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::Subtract(RECT& rect)
+{
+   if(IsEmptyRect(rect))
+      return;
+
+   Cut(rect);
+
+   Coalesce();
+   CalculateBounds();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Subtract
+Parameters:
+   ClipRegion& region : the region to be cut out of this region
+Description:
+   This function removes everything inside of another region from the
+   region.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::Subtract(ClipRegion& region)
+{
+   if(&region == this)
+   {
+      Clear();
+      return;
+   }
+
+   RECT* rects = region.GetRects();
+   int numOfRects = region.GetNumOfRects();
+
+   for(int i = 0; i < numOfRects; i++)
+      Cut(rects[i]);
+
+   Coalesce();
+   CalculateBounds();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Offset
+Parameters:
+   int dx : the distance to move the region along the x axis
+   int dy : the distance to move the region along the y axis
+Description:
+   This function moves every rectangle in the region.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::Offset(int dx, int dy)
+{
+   RECT* rects = GetRects();
+
+   for(int i = 0; i < GetNumOfRects(); i++)
+   {
+      rects[i].left += dx;
+      rects[i].top += dy;
+      rects[i].right += dx;
+      rects[i].bottom += dy;
+   }
+
+   CalculateBounds();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Contains
+Parameters:
+   int x : the x coordinate of the pixel
+   int y : the y coordinate of the pixel
+Returns:
+   true if the pixel is in the region, false if it isn't
+Description:
+   This function checks if a pixel is inside one of the rectangles of the
+   region.
+------------------------------------------------------------------------*/
+
+bool FC ClipRegion::Contains(int x, int y)
+{
+   RECT* rects = GetRects();
+
+   for(int i = 0; i < GetNumOfRects(); i++)
+   {
+      if(x >= rects[i].left && x < rects[i].right &&
+         y >= rects[i].top && y < rects[i].bottom)
+         return true;
+   }
+
+   return false;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Intersects
+Parameters:
+   RECT& rect : the rectangle to be checked
+Returns:
+   true if the rectangle overlaps the region, false if it doesn't
+Description:
+   This function checks if any part of a rectangle is in the region.
+------------------------------------------------------------------------*/
+
+bool FC ClipRegion::Intersects(RECT& rect)
+{
+   if(IsEmptyRect(rect) || !RectsOverlap(rect, GetBounds()))
+      return false;
+
+   RECT* rects = GetRects();
+
+   for(int i = 0; i < GetNumOfRects(); i++)
+   {
+      if(RectsOverlap(rect, rects[i]))
+         return true;
+   }
+
+   return false;
+}
+
+//Private Functions
+
+/*------------------------------------------------------------------------
+Function Name: Cut
+Parameters:
+   RECT& rect : the rectangle to be cut out of the region
+Description:
+   This function cuts a rectangle out of the region. Each rectangle in
+   the region that overlaps it is replaced by the up to 4 pieces of it
+   that are above, below, left, and right of the cut out rectangle. The
+   bounds of the region may be larger than the region afterwards.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::Cut(RECT& rect)
+{
+   if(!RectsOverlap(rect, GetBounds()))
+      return;
+
+   ClipRegion result;
+   result.Reserve(GetNumOfRects() + 4);
+
+   RECT* rects = GetRects();
+   RECT piece;
+
+   for(int i = 0; i < GetNumOfRects(); i++)
+   {
+      RECT& current = rects[i];
+
+      if(!RectsOverlap(current, rect))
+      {
+         result.AddRect(current);
+         continue;
+      }
+
+      //The piece above the cut out rectangle
+      if(current.top < rect.top)
+      {
+         piece = current;
+         piece.bottom = rect.top;
+         result.AddRect(piece);
+      }
+
+      //The piece below the cut out rectangle
+      if(current.bottom > rect.bottom)
+      {
+         piece = current;
+         piece.top = rect.bottom;
+         result.AddRect(piece);
+      }
+
+      //The pieces to the left and right only go as far up and down as
+      //the cut out rectangle
+      piece.top = (current.top > rect.top) ? current.top : rect.top;
+      piece.bottom = (current.bottom < rect.bottom) ? 
+         current.bottom : rect.bottom;
+
+      if(current.left < rect.left)
+      {
+         piece.left = current.left;
+         piece.right = rect.left;
+         result.AddRect(piece);
+      }
+
+      if(current.right > rect.right)
+      {
+         piece.left = rect.right;
+         piece.right = current.right;
+         result.AddRect(piece);
+      }
+   }
+
+   Swap(result);
+}
+
+/*------------------------------------------------------------------------
+Function Name: AddRect
+Parameters:
+   RECT& rect : the rectangle to be added
+Description:
+   This function adds a rectangle to the end of the rectangle list and
+   grows the bounds to include it. The rectangle must not overlap any 
+   rectangle in the region.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::AddRect(RECT& rect)
+{
+   Reserve(GetNumOfRects() + 1);
+
+   RECT& bounds = regionData->rdh.rcBound;
+
+   if(IsEmpty())
+      bounds = rect;
+   else
+   {
+      if(rect.left < bounds.left)
+         bounds.left = rect.left;
+      if(rect.top < bounds.top)
+         bounds.top = rect.top;
+      if(rect.right > bounds.right)
+         bounds.right = rect.right;
+      if(rect.bottom > bounds.bottom)
+         bounds.bottom = rect.bottom;
+   }
+
+   GetRects()[regionData->rdh.nCount] = rect;
+   regionData->rdh.nCount++;
+   regionData->rdh.nRgnSize = regionData->rdh.nCount * sizeof(RECT);
+}
+
+/*------------------------------------------------------------------------
+Function Name: RemoveRect
+Parameters:
+   int index : the index of the rectangle to be removed
+Description:
+   This function removes a rectangle from the rectangle list. The last
+   rectangle in the list is moved into its place.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::RemoveRect(int index)
+{
+   regionData->rdh.nCount--;
+   GetRects()[index] = GetRects()[regionData->rdh.nCount];
+   regionData->rdh.nRgnSize = regionData->rdh.nCount * sizeof(RECT);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Reserve
+Parameters:
+   int numOfRects : the number of rectangles that the region must have
+      room for
+Description:
+   This function makes sure that there is room for the given number of
+   rectangles. If there isn't, the rectangle list is at least doubled in
+   size.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::Reserve(int numOfRects)
+{
+   if(numOfRects <= maxNumOfRects)
+      return;
+
+   int newMaxNumOfRects = maxNumOfRects * 2;
+   if(newMaxNumOfRects < numOfRects)
+      newMaxNumOfRects = numOfRects;
+
+   RGNDATA* newRegionData = (RGNDATA*)new char[sizeof(RGNDATAHEADER) +
+      (newMaxNumOfRects * sizeof(RECT))];
+
+   memcpy(newRegionData, regionData, GetRegionDataSize());
+
+   delete[] (char*)regionData;
+   regionData = newRegionData;
+   maxNumOfRects = newMaxNumOfRects;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Coalesce
+Parameters:
+Description:
+   This function merges rectangles which are next to each other and
+   which have the same height or width into a single rectangle. Cutting
+   rectangles out of a region breaks it up into many pieces and this
+   keeps the number of rectangles that have to be clipped against down.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::Coalesce()
+{
+   RECT* rects = GetRects();
+   bool merged = true;
+
+   while(merged)
+   {
+      merged = false;
+
+      for(int i = 0; i < GetNumOfRects() && !merged; i++)
+      {
+         for(int j = i + 1; j < GetNumOfRects() && !merged; j++)
+         {
+            RECT& rect1 = rects[i];
+            RECT& rect2 = rects[j];
+
+            //Rectangles side by side with the same top and bottom
+            if(rect1.top == rect2.top && rect1.bottom == rect2.bottom &&
+               (rect1.right == rect2.left || rect2.right == rect1.left))
+            {
+               if(rect2.left < rect1.left)
+                  rect1.left = rect2.left;
+               if(rect2.right > rect1.right)
+                  rect1.right = rect2.right;
+               merged = true;
+            }
+            //Rectangles on top of each other with the same left and right
+            else if(rect1.left == rect2.left && rect1.right == rect2.right &&
+               (rect1.bottom == rect2.top || rect2.bottom == rect1.top))
+            {
+               if(rect2.top < rect1.top)
+                  rect1.top = rect2.top;
+               if(rect2.bottom > rect1.bottom)
+                  rect1.bottom = rect2.bottom;
+               merged = true;
+            }
+
+            if(merged)
+               RemoveRect(j);
+         }
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: CalculateBounds
+Parameters:
+Description:
+   This function calculates the rectangle which encloses all the
+   rectangles of the region. The bounds of an empty region are an empty
+   rectangle.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::CalculateBounds()
+{
+   RECT& bounds = regionData->rdh.rcBound;
+
+   if(IsEmpty())
+   {
+      bounds.left = 0;
+      bounds.top = 0;
+      bounds.right = 0;
+      bounds.bottom = 0;
+      return;
+   }
+
+   RECT* rects = GetRects();
+   bounds = rects[0];
+
+   for(int i = 1; i < GetNumOfRects(); i++)
+   {
+      if(rects[i].left < bounds.left)
+         bounds.left = rects[i].left;
+      if(rects[i].top < bounds.top)
+         bounds.top = rects[i].top;
+      if(rects[i].right > bounds.right)
+         bounds.right = rects[i].right;
+      if(rects[i].bottom > bounds.bottom)
+         bounds.bottom = rects[i].bottom;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Swap
+Parameters:
+   ClipRegion& region : the region to swap rectangles with
+Description:
+   This function exchanges the rectangles of two regions without
+   copying them.
+------------------------------------------------------------------------*/
+
+void FC ClipRegion::Swap(ClipRegion& region)
+{
+   RGNDATA* tempRegionData = regionData;
+   regionData = region.regionData;
+   region.regionData = tempRegionData;
+
+   int tempMaxNumOfRects = maxNumOfRects;
+   maxNumOfRects = region.maxNumOfRects;
+   region.maxNumOfRects = tempMaxNumOfRects;
+}
@@ -0,0 +1,68 @@
+/*------------------------------------------------------------------------
+File Name: DGClipRegion.h
+Description: This file contains the DG::ClipRegion class, which is an
+   area of the screen made up of any number of rectangles. It is used
+   for the clip list of the drawing surface.
+Version:
+   1.0.0    04.08.2002  Created the file
+------------------------------------------------------------------------*/
+
+#pragma once
+
+#define CR_DEFAULT_SIZE    8
+
+namespace DG
+{
+   //The rectangles in a region never overlap and are never empty. Like
+   //the RECTs passed to DirectDraw, they have an exclusive right and
+   //bottom. The rectangles are stored in an RGNDATA structure, so the
+   //region can be handed to a DirectDraw clipper or to GDI as it is.
+   class ClipRegion
+   {
+   public:
+      ClipRegion();
+      ClipRegion(ClipRegion& region);
+      ClipRegion(RECT& rect);
+      virtual ~ClipRegion();
+
+      ClipRegion& operator=(ClipRegion& region);
+
+      void FC Clear(void);
+      void FC SetRect(RECT& rect);
+
+      //Region algebra
+      void FC Union(RECT& rect);
+      void FC Union(ClipRegion& region);
+      void FC Intersect(RECT& rect);
+      void FC Intersect(ClipRegion& region);
+      void FC Subtract(RECT& rect);
+      void FC Subtract(ClipRegion& region);
+      void FC Offset(int dx, int dy);
+
+      bool FC Contains(int x, int y);
+      bool FC Intersects(RECT& rect);
+
+      bool IsEmpty(void) {return regionData->rdh.nCount == 0;}
+      int GetNumOfRects(void) {return int(regionData->rdh.nCount);}
+      RECT* GetRects(void) {return (RECT*)regionData->Buffer;}
+      RECT& GetBounds(void) {return regionData->rdh.rcBound;}
+
+      RGNDATA* GetRegionData(void) {return regionData;}
+      DWORD GetRegionDataSize(void)
+      {return sizeof(RGNDATAHEADER) + regionData->rdh.nRgnSize;}
+
+   private:
+      void FC Cut(RECT& rect);
+      void FC AddRect(RECT& rect);
+      void FC RemoveRect(int index);
+      void FC Reserve(int numOfRects);
+      void FC Coalesce(void);
+      void FC CalculateBounds(void);
+      void FC Swap(ClipRegion& region);
+
+      RGNDATA* regionData;
+
+      //The number of rectangles there is room for in regionData
+      int maxNumOfRects;
+   };
+}
@@ -0,0 +1,291 @@
+/*------------------------------------------------------------------------
+File Name: DGConvertKernels.cpp
+Description: This file contains the implementation of the convert
+   kernels, which turn the 24-bit pixels of a bitmap file into the pixel
+   format of the screen a line at a time.
+Version:
+   1.0.0    13.10.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+#include <emmintrin.h>
+
+using namespace DG;
+
+/*------------------------------------------------------------------------
+Function Name: Select
+Parameters:
+   int pixelSize : the size of a destination pixel in bytes
+   DDPIXELFORMAT& pixelFormat : the pixel format of the destination
+Returns:
+   The kernel which converts a line of file pixels to the pixel format
+Description:
+   The SSE2 kernels, and the copy of 24-bit pixels, only work with the
+   common pixel formats. Any other format goes through the plain
+   kernels, which use the color lookup tables.
+------------------------------------------------------------------------*/
+
+ConvertKernel FC ConvertKernels::Select(int pixelSize, 
+   DDPIXELFORMAT& pixelFormat)
+{
+   bool sse2 = FillKernels::IsSSE2Supported();
+   bool standardBlue = pixelFormat.dwBBitMask == 0x001F;
+
+   switch(pixelSize)
+   {
+      case 2:
+         if(sse2 && standardBlue && pixelFormat.dwGBitMask == 0x07E0 &&
+            pixelFormat.dwRBitMask == 0xF800)
+            return Convert565SSE2;
+         if(sse2 && standardBlue && pixelFormat.dwGBitMask == 0x03E0 &&
+            pixelFormat.dwRBitMask == 0x7C00)
+            return Convert555SSE2;
+         return Convert16;
+      case 3:
+         if(pixelFormat.dwRBitMask == 0xFF0000 && 
+            pixelFormat.dwGBitMask == 0xFF00 && 
+            pixelFormat.dwBBitMask == 0xFF)
+            return Copy24;
+         return Convert24;
+      default:
+         if(sse2 && pixelFormat.dwRBitMask == 0xFF0000 && 
+            pixelFormat.dwGBitMask == 0xFF00 && 
+            pixelFormat.dwBBitMask == 0xFF)
+            return Convert32SSE2;
+         return Convert32;
+   }
+}
+
+//Plain Kernels
+
+/*------------------------------------------------------------------------
+Function Name: Convert16
+Parameters:
+   UCHAR* dest : the first destination pixel
+   UCHAR* source : the first file pixel, with blue, green and red in
+      that order
+   int width : the number of pixels in the line
+   ConvertTables* tables : the color lookup tables of the pixel format
+Description:
+   This function converts a line of file pixels to 16-bit pixels.
+------------------------------------------------------------------------*/
+
+void FC ConvertKernels::Convert16(UCHAR* dest, UCHAR* source, int width,
+   ConvertTables* tables)
+{
+   USHORT* destLine = (USHORT*)dest;
+
+   for(int x = 0; x < width; x++, source += 3)
+   {
+      destLine[x] = USHORT(tables->red[source[2]] | 
+         tables->green[source[1]] | tables->blue[source[0]]);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Convert24
+Parameters:
+   The same as Convert16
+Description:
+   This function converts a line of file pixels to 24-bit pixels.
+------------------------------------------------------------------------*/
+
+void FC ConvertKernels::Convert24(UCHAR* dest, UCHAR* source, int width,
+   ConvertTables* tables)
+{
+   for(int x = 0; x < width; x++, source += 3, dest += 3)
+   {
+      UINT pixel = tables->red[source[2]] | tables->green[source[1]] | 
+         tables->blue[source[0]];
+
+      dest[0] = UCHAR(pixel);
+      dest[1] = UCHAR(pixel >> 8);
+      dest[2] = UCHAR(pixel >> 16);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Convert32
+Parameters:
+   The same as Convert16
+Description:
+   This function converts a line of file pixels to 32-bit pixels.
+------------------------------------------------------------------------*/
+
+void FC ConvertKernels::Convert32(UCHAR* dest, UCHAR* source, int width,
+   ConvertTables* tables)
+{
+   UINT* destLine = (UINT*)dest;
+
+   for(int x = 0; x < width; x++, source += 3)
+   {
+      destLine[x] = tables->red[source[2]] | tables->green[source[1]] | 
+         tables->blue[source[0]];
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Copy24
+Parameters:
+   The same as Convert16
+Description:
+   When the screen has the same 24-bit format as the file, a line is
+   just copied.
+------------------------------------------------------------------------*/
+
+void FC ConvertKernels::Copy24(UCHAR* dest, UCHAR* source, int width,
+   ConvertTables* tables)
+{
+   memcpy(dest, source, width * 3);
+}
+
+//SSE2 Kernels
+
+/*------------------------------------------------------------------------
+Function Name: Load4PixelsSSE2
+Parameters:
+   UCHAR* source : the first of 4 file pixels
+Returns:
+   The 4 pixels in the layout 0x00RRGGBB
+Description:
+   Each pixel is read as 4 bytes, so 1 byte past the last pixel is read
+   as well. The callers make sure that it is still part of the line.
+------------------------------------------------------------------------*/
+
+static inline __m128i Load4PixelsSSE2(UCHAR* source)
+{
+   __m128i pixels = _mm_set_epi32(*(int*)(source + 9), 
+      *(int*)(source + 6), *(int*)(source + 3), *(int*)source);
+   return _mm_and_si128(pixels, _mm_set1_epi32(0x00FFFFFF));
+}
+
+/*------------------------------------------------------------------------
+Function Name: ScaleChannelSSE2
+Parameters:
+   __m128i channel : 4 32-bit values from 0 to 255
+   __m128i maxValue : the largest value of the destination channel, in 
+      every 16-bit value
+Returns:
+   channel * maxValue / 255, rounded down like the color lookup tables
+Description:
+   The product is at most 255 * 63, for which (v + 1 + (v >> 8)) >> 8 is
+   the same as v / 255. The upper half of each 32-bit value stays 0.
+------------------------------------------------------------------------*/
+
+static inline __m128i ScaleChannelSSE2(__m128i channel, __m128i maxValue)
+{
+   __m128i value = _mm_mullo_epi16(channel, maxValue);
+   value = _mm_add_epi16(value, _mm_set1_epi32(1));
+   return _mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 
+      8);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Convert4Pixels16SSE2
+Parameters:
+   UCHAR* source : the first of 4 file pixels
+   int greenBits : the number of bits of green in the destination
+Returns:
+   The 4 pixels as 16-bit pixels, one in each 32-bit value
+------------------------------------------------------------------------*/
+
+static inline __m128i Convert4Pixels16SSE2(UCHAR* source, int greenBits)
+{
+   __m128i pixels = Load4PixelsSSE2(source);
+   __m128i channelMask = _mm_set1_epi32(0xFF);
+   __m128i fiveBitMax = _mm_set1_epi32(31);
+   __m128i greenMax = _mm_set1_epi32((1 << greenBits) - 1);
+
+   __m128i red = ScaleChannelSSE2(_mm_srli_epi32(pixels, 16), fiveBitMax);
+   __m128i green = ScaleChannelSSE2(_mm_and_si128(_mm_srli_epi32(pixels, 
+      8), channelMask), greenMax);
+   __m128i blue = ScaleChannelSSE2(_mm_and_si128(pixels, channelMask), 
+      fiveBitMax);
+
+   return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(red, 5 + greenBits),
+      _mm_slli_epi32(green, 5)), blue);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Convert16SSE2
+Parameters:
+   The same as Convert16, plus
+   int greenBits : the number of bits of green in the destination
+Description:
+   This function converts 8 pixels at a time to 16-bit pixels. The last
+   few pixels of the line are left to the plain kernel.
+------------------------------------------------------------------------*/
+
+static inline void Convert16SSE2(UCHAR* dest, UCHAR* source, int width,
+   int greenBits, ConvertTables* tables)
+{
+   USHORT* destLine = (USHORT*)dest;
+   int x = 0;
+
+   //The last group must not read the byte after the line
+   for(; x + 8 < width; x += 8, source += 24)
+   {
+      __m128i low = Convert4Pixels16SSE2(source, greenBits);
+      __m128i high = Convert4Pixels16SSE2(source + 12, greenBits);
+
+      //The pixels are moved to the top of each 32-bit value and back
+      //down with the sign, so that the signed pack keeps all 16 bits
+      low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+      high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+
+      _mm_storeu_si128((__m128i*)(destLine + x), _mm_packs_epi32(low, 
+         high));
+   }
+
+   ConvertKernels::Convert16((UCHAR*)(destLine + x), source, width - x,
+      tables);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Convert565SSE2
+Parameters:
+   The same as Convert16
+Description:
+   This function converts a line of file pixels to 5-6-5 pixels.
+------------------------------------------------------------------------*/
+
+void FC ConvertKernels::Convert565SSE2(UCHAR* dest, UCHAR* source, 
+   int width, ConvertTables* tables)
+{
+   Convert16SSE2(dest, source, width, 6, tables);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Convert555SSE2
+Parameters:
+   The same as Convert16
+Description:
+   This function converts a line of file pixels to 5-5-5 pixels.
+------------------------------------------------------------------------*/
+
+void FC ConvertKernels::Convert555SSE2(UCHAR* dest, UCHAR* source, 
+   int width, ConvertTables* tables)
+{
+   Convert16SSE2(dest, source, width, 5, tables);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Convert32SSE2
+Parameters:
+   The same as Convert16
+Description:
+   This function converts 4 pixels at a time to 32-bit pixels with the
+   layout 0x00RRGGBB.
+------------------------------------------------------------------------*/
+
+void FC ConvertKernels::Convert32SSE2(UCHAR* dest, UCHAR* source, 
+   int width, ConvertTables* tables)
+{
+   UINT* destLine = (UINT*)dest;
+   int x = 0;
+
+   for(; x + 4 < width; x += 4, source += 12)
+      _mm_storeu_si128((__m128i*)(destLine + x), Load4PixelsSSE2(source));
+
+   Convert32((UCHAR*)(destLine + x), source, width - x, tables);
+}
@@ -0,0 +1,432 @@
+/*------------------------------------------------------------------------
+File Name: DGDisplayList.cpp
+Description: This file contains the implementation of the
+   DG::DisplayList class, which holds the drawing of a window as a list
+   of commands.
+Version:
+   1.0.0    06.10.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+
+using namespace DG;
+
+/*Constructor*/
+DisplayList::DisplayList()
+{
+   maxNumOfCommands = 64;
+   commands = new DisplayCommand[maxNumOfCommands];
+   numOfCommands = 0;
+
+   maxTextSize = 256;
+   text = new char[maxTextSize];
+   textSize = 0;
+
+   fonts = NULL;
+   numOfFonts = 0;
+   maxNumOfFonts = 0;
+
+   valid = false;
+}
+
+/*Destructor*/
+DisplayList::~DisplayList()
+{
+   delete[] commands;
+   delete[] text;
+
+   if(fonts != NULL)
+      delete[] fonts;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Clear
+Parameters:
+Description:
+   This function removes all the commands from the list, so that it can
+   be recorded again. The memory of the list is kept.
+------------------------------------------------------------------------*/
+
+void FC DisplayList::Clear(void)
+{
+   numOfCommands = 0;
+   textSize = 0;
+
+   //The fonts are let go, so that they can be freed
+   if(fonts != NULL)
+   {
+      delete[] fonts;
+      fonts = NULL;
+   }
+
+   numOfFonts = 0;
+   maxNumOfFonts = 0;
+
+   valid = false;
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetMemoryUsage
+Parameters:
+Returns:
+   The number of bytes that the list uses
+------------------------------------------------------------------------*/
+
+UINT FC DisplayList::GetMemoryUsage(void)
+{
+   return (maxNumOfCommands * sizeof(DisplayCommand)) + maxTextSize +
+      (maxNumOfFonts * sizeof(Font));
+}
+
+/*------------------------------------------------------------------------
+Function Name: Add
+Parameters:
+   UINT type : the type of the command
+Description:
+   This function adds a command without parameters, such as DL_LOCK or
+   DL_REMOVECLIPPING, to the end of the list.
+------------------------------------------------------------------------*/
+
+void FC DisplayList::Add(UINT type)
+{
+   AddCommand(type);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Add
+Parameters:
+   UINT type : the type of the command
+   int x1, int y1, int x2, int y2 : the coordinates of the command
+   Color& color : the color of the command
+Description:
+   This function adds a command that draws with a color, or sets one, to
+   the end of the list.
+------------------------------------------------------------------------*/
+
+void FC DisplayList::Add(UINT type, int x1, int y1, int x2, int y2,
+   Color& color)
+{
+   DisplayCommand& command = AddCommand(type);
+   command.x1 = x1;
+   command.y1 = y1;
+   command.x2 = x2;
+   command.y2 = y2;
+   command.color = color;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Add
+Parameters:
+   UINT type : the type of the command
+   int x1, int y1, int x2, int y2 : the coordinates of the command
+   UINT parameter : the bitmap ID or the text transparency mode
+   UINT flags : the opacity of an alpha bitmap
+Description:
+   This function adds a command that draws a bitmap, changes the
+   clipping or sets the text transparency to the end of the list.
+------------------------------------------------------------------------*/
+
+void FC DisplayList::Add(UINT type, int x1, int y1, int x2, int y2,
+   UINT parameter, UINT flags)
+{
+   DisplayCommand& command = AddCommand(type);
+   command.x1 = x1;
+   command.y1 = y1;
+   command.x2 = x2;
+   command.y2 = y2;
+   command.parameter = parameter;
+   command.flags = flags;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Add
+Parameters:
+   UINT type : the type of the command
+   int x1, int y1, int x2, int y2 : the coordinates of the command
+   UINT parameter : the bitmap ID
+   Color& color : the transparent color of the bitmap
+Description:
+   This function adds a command that draws a bitmap with a transparent
+   color to the end of the list.
+------------------------------------------------------------------------*/
+
+void FC DisplayList::Add(UINT type, int x1, int y1, int x2, int y2,
+   UINT parameter, Color& color)
+{
+   DisplayCommand& command = AddCommand(type);
+   command.x1 = x1;
+   command.y1 = y1;
+   command.x2 = x2;
+   command.y2 = y2;
+   command.parameter = parameter;
+   command.color = color;
+}
+
+/*------------------------------------------------------------------------
+Function Name: AddText
+Parameters:
+   char* text : the text to be drawn
+   Rectangle& rect : the rectangle the text is drawn in
+   UINT flags : the Win32 API DrawText() flags
+Description:
+   This function adds a command that draws text to the end of the list.
+   The text is copied, so the string can change after it is recorded.
+------------------------------------------------------------------------*/
+
+void FC DisplayList::AddText(char* textString, Rectangle& rect, UINT flags)
+{
+   UINT length = UINT(strlen(textString)) + 1;
+
+   if(textSize + length > maxTextSize)
+   {
+      UINT newMaxTextSize = maxTextSize * 2;
+      while(textSize + length > newMaxTextSize)
+         newMaxTextSize *= 2;
+
+      char* newText = new char[newMaxTextSize];
+      memcpy(newText, text, textSize);
+      delete[] text;
+
+      text = newText;
+      maxTextSize = newMaxTextSize;
+   }
+
+   DisplayCommand& command = AddCommand(DL_TEXT);
+   command.x1 = rect.left;
+   command.y1 = rect.top;
+   command.x2 = rect.right;
+   command.y2 = rect.bottom;
+   command.parameter = textSize;
+   command.flags = flags;
+
+   memcpy(text + textSize, textString, length);
+   textSize += length;
+}
+
+/*------------------------------------------------------------------------
+Function Name: AddFont
+Parameters:
+   Font& font : the font that text is drawn with
+Description:
+   This function adds a command that sets the font to the end of the
+   list. The list holds on to the font until it is cleared, so the font
+   stays in the font registry. A font that is set more than once is only
+   kept once.
+------------------------------------------------------------------------*/
+
+void FC DisplayList::AddFont(Font& font)
+{
+   int index;
+
+   for(index = 0; index < numOfFonts; index++)
+   {
+      if(fonts[index] == font)
+         break;
+   }
+
+   if(index == numOfFonts)
+   {
+      if(numOfFonts == maxNumOfFonts)
+      {
+         int newMaxNumOfFonts = (maxNumOfFonts == 0) ? 4 :
+            maxNumOfFonts * 2;
+         Font* newFonts = new Font[newMaxNumOfFonts];
+
+         for(int i = 0; i < numOfFonts; i++)
+            newFonts[i] = fonts[i];
+
+         if(fonts != NULL)
+            delete[] fonts;
+
+         fonts = newFonts;
+         maxNumOfFonts = newMaxNumOfFonts;
+      }
+
+      fonts[numOfFonts++] = font;
+   }
+
+   AddCommand(DL_FONT).parameter = index;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Replay
+Parameters:
+   WindowSurface* surface : the surface to draw the commands on
+Description:
+   This function draws the commands of the list on a surface, in the
+   order they were recorded. The surface must not be recording.
+------------------------------------------------------------------------*/
+
+void FC DisplayList::Replay(WindowSurface* surface)
+{
+   assert(!surface->IsRecording());
+
+   for(int i = 0; i < numOfCommands; i++)
+   {
+      DisplayCommand& command = commands[i];
+
+      switch(command.type)
+      {
+         case DL_LOCK:
+            surface->LockSurface();
+            break;
+         case DL_UNLOCK:
+            surface->UnlockSurface();
+            break;
+         case DL_PIXEL:
+            surface->SetPixel(command.x1, command.y1, command.color);
+            break;
+         case DL_HORIZONTALLINE:
+            surface->DrawHorizontalLine(command.x1, command.x2,
+               command.y1, command.color);
+            break;
+         case DL_VERTICALLINE:
+            surface->DrawVerticalLine(command.x1, command.y1,
+               command.y2, command.color);
+            break;
+         case DL_LINE:
+            surface->DrawLine(Point(command.x1, command.y1),
+               Point(command.x2, command.y2), command.color);
+            break;
+         case DL_RECTANGLE:
+            surface->DrawRectangle(Rectangle(command.x1, command.y1,
+               command.x2, command.y2), command.color);
+            break;
+         case DL_FILLEDRECTANGLE:
+            surface->DrawFilledRectangle(Rectangle(command.x1, command.y1,
+               command.x2, command.y2), command.color);
+            break;
+         case DL_FILLAREA:
+            surface->FillArea(Area(command.x1, command.y1, command.x2,
+               command.y2), command.color);
+            break;
+         case DL_FILLSURFACE:
+            surface->FillSurface(command.color);
+            break;
+         case DL_BITMAP:
+            surface->DrawBitmap(Point(command.x1, command.y1),
+               command.parameter);
+            break;
+         case DL_SCALEDBITMAP:
+            surface->DrawScaledBitmap(Area(command.x1, command.y1,
+               command.x2, command.y2), command.parameter);
+            break;
+         case DL_TRANSPARENTBITMAP:
+            surface->DrawTransparentBitmap(Point(command.x1, command.y1),
+               command.parameter, command.color);
+            break;
+         case DL_TRANSPARENTSCALEDBITMAP:
+            surface->DrawTransparentScaledBitmap(Area(command.x1,
+               command.y1, command.x2, command.y2), command.parameter,
+               command.color);
+            break;
+         case DL_KEYEDBITMAP:
+            surface->DrawTransparentBitmap(Point(command.x1, command.y1),
+               command.parameter);
+            break;
+         case DL_KEYEDSCALEDBITMAP:
+            surface->DrawTransparentScaledBitmap(Area(command.x1,
+               command.y1, command.x2, command.y2), command.parameter);
+            break;
+         case DL_ALPHABITMAP:
+            surface->DrawAlphaBitmap(Point(command.x1, command.y1),
+               command.parameter);
+            break;
+         case DL_FADEDALPHABITMAP:
+            surface->DrawAlphaBitmap(Point(command.x1, command.y1),
+               command.parameter, BYTE(command.flags));
+            break;
+         case DL_FONT:
+            surface->SetGDIFont(fonts[command.parameter]);
+            break;
+         case DL_TEXTTRANSPARENCY:
+            surface->SetTextTransparency(int(command.parameter));
+            break;
+         case DL_TEXTCOLOR:
+            surface->SetTextColor(command.color);
+            break;
+         case DL_TEXTBACKGROUNDCOLOR:
+            surface->SetTextBackgroundColor(command.color);
+            break;
+         case DL_TEXT:
+         {
+            //DrawText() moves the rectangle it is given
+            Rectangle rect(command.x1, command.y1, command.x2,
+               command.y2);
+            surface->DrawText(text + command.parameter, rect,
+               command.flags);
+            break;
+         }
+         case DL_ADDCLIPPING:
+            surface->AddClippingArea(Rectangle(command.x1, command.y1,
+               command.x2, command.y2));
+            break;
+         case DL_INTERSECTCLIPPING:
+            surface->IntersectClippingArea(Rectangle(command.x1,
+               command.y1, command.x2, command.y2));
+            break;
+         case DL_SUBTRACTCLIPPING:
+            surface->SubtractClippingArea(Rectangle(command.x1,
+               command.y1, command.x2, command.y2));
+            break;
+         case DL_REMOVECLIPPING:
+            surface->RemoveClippingArea();
+            break;
+         case DL_CLEARCLIPPING:
+            surface->ClearClippingAreas();
+            break;
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Replay
+Parameters:
+   WindowSurface* surface : the surface to draw the commands on
+   Point& offset : how far the commands are moved from where they were
+      recorded
+Description:
+   This function draws the commands of the list on a surface, moved by
+   an offset.
+------------------------------------------------------------------------*/
+
+void FC DisplayList::Replay(WindowSurface* surface, Point& offset)
+{
+   Point origin = surface->GetWindowOrigin();
+
+   surface->SetWindowOrigin(Point(origin.x + offset.x,
+      origin.y + offset.y));
+   Replay(surface);
+   surface->SetWindowOrigin(origin);
+}
+
+/*------------------------------------------------------------------------
+Function Name: AddCommand
+Parameters:
+   UINT type : the type of the command
+Returns:
+   The new command
+Description:
+   This function adds a command to the end of the list, making room for
+   it if needed.
+------------------------------------------------------------------------*/
+
+DisplayCommand& FC DisplayList::AddCommand(UINT type)
+{
+   if(numOfCommands == maxNumOfCommands)
+   {
+      DisplayCommand* newCommands =
+         new DisplayCommand[maxNumOfCommands * 2];
+      memcpy(newCommands, commands,
+         maxNumOfCommands * sizeof(DisplayCommand));
+      delete[] commands;
+
+      commands = newCommands;
+      maxNumOfCommands *= 2;
+   }
+
+   DisplayCommand& command = commands[numOfCommands++];
+   command.type = type;
+
+   return command;
+}
@@ -0,0 +1,119 @@
+/*------------------------------------------------------------------------
+File Name: DGDisplayList.h
+Description: This file contains the DG::DisplayList class, which holds
+   the drawing of a window as a list of commands that can be drawn again
+   without calling the OnDrawWindow function of the window.
+Version:
+   1.0.0    06.10.2002  Created the file
+------------------------------------------------------------------------*/
+
+#pragma once
+
+//The types of display list commands
+#define DL_LOCK                        1
+#define DL_UNLOCK                      2
+#define DL_PIXEL                       3
+#define DL_HORIZONTALLINE              4
+#define DL_VERTICALLINE                5
+#define DL_LINE                        6
+#define DL_RECTANGLE                   7
+#define DL_FILLEDRECTANGLE             8
+#define DL_FILLAREA                    9
+#define DL_FILLSURFACE                 10
+#define DL_BITMAP                      11
+#define DL_SCALEDBITMAP                12
+#define DL_TRANSPARENTBITMAP           13
+#define DL_TRANSPARENTSCALEDBITMAP     14
+#define DL_KEYEDBITMAP                 15
+#define DL_KEYEDSCALEDBITMAP           16
+#define DL_ALPHABITMAP                 17
+#define DL_FADEDALPHABITMAP            18
+#define DL_FONT                        19
+#define DL_TEXTTRANSPARENCY            20
+#define DL_TEXTCOLOR                   21
+#define DL_TEXTBACKGROUNDCOLOR         22
+#define DL_TEXT                        23
+#define DL_ADDCLIPPING                 24
+#define DL_INTERSECTCLIPPING           25
+#define DL_SUBTRACTCLIPPING            26
+#define DL_REMOVECLIPPING              27
+#define DL_CLEARCLIPPING               28
+
+namespace DG
+{
+   class WindowSurface;
+
+   //A recorded call to a drawing function of a window surface. Which
+   //members are used depends on the type of the command.
+   class DisplayCommand
+   {
+   public:
+      UINT type;
+
+      //A point, the ends of a line, a rectangle, or the left, top, width
+      //and height of an area, relative to the upper-left corner of the
+      //window
+      int x1, y1;
+      int x2, y2;
+
+      //A bitmap ID, the index of a font, where the text starts in the
+      //text of the list, or a text transparency mode
+      UINT parameter;
+
+      //The DrawText() flags of text or the opacity of an alpha bitmap
+      UINT flags;
+
+      Color color;
+   };
+
+   class DisplayList
+   {
+   public:
+      DisplayList();
+      virtual ~DisplayList();
+
+      void FC Clear(void);
+
+      //A list is valid from the time it is recorded until the window
+      //draws something else
+      bool IsValid(void) {return valid;}
+      void Validate(void) {valid = true;}
+      void Invalidate(void) {valid = false;}
+
+      int GetNumOfCommands(void) {return numOfCommands;}
+      DisplayCommand& GetCommand(int index) {return commands[index];}
+      UINT FC GetMemoryUsage(void);
+
+      void FC Add(UINT type);
+      void FC Add(UINT type, int x1, int y1, int x2, int y2, Color& color);
+      void FC Add(UINT type, int x1, int y1, int x2, int y2,
+         UINT parameter, UINT flags = 0);
+      void FC Add(UINT type, int x1, int y1, int x2, int y2,
+         UINT parameter, Color& color);
+      void FC AddText(char* text, Rectangle& rect, UINT flags);
+      void FC AddFont(Font& font);
+
+      void FC Replay(WindowSurface* surface);
+      void FC Replay(WindowSurface* surface, Point& offset);
+
+   private:
+      DisplayCommand& FC AddCommand(UINT type);
+
+      DisplayCommand* commands;
+      int numOfCommands;
+      int maxNumOfCommands;
+
+      //The text of all the DL_TEXT commands, each with its terminating
+      //null character
+      char* text;
+      UINT textSize;
+      UINT maxTextSize;
+
+      //The fonts of the DL_FONT commands
+      Font* fonts;
+      int numOfFonts;
+      int maxNumOfFonts;
+
+      bool valid;
+   };
+}
@@ -21,8 +21,6 @@ Edit::Edit(UINT winID, Window* parentWin) :
 {
    SetWindowType(WT_EDIT);
    SetParent(parentWin);
-
-   lastBlinkTime = ::GetTickCount();
 }
 
 Edit::Edit(UINT winID, Window* parentWin, const int xPos, 
@@ -41,8 +39,6 @@ Edit::Edit(UINT winID, Window* parentWin, const int xPos,
    backgroundColor = backColor;
    font = _font;
    parentNotify = _parentNotify;
-
-   lastBlinkTime = ::GetTickCount();
 }
 
 Edit::Edit(UINT winID, Window* parentWin, const Area& dimensions,
@@ -60,8 +56,6 @@ Edit::Edit(UINT winID, Window* parentWin, const Area& dimensions,
    backgroundColor = backColor;
    font = _font;
    parentNotify = _parentNotify;
-
-   lastBlinkTime = ::GetTickCount();
 }
 
 Edit::Edit(UINT winID, Window* parentWin, const Point& position, 
@@ -79,8 +73,6 @@ Edit::Edit(UINT winID, Window* parentWin, const Point& position,
    backgroundColor = backColor;
    font = _font;
    parentNotify = _parentNotify;   
-
-   lastBlinkTime = ::GetTickCount();
 }
 
 /*Overridden message-handling methods*/
@@ -106,21 +98,10 @@ void FC Edit::OnDrawWindow(WindowSurface* surface)
 
    surface->LockSurface();
 
-   //If we don't have focus, then don't draw the cursor
+   //If we don't have focus, then don't draw the cursor. The blink timer
+   //turns the cursor on and off and redraws the control each time.
    if(GetGui()->GetWindowFocus() == GetWindowID())
    {
-      //Draw the cursor when necessary
-      DWORD currentTime = ::GetTickCount();
-      if(currentTime - lastBlinkTime >= DGEDIT_BLINK_RATE)
-      {
-         lastBlinkTime = currentTime;
-
-         if(cursorOn)
-            cursorOn = false;
-         else
-            cursorOn = true;
-      }
-
       if(cursorOn)
       {
          int fontHeight = font.GetHeight();
@@ -196,10 +177,38 @@ void FC Edit::OnCharacter(char character, PBYTE keyboardState)
 
       if(textChanged)
       {
+         Invalidate();
+
          Message* msg = new Message(GM_EDIT_CHANGE,
             GetParent()->GetWindowID(), 0, 0, GetWindowID());
          GetParent()->SendMessage(msg);
          delete msg;
       }
    }
-}
\ No newline at end of file
+}
+
+void FC Edit::OnSetFocus(UINT winID)
+{
+   //Start drawing the cursor, which blinks until the focus is lost
+   cursorOn = true;
+   GetGui()->CreateTimer(ED_BLINK_TIMER, GetWindowID(), cursorBlinkRate);
+   Invalidate();
+}
+
+void FC Edit::OnLoseFocus(UINT winID)
+{
+   //Remove the cursor
+   GetGui()->DestroyTimer(ED_BLINK_TIMER);
+   cursorOn = false;
+   Invalidate();
+}
+
+void FC Edit::OnTimer(UINT timerID)
+{
+   //The control is only redrawn when the cursor blinks
+   if(timerID == ED_BLINK_TIMER)
+   {
+      cursorOn = !cursorOn;
+      Invalidate();
+   }
+}
@@ -46,23 +46,30 @@ namespace DG
       void SetParentNotify(bool notify) {parentNotify = notify;}
       bool GetParentNotify(void) {return parentNotify;}
 
-      void SetForegroundColor(Color color) {foregroundColor = color;}
+      void SetForegroundColor(Color color)
+      {foregroundColor = color; Invalidate();}
       Color GetForegroundColor(void) {return foregroundColor;}
 
-      void SetBackgroundColor(Color color) {backgroundColor = color;}
+      void SetBackgroundColor(Color color)
+      {backgroundColor = color; Invalidate();}
       Color GetBackgroundColor(void) {return backgroundColor;}
 
-      void SetFont(Font aFont) {font = aFont;}
+      void SetFont(Font aFont) {font = aFont; Invalidate();}
       Font GetFont(void) {return font;}
 
-      void SetText(const char* aText) {strcpy(text, aText);}
+      void SetText(const char* aText) {strcpy(text, aText); Invalidate();}
       char* const GetText(void) {return text;}
 
+      bool FC IsOpaque(void) {return true;}
+
    protected:
       void FC OnDrawWindow(WindowSurface* surface);
       void FC OnLButtonUp(int x, int y, BYTE* keyboardState);
       void FC OnLButtonDblClk(int x, int y, BYTE* keyboardState);
       void FC OnCharacter(char character, PBYTE keyboardState);
+      void FC OnSetFocus(UINT winID);
+      void FC OnLoseFocus(UINT winID);
+      void FC OnTimer(UINT timerID);
 
    private:
       bool parentNotify;
@@ -71,7 +78,6 @@ namespace DG
       Font font;
       
       int cursorBlinkRate;
-      DWORD lastBlinkTime;
       bool cursorOn;
 
       char text[DGEDIT_DEFAULT_TEXT_LENGTH];
@@ -6,41 +6,22 @@ Version:
    1.0.0    10.03.2001  Created the file
    2.0.0    02.06.2002  Changed the file to use namespaces and adapt
       to Visual Studio .NET
+   2.1.0    22.09.2002  Fonts are interned and share their font handles
 ------------------------------------------------------------------------*/
 
 #include "DxGuiFramework.h"
 
 using namespace DG;
 
+FontEntry* Font::firstEntry = NULL;
+UINT Font::numOfEntries = 0;
+UINT Font::numOfUnusedEntries = 0;
+UINT Font::releaseCount = 0;
+
 //Default Constructor
 Font::Font()
 {
-   strcpy(fontName, "MS Sans Serif");
-   weight = FW_NORMAL;
-   italic = FALSE;
-   underline = FALSE;
-   strikeout = FALSE;
-   width = 0;
-   height = 0;
-   escapement = 0;
-   orientation = 0;
-   charSet = DEFAULT_CHARSET;
-   outPrecision = OUT_CHARACTER_PRECIS;
-   clipPrecision = CLIP_CHARACTER_PRECIS;
-   quality = DEFAULT_QUALITY;
-   pitchAndFamily = DEFAULT_PITCH | FF_DONTCARE;
-
-   fontHandle = CreateFont(height, width, escapement, orientation, weight,
-      italic, underline, strikeout, charSet, outPrecision, clipPrecision,
-      quality, pitchAndFamily, fontName);
-
-   if(fontHandle == NULL)
-   {
-      char errorMsg[64];
-      sprintf(errorMsg, "The font \"%s\" could not be created.");
-      throw(new Exception(errorMsg, EC_CREATEFONT, ET_FONT, __FILE__,
-         __LINE__));
-   }
+   entry = Acquire("MS Sans Serif", 0, FW_NORMAL, FALSE, FALSE, FALSE);
 }
 
 /*------------------------------------------------------------------------
@@ -54,77 +35,203 @@ Parameters:
    bool p_italic : whether an italicized font should be created
    bool p_underlined : whether an underlined font should be created
    bool p_strikeout : whether an strikeout font should be created
+Description:
+   The font is only created with GDI if there isn't already a font with
+   the same attributes.
 ------------------------------------------------------------------------*/
 
 Font::Font(const char* p_fontName, int p_height, int p_weight,
       bool p_italic, bool p_underline, bool p_strikeout)
 {
-   strcpy(fontName, p_fontName);
-   weight = p_weight;
-   italic = p_italic;
-   underline = p_underline;
-   strikeout = p_strikeout;
-   width = 0;
-   height = p_height;
-   escapement = 0;
-   orientation = 0;
-   charSet = DEFAULT_CHARSET;
-   outPrecision = OUT_CHARACTER_PRECIS;
-   clipPrecision = CLIP_CHARACTER_PRECIS;
-   quality = DEFAULT_QUALITY;
-   pitchAndFamily = DEFAULT_PITCH | FF_DONTCARE;
-
-   fontHandle = CreateFont(height, width, escapement, orientation, weight,
-      italic, underline, strikeout, charSet, outPrecision, clipPrecision,
-      quality, pitchAndFamily, fontName);
-
-   if(fontHandle == NULL)
+   entry = Acquire(p_fontName, p_height, p_weight, p_italic, p_underline,
+      p_strikeout);
+}
+
+//Copy Constructor
+Font::Font(const Font& font)
+{
+   entry = font.entry;
+   entry->refCount++;
+}
+
+//Overloads the '=' operator
+Font& Font::operator=(const Font& font)
+{
+   //The new entry is referenced first, in case it is the same entry
+   font.entry->refCount++;
+   Release(entry);
+
+   entry = font.entry;
+
+   return *this;
+}
+
+//Destructor
+Font::~Font()
+{
+   Release(entry);
+}
+
+/*------------------------------------------------------------------------
+Function Name: FreeUnusedFonts
+Parameters:
+Description:
+   This function frees the fonts that are kept even though no Font 
+   objects use them anymore.
+------------------------------------------------------------------------*/
+
+void FC Font::FreeUnusedFonts(void)
+{
+   FontEntry* fontEntry = firstEntry;
+
+   while(fontEntry != NULL)
    {
-      char errorMsg[64];
-      sprintf(errorMsg, "The font \"%s\" could not be created.");
-      throw(new Exception(errorMsg, EC_CREATEFONT, ET_FONT, __FILE__,
-         __LINE__));
+      FontEntry* nextEntry = fontEntry->next;
+
+      if(fontEntry->refCount == 0)
+         FreeEntry(fontEntry);
+
+      fontEntry = nextEntry;
    }
 }
 
+/*------------------------------------------------------------------------
+Function Name: Acquire
+Parameters:
+   The attributes of the font
+Returns:
+   The entry of the font, which has been referenced
+Description:
+   This function looks for a font with the same attributes in the 
+   registry and creates it with GDI if it isn't there.
+------------------------------------------------------------------------*/
 
-//Overloads the '=' operator
-Font& Font::operator=(Font& font)
+FontEntry* FC Font::Acquire(const char* fontName, int height, int weight,
+   BOOL italic, BOOL underline, BOOL strikeout)
 {
-   strcpy(fontName, font.fontName);
-   weight = font.weight;
-   italic = font.italic;
-   underline = font.underline;
-   strikeout = font.strikeout;
-   width = font.width;
-   height = font.height;
-   escapement = font.escapement;
-   orientation = font.orientation;
-   charSet = font.charSet;
-   outPrecision = font.outPrecision;
-   clipPrecision = font.clipPrecision;
-   quality = font.quality;
-   pitchAndFamily = font.pitchAndFamily;
-   
-   DeleteObject(fontHandle);
-
-   fontHandle = CreateFont(height, width, escapement, orientation, weight,
-      italic, underline, strikeout, charSet, outPrecision, clipPrecision,
-      quality, pitchAndFamily, fontName);
-
-   if(fontHandle == NULL)
+   FontEntry* fontEntry;
+
+   for(fontEntry = firstEntry; fontEntry != NULL; 
+      fontEntry = fontEntry->next)
    {
-      char errorMsg[64];
-      sprintf(errorMsg, "The font \"%s\" could not be created.");
+      if(fontEntry->height == height && fontEntry->weight == weight &&
+         fontEntry->italic == italic && fontEntry->underline == underline &&
+         fontEntry->strikeout == strikeout && 
+         strcmp(fontEntry->fontName, fontName) == 0)
+      {
+         if(fontEntry->refCount == 0)
+            numOfUnusedEntries--;
+
+         fontEntry->refCount++;
+         return fontEntry;
+      }
+   }
+
+   fontEntry = new FontEntry;
+
+   strncpy(fontEntry->fontName, fontName, sizeof(fontEntry->fontName) - 1);
+   fontEntry->fontName[sizeof(fontEntry->fontName) - 1] = '\0';
+   fontEntry->weight = weight;
+   fontEntry->italic = italic;
+   fontEntry->underline = underline;
+   fontEntry->strikeout = strikeout;
+   fontEntry->width = 0;
+   fontEntry->height = height;
+   fontEntry->escapement = 0;
+   fontEntry->orientation = 0;
+   fontEntry->charSet = DEFAULT_CHARSET;
+   fontEntry->outPrecision = OUT_CHARACTER_PRECIS;
+   fontEntry->clipPrecision = CLIP_CHARACTER_PRECIS;
+   fontEntry->quality = DEFAULT_QUALITY;
+   fontEntry->pitchAndFamily = DEFAULT_PITCH | FF_DONTCARE;
+
+   fontEntry->fontHandle = CreateFont(fontEntry->height, fontEntry->width,
+      fontEntry->escapement, fontEntry->orientation, fontEntry->weight,
+      fontEntry->italic, fontEntry->underline, fontEntry->strikeout, 
+      fontEntry->charSet, fontEntry->outPrecision, 
+      fontEntry->clipPrecision, fontEntry->quality, 
+      fontEntry->pitchAndFamily, fontEntry->fontName);
+
+   if(fontEntry->fontHandle == NULL)
+   {
+      delete fontEntry;
+
+      char errorMsg[128];
+      sprintf(errorMsg, "The font \"%s\" could not be created.", fontName);
       throw(new Exception(errorMsg, EC_CREATEFONT, ET_FONT, __FILE__,
          __LINE__));
    }
 
-   return *this;
+   fontEntry->refCount = 1;
+   fontEntry->releaseTime = 0;
+
+   fontEntry->next = firstEntry;
+   firstEntry = fontEntry;
+   numOfEntries++;
+
+   return fontEntry;
 }
 
-//Destructor
-Font::~Font()
+/*------------------------------------------------------------------------
+Function Name: Release
+Parameters:
+   FontEntry* fontEntry : the entry that a Font object no longer uses
+Description:
+   This function dereferences an entry. An entry that isn't used anymore
+   is kept in case the font is created again, but only FONT_MAX_UNUSED
+   of them are kept; past that, the one released longest ago is freed.
+------------------------------------------------------------------------*/
+
+void FC Font::Release(FontEntry* fontEntry)
 {
-   DeleteObject(fontHandle);
+   assert(fontEntry->refCount > 0);
+
+   fontEntry->refCount--;
+
+   if(fontEntry->refCount > 0)
+      return;
+
+   fontEntry->releaseTime = ++releaseCount;
+   numOfUnusedEntries++;
+
+   if(numOfUnusedEntries <= FONT_MAX_UNUSED)
+      return;
+
+   FontEntry* oldestEntry = NULL;
+
+   for(FontEntry* unusedEntry = firstEntry; unusedEntry != NULL; 
+      unusedEntry = unusedEntry->next)
+   {
+      if(unusedEntry->refCount == 0 && (oldestEntry == NULL || 
+         unusedEntry->releaseTime < oldestEntry->releaseTime))
+         oldestEntry = unusedEntry;
+   }
+
+   FreeEntry(oldestEntry);
+}
+
+/*------------------------------------------------------------------------
+Function Name: FreeEntry
+Parameters:
+   FontEntry* fontEntry : an entry that isn't used
+Description:
+   This function removes an entry from the registry and deletes its font.
+------------------------------------------------------------------------*/
+
+void FC Font::FreeEntry(FontEntry* fontEntry)
+{
+   assert(fontEntry->refCount == 0);
+
+   FontEntry** link = &firstEntry;
+
+   while(*link != fontEntry)
+      link = &(*link)->next;
+
+   *link = fontEntry->next;
+
+   DeleteObject(fontEntry->fontHandle);
+   delete fontEntry;
+
+   numOfEntries--;
+   numOfUnusedEntries--;
 }
@@ -6,33 +6,22 @@ Version:
    1.0.0    10.03.2001  Created the file
    2.0.0    02.06.2002  Changed the file to use namespaces and adapt
       to Visual Studio .NET
+   2.1.0    22.09.2002  Fonts are interned and share their font handles
 ------------------------------------------------------------------------*/
 
 #pragma once
 
+//The number of fonts that nothing uses anymore which are kept, so that
+//fonts that are created again and again aren't created with GDI again
+#define FONT_MAX_UNUSED    8
+
 namespace DG
 {
-   class Font
+   //A font created with GDI, which all the Font objects with the same
+   //attributes share
+   class FontEntry
    {
    public:
-      Font();
-      Font(const char* p_fontName, int p_height, int p_weight = FW_NORMAL,
-         bool p_italic = false, bool p_underline = false, bool p_strikeout = false);
-      virtual ~Font();
-
-      Font& operator=(Font& font);
-
-      char* const GetFontName(void) {return fontName;}
-      int GetHeight(void) {return height;}
-      int GetWeight(void) {return weight;}
-      bool IsItalic(void) {return(italic == TRUE);}
-      bool IsUnderline(void) {return(underline == TRUE);}
-      bool IsStrikeout(void) {return(strikeout == TRUE);}
-      HFONT GetFontHandle(void) {return fontHandle;}
-           
-      void SetNewDC(HDC hDC);
-
-   private:
       HFONT fontHandle;
 
       //All the user usually cares about is the font name and height
@@ -54,5 +43,57 @@ namespace DG
       int clipPrecision;
       int quality;
       int pitchAndFamily;
+
+      //The number of Font objects that use the entry
+      UINT refCount;
+
+      //When the entry was last released, which decides which unused
+      //entry is freed first
+      UINT releaseTime;
+
+      FontEntry* next;
+   };
+
+   class Font
+   {
+   public:
+      Font();
+      Font(const char* p_fontName, int p_height, int p_weight = FW_NORMAL,
+         bool p_italic = false, bool p_underline = false, bool p_strikeout = false);
+      Font(const Font& font);
+      virtual ~Font();
+
+      Font& operator=(const Font& font);
+      bool operator==(const Font& font) const {return entry == font.entry;}
+      bool operator!=(const Font& font) const {return entry != font.entry;}
+
+      char* const GetFontName(void) {return entry->fontName;}
+      int GetHeight(void) {return entry->height;}
+      int GetWeight(void) {return entry->weight;}
+      bool IsItalic(void) {return(entry->italic == TRUE);}
+      bool IsUnderline(void) {return(entry->underline == TRUE);}
+      bool IsStrikeout(void) {return(entry->strikeout == TRUE);}
+      HFONT GetFontHandle(void) {return entry->fontHandle;}
+           
+      void SetNewDC(HDC hDC);
+
+      static void FC FreeUnusedFonts(void);
+      static UINT GetNumOfFonts(void) {return numOfEntries;}
+
+   private:
+      static FontEntry* FC Acquire(const char* fontName, int height, 
+         int weight, BOOL italic, BOOL underline, BOOL strikeout);
+      static void FC Release(FontEntry* fontEntry);
+      static void FC FreeEntry(FontEntry* fontEntry);
+
+      FontEntry* entry;
+
+      //The registry of the fonts that have been created. The entries
+      //are interned, so there is only ever one for each set of 
+      //attributes.
+      static FontEntry* firstEntry;
+      static UINT numOfEntries;
+      static UINT numOfUnusedEntries;
+      static UINT releaseCount;
    };
 }
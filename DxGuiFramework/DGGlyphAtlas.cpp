@@ -0,0 +1,373 @@
+/*------------------------------------------------------------------------
+File Name: DGGlyphAtlas.cpp
+Description: This file contains the implementation of the DG::GlyphAtlas
+   class, which holds the glyphs of a font as runs of covered pixels.
+Version:
+   1.0.0    08.09.2002  Created the file
+   1.1.0    15.09.2002  Added the text layout cache
+   1.2.0    29.09.2002  Added the width of each glyph
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+
+using namespace DG;
+
+/*Constructor*/
+GlyphAtlas::GlyphAtlas()
+{
+   fontName[0] = '\0';
+   height = 0;
+   weight = 0;
+   italic = false;
+   underline = false;
+   strikeout = false;
+
+   lineHeight = 0;
+   tabWidth = 0;
+
+   memset(glyphs, 0, sizeof(glyphs));
+   memset(layouts, 0, sizeof(layouts));
+
+   runs = NULL;
+   numOfRuns = 0;
+   maxNumOfRuns = 0;
+
+   memoryUsage = 0;
+}
+
+/*Destructor*/
+GlyphAtlas::~GlyphAtlas()
+{
+   Destroy();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Create
+Parameters:
+   Font& font : the font whose glyphs are put in the atlas
+Description:
+   This function draws every character of the font with GDI, one at a
+   time, and stores the pixels that each one covers as runs. Each glyph
+   is drawn with the full advance of the character, so underlines and
+   strikeouts are part of the glyphs. The kerning pairs of the font are
+   read as well. The runs only tell whether a pixel is covered, so the 
+   glyphs are drawn with a copy of the font that isn't anti-aliased, 
+   rather than cutting the smoothed edges of the font itself.
+------------------------------------------------------------------------*/
+
+void FC GlyphAtlas::Create(Font& font)
+{
+   Destroy();
+
+   strcpy(fontName, font.GetFontName());
+   height = font.GetHeight();
+   weight = font.GetWeight();
+   italic = font.IsItalic();
+   underline = font.IsUnderline();
+   strikeout = font.IsStrikeout();
+
+   LOGFONT logFont;
+   GetObject(font.GetFontHandle(), sizeof(logFont), &logFont);
+   logFont.lfQuality = NONANTIALIASED_QUALITY;
+
+   HFONT glyphFont = CreateFontIndirect(&logFont);
+
+   if(glyphFont == NULL)
+   {
+      throw new Exception("The glyph font could not be created.",
+         EC_CREATEFONT, ET_FONT, __FILE__, __LINE__);
+   }
+
+   HDC hDC = CreateCompatibleDC(NULL);
+   HFONT hOldFont = (HFONT)SelectObject(hDC, glyphFont);
+
+   TEXTMETRIC textMetric;
+   GetTextMetrics(hDC, &textMetric);
+
+   lineHeight = textMetric.tmHeight;
+   tabWidth = textMetric.tmAveCharWidth * 8;
+
+   if(tabWidth <= 0)
+      tabWidth = 1;
+
+   //Raster fonts don't have ABC widths, but their characters don't
+   //overhang either
+   ABC widths[256];
+   if(!GetCharABCWidths(hDC, 0, 255, widths))
+   {
+      INT advances[256];
+      GetCharWidth32(hDC, 0, 255, advances);
+
+      for(int i = 0; i < 256; i++)
+      {
+         widths[i].abcA = 0;
+         widths[i].abcB = advances[i];
+         widths[i].abcC = 0;
+      }
+   }
+
+   //Find the widest glyph, which is how wide the drawing area has to be
+   int maxWidth = 1;
+   int c;
+
+   for(c = GA_FIRST_CHAR; c <= GA_LAST_CHAR; c++)
+   {
+      int advance = widths[c].abcA + widths[c].abcB + widths[c].abcC;
+      int left = (widths[c].abcA < 0) ? widths[c].abcA : 0;
+      int right = widths[c].abcA + int(widths[c].abcB);
+
+      if(right < advance)
+         right = advance;
+
+      glyphs[c].left = left;
+      glyphs[c].advance = advance;
+
+      if(right - left > maxWidth)
+         maxWidth = right - left;
+   }
+
+   BITMAPINFO bitmapInfo;
+   memset(&bitmapInfo, 0, sizeof(bitmapInfo));
+   bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+   bitmapInfo.bmiHeader.biWidth = maxWidth;
+   bitmapInfo.bmiHeader.biHeight = -lineHeight;
+   bitmapInfo.bmiHeader.biPlanes = 1;
+   bitmapInfo.bmiHeader.biBitCount = 32;
+   bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+   UINT* dibBits = NULL;
+   HBITMAP dibSection = CreateDIBSection(hDC, &bitmapInfo, DIB_RGB_COLORS,
+      (void**)&dibBits, NULL, 0);
+
+   if(dibSection == NULL)
+   {
+      SelectObject(hDC, hOldFont);
+      DeleteDC(hDC);
+      DeleteObject(glyphFont);
+      throw new Exception("The glyph bitmap could not be created.",
+         EC_CREATEFONT, ET_FONT, __FILE__, __LINE__);
+   }
+
+   HBITMAP hOldBitmap = (HBITMAP)SelectObject(hDC, dibSection);
+
+   ::SetTextColor(hDC, RGB(255, 255, 255));
+   ::SetBkMode(hDC, TRANSPARENT);
+   SetTextAlign(hDC, TA_LEFT | TA_TOP | TA_NOUPDATECP);
+
+   maxNumOfRuns = 1024;
+   runs = new USHORT[maxNumOfRuns * 3];
+
+   for(c = GA_FIRST_CHAR; c <= GA_LAST_CHAR; c++)
+   {
+      Glyph& glyph = glyphs[c];
+      char character = char(c);
+
+      PatBlt(hDC, 0, 0, maxWidth, lineHeight, BLACKNESS);
+      TextOut(hDC, -glyph.left, 0, &character, 1);
+      GdiFlush();
+
+      glyph.firstRun = numOfRuns;
+      glyph.width = 0;
+
+      for(int y = 0; y < lineHeight; y++)
+      {
+         UINT* line = dibBits + (y * maxWidth);
+         int runStart = -1;
+
+         for(int x = 0; x <= maxWidth; x++)
+         {
+            //Without anti-aliasing every pixel that is drawn is white
+            bool covered = (x < maxWidth) && ((line[x] & 0xFF00) != 0);
+
+            if(covered && runStart < 0)
+               runStart = x;
+
+            else if(!covered && runStart >= 0)
+            {
+               AddRun(y, runStart, x - runStart);
+               runStart = -1;
+
+               if(x > glyph.width)
+                  glyph.width = x;
+            }
+         }
+      }
+
+      glyph.numOfRuns = numOfRuns - glyph.firstRun;
+   }
+
+   //Read the kerning pairs between the characters in the atlas
+   DWORD numOfPairs = GetKerningPairs(hDC, 0, NULL);
+
+   if(numOfPairs > 0)
+   {
+      KERNINGPAIR* pairs = new KERNINGPAIR[numOfPairs];
+      numOfPairs = GetKerningPairs(hDC, numOfPairs, pairs);
+
+      for(DWORD i = 0; i < numOfPairs; i++)
+      {
+         if(pairs[i].wFirst <= 255 && pairs[i].wSecond <= 255 &&
+            pairs[i].iKernAmount != 0)
+            kerningPairs[(pairs[i].wFirst << 8) | pairs[i].wSecond] =
+               pairs[i].iKernAmount;
+      }
+
+      delete[] pairs;
+   }
+
+   SelectObject(hDC, hOldBitmap);
+   SelectObject(hDC, hOldFont);
+   DeleteObject(dibSection);
+   DeleteDC(hDC);
+   DeleteObject(glyphFont);
+
+   memoryUsage = (maxNumOfRuns * 3 * sizeof(USHORT)) + sizeof(glyphs) +
+      (kerningPairs.size() * sizeof(int) * 4);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Destroy
+Parameters:
+Description:
+   This function frees the glyphs.
+------------------------------------------------------------------------*/
+
+void FC GlyphAtlas::Destroy(void)
+{
+   if(runs != NULL)
+   {
+      delete[] runs;
+      runs = NULL;
+   }
+
+   numOfRuns = 0;
+   maxNumOfRuns = 0;
+   kerningPairs.clear();
+   memoryUsage = 0;
+
+   ClearLayouts();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Matches
+Parameters:
+   Font& font : a font
+Returns:
+   true if the atlas was created from a font that looks the same
+------------------------------------------------------------------------*/
+
+bool FC GlyphAtlas::Matches(Font& font)
+{
+   return IsCreated() && height == font.GetHeight() &&
+      weight == font.GetWeight() && italic == font.IsItalic() &&
+      underline == font.IsUnderline() &&
+      strikeout == font.IsStrikeout() &&
+      strcmp(fontName, font.GetFontName()) == 0;
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetKerning
+Parameters:
+   UCHAR first : the character on the left
+   UCHAR second : the character on the right
+Returns:
+   The amount that the pen moves between the two characters in addition
+   to the advance of the first one, which is usually 0 or negative
+------------------------------------------------------------------------*/
+
+int FC GlyphAtlas::GetKerning(UCHAR first, UCHAR second)
+{
+   if(kerningPairs.empty())
+      return 0;
+
+   std::map<UINT, int>::iterator pair =
+      kerningPairs.find((first << 8) | second);
+
+   return (pair == kerningPairs.end()) ? 0 : pair->second;
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetLayout
+Parameters:
+   char* text : the text to be drawn with the font
+   int maxWidth : the width of the bounding rectangle
+   UINT flags : the Win32 API DrawText() flags
+Returns:
+   The layout of the text
+Description:
+   This function looks for the layout of the text in the cache and lays
+   the text out if it isn't there. Each layout can only be in one slot,
+   so finding it takes a hash of the text and one comparison, and a new
+   layout simply replaces whatever was in its slot. Since the text is 
+   compared, a layout is never used for a string that has changed.
+------------------------------------------------------------------------*/
+
+TextLayout* FC GlyphAtlas::GetLayout(char* text, int maxWidth, UINT flags)
+{
+   flags &= TL_LAYOUT_FLAGS;
+
+   //The width only matters if lines can be broken at it
+   if(flags != DT_WORDBREAK)
+      maxWidth = 0;
+
+   UINT hash = TextLayout::Hash(text, maxWidth, flags);
+   TextLayout*& layout = layouts[hash & (GA_LAYOUT_CACHE_SIZE - 1)];
+
+   if(layout == NULL)
+      layout = new TextLayout;
+   else if(layout->Matches(text, maxWidth, flags, hash))
+      return layout;
+
+   layout->Create(this, text, maxWidth, flags, hash);
+
+   return layout;
+}
+
+/*------------------------------------------------------------------------
+Function Name: ClearLayouts
+Parameters:
+Description:
+   This function frees all the layouts in the cache.
+------------------------------------------------------------------------*/
+
+void FC GlyphAtlas::ClearLayouts(void)
+{
+   for(int i = 0; i < GA_LAYOUT_CACHE_SIZE; i++)
+   {
+      if(layouts[i] != NULL)
+      {
+         delete layouts[i];
+         layouts[i] = NULL;
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: AddRun
+Parameters:
+   int y : the line within the glyph
+   int start : the column within the glyph at which the run starts
+   int length : the number of covered pixels
+Description:
+   This function adds a run to the atlas, making room for it if needed.
+------------------------------------------------------------------------*/
+
+void FC GlyphAtlas::AddRun(int y, int start, int length)
+{
+   if(numOfRuns == maxNumOfRuns)
+   {
+      USHORT* newRuns = new USHORT[maxNumOfRuns * 2 * 3];
+      memcpy(newRuns, runs, maxNumOfRuns * 3 * sizeof(USHORT));
+      delete[] runs;
+
+      runs = newRuns;
+      maxNumOfRuns *= 2;
+   }
+
+   USHORT* run = &runs[numOfRuns * 3];
+   run[0] = USHORT(y);
+   run[1] = USHORT(start);
+   run[2] = USHORT(length);
+
+   numOfRuns++;
+}
@@ -0,0 +1,109 @@
+/*------------------------------------------------------------------------
+File Name: DGGlyphAtlas.h
+Description: This file contains the DG::GlyphAtlas class, which holds
+   the glyphs of a font after they have been drawn once with GDI, so
+   that text can be drawn without GDI.
+Version:
+   1.0.0    08.09.2002  Created the file
+   1.1.0    15.09.2002  Added the text layout cache
+   1.2.0    29.09.2002  Added the width of each glyph
+------------------------------------------------------------------------*/
+
+#pragma once
+
+//The first and last characters that have a glyph in the atlas
+#define GA_FIRST_CHAR      32
+#define GA_LAST_CHAR       255
+
+//The number of text layouts that each atlas keeps, which must be a power
+//of 2
+#define GA_LAYOUT_CACHE_SIZE  64
+
+//The DrawText() flags that text drawn with a glyph atlas supports. Text
+//with any other flags, or with a & that GDI would treat as a prefix, is
+//drawn with GDI.
+#define GA_SUPPORTED_FLAGS (DT_LEFT | DT_CENTER | DT_RIGHT | DT_TOP | \
+   DT_VCENTER | DT_BOTTOM | DT_WORDBREAK | DT_SINGLELINE | \
+   DT_EXPANDTABS | DT_NOCLIP | DT_CALCRECT | DT_NOPREFIX)
+
+namespace DG
+{
+   //Where the glyph of a character is in the atlas and how far it moves
+   //the pen
+   class Glyph
+   {
+   public:
+      //The distance from the pen position to the left edge of the glyph,
+      //which is negative for characters that overhang to the left
+      int left;
+
+      //The distance from the pen position to the pen position of the
+      //next character
+      int advance;
+
+      //The distance from the left edge of the glyph to the right of its
+      //rightmost covered pixel
+      int width;
+
+      //The runs of the glyph in the atlas
+      UINT firstRun;
+      UINT numOfRuns;
+   };
+
+   class GlyphAtlas
+   {
+   public:
+      GlyphAtlas();
+      virtual ~GlyphAtlas();
+
+      void FC Create(Font& font);
+      void FC Destroy(void);
+      bool FC Matches(Font& font);
+
+      bool IsCreated(void) {return runs != NULL;}
+      int GetLineHeight(void) {return lineHeight;}
+      int GetTabWidth(void) {return tabWidth;}
+      UINT GetMemoryUsage(void) {return memoryUsage;}
+
+      Glyph& GetGlyph(UCHAR character) {return glyphs[character];}
+      int FC GetKerning(UCHAR first, UCHAR second);
+
+      TextLayout* FC GetLayout(char* text, int maxWidth, UINT flags);
+      void FC ClearLayouts(void);
+
+      //Each run is 3 values: the line within the glyph, the column
+      //within the glyph at which the run starts, and its length
+      USHORT* GetRun(UINT index) {return &runs[index * 3];}
+
+   private:
+      void FC AddRun(int y, int start, int length);
+
+      //The font the atlas was created from
+      char fontName[64];
+      int height;
+      int weight;
+      bool italic;
+      bool underline;
+      bool strikeout;
+
+      int lineHeight;
+      int tabWidth;
+
+      Glyph glyphs[256];
+
+      //The runs of covered pixels of all the glyphs
+      USHORT* runs;
+      UINT numOfRuns;
+      UINT maxNumOfRuns;
+
+      //The kerning pairs of the font, keyed by the first character in
+      //the high byte and the second one in the low byte
+      std::map<UINT, int> kerningPairs;
+
+      //The layouts of the text drawn with the font, in the slot that
+      //the low bits of their hashes pick
+      TextLayout* layouts[GA_LAYOUT_CACHE_SIZE];
+
+      UINT memoryUsage;
+   };
+}
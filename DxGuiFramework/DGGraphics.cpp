@@ -18,54 +18,76 @@ using namespace DG;
 HRESULT CALLBACK EnumDisplayModes(LPDDSURFACEDESC2 lpDDSurfaceDesc,  
    LPVOID lpContext);
 
-/*Default Constructor*/
-Graphics::Graphics()
+/*------------------------------------------------------------------------
+Constructor
+Parameters:
+   UINT backend : the render backend to be used, which can be
+      RB_DIRECTDRAW or RB_SOFTWARE. With RB_SOFTWARE, no DirectDraw object
+      is created and all surfaces are pixel buffers in system memory.
+------------------------------------------------------------------------*/
+Graphics::Graphics(UINT backend)
 {
    if(instance != NULL)
       return;
    
    instance = this;
 
+   renderBackend = backend;
+
    hWnd = GetApp()->GetWindowsHandle();
+   lpDD = NULL;
    lpDDSPrimary = NULL;
    lpDDSSecondary = NULL;
    lpDDSDrawingSurface = NULL;
    lpPSClipper = NULL;
    lpDSClipper = NULL;
 
+   primaryBuffer = NULL;
+   secondaryBuffer = NULL;
+   drawingBuffer = NULL;
+
    surfaceLocked = false;
    SSPersistence = false;
+   frameClearing = true;
+   surfaceGeneration = 0;
 
+   bitmapAtlasList.SetDestroy(true);
    bitmapList.SetDestroy(true);
+   bitmapLoader = NULL;
+   assetPack = NULL;
+   bitmapMemory = 0;
+   placeholderColor = Color(128, 128, 128);
 
    autoClean = false;
    maxBitmaps = false;
    maxMemory = false;
    maxNumOfBitmaps = 100;
    maxAmountOfMemory = 10000000;
-   curNumOfBitmaps = 0;
-   curAmountOfMemory = 0;
 
    textTransparencyMode = TRANSPARENT;
+   glyphText = true;
+   currentGlyphAtlas = NULL;
    textColor = Color(255, 255, 255);
    textBackgroundColor = Color(0, 0, 0);
 
    clipping = false;
-   clippingArea = (RGNDATA*)new char[sizeof(RGNDATAHEADER) + sizeof(RECT)];
-   clippingArea->rdh.dwSize = sizeof(RGNDATAHEADER);
-   clippingArea->rdh.iType = RDH_RECTANGLES;
-   clippingArea->rdh.nCount = 1;
-   clippingArea->rdh.nRgnSize = sizeof(RECT);
-   clippingArea->rdh.rcBound.left = 0;
-   clippingArea->rdh.rcBound.top = 0;
-   clippingArea->rdh.rcBound.right = 0;
-   clippingArea->rdh.rcBound.bottom = 0;
-   
-   RECT clipRect = {0, 0, 0, 0};
-   memcpy(clippingArea->Buffer, &clipRect, sizeof(RECT));
+   SetRect(&screenRect, 0, 0, 0, 0);
+   memset(&pixelFormat, 0, sizeof(DDPIXELFORMAT));
+   scaleFilter = SF_NEAREST;
 
    currentSurface = NULL;
 
+   videoBuffer = NULL;
+   bufferPitch = 0;
+
+   tileRasterizer = NULL;
+   tileClipStart = -1;
+   tileClipCount = 0;
+
+   //The software backend doesn't need DirectDraw at all
+   if(renderBackend == RB_SOFTWARE)
+      return;
+
    //Initialize DirectDraw object
    HRESULT result = DirectDrawCreateEx(NULL, (void**)&lpDD, 
       IID_IDirectDraw7, NULL);
@@ -92,12 +114,19 @@ Graphics::Graphics()
 /*Destructor*/
 Graphics::~Graphics()
 {
-   if(clippingArea != NULL)
-      delete[] clippingArea;
-      
    if(currentSurface != NULL)
       delete currentSurface;
 
+   if(tileRasterizer != NULL)
+      delete tileRasterizer;
+
+   //The loader closes the files of the bitmaps that it hasn't finished
+   if(bitmapLoader != NULL)
+      delete bitmapLoader;
+
+   if(assetPack != NULL)
+      delete assetPack;
+
    //Release DirectDraw object
    if(lpDD != NULL)
    {
@@ -106,6 +135,9 @@ Graphics::~Graphics()
    }
 
    DestroyAllSurfaces();
+
+   //Nothing is loaded from the mapped bitmap files anymore
+   BitmapFile::CloseUnusedFiles();
 }
 
 /*------------------------------------------------------------------------
@@ -235,8 +267,18 @@ void Graphics::SetGraphicsMode(Point res, UINT winState, UINT clrDepth,
 
    DestroyAllSurfaces();
 
+   //The software backend creates its own surfaces in system memory
+   if(renderBackend == RB_SOFTWARE)
+   {
+      CreateSoftwareSurfaces(res, winState, clrDepth, bufferMode);
+
+      //The loaded bitmaps may be in the wrong pixel format now, so they
+      //are removed and reloaded the next time they are drawn
+      bitmapList.RemoveAllBitmaps();
+   }
+
    //If we want windowed mode
-   if(winState == WS_WINDOWED)
+   else if(winState == WS_WINDOWED)
    {
       HWND desktopWindow;
       int desktopClrDepth;
@@ -484,21 +526,30 @@ void Graphics::SetGraphicsMode(Point res, UINT winState, UINT clrDepth,
 
    //Get the pixel format information and create the lookup tables, so that
    //we can construct pixels quickly
-   DDPIXELFORMAT pixelFormat;
-   memset(&pixelFormat, 0, sizeof(DDPIXELFORMAT));
-   pixelFormat.dwSize = sizeof(DDPIXELFORMAT);
+   if(renderBackend != RB_SOFTWARE)
+   {
+      memset(&pixelFormat, 0, sizeof(DDPIXELFORMAT));
+      pixelFormat.dwSize = sizeof(DDPIXELFORMAT);
 
-   lpDDSPrimary->GetPixelFormat(&pixelFormat);
+      lpDDSPrimary->GetPixelFormat(&pixelFormat);
 
-   //Create the color lookup tables for the different pixel formats
-   //Note that 16-bit and 15-bit pixel formats are taken into account
-   //during the creation of the lookup tables
-   Color::CreateLookupTables(pixelFormat, colorDepth);
+      //Create the color lookup tables for the different pixel formats
+      //Note that 16-bit and 15-bit pixel formats are taken into account
+      //during the creation of the lookup tables
+      Color::CreateLookupTables(pixelFormat, colorDepth);
+   }
+
+   //Choose the drawing kernels that match the color depth
+   spanKernels.SelectKernels(colorDepth, pixelFormat);
+
+   //Whatever was on the old surfaces is gone
+   surfaceGeneration++;
 
    bufferingMode = bufferMode;
 
    screenRes.x = res.x;
    screenRes.y = res.y;
+   SetRect(&screenRect, 0, 0, res.x, res.y);
 
    windowedState = winState;
  
@@ -508,7 +559,7 @@ void Graphics::SetGraphicsMode(Point res, UINT winState, UINT clrDepth,
       SSPersistence = persistence;
 
    if(clipping)
-      AddClippingArea(clippingRect);
+      ApplyClippingRegion();
 }
 
 //Bitmap functions
@@ -573,6 +624,292 @@ void Graphics::LoadBitmap(UINT bitmapID, UINT priority,
    }
 }
 
+/*------------------------------------------------------------------------
+Function Name: LoadAlphaBitmap
+Parameters:
+   UINT bitmapID : the ID of the bitmap to be loaded
+   UINT priority : the priority to be assigned to the loaded bitmap
+   UINT fileName : the name of the 32-bit bitmap file that the bitmap 
+      will be loaded from
+   bool premultiplied : true if the colors in the file have already 
+      been multiplied by the alpha channel
+Description:
+   This function loads a bitmap with an alpha channel and assigns it the
+   ID and priority. The bitmap is drawn with DrawAlphaBitmap(). The 
+   colors are multiplied by the alpha channel when the bitmap is loaded,
+   unless the file has been saved that way.
+------------------------------------------------------------------------*/
+
+void Graphics::LoadAlphaBitmap(UINT bitmapID, UINT priority, 
+                                 const char* fileName, bool premultiplied)
+{
+   Bitmap* bitmap = new Bitmap(bitmapID, priority);
+   bitmap->SetPremultipliedAlpha(premultiplied);
+   bitmap->LoadBitmap(fileName);
+
+   bitmapList.Append(bitmap, bitmapID);
+   if(autoClean)
+   {
+      if(maxBitmaps)
+         CleanMaxBitmaps();
+
+      if(maxMemory)
+         CleanMaxBitmapMemory();
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: LoadPackedBitmap
+Parameters:
+   UINT bitmapID : the ID of the bitmap to be loaded
+   UINT priority : the priority to be assigned to the loaded bitmap
+   const char* fileName : the name of the file that the bitmap will be 
+      loaded from
+Description:
+   This function loads a bitmap like LoadBitmap(), but a bitmap that is
+   no larger than BA_MAX_BITMAP_SIZE is packed into a bitmap atlas 
+   together with other small bitmaps. This is meant for icons and the 
+   parts of controls, which would waste memory on surfaces of their own.
+------------------------------------------------------------------------*/
+
+void Graphics::LoadPackedBitmap(UINT bitmapID, UINT priority, 
+                                  const char* fileName)
+{
+   Bitmap* bitmap = new Bitmap(bitmapID, priority);
+   bitmap->SetPacked(true);
+
+   try
+   {
+      bitmap->LoadBitmap(fileName);
+   }
+   catch(...)
+   {
+      delete bitmap;
+      throw;
+   }
+
+   bitmapList.Append(bitmap, bitmapID);
+   if(autoClean)
+   {
+      if(maxBitmaps)
+         CleanMaxBitmaps();
+
+      if(maxMemory)
+         CleanMaxBitmapMemory();
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: LoadBitmapView
+Parameters:
+   UINT bitmapID : the ID of the bitmap to be loaded
+   UINT priority : the priority to be assigned to the loaded bitmap
+   Area& area : the rectangular area of the bitmap that is to be loaded
+   const char* fileName : the name of the file that the bitmap will be 
+      loaded from
+Description:
+   This function loads an area of a bitmap like LoadBitmapDimensions(),
+   but the bitmap is a view of the whole file, which is loaded once into
+   a sheet that all the views of the file share. This is meant for 
+   skins that cut many bitmaps out of one file, which would otherwise 
+   each copy their area. Files with an alpha channel can't have views,
+   so their areas are copied as usual. The whole file is loaded for the
+   first view, views don't get run-length sprites, and the sheet is only
+   freed when all of its views have been deleted.
+------------------------------------------------------------------------*/
+
+void Graphics::LoadBitmapView(UINT bitmapID, UINT priority, Area& area,
+   const char* fileName)
+{
+   Bitmap* bitmap = new Bitmap(bitmapID, priority);
+   bitmap->SetView(true);
+
+   try
+   {
+      bitmap->LoadBitmap(fileName, area);
+   }
+   catch(...)
+   {
+      delete bitmap;
+      throw;
+   }
+
+   bitmapList.Append(bitmap, bitmapID);
+   if(autoClean)
+   {
+      if(maxBitmaps)
+         CleanMaxBitmaps();
+
+      if(maxMemory)
+         CleanMaxBitmapMemory();
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: LoadTiledBitmap
+Parameters:
+   UINT bitmapID : the ID of the bitmap to be loaded
+   UINT priority : the priority to be assigned to the loaded bitmap
+   const char* fileName : the name of the file that the bitmap will be 
+      loaded from
+Description:
+   This function adds a tiled bitmap, which is meant for bitmaps that are
+   much larger than what is shown of them, such as a large image that is
+   scrolled. Only the tiles of the bitmap that are drawn are loaded, and
+   at most BM_MAX_TILES of them are kept, so the memory of the bitmap 
+   depends on how much of it is on the screen rather than on its size.
+   Tiled bitmaps can only be drawn with DrawBitmap().
+------------------------------------------------------------------------*/
+
+void Graphics::LoadTiledBitmap(UINT bitmapID, UINT priority, 
+   const char* fileName)
+{
+   Bitmap* bitmap = new Bitmap(bitmapID, priority);
+
+   try
+   {
+      bitmap->LoadTiledBitmap(fileName);
+   }
+   catch(...)
+   {
+      delete bitmap;
+      throw;
+   }
+
+   bitmapList.Append(bitmap, bitmapID);
+   if(autoClean)
+   {
+      if(maxBitmaps)
+         CleanMaxBitmaps();
+
+      if(maxMemory)
+         CleanMaxBitmapMemory();
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: LoadBitmapAsync
+Parameters:
+   UINT bitmapID : the ID of the bitmap to be loaded
+   UINT priority : the priority to be assigned to the loaded bitmap
+   const char* fileName : the name of the file that the bitmap will be 
+      loaded from
+   UINT windowID : the window that gets a GM_BITMAPLOADED message when
+      the bitmap has been loaded, or IDW_NONE
+Description:
+   This function adds a bitmap to the bitmap list right away, but the
+   bitmap is decoded by the threads of the bitmap loader. Until then it
+   has its size, so windows can be laid out around it, and it is drawn
+   as a rectangle of the placeholder color. The file is checked here, so
+   a file that can't be loaded throws an exception like LoadBitmap().
+------------------------------------------------------------------------*/
+
+void Graphics::LoadBitmapAsync(UINT bitmapID, UINT priority, 
+                                 const char* fileName, UINT windowID)
+{
+   if(bitmapLoader == NULL)
+      bitmapLoader = new BitmapLoader();
+
+   Bitmap* bitmap = new Bitmap(bitmapID, priority);
+   BitmapLoad* load;
+
+   try
+   {
+      load = bitmap->BeginAsyncLoad(fileName);
+   }
+   catch(...)
+   {
+      delete bitmap;
+      throw;
+   }
+
+   load->bitmapID = bitmapID;
+   load->windowID = windowID;
+   load->convertLine = spanKernels.ConvertLine;
+   load->pixelSize = bytesPerPixel;
+   load->pixelFormat = pixelFormat;
+   load->surfaceGeneration = surfaceGeneration;
+
+   bitmapLoader->Queue(load);
+   bitmapList.Append(bitmap, bitmapID);
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetFinishedBitmapLoad
+Parameters:
+   UINT& bitmapID : gets the ID of the bitmap that has been loaded
+   UINT& windowID : gets the window that wants to know about it
+Returns:
+   true if a bitmap has been loaded, false if none have finished
+Description:
+   This function hands the pixels that the bitmap loader has decoded to
+   the first bitmap that is done. It is called by the GUI once a frame,
+   and again until it returns false. A bitmap that was decoded for a
+   graphics mode that has been changed since is queued again.
+------------------------------------------------------------------------*/
+
+bool Graphics::GetFinishedBitmapLoad(UINT& bitmapID, UINT& windowID)
+{
+   if(bitmapLoader == NULL)
+      return false;
+
+   BitmapLoad* load;
+   while((load = bitmapLoader->GetFinishedLoad()) != NULL)
+   {
+      Bitmap* bitmap = load->bitmap;
+
+      if(bitmap != NULL && !load->alpha && load->pixels != NULL &&
+         load->surfaceGeneration != surfaceGeneration)
+      {
+         delete load->pixels;
+
+         load->convertLine = spanKernels.ConvertLine;
+         load->pixelSize = bytesPerPixel;
+         load->pixelFormat = pixelFormat;
+         load->surfaceGeneration = surfaceGeneration;
+         bitmapLoader->Queue(load);
+         continue;
+      }
+
+      BitmapFile::Close(load->file);
+
+      //The bitmap was deleted while it was being decoded
+      if(bitmap == NULL)
+      {
+         if(load->pixels != NULL)
+            delete load->pixels;
+
+         delete load;
+         continue;
+      }
+
+      bitmapID = load->bitmapID;
+      windowID = load->windowID;
+      PixelBuffer* pixels = load->pixels;
+      delete load;
+
+      bitmap->FinishAsyncLoad(pixels);
+
+      if(bitmap->IsLoaded())
+      {
+         bitmapList.AddLoadedBitmap(bitmap);
+
+         if(autoClean)
+         {
+            if(maxBitmaps)
+               CleanMaxBitmaps();
+
+            if(maxMemory)
+               CleanMaxBitmapMemory();
+         }
+      }
+
+      return true;
+   }
+
+   return false;
+}
+
 /*------------------------------------------------------------------------
 Function Name: LoadBitmapDimensions
 Parameters:
@@ -637,7 +974,8 @@ Description:
 
 void Graphics::RemoveBitmap(UINT bitmapID)
 {
-   bitmapList.GetItemById(bitmapID)->DestroyBitmap();
+   FlushDrawing();
+   bitmapList.RemoveBitmap(bitmapList.GetItemById(bitmapID));
 }
 
 /*------------------------------------------------------------------------
@@ -651,6 +989,7 @@ Description:
 
 void Graphics::RemoveAllBitmaps()
 {
+   FlushDrawing();
    bitmapList.RemoveAllBitmaps();
 }
 
@@ -666,6 +1005,15 @@ Description:
 
 void Graphics::DeleteBitmap(UINT bitmapID)
 {
+   FlushDrawing();
+
+   if(bitmapLoader != NULL)
+   {
+      Bitmap* bitmap = bitmapList.GetItemById(bitmapID);
+      if(bitmap != NULL && bitmap->IsLoadPending())
+         bitmapLoader->Cancel(bitmap);
+   }
+
    bitmapList.DeleteById(bitmapID);
 }
 
@@ -680,6 +1028,11 @@ Description:
 
 void Graphics::DeleteAllBitmaps()
 {
+   FlushDrawing();
+
+   if(bitmapLoader != NULL)
+      bitmapLoader->CancelAll();
+
    bitmapList.DeleteAll();
 }
 
@@ -708,15 +1061,22 @@ void Graphics::EnableAutoClean(bool clean, bool maxBmp, bool maxMem)
 Function Name: CleanMaxBitmaps
 Parameters:
 Description:
-   This function removes the lowest priority bitmap possible from memory
-   until the number of bitmaps in the list is under the max. bitmap limit.
+   This function removes bitmaps from memory until the number of bitmaps
+   in the list is under the max. bitmap limit. The bitmaps that have gone
+   undrawn the longest for their priority are removed first.
 ------------------------------------------------------------------------*/
 
 void Graphics::CleanMaxBitmaps(void)
 {
+   FlushDrawing();
    while(maxNumOfBitmaps < bitmapList.GetNumOfLoadedBitmaps())
    {
-      bitmapList.RemoveFirstLowestPriorityBitmap();   
+      UINT numOfBitmaps = bitmapList.GetNumOfLoadedBitmaps();
+      bitmapList.RemoveLeastRecentlyUsedBitmap();
+
+      //The bitmaps that are left can't be removed
+      if(bitmapList.GetNumOfLoadedBitmaps() == numOfBitmaps)
+         break;
    }
 }
 
@@ -724,19 +1084,49 @@ void Graphics::CleanMaxBitmaps(void)
 Function Name: CleanMaxBitmaps
 Parameters:
 Description:
-   This function removes the lowest priority bitmap possible from memory
-   until the amount of memory used by the bitmaps in the list is under 
-   the max. memory limit.
+   This function removes bitmaps from memory until the amount of memory
+   used by the bitmaps in the list is under the max. memory limit, in 
+   the same order as CleanMaxBitmaps(). Removing a packed bitmap only 
+   frees memory once the other bitmaps in its atlas are gone as well.
+   The scaled copies of the bitmaps are destroyed before any bitmap is
+   removed.
 ------------------------------------------------------------------------*/
 
 void Graphics::CleanMaxBitmapMemory(void)
 {
-   while(maxAmountOfMemory < bitmapList.GetTotalMemory())
+   FlushDrawing();
+
+   //The scaled copies can be made again, so they go first
+   if(maxAmountOfMemory < GetCurrentBitmapMemory())
+      bitmapList.DestroyScaledCopies();
+
+   //Removing a bitmap from an atlas that other bitmaps are still in
+   //doesn't lower the total, so those bitmaps are passed over
+   while(maxAmountOfMemory < GetCurrentBitmapMemory())
    {
-      bitmapList.RemoveFirstLowestPriorityBitmap();   
+      if(!bitmapList.RemoveLeastRecentlyUsedMemory())
+         break;
    }
 }
 
+/*------------------------------------------------------------------------
+Function Name: GetCurrentBitmapMemory
+Parameters:
+Returns:
+   The number of bytes used by the loaded bitmaps
+Description:
+   The total is kept up to date as surfaces are made and freed, so that
+   the memory cap can be checked after every bitmap that is removed. It
+   counts the bitmaps with surfaces of their own, their tiles and scaled
+   copies, and the atlases and sheets as a whole, including the space 
+   that isn't used by any bitmap.
+------------------------------------------------------------------------*/
+
+UINT Graphics::GetCurrentBitmapMemory(void)
+{
+   return bitmapMemory;
+}
+
 /*------------------------------------------------------------------------
 Function Name: CleanBitmap
 Parameters:
@@ -748,9 +1138,10 @@ Description:
 
 void Graphics::CleanBitmap(UINT bitmapID)
 {
+   FlushDrawing();
    Bitmap* bitmap = bitmapList.GetItemById(bitmapID);
    if(bitmap != NULL)
-      bitmap->DestroyBitmap();
+      bitmapList.RemoveBitmap(bitmap);
 }
 
 /*------------------------------------------------------------------------
@@ -764,6 +1155,7 @@ Description:
 
 void Graphics::CleanBitmapByPriority(UINT priority)
 {
+   FlushDrawing();
    bitmapList.RemoveFirstBitmapByPriority(priority);
 }
 
@@ -778,6 +1170,7 @@ Description:
 
 void Graphics::CleanAllBitmapsByPriority(UINT priority)
 {
+   FlushDrawing();
    bitmapList.RemoveAllBitmapsByPriority(priority);
 }
 
@@ -826,6 +1219,8 @@ Description:
 
 void Graphics::SetTransparentColor(UINT bitmapID, Color& transparentColor)
 {
+   //The runs of the bitmap are found again
+   FlushDrawing();
    bitmapList.GetItemById(bitmapID)->SetTransparentColor(transparentColor);
 }
 
@@ -842,17 +1237,90 @@ Description:
 
 bool Graphics::BitmapFileExists(const char* fileName)
 {
-   bool fileExists = false;
+   if(assetPack != NULL && assetPack->Find(fileName) != NULL)
+      return true;
 
-   FILE* bitmapFile = fopen(fileName, "r");
+   //The file is mapped for the load that usually follows
+   return BitmapFile::Exists(fileName);
+}
+
+/*------------------------------------------------------------------------
+Function Name: OpenAssetPack
+Parameters:
+   const char* fileName : the name of a pack file written by 
+      AssetPack::Build()
+Description:
+   This function maps an asset pack into memory, closing the one that 
+   was open. From then on the bitmaps that are in the pack are copied 
+   from it, a line at a time, when they are loaded with LoadBitmap() or
+   LoadPackedBitmap(), or reloaded after being removed from memory. The
+   pack is only used when it has the pixel format of the screen. Other
+   bitmaps, and the bitmaps of LoadBitmapAsync(), are still decoded from
+   their files.
+------------------------------------------------------------------------*/
+
+void Graphics::OpenAssetPack(const char* fileName)
+{
+   if(assetPack == NULL)
+      assetPack = new AssetPack;
+
+   try
+   {
+      assetPack->Open(fileName);
+   }
+   catch(...)
+   {
+      delete assetPack;
+      assetPack = NULL;
+      throw;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: CloseAssetPack
+Parameters:
+Description:
+   This function closes the asset pack. The bitmaps that were copied 
+   from it stay loaded, but they are loaded from their files if they are
+   ever loaded again.
+------------------------------------------------------------------------*/
 
-   if(bitmapFile != NULL)
+void Graphics::CloseAssetPack()
+{
+   if(assetPack != NULL)
    {
-      fileExists = true;
-      fclose(bitmapFile);
+      delete assetPack;
+      assetPack = NULL;
    }
+}
+
+/*------------------------------------------------------------------------
+Function Name: FindPackedPixels
+Parameters:
+   const char* fileName : the name of a bitmap file
+   Point& size : gets the size of the bitmap
+   LONG& pitch : gets the number of bytes from one line to the next
+Returns:
+   The top line of the bitmap in the asset pack, in the pixel format of
+   the screen, or NULL if it has to be loaded from the file
+------------------------------------------------------------------------*/
+
+UCHAR* FC Graphics::FindPackedPixels(const char* fileName, Point& size,
+   LONG& pitch)
+{
+   if(assetPack == NULL)
+      return NULL;
+
+   int layout = AssetPack::SelectLayout(bytesPerPixel, pixelFormat);
+   if(layout == -1)
+      return NULL;
+
+   AssetPackEntry* entry = assetPack->Find(fileName);
+   if(entry == NULL)
+      return NULL;
 
-   return fileExists;
+   size = Point(entry->width, entry->height);
+   return assetPack->GetPixels(*entry, layout, pitch);
 }
 
 /*------------------------------------------------------------------------
@@ -866,8 +1334,15 @@ Description:
 
 void Graphics::BeginFrame()
 {
-   if(bufferingMode != BT_SINGLE && SSPersistence == false)
+   if(bufferingMode != BT_SINGLE && SSPersistence == false && 
+      frameClearing)
    {
+      if(renderBackend == RB_SOFTWARE)
+      {
+         secondaryBuffer->Fill(NULL, 0);
+         return;
+      }
+
       DDBLTFX bltFx;
       bltFx.dwSize = sizeof(bltFx);
       bltFx.dwFillColor = 0;
@@ -876,6 +1351,33 @@ void Graphics::BeginFrame()
    }
 }
 
+/*------------------------------------------------------------------------
+Function Name: GetDrawingSurfaceAge
+Parameters:
+Returns:
+   the number of frames since the drawing surface was last drawn on
+Description:
+   This function tells how many frames old the contents of the drawing
+   surface are when a frame begins. A persistent surface, or the 
+   offscreen surface of windowed mode, has the previous frame on it. 
+   Buffers that trade places when flipping have the frame before that,
+   and a triple-buffered flip chain has the frame before that one.
+------------------------------------------------------------------------*/
+
+int Graphics::GetDrawingSurfaceAge()
+{
+   if(IsDrawingSurfacePersistent())
+      return 1;
+
+   if(renderBackend == RB_SOFTWARE)
+      return 2;
+
+   if(windowedState == WS_WINDOWED)
+      return 1;
+
+   return (bufferingMode == BT_TRIPLE) ? 3 : 2;
+}
+
 /*------------------------------------------------------------------------
 Function Name: EndFrame
 Parameters:
@@ -890,30 +1392,99 @@ Description:
 void Graphics::EndFrame()
 {
    FlipSurface();
+   bitmapList.NextFrame();
 }
 
-//Drawing Functions
-
 /*------------------------------------------------------------------------
-Function Name: LockSurface
+Function Name: EnableTileRendering
 Parameters:
+   bool enable : whether drawing is recorded and rasterized in tiles
+   int numOfThreads : the number of threads that rasterize the tiles,
+      or 0 for one for each processor
 Description:
-   This function locks the surface and must be called before any of the
-   non-blit functions are used. When the surface is locked, no blit 
-   functions may be used. If it is not called when using non-blit 
-   functions, the program will fail with an error.
+   This function turns tile rendering on or off. With tile rendering on,
+   the drawing functions of the software backend only record what they
+   draw, and the recorded drawing is rasterized on several threads when
+   the frame is flipped or when something needs the pixels that were
+   drawn. What ends up in the drawing buffer is exactly what would have
+   been drawn without it. The DirectDraw backend draws with the blitter
+   anyway, so tile rendering stays off for it.
 ------------------------------------------------------------------------*/
 
-void FC Graphics::LockSurface()
+void Graphics::EnableTileRendering(bool enable, int numOfThreads)
 {
-   assert(surfaceLocked == false);
+   FlushDrawing();
 
-   HRESULT result;
+   if(tileRasterizer != NULL)
+   {
+      delete tileRasterizer;
+      tileRasterizer = NULL;
+   }
 
-   memset(&ddsd, 0, sizeof(ddsd));
-   ddsd.dwSize = sizeof(ddsd);
-   
-   result = lpDDSDrawingSurface->Lock(NULL, &ddsd, DDLOCK_SURFACEMEMORYPTR |
+   tileClipStart = -1;
+
+   if(enable && renderBackend == RB_SOFTWARE)
+      tileRasterizer = new TileRasterizer(this, numOfThreads);
+}
+
+/*------------------------------------------------------------------------
+Function Name: FlushDrawing
+Parameters:
+Description:
+   This function rasterizes the drawing that has been recorded for tile
+   rendering. It is called before anything reads the drawing buffer or 
+   frees something that recorded drawing refers to, and it does nothing
+   when tile rendering is off.
+------------------------------------------------------------------------*/
+
+void FC Graphics::FlushDrawing(void)
+{
+   if(tileRasterizer == NULL || tileRasterizer->IsEmpty())
+      return;
+
+   bool wasLocked = surfaceLocked;
+   if(!wasLocked)
+      LockSurface();
+
+   tileRasterizer->Rasterize();
+
+   if(!wasLocked)
+      UnlockSurface();
+
+   tileClipStart = -1;
+}
+
+//Drawing Functions
+
+/*------------------------------------------------------------------------
+Function Name: LockSurface
+Parameters:
+Description:
+   This function locks the surface and must be called before any of the
+   non-blit functions are used. When the surface is locked, no blit 
+   functions may be used. If it is not called when using non-blit 
+   functions, the program will fail with an error.
+------------------------------------------------------------------------*/
+
+void FC Graphics::LockSurface()
+{
+   assert(surfaceLocked == false);
+
+   //A pixel buffer is always accessible, so locking is only bookkeeping
+   if(renderBackend == RB_SOFTWARE)
+   {
+      videoBuffer = drawingBuffer->GetBits();
+      bufferPitch = drawingBuffer->GetPitch();
+      surfaceLocked = true;
+      return;
+   }
+
+   HRESULT result;
+
+   memset(&ddsd, 0, sizeof(ddsd));
+   ddsd.dwSize = sizeof(ddsd);
+   
+   result = lpDDSDrawingSurface->Lock(NULL, &ddsd, DDLOCK_SURFACEMEMORYPTR |
       DDLOCK_WAIT, NULL);
 
    switch(result)
@@ -954,12 +1525,15 @@ void FC Graphics::UnlockSurface(void)
    assert(surfaceLocked == true);
 
 #ifndef _DEBUG
-   HRESULT result;
+   if(renderBackend != RB_SOFTWARE)
+   {
+      HRESULT result;
 
-   result = lpDDSDrawingSurface->Unlock(NULL);
+      result = lpDDSDrawingSurface->Unlock(NULL);
 
-   if(result != DD_OK)
-      HandleDDrawError(EC_DDLOCKSURFACE, result, __FILE__, __LINE__);
+      if(result != DD_OK)
+         HandleDDrawError(EC_DDLOCKSURFACE, result, __FILE__, __LINE__);
+   }
 #endif
 
    videoBuffer = NULL;
@@ -981,12 +1555,35 @@ void FC Graphics::FlipSurface(void)
 {
    HRESULT result;
 
+   FlushDrawing();
+
    if(IsIconic(hWnd))
       return;
 
    if(surfaceLocked)
       UnlockSurface();
 
+   if(renderBackend == RB_SOFTWARE)
+   {
+      //With persistence the secondary buffer must keep its contents,
+      //otherwise the buffers can simply trade places
+      if(bufferingMode != BT_SINGLE)
+      {
+         if(SSPersistence)
+            primaryBuffer->Blit(0, 0, secondaryBuffer);
+         else
+         {
+            PixelBuffer* tempBuffer = primaryBuffer;
+            primaryBuffer = secondaryBuffer;
+            secondaryBuffer = tempBuffer;
+            drawingBuffer = secondaryBuffer;
+         }
+      }
+
+      PresentSoftwareSurface();
+      return;
+   }
+
    //Check to see if the DirectDraw surfaces were lost
    if(lpDDSPrimary->IsLost() == DDERR_SURFACELOST)
       RestoreAllSurfaces();
@@ -1031,36 +1628,32 @@ Parameters:
    Color& color : the color that the pixel is to be set to
 Description:
    This function sets a pixel at the specified location to the specified
-   color. The specified location must be on the screen and the surface
-   must be locked or the function will fail.
+   color. Nothing is drawn if the location is off the screen or outside
+   the clip list. The surface must be locked or the function will fail.
 ------------------------------------------------------------------------*/
 
 void FC Graphics::SetPixel(int x, int y, Color& color)
 {
    assert(surfaceLocked == true);
-   assert(x >= 0 && x < screenRes.x && y >= 0 && y < screenRes.y);
 
-   switch(colorDepth)
+   if(x < 0 || x >= screenRes.x || y < 0 || y >= screenRes.y)
+      return;
+
+   if(clipping && !clippingRegion.Contains(x, y))
+      return;
+
+   if(tileRasterizer != NULL)
    {
-      case CD_16BIT:
-         ((USHORT*)videoBuffer)[x + y * (bufferPitch >> 1)] = color.To16Bit();
-         break;
-      case CD_24BIT:
-      {
-         UINT colorValue = color.To24Bit();
-         
-         int bufferPosition = (x * 3) + (y * bufferPitch);
+      TileCommand command;
+      command.type = TC_FILL;
+      SetRect(&command.bounds, x, y, x + 1, y + 1);
+      command.pixel = ColorToPixel(color);
 
-         //Copy the 3 bytes into video memory
-			((UCHAR*)videoBuffer)[bufferPosition++] = ((UCHAR*)&colorValue)[0];
-			((UCHAR*)videoBuffer)[bufferPosition++] = ((UCHAR*)&colorValue)[1];
-			((UCHAR*)videoBuffer)[bufferPosition++] = ((UCHAR*)&colorValue)[2];
-      }
-         break;
-      case CD_32BIT:
-         ((UINT*)videoBuffer)[x + y * (bufferPitch >> 2)] = color.To32Bit();
-         break;
+      RecordCommand(command);
+      return;
    }
+
+   spanKernels.HorizontalSpan(GetBufferAddress(x, y), 1, ColorToPixel(color));
 }
 
 /*------------------------------------------------------------------------
@@ -1072,16 +1665,14 @@ Parameters:
    Color& color : the color that the line is to be set to
 Description:
    This function draws a horizontal line between 2 x-coordinates at
-   the specified y-coordinate. The coordinates must be valid coordinates
-   on the screen and the surface must be locked when calling this 
-   function or the function will fail.
+   the specified y-coordinate. The line is clipped to the screen and the
+   clip list. The surface must be locked when calling this function or 
+   the function will fail.
 ------------------------------------------------------------------------*/
 
 void FC Graphics::DrawHorizontalLine(int x1, int x2, int y, Color& color)
 {
    assert(surfaceLocked == true);
-   assert(x1 >= 0 && x1 < screenRes.x && x2 >= 0 && x2 < screenRes.x &&
-      y >= 0 && y < screenRes.y);
 
    int beginX, endX;
    if(x1 < x2)
@@ -1095,45 +1686,30 @@ void FC Graphics::DrawHorizontalLine(int x1, int x2, int y, Color& color)
       endX = x1;
    }
 
-   int bufferPosition;
-   switch(colorDepth)
+   UINT pixel = ColorToPixel(color);
+
+   if(tileRasterizer != NULL)
    {
-      case CD_16BIT:
-         bufferPosition = beginX + y * (bufferPitch >> 1);
-         break;
-      case CD_24BIT:
-         bufferPosition = (beginX * 3) + (y * bufferPitch);
-         break;
-      case CD_32BIT:
-         bufferPosition = beginX + y * (bufferPitch >> 2);
-         break;
+      TileCommand command;
+      command.type = TC_FILL;
+      SetRect(&command.bounds, beginX, y, endX + 1, y + 1);
+      command.pixel = pixel;
+
+      RecordCommand(command);
+      return;
    }
 
-   for(int x = beginX; x <= endX; x++)
+   //Draw the part of the line that is within each clipping rectangle
+   RECT clipRect;
+
+   for(int i = 0; i < GetNumOfLockedClipRects(); i++)
    {
-      switch(colorDepth)
-      {
-         case CD_16BIT:
-            ((USHORT*)videoBuffer)[bufferPosition] = color.To16Bit();
-            bufferPosition++;
-            break;
-         case CD_24BIT:
-         {
-            UINT colorValue = color.To24Bit();
-     
-            //Due to the way an int is stored, index 0 in colorValue
-            //would access the *least* significant byte and not the
-            //most significant byte as would assume
-			   ((UCHAR*)videoBuffer)[bufferPosition++] = ((UCHAR*)&colorValue)[0];
-			   ((UCHAR*)videoBuffer)[bufferPosition++] = ((UCHAR*)&colorValue)[1];
-			   ((UCHAR*)videoBuffer)[bufferPosition++] = ((UCHAR*)&colorValue)[2];
-         }
-            break;
-         case CD_32BIT:
-            ((UINT*)videoBuffer)[bufferPosition] = color.To32Bit();
-            bufferPosition++;
-            break;
-      }      
+      int left = beginX, top = y, right = endX, bottom = y;
+
+      if(GetLockedClipRect(i, clipRect) && 
+         ClipToRect(left, top, right, bottom, clipRect))
+         spanKernels.HorizontalSpan(GetBufferAddress(left, y), 
+            right - left + 1, pixel);
    }
 }
 
@@ -1146,16 +1722,14 @@ Parameters:
    Color& color : the color that the line is to be set to
 Description:
    This function draws a vertical line between 2 y-coordinates at
-   the specified x-coordinate. The coordinates must be valid coordinates
-   on the screen and the surface must be locked when calling this 
-   function or the function will fail.
+   the specified x-coordinate. The line is clipped to the screen and the
+   clip list. The surface must be locked when calling this function or 
+   the function will fail.
 ------------------------------------------------------------------------*/
 
 void FC Graphics::DrawVerticalLine(int x, int y1, int y2, Color& color)
 {
    assert(surfaceLocked == true);
-   assert(x >= 0 && x < screenRes.x && y1 >= 0 && y1 < screenRes.y &&
-      y2 >= 0 && y2 < screenRes.y);
 
    int beginY, endY;
    if(y1 < y2)
@@ -1169,43 +1743,30 @@ void FC Graphics::DrawVerticalLine(int x, int y1, int y2, Color& color)
       endY = y1;
    }
 
-   int bufferPosition;
-   switch(colorDepth)
+   UINT pixel = ColorToPixel(color);
+
+   if(tileRasterizer != NULL)
    {
-      case CD_16BIT:
-         bufferPosition = x + beginY * (bufferPitch >> 1);
-         break;
-      case CD_24BIT:
-         bufferPosition = (x * 3) + (beginY * bufferPitch);
-         break;
-      case CD_32BIT:
-         bufferPosition = x + beginY * (bufferPitch >> 2);
-         break;
+      TileCommand command;
+      command.type = TC_FILL;
+      SetRect(&command.bounds, x, beginY, x + 1, endY + 1);
+      command.pixel = pixel;
+
+      RecordCommand(command);
+      return;
    }
 
-   for(int y = beginY; y <= endY; y++)
+   //Draw the part of the line that is within each clipping rectangle
+   RECT clipRect;
+
+   for(int i = 0; i < GetNumOfLockedClipRects(); i++)
    {
-      switch(colorDepth)
-      {
-         case CD_16BIT:
-            ((USHORT*)videoBuffer)[bufferPosition] = color.To16Bit();
-            bufferPosition = bufferPosition + (bufferPitch >> 1);
-            break;
-         case CD_24BIT:
-         {
-            UINT colorValue = color.To24Bit();
-     
-			   ((UCHAR*)videoBuffer)[bufferPosition] = ((UCHAR*)&colorValue)[0];
-			   ((UCHAR*)videoBuffer)[bufferPosition + 1] = ((UCHAR*)&colorValue)[1];
-			   ((UCHAR*)videoBuffer)[bufferPosition + 2] = ((UCHAR*)&colorValue)[2];
-         }
-            bufferPosition = bufferPosition + bufferPitch;
-            break;
-         case CD_32BIT:
-            ((UINT*)videoBuffer)[bufferPosition] = color.To32Bit();
-            bufferPosition = bufferPosition + (bufferPitch >> 2);
-            break;
-      }      
+      int left = x, top = beginY, right = x, bottom = endY;
+
+      if(GetLockedClipRect(i, clipRect) && 
+         ClipToRect(left, top, right, bottom, clipRect))
+         spanKernels.VerticalSpan(GetBufferAddress(x, top), 
+            bottom - top + 1, bufferPitch, pixel);
    }
 }
 
@@ -1216,223 +1777,205 @@ Parameters:
    Point p2: the coordinate describing the end of the line
    Color& color : the color that the line is to be set to
 Description:
-   This function draws a line between 2 points on the screen. Each point
-   needs to be a valid point on the screen and the surface needs to be
-   locked when calling this function or the function will fail.
+   This function draws a line between 2 points. The points may be off
+   the screen, as the line is clipped to the screen and the clip list.
+   The surface needs to be locked when calling this function or the 
+   function will fail.
 ------------------------------------------------------------------------*/
 
 void FC Graphics::DrawLine(Point& p1, Point& p2, Color& color)
 {
    assert(surfaceLocked == true);
-   assert(p1.x >= 0 && p1.x < screenRes.x && p1.y >= 0 && p1.y < screenRes.y);
-   assert(p2.x >= 0 && p2.x < screenRes.x && p2.y >= 0 && p2.y < screenRes.y);
 
+   UINT pixel = ColorToPixel(color);
+
+   if(tileRasterizer != NULL)
+   {
+      TileCommand command;
+      command.type = TC_LINE;
+      SetRect(&command.bounds, min(p1.x, p2.x), min(p1.y, p2.y), 
+         max(p1.x, p2.x) + 1, max(p1.y, p2.y) + 1);
+      command.x1 = p1.x;
+      command.y1 = p1.y;
+      command.x2 = p2.x;
+      command.y2 = p2.y;
+      command.pixel = pixel;
+
+      RecordCommand(command);
+      return;
+   }
+
+   RECT clipRect;
+
+   for(int i = 0; i < GetNumOfLockedClipRects(); i++)
+   {
+      if(!GetLockedClipRect(i, clipRect))
+         continue;
+
+      UINT outCode1 = GetOutCode(p1, clipRect);
+      UINT outCode2 = GetOutCode(p2, clipRect);
+
+      //Both ends are on the same outer side of the rectangle, so the 
+      //line can't cross it
+      if((outCode1 & outCode2) != 0)
+         continue;
+
+      //Both ends are within the rectangle. The rectangles of the clip
+      //list don't overlap, so the line is in no other rectangle.
+      if((outCode1 | outCode2) == 0)
+      {
+         DrawUnclippedLine(p1, p2, pixel);
+         return;
+      }
+
+      DrawClippedLine(p1, p2, clipRect, pixel);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawUnclippedLine
+Parameters:
+   Point p1: the coordinate describing the beginning of the line
+   Point p2: the coordinate describing the end of the line
+   UINT pixel : the pixel value of the color of the line
+Description:
+   This function draws an entire line with the line kernel. Both points
+   must be within the clip list.
+------------------------------------------------------------------------*/
+
+void FC Graphics::DrawUnclippedLine(Point& p1, Point& p2, UINT pixel)
+{
    //Difference along the x axis
    int dx = p2.x - p1.x;
 
    //Difference along the y axis
    int dy = p2.y - p1.y;
    
-   //Increment to get to the next pixel in the x direction
-   int xInc;
+   //Number of bytes to get to the next pixel in the x direction
+   int xInc = spanKernels.pixelSize;
    
-   //Increment to get to the next pixel in the y direction
-   int yInc;
-
-   //The error factor which tells us when to move to the next pixel line/column
-   int errorFactor = 0;
-
-   //The position in the buffer
-   int bufferPosition;
-
-   switch(colorDepth)
-   {
-      case CD_16BIT:
-         bufferPosition = p1.x + p1.y * (bufferPitch >> 1);
-         break;
-      case CD_24BIT:
-         bufferPosition = (p1.x * 3) + (p1.y * bufferPitch);
-         break;
-      case CD_32BIT:
-         bufferPosition = p1.x + p1.y * (bufferPitch >> 2);
-         break;
-   }
+   //Number of bytes to get to the next pixel in the y direction
+   LONG yInc = bufferPitch;
 
    //Now we need to calculate in which direction we need to go when
    //drawing the line
 
-   //Line is moving to the right
-   if(dx >= 0)
-   {
-      switch(colorDepth)
-      {
-         case CD_16BIT:
-         case CD_32BIT:
-            xInc = 1;
-            break;
-         case CD_24BIT:
-            xInc = 3;
-            break;         
-      }
-   }
    //Line is moving to the left
-   else
+   if(dx < 0)
    {
-      switch(colorDepth)
-      {
-         case CD_16BIT:
-         case CD_32BIT:
-            xInc = -1;
-            break;
-         case CD_24BIT:
-            xInc = -3;
-            break;         
-      }
+      xInc = -xInc;
       dx = -dx;
    }
 
-   //Line is moving down
-   if(dy >= 0)
-   {
-      switch(colorDepth)
-      {
-         case CD_16BIT:
-            yInc = bufferPitch >> 1;
-            break;
-         case CD_24BIT:
-            yInc = bufferPitch;
-            break;         
-         case CD_32BIT:
-            yInc = bufferPitch >> 2;
-      }
-   }
-
    //Line is moving up
-   else
+   if(dy < 0)
    {
-      switch(colorDepth)
-      {
-         case CD_16BIT:
-            yInc = -(bufferPitch >> 1);
-            break;
-         case CD_24BIT:
-            yInc = -bufferPitch;
-            break;         
-         case CD_32BIT:
-            yInc = -(bufferPitch >> 2);
-      }
+      yInc = -yInc;
       dy = -dy;
    }
 
-
    //Now we draw the line
-   if(dx > dy)
-   {
-      for(int i = 0; i <= dx; i++)
-      {
-         //Set the pixel
-         switch(colorDepth)
-         {  
-            case CD_16BIT:
-               ((USHORT*)videoBuffer)[bufferPosition] = color.To16Bit();
-               break;
-            case CD_24BIT:
-            {
-               UINT colorValue = color.To24Bit();
-
-			      ((UCHAR*)videoBuffer)[bufferPosition] = ((UCHAR*)&colorValue)[0];
-			      ((UCHAR*)videoBuffer)[bufferPosition + 1] = ((UCHAR*)&colorValue)[1];
-			      ((UCHAR*)videoBuffer)[bufferPosition + 2] = ((UCHAR*)&colorValue)[2];
-            }
-               break;
-            case CD_32BIT:
-               ((UINT*)videoBuffer)[bufferPosition] = color.To32Bit();
-               break;   
-         }
+   spanKernels.Line(GetBufferAddress(p1.x, p1.y), dx, dy, xInc, yInc, 
+      pixel);
+}
 
-         //Adjust the error factor
-         errorFactor = errorFactor + dy;
+/*------------------------------------------------------------------------
+Function Name: DrawRectangle
+Parameters:
+   DG::Rectangle rect: a rectangle describing the upper-left and lower-
+      right corners of the rectangle to be drawn
+   Color& color : the color that the rectangle should be
+Description:
+   This function draws a non-filled rectangle with 1 pixel-wide borders. 
+   The rectangle is clipped to the screen and the clip list. The surface 
+   needs to be locked when calling this function or the function will 
+   fail.
+------------------------------------------------------------------------*/
 
-         //Test to see if error has overflowed
-         if(errorFactor > dx)
-         {
-            errorFactor = errorFactor - dx;
+void FC Graphics::DrawRectangle(DG::Rectangle& rect, Color& color)
+{
+   assert(surfaceLocked == true);
 
-            //Move to next line
-            bufferPosition = bufferPosition + yInc;
-      	}
+   int beginX, endX, beginY, endY;
 
-         //Move to the next pixel
-         bufferPosition = bufferPosition + xInc;
-      }
+   if(rect.left <= rect.right)
+   {
+      beginX = rect.left;
+      endX = rect.right;
+   }
+   else
+   {
+      beginX = rect.right;
+      endX = rect.left;
    }
 
+   if(rect.top <= rect.bottom)
+   {
+      beginY = rect.top;
+      endY = rect.bottom;
+   }
    else
    {
-      for (int i = 0; i <= dy; i++)
-      {
-         //Set the pixel
-         switch(colorDepth)
-         {  
-            case CD_16BIT:
-               ((USHORT*)videoBuffer)[bufferPosition] = color.To16Bit();
-               break;
-            case CD_24BIT:
-            {
-               UINT colorValue = color.To24Bit();
+      beginY = rect.bottom;
+      endY = rect.top;
+   }
 
-			      ((UCHAR*)videoBuffer)[bufferPosition] = ((UCHAR*)&colorValue)[0];
-			      ((UCHAR*)videoBuffer)[bufferPosition + 1] = ((UCHAR*)&colorValue)[1];
-			      ((UCHAR*)videoBuffer)[bufferPosition + 2] = ((UCHAR*)&colorValue)[2];
-            }
-               break;
-            case CD_32BIT:
-               ((UINT*)videoBuffer)[bufferPosition] = color.To32Bit();
-               break;   
-         }
+   //With a clip list or part of the rectangle off the screen, the lines
+   //clip themselves, and they are recorded for tile rendering
+   if(tileRasterizer != NULL || clipping || beginX < 0 || beginY < 0 || 
+      endX >= screenRes.x || endY >= screenRes.y)
+   {
+      DrawHorizontalLine(beginX, endX, beginY, color);
+      DrawHorizontalLine(beginX, endX, endY, color);
 
-         //Adjust the error factor
-         errorFactor = errorFactor + dx;
+      if(beginY + 1 <= endY - 1)
+      {
+         DrawVerticalLine(beginX, beginY + 1, endY - 1, color);
+         DrawVerticalLine(endX, beginY + 1, endY - 1, color);
+      }
 
-         //Test to see if error overflowed
-         if(errorFactor > 0)
-         {
-            errorFactor = errorFactor - dy;
+      return;
+   }
 
-            //Move to next line
-            bufferPosition = bufferPosition + xInc;
+   UINT pixel = ColorToPixel(color);
+   int width = endX - beginX + 1;
 
-         }
+   //First we draw the top and bottom lines
+   spanKernels.HorizontalSpan(GetBufferAddress(beginX, beginY), width, pixel);
+   spanKernels.HorizontalSpan(GetBufferAddress(beginX, endY), width, pixel);
+   
+   //Now we draw the left and right lines
+   //The corner pixels have already been drawn
+   beginY++;
+   endY--;
 
-         //Move to the next pixel
-         bufferPosition = bufferPosition + yInc;
-      }
+   if(beginY <= endY)
+   {
+      spanKernels.VerticalSpan(GetBufferAddress(beginX, beginY), 
+         endY - beginY + 1, bufferPitch, pixel);
+      spanKernels.VerticalSpan(GetBufferAddress(endX, beginY), 
+         endY - beginY + 1, bufferPitch, pixel);
    }
 }
 
 /*------------------------------------------------------------------------
-Function Name: DrawRectangle
+Function Name: DrawFilledRectangle
 Parameters:
    DG::Rectangle rect: a rectangle describing the upper-left and lower-
       right corners of the rectangle to be drawn
    Color& color : the color that the rectangle should be
 Description:
-   This function draws a non-filled rectangle with 1 pixel-wide borders. 
-   The entire area of the rectangle needs to be within the screen and 
-   the surface needs to be locked when calling this function
-   or the function will fail.
+   This function draws a filled rectangle, completely filling the
+   specified rectangle with the specified color. The rectangle is 
+   clipped to the screen and the clip list. The surface needs to be 
+   locked when calling this function or the function will fail.
 ------------------------------------------------------------------------*/
 
-void FC Graphics::DrawRectangle(DG::Rectangle& rect, Color& color)
+void FC Graphics::DrawFilledRectangle(DG::Rectangle& rect, Color& color)
 {
    assert(surfaceLocked == true);
-   assert(rect.left >= 0 && rect.left < screenRes.x && rect.top >= 0 && 
-      rect.top < screenRes.y && rect.right >= 0 && rect.right < screenRes.x && 
-      rect.bottom >= 0 && rect.bottom < screenRes.y);
 
    int beginX, endX, beginY, endY;
-   USHORT color16Bit = 0;
-   UINT color32Bit = 0;
 
    if(rect.left <= rect.right)
    {
@@ -1456,220 +1999,30 @@ void FC Graphics::DrawRectangle(DG::Rectangle& rect, Color& color)
       endY = rect.top;
    }
 
-   int bufferPositionFirstLine;
-   int bufferPositionSecondLine;
+   UINT pixel = ColorToPixel(color);
 
-   //First we draw the top and bottom lines
-   switch(colorDepth)
+   if(tileRasterizer != NULL)
    {
-      case CD_16BIT:
-         bufferPositionFirstLine = beginX + beginY * (bufferPitch >> 1);
-         bufferPositionSecondLine = beginX + endY * (bufferPitch >> 1);
-         color16Bit = color.To16Bit();
-         break;
-      case CD_24BIT:
-         bufferPositionFirstLine = (beginX * 3) + (beginY * bufferPitch);
-         bufferPositionSecondLine = (beginX * 3) + (endY * bufferPitch);
-         break;
-      case CD_32BIT:
-         bufferPositionFirstLine = beginX + beginY * (bufferPitch >> 2);
-         bufferPositionSecondLine = beginX + endY * (bufferPitch >> 2);
-         color32Bit = color.To32Bit();
-         break;
-   }
-
-   for(int x = beginX; x <= endX; x++)
-   {
-      switch(colorDepth)
-      {
-         case CD_16BIT:
-            ((USHORT*)videoBuffer)[bufferPositionFirstLine] = color16Bit;
-            ((USHORT*)videoBuffer)[bufferPositionSecondLine] = color16Bit;
-            bufferPositionFirstLine++;
-            bufferPositionSecondLine++;
-            break;
-         case CD_24BIT:
-         {
-            UINT colorValue = color.To24Bit();
-			   ((UCHAR*)videoBuffer)[bufferPositionFirstLine++] = ((UCHAR*)&colorValue)[0];
-			   ((UCHAR*)videoBuffer)[bufferPositionFirstLine++] = ((UCHAR*)&colorValue)[1];
-			   ((UCHAR*)videoBuffer)[bufferPositionFirstLine++] = ((UCHAR*)&colorValue)[2];
-
-			   ((UCHAR*)videoBuffer)[bufferPositionSecondLine++] = ((UCHAR*)&colorValue)[0];
-			   ((UCHAR*)videoBuffer)[bufferPositionSecondLine++] = ((UCHAR*)&colorValue)[1];
-			   ((UCHAR*)videoBuffer)[bufferPositionSecondLine++] = ((UCHAR*)&colorValue)[2];
-         }
-            break;
-         case CD_32BIT:
-            ((UINT*)videoBuffer)[bufferPositionFirstLine] = color32Bit;
-            ((UINT*)videoBuffer)[bufferPositionSecondLine] = color32Bit;
-            bufferPositionFirstLine++;
-            bufferPositionSecondLine++;
-            break;
-      }      
-   }  
-   
-   //Now we draw the left and right lines
-   //The corner pixels have already been drawn
-   beginY++;
-   endY--;
-
-   switch(colorDepth)
-   {
-      case CD_16BIT:
-         bufferPositionFirstLine = beginX + beginY * (bufferPitch >> 1);
-         bufferPositionSecondLine = endX + beginY * (bufferPitch >> 1);
-         color16Bit = color.To16Bit();
-         break;
-      case CD_24BIT:
-         bufferPositionFirstLine = (beginX * 3) + (beginY * bufferPitch);
-         bufferPositionSecondLine = (endX * 3) + (beginY * bufferPitch);
-         break;
-      case CD_32BIT:
-         bufferPositionFirstLine = beginX + beginY * (bufferPitch >> 2);
-         bufferPositionSecondLine = endX + beginY * (bufferPitch >> 2);
-         color32Bit = color.To32Bit();
-         break;
-   }
-
-   for(int y = beginY; y <= endY; y++)
-   {
-      switch(colorDepth)
-      {
-         case CD_16BIT:
-            ((USHORT*)videoBuffer)[bufferPositionFirstLine] = color16Bit;
-            ((USHORT*)videoBuffer)[bufferPositionSecondLine] = color16Bit;
-            bufferPositionFirstLine = bufferPositionFirstLine + (bufferPitch >> 1);
-            bufferPositionSecondLine = bufferPositionSecondLine + (bufferPitch >> 1);
-            break;
-         case CD_24BIT:
-         {
-            UINT colorValue = color.To24Bit();
-			   ((UCHAR*)videoBuffer)[bufferPositionFirstLine] = ((UCHAR*)&colorValue)[0];
-			   ((UCHAR*)videoBuffer)[bufferPositionFirstLine + 1] = ((UCHAR*)&colorValue)[1];
-			   ((UCHAR*)videoBuffer)[bufferPositionFirstLine + 2] = ((UCHAR*)&colorValue)[2];
-
-			   ((UCHAR*)videoBuffer)[bufferPositionSecondLine] = ((UCHAR*)&colorValue)[0];
-			   ((UCHAR*)videoBuffer)[bufferPositionSecondLine + 1] = ((UCHAR*)&colorValue)[1];
-			   ((UCHAR*)videoBuffer)[bufferPositionSecondLine + 2] = ((UCHAR*)&colorValue)[2];
-         }
-            bufferPositionFirstLine = bufferPositionFirstLine + bufferPitch;
-            bufferPositionSecondLine = bufferPositionSecondLine + bufferPitch;
-            break;
-         case CD_32BIT:
-            ((UINT*)videoBuffer)[bufferPositionFirstLine] = color32Bit;
-            ((UINT*)videoBuffer)[bufferPositionSecondLine] = color32Bit;
-            bufferPositionFirstLine = bufferPositionFirstLine + (bufferPitch >> 2);
-            bufferPositionSecondLine = bufferPositionSecondLine + (bufferPitch >> 2);
-            break;
-      }      
-   } 
-}
-
-/*------------------------------------------------------------------------
-Function Name: DrawFilledRectangle
-Parameters:
-   DG::Rectangle rect: a rectangle describing the upper-left and lower-
-      right corners of the rectangle to be drawn
-   Color& color : the color that the rectangle should be
-Description:
-   This function draws a filled rectangle, completely filling the
-   specified rectangle with the specified color. 
-   The entire area of the rectangle needs to be within the screen and 
-   the surface needs to be locked when calling this function
-   or the function will fail.
-------------------------------------------------------------------------*/
-
-void FC Graphics::DrawFilledRectangle(DG::Rectangle& rect, Color& color)
-{
-   assert(surfaceLocked == true);
-   assert(rect.left >= 0 && rect.left < screenRes.x && rect.top >= 0 && 
-      rect.top < screenRes.y && rect.right >= 0 && rect.right < screenRes.x && 
-      rect.bottom >= 0 && rect.bottom < screenRes.y);
-
-   int beginX, endX, beginY, endY;
-   USHORT color16Bit = 0;
-   UINT color32Bit = 0;
-
-   if(rect.left <= rect.right)
-   {
-      beginX = rect.left;
-      endX = rect.right;
-   }
-   else
-   {
-      beginX = rect.right;
-      endX = rect.left;
-   }
+      TileCommand command;
+      command.type = TC_FILL;
+      SetRect(&command.bounds, beginX, beginY, endX + 1, endY + 1);
+      command.pixel = pixel;
 
-   if(rect.top <= rect.bottom)
-   {
-      beginY = rect.top;
-      endY = rect.bottom;
-   }
-   else
-   {
-      beginY = rect.bottom;
-      endY = rect.top;
+      RecordCommand(command);
+      return;
    }
 
-   int bufferPosition;
-
-   //First we draw the top and bottom lines
-   switch(colorDepth)
-   {
-      case CD_16BIT:
-         bufferPosition = beginX + beginY * (bufferPitch >> 1);
-         color16Bit = color.To16Bit();
-         break;
-      case CD_24BIT:
-         bufferPosition = (beginX * 3) + (beginY * bufferPitch);
-         break;
-      case CD_32BIT:
-         bufferPosition = beginX + beginY * (bufferPitch >> 2);
-         color32Bit = color.To32Bit();
-         break;
-   }
+   //Fill the part of the rectangle that is within each clipping rectangle
+   RECT clipRect;
 
-   for(int y = beginY; y <= endY; y++)
+   for(int i = 0; i < GetNumOfLockedClipRects(); i++)
    {
-      //Move the buffer position to the current line
-      switch(colorDepth)
-      {
-         case CD_16BIT:
-            bufferPosition = beginX + y * (bufferPitch >> 1);
-            break;
-         case CD_24BIT:
-            bufferPosition = (beginX * 3) + (y * bufferPitch);
-            break;
-         case CD_32BIT:
-            bufferPosition = beginX + y * (bufferPitch >> 2);
-            break;
-      }        
+      int left = beginX, top = beginY, right = endX, bottom = endY;
 
-      //Draw the line
-      for(int x = beginX; x <= endX; x++)
-      {
-         switch(colorDepth)
-         {
-            case CD_16BIT:
-               ((USHORT*)videoBuffer)[bufferPosition] = color16Bit;
-               bufferPosition++;
-               break;
-            case CD_24BIT:
-            {
-               UINT colorValue = color.To24Bit();
-			      ((UCHAR*)videoBuffer)[bufferPosition++] = ((UCHAR*)&colorValue)[0];
-			      ((UCHAR*)videoBuffer)[bufferPosition++] = ((UCHAR*)&colorValue)[1];
-			      ((UCHAR*)videoBuffer)[bufferPosition++] = ((UCHAR*)&colorValue)[2];
-            }
-               break;
-            case CD_32BIT:
-               ((UINT*)videoBuffer)[bufferPosition] = color.To32Bit();
-               bufferPosition++;
-               break;
-         }  
-      }
+      if(GetLockedClipRect(i, clipRect) && 
+         ClipToRect(left, top, right, bottom, clipRect))
+         spanKernels.FillRect(GetBufferAddress(left, top), bufferPitch, 
+            right - left + 1, bottom - top + 1, pixel);
    }
 }
 
@@ -1742,6 +2095,30 @@ void FC Graphics::FillArea(Area& area, Color& color)
    areaRect.right++;
    areaRect.bottom++;
 
+   if(tileRasterizer != NULL)
+   {
+      TileCommand command;
+      command.type = TC_FILL;
+      command.bounds = areaRect;
+      command.pixel = bltFx.dwFillColor;
+
+      RecordCommand(command);
+      return;
+   }
+
+   if(renderBackend == RB_SOFTWARE)
+   {
+      for(int i = 0; i < GetNumOfLockedClipRects(); i++)
+      {
+         drawingBuffer->Fill(&areaRect, bltFx.dwFillColor, 
+            GetSoftwareClipRect(i));
+      }
+      return;
+   }
+
+   if(IsClippedAway())
+      return;
+
    result = lpDDSDrawingSurface->Blt(&areaRect, NULL, NULL, 
       DDBLT_COLORFILL | DDBLT_WAIT, &bltFx);
 
@@ -1782,6 +2159,27 @@ void FC Graphics::FillScreen(Color& color)
          break;
    }
 
+   if(tileRasterizer != NULL)
+   {
+      TileCommand command;
+      command.type = TC_FILL;
+      command.bounds = screenRect;
+      command.pixel = bltFx.dwFillColor;
+
+      RecordCommand(command);
+      return;
+   }
+
+   if(renderBackend == RB_SOFTWARE)
+   {
+      for(int i = 0; i < GetNumOfLockedClipRects(); i++)
+         drawingBuffer->Fill(NULL, bltFx.dwFillColor, GetSoftwareClipRect(i));
+      return;
+   }
+
+   if(IsClippedAway())
+      return;
+
    result = lpDDSDrawingSurface->Blt(NULL, NULL, NULL, 
       DDBLT_COLORFILL | DDBLT_WAIT, &bltFx);
 
@@ -1805,6 +2203,29 @@ void FC Graphics::DrawBitmap(Point& location, UINT bitmapID)
    assert(surfaceLocked == false);
 
    Bitmap* bitmap = bitmapList.GetItemById(bitmapID);
+   bitmapList.UseBitmap(bitmap);
+
+   //The bitmap loader hasn't finished the bitmap yet
+   if(bitmap->IsLoadPending())
+   {
+      DrawPlaceholder(Area(location.x, location.y, bitmap->GetWidth(),
+         bitmap->GetHeight()));
+      return;
+   }
+
+   //Only the tiles of a tiled bitmap that can be seen are drawn
+   if(bitmap->IsTiled())
+   {
+      DrawTiles(location, bitmap);
+      return;
+   }
+
+   //A bitmap with an alpha channel can only be blended
+   if(bitmap->HasAlpha())
+   {
+      BlendBitmap(location, bitmap, 255);
+      return;
+   }
 
 #ifdef _DEBUG
    if(!clipping)
@@ -1816,26 +2237,10 @@ void FC Graphics::DrawBitmap(Point& location, UINT bitmapID)
    }
 #endif
 
-   HRESULT result;
-
-   RECT destRect = {location.x, location.y, 
-      location.x + bitmap->GetWidth(),
-      location.y + bitmap->GetHeight()};
-
-   result = lpDDSDrawingSurface->Blt(&destRect, bitmap->GetDDSurface(), 
-      NULL, DDBLT_WAIT, NULL);
-
-   switch(result)
+   if(!BlitBitmap(location, bitmap))
    {
-      case DDERR_SURFACELOST:
-         RestoreAllSurfaces();
-         DrawBitmap(location, bitmapID);
-         break;
-      case DD_OK:
-         break;
-      default:
-         HandleDDrawError(EC_DDDRAWBMP, result, __FILE__, __LINE__);
-         break;
+      RestoreAllSurfaces();
+      DrawBitmap(location, bitmapID);
    }
 }
 
@@ -1848,7 +2253,12 @@ Description:
    This function draws the bitmap with the specified ID on the screen
    within the area specified. The bitmap will be automatically scaled to
    fit within the specified area. If no clipping region is defined, the 
-   area must be entirely within the screen.
+   area must be entirely within the screen. The software backend and 
+   bilinear filtering scale the bitmap in software, otherwise the 
+   DirectDraw blitter does it. A bitmap that is scaled in software is 
+   scaled once into a scaled copy when it is drawn at the same size 
+   again, and the copy is drawn from then on. A bitmap with an alpha 
+   channel can't be scaled.
 ------------------------------------------------------------------------*/
 
 void FC Graphics::DrawScaledBitmap(Area& area, UINT bitmapID)
@@ -1856,6 +2266,17 @@ void FC Graphics::DrawScaledBitmap(Area& area, UINT bitmapID)
    assert(surfaceLocked == false);
 
    Bitmap* bitmap = bitmapList.GetItemById(bitmapID);
+   bitmapList.UseBitmap(bitmap);
+
+   //The bitmap loader hasn't finished the bitmap yet
+   if(bitmap->IsLoadPending())
+   {
+      DrawPlaceholder(area);
+      return;
+   }
+
+   CheckNotTiled(bitmap);
+   CheckNotAlpha(bitmap);
 
 #ifdef _DEBUG
    if(!clipping)
@@ -1869,11 +2290,35 @@ void FC Graphics::DrawScaledBitmap(Area& area, UINT bitmapID)
 
    HRESULT result;
 
+   if(renderBackend == RB_SOFTWARE || scaleFilter == SF_BILINEAR)
+   {
+      //A bitmap that keeps being drawn at the same size is scaled once
+      //into a copy, which is then drawn without scaling
+      Bitmap* scaledCopy = GetScaledCopy(bitmap, area.width, 
+         area.height);
+
+      if(scaledCopy == NULL)
+         StretchBitmap(area, bitmap, false, 0);
+
+      else if(!BlitBitmap(Point(area.left, area.top), scaledCopy))
+      {
+         RestoreAllSurfaces();
+         DrawScaledBitmap(area, bitmapID);
+      }
+
+      return;
+   }
+
    RECT destRect = {area.left, area.top, 
       area.Right() + 1, area.Bottom() + 1};
 
-   result = lpDDSDrawingSurface->Blt(&destRect, bitmap->GetDDSurface(), 
-      NULL, DDBLT_WAIT, NULL);
+   if(IsClippedAway())
+      return;
+
+   LPDIRECTDRAWSURFACE7 lpDDSSource = bitmap->GetDDSurface();
+
+   result = lpDDSDrawingSurface->Blt(&destRect, lpDDSSource, 
+      bitmap->GetSourceRect(), DDBLT_WAIT, NULL);
 
    switch(result)
    {
@@ -1910,6 +2355,24 @@ void FC Graphics::DrawTransparentBitmap(Point& location, UINT bitmapID,
    assert(surfaceLocked == false);
 
    Bitmap* bitmap = bitmapList.GetItemById(bitmapID);
+   bitmapList.UseBitmap(bitmap);
+
+   //The bitmap loader hasn't finished the bitmap yet
+   if(bitmap->IsLoadPending())
+   {
+      DrawPlaceholder(Area(location.x, location.y, bitmap->GetWidth(),
+         bitmap->GetHeight()));
+      return;
+   }
+
+   CheckNotTiled(bitmap);
+
+   //The alpha channel of a bitmap replaces its transparent color
+   if(bitmap->HasAlpha())
+   {
+      BlendBitmap(location, bitmap, 255);
+      return;
+   }
 
 #ifdef _DEBUG
    if(!clipping)
@@ -1923,6 +2386,58 @@ void FC Graphics::DrawTransparentBitmap(Point& location, UINT bitmapID,
 
    HRESULT result;
 
+   if(renderBackend == RB_SOFTWARE)
+   {
+      PixelBuffer* bitmapBuffer = bitmap->GetPixelBuffer();
+      RunLengthSprite* sprite = bitmap->GetRunLengthSprite();
+      UINT key = ColorToPixel(transparentColor);
+
+      //The runs of the bitmap can only be used if they were found with
+      //the same transparent color
+      bool useRuns = (sprite != NULL && sprite->GetKey() == key);
+
+      if(tileRasterizer != NULL)
+      {
+         TileCommand command;
+         SetRect(&command.bounds, location.x, location.y, 
+            location.x + bitmap->GetWidth(), 
+            location.y + bitmap->GetHeight());
+         command.x1 = location.x;
+         command.y1 = location.y;
+
+         if(useRuns)
+         {
+            command.type = TC_RUNLENGTHBLIT;
+            command.source = sprite;
+         }
+         else
+         {
+            command.type = TC_TRANSPARENTBLIT;
+            command.pixel = key;
+            command.source = bitmapBuffer;
+            command.sourceRect = bitmap->GetSourceRect();
+         }
+
+         RecordCommand(command);
+         return;
+      }
+
+      for(int i = 0; i < GetNumOfLockedClipRects(); i++)
+      {
+         if(useRuns)
+            drawingBuffer->BlitRunLength(location.x, location.y, sprite,
+               GetSoftwareClipRect(i));
+         else
+            drawingBuffer->BlitTransparent(location.x, location.y, 
+               bitmapBuffer, key, bitmap->GetSourceRect(), 
+               GetSoftwareClipRect(i));
+      }
+      return;
+   }
+
+   if(IsClippedAway())
+      return;
+
    RECT destRect = {location.x, location.y, 
       location.x + bitmap->GetWidth(),
       location.y + bitmap->GetHeight()};
@@ -1945,8 +2460,10 @@ void FC Graphics::DrawTransparentBitmap(Point& location, UINT bitmapID,
    bltFx.dwSize = sizeof(bltFx);
    bltFx.ddckSrcColorkey = colorKey;
 
-   result = lpDDSDrawingSurface->Blt(&destRect, bitmap->GetDDSurface(), 
-      NULL, DDBLT_WAIT | DDBLT_KEYSRCOVERRIDE, &bltFx);
+   LPDIRECTDRAWSURFACE7 lpDDSSource = bitmap->GetDDSurface();
+
+   result = lpDDSDrawingSurface->Blt(&destRect, lpDDSSource, 
+      bitmap->GetSourceRect(), DDBLT_WAIT | DDBLT_KEYSRCOVERRIDE, &bltFx);
 
    switch(result)
    {
@@ -1974,7 +2491,8 @@ Description:
    within the area specified. Any pixel of the transparent color in the
    bitmap will not be drawn on the screen. The bitmap will be 
    automatically scaled to fit within the specified area. If no clipping 
-   region is defined, the area must be entirely within the screen.
+   region is defined, the area must be entirely within the screen. A 
+   bitmap with an alpha channel can't be scaled.
 ------------------------------------------------------------------------*/
 
 void FC Graphics::DrawTransparentScaledBitmap(Area& area, UINT bitmapID,
@@ -1983,6 +2501,17 @@ void FC Graphics::DrawTransparentScaledBitmap(Area& area, UINT bitmapID,
    assert(surfaceLocked == false);
 
    Bitmap* bitmap = bitmapList.GetItemById(bitmapID);
+   bitmapList.UseBitmap(bitmap);
+
+   //The bitmap loader hasn't finished the bitmap yet
+   if(bitmap->IsLoadPending())
+   {
+      DrawPlaceholder(area);
+      return;
+   }
+
+   CheckNotTiled(bitmap);
+   CheckNotAlpha(bitmap);
 
 #ifdef _DEBUG
    if(!clipping)
@@ -1996,9 +2525,18 @@ void FC Graphics::DrawTransparentScaledBitmap(Area& area, UINT bitmapID,
 
    HRESULT result;
 
+   if(renderBackend == RB_SOFTWARE || scaleFilter == SF_BILINEAR)
+   {
+      StretchBitmap(area, bitmap, true, ColorToPixel(transparentColor));
+      return;
+   }
+
    RECT destRect = {area.left, area.top, 
       area.Right() + 1, area.Bottom() + 1};
 
+   if(IsClippedAway())
+      return;
+
    DDCOLORKEY colorKey;
    switch(colorDepth)
    {
@@ -2017,8 +2555,10 @@ void FC Graphics::DrawTransparentScaledBitmap(Area& area, UINT bitmapID,
    bltFx.dwSize = sizeof(bltFx);
    bltFx.ddckSrcColorkey = colorKey;
 
-   result = lpDDSDrawingSurface->Blt(&destRect, bitmap->GetDDSurface(), 
-      NULL, DDBLT_WAIT | DDBLT_KEYSRCOVERRIDE, &bltFx);
+   LPDIRECTDRAWSURFACE7 lpDDSSource = bitmap->GetDDSurface();
+
+   result = lpDDSDrawingSurface->Blt(&destRect, lpDDSSource, 
+      bitmap->GetSourceRect(), DDBLT_WAIT | DDBLT_KEYSRCOVERRIDE, &bltFx);
 
    switch(result)
    {
@@ -2053,6 +2593,24 @@ void FC Graphics::DrawTransparentBitmap(Point& location, UINT bitmapID)
    assert(surfaceLocked == false);
 
    Bitmap* bitmap = bitmapList.GetItemById(bitmapID);
+   bitmapList.UseBitmap(bitmap);
+
+   //The bitmap loader hasn't finished the bitmap yet
+   if(bitmap->IsLoadPending())
+   {
+      DrawPlaceholder(Area(location.x, location.y, bitmap->GetWidth(),
+         bitmap->GetHeight()));
+      return;
+   }
+
+   CheckNotTiled(bitmap);
+
+   //The alpha channel of a bitmap replaces its transparent color
+   if(bitmap->HasAlpha())
+   {
+      BlendBitmap(location, bitmap, 255);
+      return;
+   }
 
 #ifdef _DEBUG
    if(!clipping)
@@ -2066,12 +2624,67 @@ void FC Graphics::DrawTransparentBitmap(Point& location, UINT bitmapID)
 
    HRESULT result;
 
+   if(renderBackend == RB_SOFTWARE)
+   {
+      RunLengthSprite* sprite = bitmap->GetRunLengthSprite();
+
+      //A packed bitmap has no runs of its own
+      if(sprite == NULL)
+      {
+         DrawTransparentBitmap(location, bitmapID, 
+            bitmap->GetTransparentColor());
+         return;
+      }
+
+      if(tileRasterizer != NULL)
+      {
+         TileCommand command;
+         command.type = TC_RUNLENGTHBLIT;
+         SetRect(&command.bounds, location.x, location.y, 
+            location.x + bitmap->GetWidth(), 
+            location.y + bitmap->GetHeight());
+         command.x1 = location.x;
+         command.y1 = location.y;
+         command.source = sprite;
+
+         RecordCommand(command);
+         return;
+      }
+
+      for(int i = 0; i < GetNumOfLockedClipRects(); i++)
+      {
+         drawingBuffer->BlitRunLength(location.x, location.y, sprite,
+            GetSoftwareClipRect(i));
+      }
+      return;
+   }
+
+   if(IsClippedAway())
+      return;
+
    RECT destRect = {location.x, location.y, 
-      (location.x + bitmap->GetWidth()) - 1,
-      (location.y + bitmap->GetHeight()) - 1};
+      location.x + bitmap->GetWidth(),
+      location.y + bitmap->GetHeight()};
+
+   LPDIRECTDRAWSURFACE7 lpDDSSource = bitmap->GetDDSurface();
 
-   result = lpDDSDrawingSurface->Blt(&destRect, bitmap->GetDDSurface(), 
-      NULL, DDBLT_WAIT | DDBLT_KEYSRC, NULL);
+   //An atlas has no color key, so a packed bitmap passes its own
+   DWORD keyFlag = DDBLT_KEYSRC;
+   DDBLTFX bltFx;
+   memset(&bltFx, 0, sizeof(bltFx));
+   bltFx.dwSize = sizeof(bltFx);
+
+   if(bitmap->GetAtlas() != NULL)
+   {
+      bltFx.ddckSrcColorkey.dwColorSpaceLowValue = 
+         ColorToPixel(bitmap->GetTransparentColor());
+      bltFx.ddckSrcColorkey.dwColorSpaceHighValue = 
+         bltFx.ddckSrcColorkey.dwColorSpaceLowValue;
+      keyFlag = DDBLT_KEYSRCOVERRIDE;
+   }
+
+   result = lpDDSDrawingSurface->Blt(&destRect, lpDDSSource, 
+      bitmap->GetSourceRect(), DDBLT_WAIT | keyFlag, &bltFx);
 
    switch(result)
    {
@@ -2099,7 +2712,7 @@ Description:
    transparent color in the bitmap will not be drawn on the screen. 
    The bitmap will be automatically scaled to fit within the specified 
    area. If no clipping region is defined, the area must be entirely 
-   within the screen.
+   within the screen. A bitmap with an alpha channel can't be scaled.
 ------------------------------------------------------------------------*/
 
 void FC Graphics::DrawTransparentScaledBitmap(Area& area, UINT bitmapID)
@@ -2107,8 +2720,19 @@ void FC Graphics::DrawTransparentScaledBitmap(Area& area, UINT bitmapID)
    assert(surfaceLocked == false);
 
    Bitmap* bitmap = bitmapList.GetItemById(bitmapID);
+   bitmapList.UseBitmap(bitmap);
 
-#ifdef _DEBUG
+   //The bitmap loader hasn't finished the bitmap yet
+   if(bitmap->IsLoadPending())
+   {
+      DrawPlaceholder(area);
+      return;
+   }
+
+   CheckNotTiled(bitmap);
+   CheckNotAlpha(bitmap);
+
+#ifdef _DEBUG
    if(!clipping)
    {
       assert(area.left >= 0 && area.left < screenRes.x && 
@@ -2120,11 +2744,38 @@ void FC Graphics::DrawTransparentScaledBitmap(Area& area, UINT bitmapID)
 
    HRESULT result;
 
+   if(renderBackend == RB_SOFTWARE || scaleFilter == SF_BILINEAR)
+   {
+      StretchBitmap(area, bitmap, true, 
+         ColorToPixel(bitmap->GetTransparentColor()));
+      return;
+   }
+
+   if(IsClippedAway())
+      return;
+
    RECT destRect = {area.left, area.top, 
-      area.Right(), area.Bottom()};
+      area.Right() + 1, area.Bottom() + 1};
+
+   LPDIRECTDRAWSURFACE7 lpDDSSource = bitmap->GetDDSurface();
+
+   //An atlas has no color key, so a packed bitmap passes its own
+   DWORD keyFlag = DDBLT_KEYSRC;
+   DDBLTFX bltFx;
+   memset(&bltFx, 0, sizeof(bltFx));
+   bltFx.dwSize = sizeof(bltFx);
+
+   if(bitmap->GetAtlas() != NULL)
+   {
+      bltFx.ddckSrcColorkey.dwColorSpaceLowValue = 
+         ColorToPixel(bitmap->GetTransparentColor());
+      bltFx.ddckSrcColorkey.dwColorSpaceHighValue = 
+         bltFx.ddckSrcColorkey.dwColorSpaceLowValue;
+      keyFlag = DDBLT_KEYSRCOVERRIDE;
+   }
 
-   result = lpDDSDrawingSurface->Blt(&destRect, bitmap->GetDDSurface(), 
-      NULL, DDBLT_WAIT | DDBLT_KEYSRC, NULL);
+   result = lpDDSDrawingSurface->Blt(&destRect, lpDDSSource, 
+      bitmap->GetSourceRect(), DDBLT_WAIT | keyFlag, &bltFx);
 
    switch(result)
    {
@@ -2140,6 +2791,218 @@ void FC Graphics::DrawTransparentScaledBitmap(Area& area, UINT bitmapID)
    }
 }
 
+/*------------------------------------------------------------------------
+Function Name: DrawAlphaBitmap
+Parameters:
+   Point& location : the location at which to draw the bitmap, this
+      is the coordinate where the upper-left corner of the bitmap will be.
+   UINT bitmapID : the ID of the bitmap to be drawn
+Description:
+   This function blends a bitmap with an alpha channel onto the screen.
+   The bitmap is clipped to the screen and the clip list. The surface
+   is locked while the bitmap is drawn, so it doesn't have to be locked
+   beforehand.
+------------------------------------------------------------------------*/
+
+void FC Graphics::DrawAlphaBitmap(Point& location, UINT bitmapID)
+{
+   Bitmap* bitmap = bitmapList.GetItemById(bitmapID);
+   bitmapList.UseBitmap(bitmap);
+
+   //The bitmap loader hasn't finished the bitmap yet
+   if(bitmap->IsLoadPending())
+   {
+      DrawPlaceholder(Area(location.x, location.y, bitmap->GetWidth(),
+         bitmap->GetHeight()));
+      return;
+   }
+
+   //Blending a tiled bitmap without fading it is what drawing it does
+   if(bitmap->IsTiled())
+   {
+      DrawTiles(location, bitmap);
+      return;
+   }
+
+   assert(bitmap->HasAlpha());
+
+   BlendBitmap(location, bitmap, 255);
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawAlphaBitmap
+Parameters:
+   Point& location : the location at which to draw the bitmap, this
+      is the coordinate where the upper-left corner of the bitmap will be.
+   UINT bitmapID : the ID of the bitmap to be drawn
+   BYTE opacity : the opacity of the whole bitmap, from 0 (invisible)
+      to 255 (only the alpha channel of the bitmap counts)
+Description:
+   This function blends a bitmap with an alpha channel onto the screen,
+   fading the whole bitmap by the opacity, which is useful for fading
+   windows and sprites in and out.
+------------------------------------------------------------------------*/
+
+void FC Graphics::DrawAlphaBitmap(Point& location, UINT bitmapID, 
+   BYTE opacity)
+{
+   Bitmap* bitmap = bitmapList.GetItemById(bitmapID);
+   bitmapList.UseBitmap(bitmap);
+
+   //The bitmap loader hasn't finished the bitmap yet
+   if(bitmap->IsLoadPending())
+   {
+      DrawPlaceholder(Area(location.x, location.y, bitmap->GetWidth(),
+         bitmap->GetHeight()));
+      return;
+   }
+
+   CheckNotTiled(bitmap);
+
+   assert(bitmap->HasAlpha());
+
+   BlendBitmap(location, bitmap, opacity);
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawBackingStore
+Parameters:
+   Point& location: the location on the screen of the upper-left corner
+      of the window that the store belongs to
+   BackingStore* store : the backing store to be drawn
+Returns:
+   true if the store was drawn, false if the store's surface was lost 
+   and what was on it is gone
+Description:
+   This function draws a backing store on the screen, so that the window
+   it belongs to doesn't have to draw itself. Like a bitmap, the store
+   is clipped to the clip list.
+------------------------------------------------------------------------*/
+
+bool FC Graphics::DrawBackingStore(Point& location, BackingStore* store)
+{
+   assert(surfaceLocked == false);
+   assert(store->IsCreated());
+
+   if(tileRasterizer != NULL)
+   {
+      TileCommand command;
+      command.type = TC_BLIT;
+      SetRect(&command.bounds, location.x, location.y, 
+         location.x + store->GetWidth(), location.y + store->GetHeight());
+      command.x1 = location.x;
+      command.y1 = location.y;
+      command.source = store->GetPixelBuffer();
+      command.sourceRect = NULL;
+
+      RecordCommand(command);
+      return true;
+   }
+
+   if(renderBackend == RB_SOFTWARE)
+   {
+      for(int i = 0; i < GetNumOfLockedClipRects(); i++)
+      {
+         drawingBuffer->Blit(location.x, location.y, 
+            store->GetPixelBuffer(), NULL, GetSoftwareClipRect(i));
+      }
+      return true;
+   }
+
+   if(IsClippedAway())
+      return true;
+
+   RECT destRect = {location.x, location.y, 
+      location.x + store->GetWidth(),
+      location.y + store->GetHeight()};
+
+   HRESULT result;
+   result = lpDDSDrawingSurface->Blt(&destRect, store->GetDDSurface(), 
+      NULL, DDBLT_WAIT, NULL);
+
+   switch(result)
+   {
+      case DDERR_SURFACELOST:
+         RestoreAllSurfaces();
+         store->Restore();
+         return false;
+      case DD_OK:
+         break;
+      default:
+         HandleDDrawError(EC_DDBACKINGSTORE, result, __FILE__, __LINE__);
+         break;
+   }
+
+   return true;
+}
+
+/*------------------------------------------------------------------------
+Function Name: CopyToBackingStore
+Parameters:
+   ClipRegion& region : the part of the screen to be copied, which must
+      be on the screen and within the window that the store belongs to
+   Point& location: the location on the screen of the upper-left corner
+      of the window that the store belongs to
+   BackingStore* store : the backing store to copy to
+Returns:
+   true if the region was copied, false if a surface was lost
+Description:
+   This function copies what a window has drawn from the drawing surface 
+   into the window's backing store, and marks that part of the store as
+   valid.
+------------------------------------------------------------------------*/
+
+bool FC Graphics::CopyToBackingStore(ClipRegion& region, Point& location,
+   BackingStore* store)
+{
+   assert(surfaceLocked == false);
+   assert(store->IsCreated());
+
+   //What is copied has to have been drawn
+   FlushDrawing();
+
+   RECT* rects = region.GetRects();
+
+   if(renderBackend == RB_SOFTWARE)
+   {
+      for(int i = 0; i < region.GetNumOfRects(); i++)
+      {
+         store->GetPixelBuffer()->Blit(rects[i].left - location.x, 
+            rects[i].top - location.y, drawingBuffer, &rects[i]);
+      }
+
+      store->Validate(region, location);
+      return true;
+   }
+
+   HRESULT result;
+
+   //The store has no clipper, so the faster BltFast can be used
+   for(int j = 0; j < region.GetNumOfRects(); j++)
+   {
+      result = store->GetDDSurface()->BltFast(rects[j].left - location.x,
+         rects[j].top - location.y, lpDDSDrawingSurface, &rects[j],
+         DDBLTFAST_NOCOLORKEY | DDBLTFAST_WAIT);
+
+      switch(result)
+      {
+         case DDERR_SURFACELOST:
+            RestoreAllSurfaces();
+            store->Restore();
+            return false;
+         case DD_OK:
+            break;
+         default:
+            HandleDDrawError(EC_DDBACKINGSTORE, result, __FILE__, 
+               __LINE__);
+            break;
+      }
+   }
+
+   store->Validate(region, location);
+   return true;
+}
+
 
 //GDI Drawing Functions
 
@@ -2155,7 +3018,8 @@ Description:
 
 void Graphics::FlipToGDISurface()
 {
-   lpDD->FlipToGDISurface();
+   if(renderBackend != RB_SOFTWARE)
+      lpDD->FlipToGDISurface();
 }
 
 /*------------------------------------------------------------------------
@@ -2169,7 +3033,15 @@ Description:
 
 void FC Graphics::SetGDIFont(Font& font)
 {
+   //Fonts with the same attributes share an entry, so this is a pointer
+   //comparison
+   if(font == currentGDIFont)
+      return;
+
    currentGDIFont = font;
+
+   //The atlas of the font is looked for the next time text is drawn
+   currentGlyphAtlas = NULL;
 }
 
 /*------------------------------------------------------------------------
@@ -2229,21 +3101,39 @@ Parameters:
 Description:
    This function draws the specified text within the bounding rectangle
    according to the flags. This is a wrapper around the Win32 API
-   DrawText() function and behaves about the same.
+   DrawText() function and behaves about the same. Unless it has been
+   disabled, the text is drawn from the glyph atlas of the current font
+   if the flags allow it, which is much faster than GDI.
 ------------------------------------------------------------------------*/
 
 void FC Graphics::DrawText(char* text, DG::Rectangle& rect, UINT flags)
 {
+   //Glyph atlases don't underline the character after a &
+   if(glyphText && (flags & ~GA_SUPPORTED_FLAGS) == 0 &&
+      ((flags & DT_NOPREFIX) || strchr(text, '&') == NULL))
+   {
+      DrawGlyphText(text, rect, flags);
+      return;
+   }
+
+   if(renderBackend == RB_SOFTWARE)
+   {
+      DrawSoftwareText(text, rect, flags);
+      return;
+   }
+
    HDC hDC;
    HRESULT result;
 
    result = lpDDSDrawingSurface->GetDC(&hDC);
 
-   HRGN clippingRegion;
+   HRGN clipRegionHandle;
    if(clipping)
    {
-      clippingRegion = CreateRectRgnIndirect(&clippingRect.ToRECT());
-      SelectClipRgn(hDC, clippingRegion);
+      clipRegionHandle = ExtCreateRegion(NULL, 
+         clippingRegion.GetRegionDataSize(), 
+         clippingRegion.GetRegionData());
+      SelectClipRgn(hDC, clipRegionHandle);
    }
 
    ::SetTextColor(hDC, textColor.ToCOLORREF());
@@ -2257,7 +3147,7 @@ void FC Graphics::DrawText(char* text, DG::Rectangle& rect, UINT flags)
    {
       case DDERR_SURFACELOST:
          if(clipping)
-            DeleteObject((HGDIOBJ)(HRGN)clippingRegion);
+            DeleteObject((HGDIOBJ)(HRGN)clipRegionHandle);
          RestoreAllSurfaces();
          DrawText(text, rect, flags);
          break;
@@ -2265,7 +3155,7 @@ void FC Graphics::DrawText(char* text, DG::Rectangle& rect, UINT flags)
          break;
       default:
          if(clipping)
-            DeleteObject((HGDIOBJ)(HRGN)clippingRegion);
+            DeleteObject((HGDIOBJ)(HRGN)clipRegionHandle);
          HandleDDrawError(EC_DDTEXT, result, __FILE__, __LINE__);
          break;
    }
@@ -2286,7 +3176,7 @@ void FC Graphics::DrawText(char* text, DG::Rectangle& rect, UINT flags)
    result = lpDDSDrawingSurface->ReleaseDC(hDC);
 
    if(clipping)
-      DeleteObject((HGDIOBJ)(HRGN)clippingRegion);
+      DeleteObject((HGDIOBJ)(HRGN)clipRegionHandle);
 }
 
 //Clipping Functions
@@ -2296,62 +3186,93 @@ Parameters:
    DG::Rectangle& rect : the clipping area to be added
 Description:
    This function adds the clipping area to the clip list on the drawing
-   surface. At the moment only one clipping area can be in the clip list,
-   so the given clipping area will replace the previous clipping area.
+   surface. Nothing outside of the areas in the clip list is drawn, so 
+   if there was no clip list before, the clip list will consist of just
+   this area.
 ------------------------------------------------------------------------*/
 
 void FC Graphics::AddClippingArea(DG::Rectangle& rect)
 {
-//   assert(rect.left >= 0 && rect.left < screenRes.x &&
-//      rect.right >= 0 && rect.right < screenRes.x &&
-//      rect.top >= 0 && rect.top < screenRes.y &&
-//      rect.bottom >= 0 && rect.bottom < screenRes.y);
+   RECT areaRect = rect.ToClipRECT();
 
-   int tempVariable;
-   if(rect.left > rect.right)
-   {
-      tempVariable = rect.left;
-      rect.left = rect.right;
-      rect.right = tempVariable;
-   }
+   if(!clipping)
+      clippingRegion.Clear();
 
-   if(rect.top > rect.bottom)
-   {
-      tempVariable = rect.top;
-      rect.top = rect.bottom;
-      rect.bottom = tempVariable;
-   }
+   clippingRegion.Union(areaRect);
 
-   //Store the clipping rect in a DG::Rectangle object so we can
-   //easily use it later
-   clippingRect = rect;
+   ApplyClippingRegion();
+}
 
-   RECT areaRect = rect.ToRECT();
+/*------------------------------------------------------------------------
+Function Name: IntersectClippingArea()
+Parameters:
+   DG::Rectangle& rect : the clipping area to intersect the clip list with
+Description:
+   This function removes everything outside of the clipping area from the
+   clip list on the drawing surface. If there was no clip list before,
+   the clip list will consist of just this area.
+------------------------------------------------------------------------*/
 
-   //The right and bottom appear to be exclusive with a clipping 
-   //rectangle, so we must increment them by 1
-   areaRect.right++;
-   areaRect.bottom++;
+void FC Graphics::IntersectClippingArea(DG::Rectangle& rect)
+{
+   RECT areaRect = rect.ToClipRECT();
 
-   //Add the clipping list to the DirectDraw clipper object
-   memcpy(clippingArea->Buffer, &areaRect, sizeof(RECT));
-   clippingArea->rdh.rcBound = areaRect;
-   lpDSClipper->SetClipList(clippingArea, 0);
+   if(!clipping)
+      clippingRegion.SetRect(areaRect);
+   else
+      clippingRegion.Intersect(areaRect);
 
-   HRESULT result;
-   result = lpDDSDrawingSurface->SetClipper(lpDSClipper);
+   ApplyClippingRegion();
+}
 
-   if(result != DD_OK)
-      HandleDDrawError(EC_DDCLIPPING, result, __FILE__, __LINE__);      
+/*------------------------------------------------------------------------
+Function Name: SubtractClippingArea()
+Parameters:
+   DG::Rectangle& rect : the clipping area to be removed from the clip
+      list
+Description:
+   This function removes the clipping area from the clip list on the 
+   drawing surface, so that nothing will be drawn within that area. If 
+   there was no clip list before, the clip list will consist of the 
+   entire screen except this area.
+------------------------------------------------------------------------*/
 
-   clipping = true;
+void FC Graphics::SubtractClippingArea(DG::Rectangle& rect)
+{
+   RECT areaRect = rect.ToClipRECT();
+
+   if(!clipping)
+   {
+      RECT screenRect = {0, 0, screenRes.x, screenRes.y};
+      clippingRegion.SetRect(screenRect);
+   }
+
+   clippingRegion.Subtract(areaRect);
+
+   ApplyClippingRegion();
+}
+
+/*------------------------------------------------------------------------
+Function Name: SetClippingRegion()
+Parameters:
+   ClipRegion& region : the new clip list
+Description:
+   This function replaces the clip list on the drawing surface with the
+   given region.
+------------------------------------------------------------------------*/
+
+void FC Graphics::SetClippingRegion(ClipRegion& region)
+{
+   clippingRegion = region;
+
+   ApplyClippingRegion();
 }
 
 /*------------------------------------------------------------------------
 Function Name: RemoveClippingArea()
 Parameters:
 Description:
-   This function removes the clipping area from the drawing surface.
+   This function removes the clip list from the drawing surface.
    After the function is called, there will be no clipping areas on the
    drawing surface.
 ------------------------------------------------------------------------*/
@@ -2361,16 +3282,18 @@ void FC Graphics::RemoveClippingArea()
    //We now aren't clipping anymore and need to remove the clipper object
    //from the surface
    clipping = false;
-   lpDDSDrawingSurface->SetClipper(NULL);
+   tileClipStart = -1;
+
+   if(renderBackend != RB_SOFTWARE)
+      lpDDSDrawingSurface->SetClipper(NULL);
 }
 
 /*------------------------------------------------------------------------
 Function Name: ClearClippingAreas()
 Parameters:
 Description:
-   This function removes all the clipping area from the drawing surface.
-   The function is the same as RemoveClippingArea for now, but this will
-   change once multiple clipping areas are implemented.
+   This function removes all the clipping areas from the drawing surface.
+   The function is the same as RemoveClippingArea.
 ------------------------------------------------------------------------*/
 
 void FC Graphics::ClearClippingAreas()
@@ -2398,8 +3321,12 @@ Surface* FC Graphics::GetSurface(Area& area)
       return NULL;
    
    currentSurface = new Surface(area);
-   AddClippingArea(DG::Rectangle(area.left, area.top, area.Right(), 
-      area.Bottom()));
+
+   RECT surfaceRect = {area.left, area.top, area.Right() + 1, 
+      area.Bottom() + 1};
+   ClipRegion surfaceRegion(surfaceRect);
+   SetClippingRegion(surfaceRegion);
+
    return currentSurface;
 }
 
@@ -2438,8 +3365,15 @@ Description:
 
 void FC Graphics::RestoreAllSurfaces()
 {
+   //Pixel buffers in system memory can never be lost
+   if(renderBackend == RB_SOFTWARE)
+      return;
+
    HRESULT result;
 
+   //The contents of the restored surfaces are undefined
+   surfaceGeneration++;
+
    //Try to restore the primary surface
    result = lpDDSPrimary->Restore();
 
@@ -2468,6 +3402,28 @@ Description:
 
 void FC Graphics::DestroyAllSurfaces()
 {
+   //Whatever was recorded was going to be drawn on the old surfaces
+   if(tileRasterizer != NULL)
+   {
+      tileRasterizer->Clear();
+      tileClipStart = -1;
+   }
+
+   //Get rid of the software surfaces
+   if(primaryBuffer != NULL)
+   {
+      delete primaryBuffer;
+      primaryBuffer = NULL;
+   }
+
+   if(secondaryBuffer != NULL)
+   {
+      delete secondaryBuffer;
+      secondaryBuffer = NULL;
+   }
+
+   drawingBuffer = NULL;
+
    //Get rid of the old surfaces
    if(lpDDSPrimary != NULL)
    {
@@ -2512,6 +3468,12 @@ void FC Graphics::ClearPrimarySurface()
 {
    assert(surfaceLocked == false);
 
+   if(renderBackend == RB_SOFTWARE)
+   {
+      primaryBuffer->Fill(NULL, 0);
+      return;
+   }
+
    HRESULT result;
 
    DDBLTFX bltFx;
@@ -2525,6 +3487,1693 @@ void FC Graphics::ClearPrimarySurface()
       HandleDDrawError(EC_DDCLEARPRIMARY, result, __FILE__, __LINE__);
 }
 
+/*------------------------------------------------------------------------
+Function Name: CreateSoftwareSurfaces()
+Parameters:
+   Point res : the resolution of the surfaces
+   UINT winState : WS_WINDOWED or WS_FULLSCREEN
+   UINT clrDepth : the color depth of the surfaces, which can be
+      CD_16BIT, CD_24BIT, or CD_32BIT
+   UINT bufferMode : the buffer mode, which can be BT_SINGLE, BT_DOUBLE,
+      or BT_TRIPLE
+Description:
+   This function creates the primary and secondary surfaces of the 
+   software backend as pixel buffers in system memory. The display mode
+   is never changed: in full-screen mode the window just covers the 
+   screen and the frame is stretched to fit it. The pixel format is
+   always 5-6-5 in 16-bit color and 8-8-8 otherwise. Triple buffering
+   has no meaning in system memory and is the same as double buffering.
+------------------------------------------------------------------------*/
+
+void Graphics::CreateSoftwareSurfaces(Point res, UINT winState, 
+   UINT clrDepth, UINT bufferMode)
+{
+   if(clrDepth != CD_16BIT && clrDepth != CD_24BIT && clrDepth != CD_32BIT)
+   {
+      throw new Exception("Only 16-, 24-, and 32-bit color depths are "\
+         "supported.", EC_DDSETGRAPHMODE, ET_DIRECTDRAW, __FILE__, __LINE__);
+   }
+
+   if(bufferMode != BT_SINGLE && bufferMode != BT_DOUBLE && 
+      bufferMode != BT_TRIPLE)
+   {
+      throw new Exception("The buffer mode flag is not valid", 
+         EC_DDSETGRAPHMODE, ET_DIRECTDRAW, __FILE__, __LINE__);
+   }
+
+   //The frame is still shown in the application window
+   if(winState == WS_WINDOWED)
+   {
+      SetWindowLong(hWnd, GWL_STYLE, WS_OVERLAPPEDWINDOW | WS_VISIBLE);
+   
+      int xWindowSize = res.x + (GetSystemMetrics(SM_CXSIZEFRAME) * 2);
+      int yWindowSize = res.y + (GetSystemMetrics(SM_CYSIZEFRAME) * 2) +
+         GetSystemMetrics(SM_CYCAPTION);
+
+      SetWindowPos(hWnd, 0, 
+         (GetSystemMetrics(SM_CXSCREEN) - res.x) / 2,
+         (GetSystemMetrics(SM_CYSCREEN) - res.y) / 2,
+         xWindowSize, yWindowSize, SWP_SHOWWINDOW);
+   }
+
+   else
+   {
+      SetWindowLong(hWnd, GWL_STYLE, WS_POPUP | WS_VISIBLE);
+
+      SetWindowPos(hWnd, 0, 0, 0, GetSystemMetrics(SM_CXSCREEN),
+         GetSystemMetrics(SM_CYSCREEN), SWP_SHOWWINDOW);
+   }
+
+   //Describe the pixel format so that the color lookup tables can be
+   //created the same way as for a DirectDraw surface
+   memset(&pixelFormat, 0, sizeof(DDPIXELFORMAT));
+   pixelFormat.dwSize = sizeof(DDPIXELFORMAT);
+   pixelFormat.dwFlags = DDPF_RGB;
+
+   switch(clrDepth)
+   {
+      case CD_16BIT:
+         bytesPerPixel = 2;
+         pixelFormat.dwRGBBitCount = 16;
+         pixelFormat.dwRBitMask = 0xF800;
+         pixelFormat.dwGBitMask = 0x07E0;
+         pixelFormat.dwBBitMask = 0x001F;
+         break;
+      case CD_24BIT:
+      case CD_32BIT:
+         bytesPerPixel = (clrDepth == CD_24BIT) ? 3 : 4;
+         pixelFormat.dwRGBBitCount = bytesPerPixel * 8;
+         pixelFormat.dwRBitMask = 0x00FF0000;
+         pixelFormat.dwGBitMask = 0x0000FF00;
+         pixelFormat.dwBBitMask = 0x000000FF;
+         break;
+   }
+
+   primaryBuffer = new PixelBuffer(res.x, res.y, bytesPerPixel);
+
+   if(bufferMode != BT_SINGLE)
+   {
+      secondaryBuffer = new PixelBuffer(res.x, res.y, bytesPerPixel);
+      drawingBuffer = secondaryBuffer;
+   }
+
+   else
+      drawingBuffer = primaryBuffer;
+
+   colorDepth = clrDepth;
+
+   Color::CreateLookupTables(pixelFormat, colorDepth);
+}
+
+/*------------------------------------------------------------------------
+Function Name: PresentSoftwareSurface()
+Parameters:
+Description:
+   This function copies the primary pixel buffer of the software backend 
+   into the client area of the application window with GDI.
+------------------------------------------------------------------------*/
+
+void FC Graphics::PresentSoftwareSurface()
+{
+   //A BITMAPINFO with room for the 3 color masks of a 16-bit DIB
+   struct
+   {
+      BITMAPINFOHEADER bmiHeader;
+      DWORD bmiColorMasks[3];
+   } bitmapInfo;
+
+   memset(&bitmapInfo, 0, sizeof(bitmapInfo));
+   bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+   bitmapInfo.bmiHeader.biWidth = primaryBuffer->GetWidth();
+
+   //A negative height makes the DIB top-down like the pixel buffer
+   bitmapInfo.bmiHeader.biHeight = -primaryBuffer->GetHeight();
+   bitmapInfo.bmiHeader.biPlanes = 1;
+   bitmapInfo.bmiHeader.biBitCount = WORD(bytesPerPixel * 8);
+   bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+   if(colorDepth == CD_16BIT)
+   {
+      bitmapInfo.bmiHeader.biCompression = BI_BITFIELDS;
+      bitmapInfo.bmiColorMasks[0] = 0xF800;
+      bitmapInfo.bmiColorMasks[1] = 0x07E0;
+      bitmapInfo.bmiColorMasks[2] = 0x001F;
+   }
+
+   RECT windowRect;
+   GetClientRect(hWnd, &windowRect);
+
+   HDC hDC = GetDC(hWnd);
+
+   StretchDIBits(hDC, 0, 0, windowRect.right, windowRect.bottom,
+      0, 0, primaryBuffer->GetWidth(), primaryBuffer->GetHeight(), 
+      primaryBuffer->GetBits(), (BITMAPINFO*)&bitmapInfo, 
+      DIB_RGB_COLORS, SRCCOPY);
+
+   ReleaseDC(hWnd, hDC);
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawSoftwareText()
+Parameters:
+   char* text : an array of characters containing the string to be drawn
+   DG::Rectangle& rect : the bounding rectangle on the screen
+   UINT flags : the Win32 API DrawText() flags
+Description:
+   This function is DrawText() for the software backend. The part of the
+   drawing buffer under the text is copied into a DIB section, the text
+   is drawn into the DIB section with GDI, and the result is copied back.
+------------------------------------------------------------------------*/
+
+void FC Graphics::DrawSoftwareText(char* text, DG::Rectangle& rect, 
+   UINT flags)
+{
+   //GDI draws over what is already in the buffer
+   FlushDrawing();
+
+   HDC hDC = CreateCompatibleDC(NULL);
+
+   HFONT hOldFont = (HFONT)SelectObject(hDC, currentGDIFont.GetFontHandle());
+
+   RECT rectStruct = rect.ToRECT();
+
+   //Measuring the text doesn't need anything to draw on
+   if(flags & DT_CALCRECT)
+   {
+      ::DrawText(hDC, text, -1, &rectStruct, flags | DT_EXPANDTABS |
+         DT_NOPREFIX);
+
+      rect.SetRectangle(rectStruct.left, rectStruct.top, rectStruct.right,
+         rectStruct.bottom);
+
+      SelectObject(hDC, hOldFont);
+      DeleteDC(hDC);
+      return;
+   }
+
+   //Only the visible part of the bounding rectangle is copied
+   RECT visibleRect = rectStruct;
+   RECT bufferRect = {0, 0, drawingBuffer->GetWidth(), 
+      drawingBuffer->GetHeight()};
+   
+   IntersectRect(&visibleRect, &visibleRect, &bufferRect);
+
+   if(clipping)
+   {
+      RECT& clipBounds = clippingRegion.GetBounds();
+      IntersectRect(&visibleRect, &visibleRect, &clipBounds);
+   }
+
+   if(IsRectEmpty(&visibleRect))
+   {
+      SelectObject(hDC, hOldFont);
+      DeleteDC(hDC);
+      return;
+   }
+
+   int visibleWidth = visibleRect.right - visibleRect.left;
+   int visibleHeight = visibleRect.bottom - visibleRect.top;
+
+   struct
+   {
+      BITMAPINFOHEADER bmiHeader;
+      DWORD bmiColorMasks[3];
+   } bitmapInfo;
+
+   memset(&bitmapInfo, 0, sizeof(bitmapInfo));
+   bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+   bitmapInfo.bmiHeader.biWidth = visibleWidth;
+   bitmapInfo.bmiHeader.biHeight = -visibleHeight;
+   bitmapInfo.bmiHeader.biPlanes = 1;
+   bitmapInfo.bmiHeader.biBitCount = WORD(bytesPerPixel * 8);
+   bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+   if(colorDepth == CD_16BIT)
+   {
+      bitmapInfo.bmiHeader.biCompression = BI_BITFIELDS;
+      bitmapInfo.bmiColorMasks[0] = 0xF800;
+      bitmapInfo.bmiColorMasks[1] = 0x07E0;
+      bitmapInfo.bmiColorMasks[2] = 0x001F;
+   }
+
+   UCHAR* dibBits = NULL;
+   HBITMAP dibSection = CreateDIBSection(hDC, (BITMAPINFO*)&bitmapInfo,
+      DIB_RGB_COLORS, (void**)&dibBits, NULL, 0);
+
+   if(dibSection == NULL)
+   {
+      SelectObject(hDC, hOldFont);
+      DeleteDC(hDC);
+      throw new Exception("The text bitmap could not be created.", 
+         EC_DDTEXT, ET_DIRECTDRAW, __FILE__, __LINE__);
+   }
+
+   HBITMAP hOldBitmap = (HBITMAP)SelectObject(hDC, dibSection);
+
+   //DIB scanlines have the same padding as pixel buffer scanlines
+   LONG dibPitch = ((visibleWidth * bytesPerPixel) + 3) & ~3;
+   int lineSize = visibleWidth * bytesPerPixel;
+   int y;
+
+   //Copy what is already drawn, so that transparent text has the right
+   //background
+   for(y = 0; y < visibleHeight; y++)
+   {
+      memcpy(dibBits + (y * dibPitch), 
+         drawingBuffer->GetScanLine(visibleRect.top + y) + 
+         (visibleRect.left * bytesPerPixel), lineSize);
+   }
+
+   ::SetTextColor(hDC, textColor.ToCOLORREF());
+   ::SetBkColor(hDC, textBackgroundColor.ToCOLORREF());
+   ::SetBkMode(hDC, textTransparencyMode);
+
+   //Move the origin so that the text is drawn at screen coordinates
+   SetViewportOrgEx(hDC, -visibleRect.left, -visibleRect.top, NULL);
+
+   ::DrawText(hDC, text, -1, &rectStruct, flags | DT_EXPANDTABS |
+      DT_NOPREFIX);
+
+   //Make sure GDI is finished before touching the bits
+   GdiFlush();
+
+   //Only the part of the text within the clip list is copied back
+   for(int i = 0; i < GetNumOfLockedClipRects(); i++)
+   {
+      RECT copyRect = visibleRect;
+      RECT* clipRect = GetSoftwareClipRect(i);
+
+      if(clipRect != NULL && !IntersectRect(&copyRect, &copyRect, clipRect))
+         continue;
+
+      int copySize = (copyRect.right - copyRect.left) * bytesPerPixel;
+      UCHAR* copySource = dibBits + 
+         ((copyRect.top - visibleRect.top) * dibPitch) +
+         ((copyRect.left - visibleRect.left) * bytesPerPixel);
+
+      for(y = copyRect.top; y < copyRect.bottom; y++, copySource += dibPitch)
+      {
+         memcpy(drawingBuffer->GetScanLine(y) + 
+            (copyRect.left * bytesPerPixel), copySource, copySize);
+      }
+   }
+
+   SelectObject(hDC, hOldBitmap);
+   SelectObject(hDC, hOldFont);
+   DeleteObject(dibSection);
+   DeleteDC(hDC);
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetGlyphAtlas()
+Parameters:
+Returns:
+   The glyph atlas of the current font
+Description:
+   This function finds the glyph atlas of the current font, creating it
+   the first time text is drawn with the font.
+------------------------------------------------------------------------*/
+
+GlyphAtlas* FC Graphics::GetGlyphAtlas(void)
+{
+   if(currentGlyphAtlas != NULL)
+      return currentGlyphAtlas;
+
+   ListIterator<GlyphAtlas> iterator = glyphAtlasList.Begin();
+
+   while(!iterator.EndOfList())
+   {
+      if(iterator.GetData()->Matches(currentGDIFont))
+      {
+         currentGlyphAtlas = iterator.GetData();
+         return currentGlyphAtlas;
+      }
+
+      iterator++;
+   }
+
+   //The atlas is added to the list before it is created, so that it is
+   //freed even if it can't be created
+   GlyphAtlas* atlas = new GlyphAtlas;
+   glyphAtlasList.Append(atlas, glyphAtlasList.GetNumOfItems());
+   atlas->Create(currentGDIFont);
+
+   currentGlyphAtlas = atlas;
+
+   return currentGlyphAtlas;
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawGlyphText()
+Parameters:
+   char* text : an array of characters containing the string to be drawn
+   DG::Rectangle& rect : the bounding rectangle on the screen
+   UINT flags : the Win32 API DrawText() flags, which must be within 
+      GA_SUPPORTED_FLAGS
+Description:
+   This function is DrawText() for text drawn from the glyph atlas of 
+   the current font. The text is laid out once and the layout is kept by
+   the atlas, so measuring text and drawing it again, which controls do
+   every frame, only costs a lookup. The runs of each glyph are drawn 
+   with the span kernels, so it works the same way on both backends and
+   never needs a device context. The surface is locked if it isn't 
+   already.
+------------------------------------------------------------------------*/
+
+void FC Graphics::DrawGlyphText(char* text, DG::Rectangle& rect, UINT flags)
+{
+   GlyphAtlas* atlas = GetGlyphAtlas();
+   TextLayout* layout = atlas->GetLayout(text, rect.right - rect.left, 
+      flags);
+
+   if(flags & DT_CALCRECT)
+   {
+      rect.SetRectangle(rect.left, rect.top, rect.left + layout->GetWidth(),
+         rect.top + layout->GetHeight());
+      return;
+   }
+
+   int lineHeight = atlas->GetLineHeight();
+
+   //Only single lines can be centered vertically or put at the bottom
+   int y = rect.top;
+
+   if(flags & DT_SINGLELINE)
+   {
+      if(flags & DT_VCENTER)
+         y = rect.top + (((rect.bottom - rect.top) - lineHeight) / 2);
+      else if(flags & DT_BOTTOM)
+         y = rect.bottom - lineHeight;
+   }
+
+   UINT pixel = ColorToPixel(textColor);
+   UINT backgroundPixel = ColorToPixel(textBackgroundColor);
+
+   if(tileRasterizer != NULL)
+   {
+      RecordGlyphText(atlas, layout, rect, flags, y, pixel, 
+         backgroundPixel);
+      return;
+   }
+
+   bool wasLocked = surfaceLocked;
+   if(!wasLocked)
+      LockSurface();
+
+   RECT clipRect;
+
+   for(int i = 0; i < GetNumOfLockedClipRects(); i++)
+   {
+      if(!GetLockedClipRect(i, clipRect))
+         continue;
+
+      if(!(flags & DT_NOCLIP))
+      {
+         if(clipRect.left < rect.left)
+            clipRect.left = rect.left;
+         if(clipRect.top < rect.top)
+            clipRect.top = rect.top;
+         if(clipRect.right > rect.right)
+            clipRect.right = rect.right;
+         if(clipRect.bottom > rect.bottom)
+            clipRect.bottom = rect.bottom;
+
+         if(clipRect.left >= clipRect.right || 
+            clipRect.top >= clipRect.bottom)
+            continue;
+      }
+
+      int lineY = y;
+
+      for(int lineIndex = 0; lineIndex < layout->GetNumOfLines() && 
+         lineY < clipRect.bottom; lineIndex++, lineY += lineHeight)
+      {
+         if(lineY + lineHeight <= clipRect.top)
+            continue;
+
+         TextLine& line = layout->GetLine(lineIndex);
+         int lineX = rect.left;
+
+         if(flags & DT_CENTER)
+            lineX += ((rect.right - rect.left) - line.width) / 2;
+         else if(flags & DT_RIGHT)
+            lineX = rect.right - line.width;
+
+         if(textTransparencyMode == OPAQUE)
+         {
+            int left = lineX, top = lineY;
+            int right = (lineX + line.width) - 1;
+            int bottom = (lineY + lineHeight) - 1;
+
+            if(ClipToRect(left, top, right, bottom, clipRect))
+               spanKernels.FillRect(GetBufferAddress(left, top), 
+                  bufferPitch, right - left + 1, bottom - top + 1, 
+                  backgroundPixel);
+         }
+
+         DrawGlyphLine(atlas, layout, line, lineX, lineY, pixel, clipRect);
+      }
+   }
+
+   if(!wasLocked)
+      UnlockSurface();
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawGlyphLine()
+Parameters:
+   GlyphAtlas* atlas : the atlas of the font the text is drawn with
+   TextLayout* layout : the layout of the text
+   TextLine& line : the line to be drawn
+   int x, int y : the upper-left corner of the line on the screen
+   UINT pixel : the pixel value of the text color
+   RECT& clipRect : the clipping rectangle, with an exclusive right and
+      bottom
+Description:
+   This function draws the runs of each glyph in a line that are within
+   the clipping rectangle. The surface must be locked.
+------------------------------------------------------------------------*/
+
+void FC Graphics::DrawGlyphLine(GlyphAtlas* atlas, TextLayout* layout,
+   TextLine& line, int x, int y, UINT pixel, RECT& clipRect)
+{
+   int lastGlyph = line.firstGlyph + line.numOfGlyphs;
+
+   for(int i = line.firstGlyph; i < lastGlyph; i++)
+   {
+      PlacedGlyph& placedGlyph = layout->GetGlyph(i);
+      Glyph& glyph = atlas->GetGlyph(placedGlyph.character);
+      int glyphX = x + placedGlyph.x + glyph.left;
+
+      if(glyphX >= clipRect.right)
+         break;
+
+      DrawGlyph(atlas, placedGlyph.character, glyphX, y, pixel, clipRect);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawGlyph()
+Parameters:
+   GlyphAtlas* atlas : the atlas of the font the glyph belongs to
+   UCHAR character : the character of the glyph
+   int x, int y : the upper-left corner of the glyph on the screen
+   UINT pixel : the pixel value of the text color
+   RECT& clipRect : the clipping rectangle, with an exclusive right and
+      bottom
+Description:
+   This function draws the runs of a glyph that are within the clipping
+   rectangle. The surface must be locked.
+------------------------------------------------------------------------*/
+
+void FC Graphics::DrawGlyph(GlyphAtlas* atlas, UCHAR character, int x, 
+   int y, UINT pixel, RECT& clipRect)
+{
+   Glyph& glyph = atlas->GetGlyph(character);
+
+   for(UINT r = 0; r < glyph.numOfRuns; r++)
+   {
+      USHORT* run = atlas->GetRun(glyph.firstRun + r);
+
+      int spanY = y + run[0];
+      int left = x + run[1];
+      int right = left + run[2];
+
+      if(spanY < clipRect.top || spanY >= clipRect.bottom)
+         continue;
+
+      if(left < clipRect.left)
+         left = clipRect.left;
+      if(right > clipRect.right)
+         right = clipRect.right;
+
+      if(left < right)
+         spanKernels.HorizontalSpan(GetBufferAddress(left, spanY), 
+            right - left, pixel);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: RecordGlyphText()
+Parameters:
+   GlyphAtlas* atlas : the atlas of the font the text is drawn with
+   TextLayout* layout : the layout of the text
+   DG::Rectangle& rect : the rectangle the text is drawn in
+   UINT flags : the DrawText() flags of the text
+   int y : the top of the first line on the screen
+   UINT pixel : the pixel value of the text color
+   UINT backgroundPixel : the pixel value of the background color
+Description:
+   This function records text for tile rendering, with a command for the
+   background of each line if it is opaque and one for each glyph. The
+   glyphs are recorded separately so that each tile only draws the 
+   glyphs that reach it.
+------------------------------------------------------------------------*/
+
+void FC Graphics::RecordGlyphText(GlyphAtlas* atlas, TextLayout* layout,
+   DG::Rectangle& rect, UINT flags, int y, UINT pixel, 
+   UINT backgroundPixel)
+{
+   RECT limitRect = {rect.left, rect.top, rect.right, rect.bottom};
+
+   TileCommand command;
+   if(!RecordClipRects(command, (flags & DT_NOCLIP) ? NULL : &limitRect))
+      return;
+
+   int lineHeight = atlas->GetLineHeight();
+   int lineY = y;
+
+   for(int lineIndex = 0; lineIndex < layout->GetNumOfLines(); 
+      lineIndex++, lineY += lineHeight)
+   {
+      TextLine& line = layout->GetLine(lineIndex);
+      int lineX = rect.left;
+
+      if(flags & DT_CENTER)
+         lineX += ((rect.right - rect.left) - line.width) / 2;
+      else if(flags & DT_RIGHT)
+         lineX = rect.right - line.width;
+
+      if(textTransparencyMode == OPAQUE)
+      {
+         command.type = TC_FILL;
+         SetRect(&command.bounds, lineX, lineY, lineX + line.width, 
+            lineY + lineHeight);
+         command.pixel = backgroundPixel;
+
+         tileRasterizer->AddCommand(command);
+      }
+
+      command.type = TC_GLYPH;
+      command.pixel = pixel;
+      command.source = atlas;
+
+      int lastGlyph = line.firstGlyph + line.numOfGlyphs;
+
+      for(int i = line.firstGlyph; i < lastGlyph; i++)
+      {
+         PlacedGlyph& placedGlyph = layout->GetGlyph(i);
+         Glyph& glyph = atlas->GetGlyph(placedGlyph.character);
+         int glyphX = lineX + placedGlyph.x + glyph.left;
+
+         SetRect(&command.bounds, glyphX, lineY, glyphX + glyph.width, 
+            lineY + lineHeight);
+         command.x1 = glyphX;
+         command.y1 = lineY;
+         command.parameter = placedGlyph.character;
+
+         tileRasterizer->AddCommand(command);
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: ColorToPixel()
+Parameters:
+   Color& color : the color to be converted
+Returns:
+   The color in the pixel format of the current color depth
+Description:
+   This function converts a color into a pixel value that can be written 
+   to the drawing surface.
+------------------------------------------------------------------------*/
+
+UINT FC Graphics::ColorToPixel(Color& color)
+{
+   switch(colorDepth)
+   {
+      case CD_16BIT:
+         return color.To16Bit();
+      case CD_24BIT:
+         return color.To24Bit();
+      default:
+         return color.To32Bit();
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetBufferAddress()
+Parameters:
+   int x : the x coordinate of the pixel
+   int y : the y coordinate of the pixel
+Returns:
+   A pointer to the first byte of the pixel in the locked drawing surface
+Description:
+   This function calculates the address of a pixel in the locked drawing
+   surface, which is where the span kernels start drawing.
+------------------------------------------------------------------------*/
+
+UCHAR* FC Graphics::GetBufferAddress(int x, int y)
+{
+   return videoBuffer + (y * bufferPitch) + (x * spanKernels.pixelSize);
+}
+
+/*------------------------------------------------------------------------
+Function Name: ApplyClippingRegion()
+Parameters:
+Description:
+   This function turns clipping on and hands the clip list to the
+   DirectDraw clipper of the drawing surface.
+------------------------------------------------------------------------*/
+
+void FC Graphics::ApplyClippingRegion()
+{
+   clipping = true;
+   tileClipStart = -1;
+
+   //The software backend clips with the rectangles of the clip list
+   //directly
+   if(renderBackend == RB_SOFTWARE)
+      return;
+
+   //DirectDraw won't take an empty clip list, but nothing is drawn when
+   //the clip list is empty anyway
+   if(clippingRegion.IsEmpty())
+      return;
+
+   //Add the clipping list to the DirectDraw clipper object
+   lpDSClipper->SetClipList(clippingRegion.GetRegionData(), 0);
+
+   HRESULT result;
+   result = lpDDSDrawingSurface->SetClipper(lpDSClipper);
+
+   if(result != DD_OK)
+      HandleDDrawError(EC_DDCLIPPING, result, __FILE__, __LINE__);      
+}
+
+/*------------------------------------------------------------------------
+Function Name: ClipToRect()
+Parameters:
+   int& left, int& top, int& right, int& bottom : the corners of the area
+      to be clipped, with an inclusive right and bottom
+   RECT& clipRect : the clipping rectangle, with an exclusive right and
+      bottom
+Returns:
+   true if part of the area is within the clipping rectangle, false if
+   none of it is
+Description:
+   This function shrinks an area to the part of it that is within a 
+   clipping rectangle.
+------------------------------------------------------------------------*/
+
+bool FC Graphics::ClipToRect(int& left, int& top, int& right, int& bottom,
+   RECT& clipRect)
+{
+   if(left < clipRect.left)
+      left = clipRect.left;
+   if(top < clipRect.top)
+      top = clipRect.top;
+   if(right >= clipRect.right)
+      right = clipRect.right - 1;
+   if(bottom >= clipRect.bottom)
+      bottom = clipRect.bottom - 1;
+
+   return left <= right && top <= bottom;
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawClippedLine()
+Parameters:
+   Point& p1 : the coordinate describing the beginning of the line
+   Point& p2 : the coordinate describing the end of the line
+   RECT& clipRect : the clipping rectangle, with an exclusive right and
+      bottom
+   UINT pixel : the pixel value of the color of the line
+Description:
+   This function draws the part of a line that is within a clipping
+   rectangle. Instead of testing each pixel, the range of pixels within
+   the rectangle is calculated and the line kernel is started in the
+   middle of the line with the error factor it would have had there.
+   This way the pixels drawn are exactly the ones that would have been
+   drawn without clipping.
+------------------------------------------------------------------------*/
+
+void FC Graphics::DrawClippedLine(Point& p1, Point& p2, RECT& clipRect,
+   UINT pixel)
+{
+   int dx = p2.x - p1.x;
+   int dy = p2.y - p1.y;
+   int xDir = 1;
+   int yDir = 1;
+
+   if(dx < 0)
+   {
+      xDir = -1;
+      dx = -dx;
+   }
+
+   if(dy < 0)
+   {
+      yDir = -1;
+      dy = -dy;
+   }
+
+   //The line kernel steps along the major axis with every pixel and 
+   //along the minor axis whenever the error factor overflows. Like
+   //DrawLine, a line with dx == dy has the y axis as its major axis.
+   int major, minor;
+   int majorStart, minorStart, majorDir, minorDir;
+   int majorLow, majorHigh, minorLow, minorHigh;
+   LONG majorStep, minorStep;
+
+   if(dx > dy)
+   {
+      major = dx;
+      minor = dy;
+      majorStart = p1.x;
+      minorStart = p1.y;
+      majorDir = xDir;
+      minorDir = yDir;
+      majorLow = clipRect.left;
+      majorHigh = clipRect.right - 1;
+      minorLow = clipRect.top;
+      minorHigh = clipRect.bottom - 1;
+      majorStep = xDir * spanKernels.pixelSize;
+      minorStep = yDir * bufferPitch;
+   }
+   else
+   {
+      major = dy;
+      minor = dx;
+      majorStart = p1.y;
+      minorStart = p1.x;
+      majorDir = yDir;
+      minorDir = xDir;
+      majorLow = clipRect.top;
+      majorHigh = clipRect.bottom - 1;
+      minorLow = clipRect.left;
+      minorHigh = clipRect.right - 1;
+      majorStep = yDir * bufferPitch;
+      minorStep = xDir * spanKernels.pixelSize;
+   }
+
+   //The first and last pixel, counted from the beginning of the line,
+   //whose major coordinate is within the clipping rectangle
+   int firstPixel, lastPixel;
+
+   if(majorDir > 0)
+   {
+      firstPixel = majorLow - majorStart;
+      lastPixel = majorHigh - majorStart;
+   }
+   else
+   {
+      firstPixel = majorStart - majorHigh;
+      lastPixel = majorStart - majorLow;
+   }
+
+   if(firstPixel < 0)
+      firstPixel = 0;
+   if(lastPixel > major)
+      lastPixel = major;
+
+   //The first and last number of minor steps that keep the minor 
+   //coordinate within the clipping rectangle
+   int firstStep, lastStep;
+
+   if(minorDir > 0)
+   {
+      firstStep = minorLow - minorStart;
+      lastStep = minorHigh - minorStart;
+   }
+   else
+   {
+      firstStep = minorStart - minorHigh;
+      lastStep = minorStart - minorLow;
+   }
+
+   if(firstStep < 0)
+      firstStep = 0;
+
+   if(firstPixel > lastPixel || lastStep < 0)
+      return;
+
+   //Pixel i of the line has taken (initialError + i * minor) / major
+   //minor steps, which is turned around to find the pixels at which 
+   //the line enters and leaves the minor range
+   int initialError = major >> 1;
+
+   if(minor == 0)
+   {
+      if(firstStep > 0)
+         return;
+   }
+   else
+   {
+      if(firstStep > 0)
+      {
+         __int64 enterPixel = ((__int64(firstStep) * major) - 
+            initialError + minor - 1) / minor;
+         if(enterPixel > firstPixel)
+            firstPixel = int(enterPixel);
+      }
+
+      __int64 leavePixel = ((__int64(lastStep + 1) * major) - 
+         initialError - 1) / minor;
+      if(leavePixel < lastPixel)
+         lastPixel = int(leavePixel);
+
+      if(firstPixel > lastPixel)
+         return;
+   }
+
+   //Find the position and the error factor at the first pixel
+   int steps = 0;
+   int errorFactor = 0;
+
+   if(major > 0)
+   {
+      __int64 error = (__int64(firstPixel) * minor) + initialError;
+      steps = int(error / major);
+      errorFactor = int(error % major);
+   }
+
+   int majorCoord = majorStart + (majorDir * firstPixel);
+   int minorCoord = minorStart + (minorDir * steps);
+
+   UCHAR* dest;
+   if(dx > dy)
+      dest = GetBufferAddress(majorCoord, minorCoord);
+   else
+      dest = GetBufferAddress(minorCoord, majorCoord);
+
+   spanKernels.LineSpan(dest, (lastPixel - firstPixel) + 1, major, minor,
+      errorFactor, majorStep, minorStep, pixel);
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetSoftwareClipRect()
+Parameters:
+   int index : the index of the rectangle in the clip list
+Returns:
+   A pointer to the clipping rectangle with an exclusive right and bottom
+   or NULL if there is no clipping
+Description:
+   This function returns a rectangle of the clip list, which the software 
+   backend passes to the pixel buffers.
+------------------------------------------------------------------------*/
+
+RECT* FC Graphics::GetSoftwareClipRect(int index)
+{
+   if(!clipping)
+      return NULL;
+
+   return &clippingRegion.GetRects()[index];
+}
+
+/*------------------------------------------------------------------------
+Function Name: AllocateAtlasArea()
+Parameters:
+   int width : the width of a packed bitmap
+   int height : the height of a packed bitmap
+   RECT& rect : receives the area of the bitmap in the atlas
+Returns:
+   The atlas that the bitmap is packed into
+Description:
+   This function finds room for a bitmap in the first atlas that has 
+   enough, or in a new atlas if none of them do.
+------------------------------------------------------------------------*/
+
+BitmapAtlas* FC Graphics::AllocateAtlasArea(int width, int height, 
+   RECT& rect)
+{
+   ListIterator<BitmapAtlas> iterator = bitmapAtlasList.Begin();
+
+   while(!iterator.EndOfList())
+   {
+      if(iterator.GetData()->Allocate(width, height, rect))
+         return iterator.GetData();
+
+      iterator++;
+   }
+
+   BitmapAtlas* atlas = new BitmapAtlas;
+   bitmapAtlasList.Append(atlas, bitmapAtlasList.GetNumOfItems());
+
+   if(!atlas->Allocate(width, height, rect))
+   {
+      throw new Exception("The bitmap is too large for an atlas.", 
+         EC_BMBITMAPLOAD, ET_BITMAP, __FILE__, __LINE__);
+   }
+
+   return atlas;
+}
+
+/*------------------------------------------------------------------------
+Function Name: ReloadAtlasBitmaps()
+Parameters:
+   BitmapAtlas* atlas : an atlas whose surface has been restored
+Description:
+   This function loads the loaded bitmaps that are in an atlas into it
+   again.
+------------------------------------------------------------------------*/
+
+void FC Graphics::ReloadAtlasBitmaps(BitmapAtlas* atlas)
+{
+   ListIterator<Bitmap> iterator = bitmapList.Begin();
+
+   while(!iterator.EndOfList())
+   {
+      Bitmap* bitmap = iterator.GetData();
+
+      if(bitmap->IsLoaded() && bitmap->GetAtlas() == atlas)
+         bitmap->ReloadAtlasArea();
+
+      iterator++;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: FindBitmapSheet()
+Parameters:
+   const char* fileName : the name of a bitmap file
+Returns:
+   The sheet of the file
+Description:
+   This function finds the sheet that the views of a file share, or 
+   makes a new one if the file doesn't have one yet. Sheets are kept in
+   the list of atlases, so their memory is counted like that of atlases.
+------------------------------------------------------------------------*/
+
+BitmapAtlas* FC Graphics::FindBitmapSheet(const char* fileName)
+{
+   ListIterator<BitmapAtlas> iterator = bitmapAtlasList.Begin();
+
+   while(!iterator.EndOfList())
+   {
+      BitmapAtlas* atlas = iterator.GetData();
+
+      if(atlas->IsSheet() && _stricmp(atlas->GetFileName(), fileName) == 0)
+         return atlas;
+
+      iterator++;
+   }
+
+   BitmapAtlas* sheet = new BitmapAtlas(fileName);
+   bitmapAtlasList.Append(sheet, bitmapAtlasList.GetNumOfItems());
+
+   return sheet;
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawPlaceholder()
+Parameters:
+   Area& area : where the bitmap would be drawn
+Description:
+   This function fills the area of a bitmap that the bitmap loader 
+   hasn't finished with the placeholder color.
+------------------------------------------------------------------------*/
+
+void FC Graphics::DrawPlaceholder(Area& area)
+{
+   FillArea(area, placeholderColor);
+}
+
+/*------------------------------------------------------------------------
+Function Name: BlendBitmap()
+Parameters:
+   Point& location : the location of the upper-left corner of the bitmap
+   Bitmap* bitmap : a bitmap with an alpha channel
+   UINT opacity : the opacity of the whole bitmap, from 0 to 255
+Description:
+   This function blends the part of a bitmap that is within each 
+   clipping rectangle with the blend kernel of the color depth. The
+   surface is locked if it isn't already.
+------------------------------------------------------------------------*/
+
+void FC Graphics::BlendBitmap(Point& location, Bitmap* bitmap, UINT opacity)
+{
+   CheckNotTiled(bitmap);
+
+   if(opacity == 0)
+      return;
+
+   PixelBuffer* source = bitmap->GetAlphaBuffer();
+
+   if(tileRasterizer != NULL)
+   {
+      TileCommand command;
+      command.type = TC_BLEND;
+      SetRect(&command.bounds, location.x, location.y, 
+         location.x + source->GetWidth(), location.y + source->GetHeight());
+      command.x1 = location.x;
+      command.y1 = location.y;
+      command.parameter = opacity;
+      command.source = source;
+
+      RecordCommand(command);
+      return;
+   }
+
+   bool wasLocked = surfaceLocked;
+   if(!wasLocked)
+      LockSurface();
+
+   RECT clipRect;
+
+   for(int i = 0; i < GetNumOfLockedClipRects(); i++)
+   {
+      if(GetLockedClipRect(i, clipRect))
+         BlendRect(location.x, location.y, source, opacity, clipRect);
+   }
+
+   if(!wasLocked)
+      UnlockSurface();
+}
+
+/*------------------------------------------------------------------------
+Function Name: BlendRect()
+Parameters:
+   int x, int y : the location of the upper-left corner of the source
+   PixelBuffer* source : the 32-bit buffer with the alpha channel
+   UINT opacity : the opacity of the whole source, from 0 to 255
+   RECT& clipRect : the clipping rectangle, with an exclusive right and
+      bottom
+Description:
+   This function blends the part of a source that is within a clipping
+   rectangle. The surface must be locked.
+------------------------------------------------------------------------*/
+
+void FC Graphics::BlendRect(int x, int y, PixelBuffer* source, 
+   UINT opacity, RECT& clipRect)
+{
+   int left = x, top = y;
+   int right = (x + source->GetWidth()) - 1;
+   int bottom = (y + source->GetHeight()) - 1;
+
+   if(!ClipToRect(left, top, right, bottom, clipRect))
+      return;
+
+   UCHAR* sourceBits = source->GetScanLine(top - y) + ((left - x) * 4);
+
+   spanKernels.BlendRect(GetBufferAddress(left, top), bufferPitch,
+      sourceBits, source->GetPitch(), right - left + 1, bottom - top + 1, 
+      opacity);
+}
+
+/*------------------------------------------------------------------------
+Function Name: StretchBitmap()
+Parameters:
+   Area& area : the area that the bitmap is scaled to fit
+   Bitmap* bitmap : the bitmap to be drawn
+   bool transparent : whether pixels matching the key are skipped
+   UINT key : the transparent pixel value
+Description:
+   This function scales a bitmap into the drawing surface with the scale
+   kernel of the current filter. The part of the area that is within 
+   each clipping rectangle is drawn separately, starting at the right
+   place in the bitmap, so clipping doesn't move the bitmap. The surface
+   must not be locked.
+------------------------------------------------------------------------*/
+
+void FC Graphics::StretchBitmap(Area& area, Bitmap* bitmap, bool transparent,
+   UINT key)
+{
+   if(IsClippedAway() || area.width <= 0 || area.height <= 0)
+      return;
+
+   RECT destRect = {area.left, area.top, 
+      area.Right() + 1, area.Bottom() + 1};
+
+   if(renderBackend == RB_SOFTWARE && tileRasterizer != NULL)
+   {
+      TileCommand command;
+      command.type = TC_STRETCH;
+      command.bounds = destRect;
+      command.x1 = destRect.left;
+      command.y1 = destRect.top;
+      command.x2 = destRect.right;
+      command.y2 = destRect.bottom;
+      command.pixel = key;
+      command.parameter = scaleFilter;
+      command.transparent = transparent;
+      command.source = bitmap->GetPixelBuffer();
+      command.sourceRect = bitmap->GetSourceRect();
+
+      RecordCommand(command);
+      return;
+   }
+
+   ScaleSetup setup;
+   setup.transparent = transparent;
+   setup.key = key;
+
+   if(!LockScaleSource(bitmap, setup))
+   {
+      RestoreAllSurfaces();
+      StretchBitmap(area, bitmap, transparent, key);
+      return;
+   }
+
+   LockSurface();
+
+   RECT clipRect;
+
+   for(int i = 0; i < GetNumOfLockedClipRects(); i++)
+   {
+      if(GetLockedClipRect(i, clipRect))
+         StretchRect(destRect, setup, scaleFilter, clipRect);
+   }
+
+   UnlockSurface();
+   UnlockScaleSource(bitmap);
+}
+
+/*------------------------------------------------------------------------
+Function Name: LockScaleSource()
+Parameters:
+   Bitmap* bitmap : the bitmap to be scaled
+   ScaleSetup& setup : receives the pixels and the size of the bitmap
+Returns:
+   true if the pixels could be read, false if the surface of the bitmap
+   was lost
+Description:
+   This function gives a scale setup the pixels of a bitmap. The pixels
+   of a DirectDraw bitmap have to be read from its surface, which stays
+   locked until UnlockScaleSource() is called. A packed bitmap starts at
+   its area in the atlas.
+------------------------------------------------------------------------*/
+
+bool FC Graphics::LockScaleSource(Bitmap* bitmap, ScaleSetup& setup)
+{
+   CheckNotTiled(bitmap);
+   CheckNotAlpha(bitmap);
+
+   setup.sourceWidth = bitmap->GetWidth();
+   setup.sourceHeight = bitmap->GetHeight();
+
+   if(renderBackend == RB_SOFTWARE)
+   {
+      PixelBuffer* source = bitmap->GetPixelBuffer();
+      setup.source = source->GetBits();
+      setup.sourcePitch = source->GetPitch();
+   }
+
+   else
+   {
+      DDSURFACEDESC2 sourceDesc;
+      memset(&sourceDesc, 0, sizeof(sourceDesc));
+      sourceDesc.dwSize = sizeof(sourceDesc);
+
+      HRESULT result = bitmap->GetDDSurface()->Lock(NULL, &sourceDesc, 
+         DDLOCK_SURFACEMEMORYPTR | DDLOCK_READONLY | DDLOCK_WAIT, NULL);
+
+      switch(result)
+      {
+         case DDERR_SURFACELOST:
+            return false;
+         case DD_OK:
+            break;
+         default:
+            HandleDDrawError(EC_DDDRAWBMP, result, __FILE__, __LINE__);
+            break;
+      }
+
+      setup.source = (UCHAR*)sourceDesc.lpSurface;
+      setup.sourcePitch = sourceDesc.lPitch;
+   }
+
+   RECT* sourceRect = bitmap->GetSourceRect();
+
+   if(sourceRect != NULL)
+   {
+      setup.source += (sourceRect->top * setup.sourcePitch) + 
+         (sourceRect->left * bytesPerPixel);
+   }
+
+   return true;
+}
+
+void FC Graphics::UnlockScaleSource(Bitmap* bitmap)
+{
+   if(renderBackend != RB_SOFTWARE)
+      bitmap->GetDDSurface()->Unlock(NULL);
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetScaledCopy()
+Parameters:
+   Bitmap* bitmap : the bitmap to be drawn scaled
+   int width, int height : the size the bitmap is drawn at
+Returns:
+   The scaled copy of the bitmap at that size, or NULL if the bitmap has
+   to be scaled as it is drawn
+Description:
+   This function finds the scaled copy of a bitmap for the current 
+   filter, or makes one if the bitmap was drawn at the same size the 
+   last time as well. Copies count towards the memory limit, so a copy
+   isn't made if it would go over the limit.
+------------------------------------------------------------------------*/
+
+Bitmap* FC Graphics::GetScaledCopy(Bitmap* bitmap, int width, int height)
+{
+   if(width <= 0 || height <= 0)
+      return NULL;
+
+   Bitmap* copy = bitmap->FindScaledCopy(width, height, scaleFilter);
+
+   if(copy != NULL || 
+      !bitmap->IsScaledCopyWanted(width, height, scaleFilter))
+      return copy;
+
+   if(maxMemory && GetCurrentBitmapMemory() + 
+      (width * height * bytesPerPixel) > maxAmountOfMemory)
+      return NULL;
+
+   ScaleSetup setup;
+
+   if(!LockScaleSource(bitmap, setup))
+      return NULL;
+
+   copy = bitmap->AddScaledCopy(width, height, scaleFilter, setup);
+   UnlockScaleSource(bitmap);
+
+   return copy;
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawTiles()
+Parameters:
+   Point& location : where the upper-left corner of the bitmap is drawn
+   Bitmap* bitmap : the tiled bitmap to be drawn
+Description:
+   This function draws the tiles of a tiled bitmap that are within the
+   screen and the bounds of the clip list, which loads them if they 
+   aren't loaded. Tiles of a bitmap with an alpha channel are blended.
+------------------------------------------------------------------------*/
+
+void FC Graphics::DrawTiles(Point& location, Bitmap* bitmap)
+{
+   if(IsClippedAway())
+      return;
+
+   RECT visibleRect = screenRect;
+
+   if(clipping)
+   {
+      RECT& clipBounds = clippingRegion.GetBounds();
+      IntersectRect(&visibleRect, &visibleRect, &clipBounds);
+   }
+
+   //The visible part of the bitmap, relative to its upper-left corner
+   int left = max(visibleRect.left - location.x, 0);
+   int top = max(visibleRect.top - location.y, 0);
+   int right = min(visibleRect.right - location.x, bitmap->GetWidth());
+   int bottom = min(visibleRect.bottom - location.y, bitmap->GetHeight());
+
+   if(left >= right || top >= bottom)
+      return;
+
+   for(int row = top / BM_TILE_SIZE; row <= (bottom - 1) / BM_TILE_SIZE;
+      row++)
+   {
+      for(int column = left / BM_TILE_SIZE; 
+         column <= (right - 1) / BM_TILE_SIZE; column++)
+      {
+         Bitmap* tile = bitmap->GetTile(column, row);
+         Point tileLocation(location.x + (column * BM_TILE_SIZE),
+            location.y + (row * BM_TILE_SIZE));
+
+         if(tile->HasAlpha())
+            BlendBitmap(tileLocation, tile, 255);
+
+         //The tiles are loaded again after the surfaces are restored
+         else if(!BlitBitmap(tileLocation, tile))
+         {
+            RestoreAllSurfaces();
+            DrawTiles(location, bitmap);
+            return;
+         }
+      }
+   }
+}
+
+//A tiled bitmap has no surface to draw from, only the tiles that are
+//loaded, so it can only be drawn at its own size with DrawBitmap()
+void FC Graphics::CheckNotTiled(Bitmap* bitmap)
+{
+   if(bitmap->IsTiled())
+   {
+      throw new Exception("A tiled bitmap can only be drawn at its own "\
+         "size, without a transparent color or fading.", EC_BMTILED, 
+         ET_BITMAP, __FILE__, __LINE__);
+   }
+}
+
+//The scale kernels only read pixels in the format of the drawing 
+//surface, and a bitmap with an alpha channel only has a 32-bit buffer
+//that is blended, so it can't be scaled
+void FC Graphics::CheckNotAlpha(Bitmap* bitmap)
+{
+   if(bitmap->HasAlpha())
+   {
+      throw new Exception("A bitmap with an alpha channel can't be "\
+         "scaled.", EC_BMALPHA, ET_BITMAP, __FILE__, __LINE__);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: BlitBitmap()
+Parameters:
+   Point& location : where the upper-left corner of the bitmap is drawn
+   Bitmap* bitmap : the bitmap to be drawn
+Returns:
+   false if a DirectDraw surface was lost, true otherwise
+Description:
+   This function copies a bitmap to the drawing surface without scaling
+   it, through the tile rasterizer, the pixel buffers of the software
+   backend or the DirectDraw blitter.
+------------------------------------------------------------------------*/
+
+bool FC Graphics::BlitBitmap(Point& location, Bitmap* bitmap)
+{
+   if(tileRasterizer != NULL)
+   {
+      TileCommand command;
+      command.type = TC_BLIT;
+      SetRect(&command.bounds, location.x, location.y, 
+         location.x + bitmap->GetWidth(), location.y + bitmap->GetHeight());
+      command.x1 = location.x;
+      command.y1 = location.y;
+      command.source = bitmap->GetPixelBuffer();
+      command.sourceRect = bitmap->GetSourceRect();
+
+      RecordCommand(command);
+      return true;
+   }
+
+   if(renderBackend == RB_SOFTWARE)
+   {
+      PixelBuffer* bitmapBuffer = bitmap->GetPixelBuffer();
+
+      for(int i = 0; i < GetNumOfLockedClipRects(); i++)
+      {
+         drawingBuffer->Blit(location.x, location.y, bitmapBuffer, 
+            bitmap->GetSourceRect(), GetSoftwareClipRect(i));
+      }
+      return true;
+   }
+
+   if(IsClippedAway())
+      return true;
+
+   RECT destRect = {location.x, location.y, 
+      location.x + bitmap->GetWidth(),
+      location.y + bitmap->GetHeight()};
+
+   HRESULT result = lpDDSDrawingSurface->Blt(&destRect, 
+      bitmap->GetDDSurface(), bitmap->GetSourceRect(), DDBLT_WAIT, NULL);
+
+   switch(result)
+   {
+      case DDERR_SURFACELOST:
+         return false;
+      case DD_OK:
+         break;
+      default:
+         HandleDDrawError(EC_DDDRAWBMP, result, __FILE__, __LINE__);
+         break;
+   }
+
+   return true;
+}
+
+/*------------------------------------------------------------------------
+Function Name: StretchRect()
+Parameters:
+   RECT& destRect : the area that the source is scaled to fit, with an
+      exclusive right and bottom
+   ScaleSetup setup : the source of the scaling
+   UINT filter : the filter to scale with
+   RECT& clipRect : the clipping rectangle, with an exclusive right and
+      bottom
+Description:
+   This function scales the part of the source that ends up within a 
+   clipping rectangle. The setup is a copy, since the position in the
+   source depends on where the clipped area starts. The surface must be
+   locked.
+------------------------------------------------------------------------*/
+
+void FC Graphics::StretchRect(RECT& destRect, ScaleSetup setup, 
+   UINT filter, RECT& clipRect)
+{
+   int left = destRect.left, top = destRect.top;
+   int right = destRect.right - 1, bottom = destRect.bottom - 1;
+
+   if(!ClipToRect(left, top, right, bottom, clipRect))
+      return;
+
+   ScaleKernel scaleKernel = (filter == SF_BILINEAR) ? 
+      spanKernels.ScaleBilinear : spanKernels.ScaleNearest;
+
+   setup.SetArea(destRect, left, top, filter);
+
+   scaleKernel(GetBufferAddress(left, top), bufferPitch, 
+      right - left + 1, bottom - top + 1, setup);
+}
+
+/*------------------------------------------------------------------------
+Function Name: RecordClipRects()
+Parameters:
+   TileCommand& command : receives the clipping rectangles
+   RECT* limitRect : a rectangle that the clipping rectangles are 
+      limited to, with an exclusive right and bottom, or NULL
+Returns:
+   true if there is anything to draw in, false if there isn't
+Description:
+   This function gives a command for tile rendering the clipping 
+   rectangles of the current clip list that are on the screen. Without
+   a limiting rectangle, the clip list is only added to the rasterizer
+   once until it changes, and the commands share it.
+------------------------------------------------------------------------*/
+
+bool FC Graphics::RecordClipRects(TileCommand& command, RECT* limitRect)
+{
+   if(limitRect == NULL && tileClipStart >= 0)
+   {
+      command.firstClipRect = tileClipStart;
+      command.numOfClipRects = tileClipCount;
+      return tileClipCount > 0;
+   }
+
+   int firstClipRect = tileRasterizer->GetNumOfClipRects();
+   RECT clipRect;
+
+   for(int i = 0; i < GetNumOfLockedClipRects(); i++)
+   {
+      if(!GetLockedClipRect(i, clipRect))
+         continue;
+
+      if(limitRect != NULL)
+      {
+         if(clipRect.left < limitRect->left)
+            clipRect.left = limitRect->left;
+         if(clipRect.top < limitRect->top)
+            clipRect.top = limitRect->top;
+         if(clipRect.right > limitRect->right)
+            clipRect.right = limitRect->right;
+         if(clipRect.bottom > limitRect->bottom)
+            clipRect.bottom = limitRect->bottom;
+
+         if(clipRect.left >= clipRect.right || 
+            clipRect.top >= clipRect.bottom)
+            continue;
+      }
+
+      tileRasterizer->AddClipRect(clipRect);
+   }
+
+   command.firstClipRect = firstClipRect;
+   command.numOfClipRects = tileRasterizer->GetNumOfClipRects() - 
+      firstClipRect;
+
+   if(limitRect == NULL)
+   {
+      tileClipStart = command.firstClipRect;
+      tileClipCount = command.numOfClipRects;
+   }
+
+   return command.numOfClipRects > 0;
+}
+
+/*------------------------------------------------------------------------
+Function Name: RecordCommand()
+Parameters:
+   TileCommand& command : the command to be recorded
+Description:
+   This function records a command for tile rendering that is clipped 
+   to the current clip list.
+------------------------------------------------------------------------*/
+
+void FC Graphics::RecordCommand(TileCommand& command)
+{
+   if(RecordClipRects(command, NULL))
+      tileRasterizer->AddCommand(command);
+}
+
+/*------------------------------------------------------------------------
+Function Name: RasterCommand()
+Parameters:
+   TileCommand& command : a recorded command
+   RECT& clipRect : the clipping rectangle, with an exclusive right and
+      bottom
+Description:
+   This function draws the part of a recorded command that is within a
+   clipping rectangle, with the same functions that draw it when tile
+   rendering is off. It is called by the threads of the tile rasterizer,
+   so it must only write within the clipping rectangle. The surface must
+   be locked.
+------------------------------------------------------------------------*/
+
+void FC Graphics::RasterCommand(TileCommand& command, RECT& clipRect)
+{
+   switch(command.type)
+   {
+      case TC_FILL:
+         drawingBuffer->Fill(&command.bounds, command.pixel, &clipRect);
+         break;
+
+      case TC_LINE:
+      {
+         Point p1(command.x1, command.y1);
+         Point p2(command.x2, command.y2);
+
+         UINT outCode1 = GetOutCode(p1, clipRect);
+         UINT outCode2 = GetOutCode(p2, clipRect);
+
+         if((outCode1 & outCode2) != 0)
+            break;
+
+         if((outCode1 | outCode2) == 0)
+            DrawUnclippedLine(p1, p2, command.pixel);
+         else
+            DrawClippedLine(p1, p2, clipRect, command.pixel);
+         break;
+      }
+
+      case TC_BLIT:
+         drawingBuffer->Blit(command.x1, command.y1, 
+            (PixelBuffer*)command.source, command.sourceRect, &clipRect);
+         break;
+
+      case TC_TRANSPARENTBLIT:
+         drawingBuffer->BlitTransparent(command.x1, command.y1, 
+            (PixelBuffer*)command.source, command.pixel, 
+            command.sourceRect, &clipRect);
+         break;
+
+      case TC_RUNLENGTHBLIT:
+         drawingBuffer->BlitRunLength(command.x1, command.y1, 
+            (RunLengthSprite*)command.source, &clipRect);
+         break;
+
+      case TC_BLEND:
+         BlendRect(command.x1, command.y1, (PixelBuffer*)command.source,
+            command.parameter, clipRect);
+         break;
+
+      case TC_STRETCH:
+      {
+         PixelBuffer* source = (PixelBuffer*)command.source;
+         RECT destRect = {command.x1, command.y1, command.x2, command.y2};
+
+         ScaleSetup setup;
+         setup.source = source->GetBits();
+         setup.sourcePitch = source->GetPitch();
+         setup.sourceWidth = source->GetWidth();
+         setup.sourceHeight = source->GetHeight();
+
+         if(command.sourceRect != NULL)
+         {
+            RECT& sourceRect = *command.sourceRect;
+
+            setup.source += (sourceRect.top * setup.sourcePitch) + 
+               (sourceRect.left * bytesPerPixel);
+            setup.sourceWidth = sourceRect.right - sourceRect.left;
+            setup.sourceHeight = sourceRect.bottom - sourceRect.top;
+         }
+
+         setup.transparent = command.transparent;
+         setup.key = command.pixel;
+
+         StretchRect(destRect, setup, command.parameter, clipRect);
+         break;
+      }
+
+      case TC_GLYPH:
+         DrawGlyph((GlyphAtlas*)command.source, UCHAR(command.parameter),
+            command.x1, command.y1, command.pixel, clipRect);
+         break;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetLockedClipRect()
+Parameters:
+   int index : the index of the rectangle in the clip list
+   RECT& clipRect : receives the clipping rectangle, with an exclusive 
+      right and bottom
+Returns:
+   true if the clipping rectangle is on the screen, false if it isn't
+Description:
+   This function gets a rectangle that the locked primitives clip 
+   against. That is the part of a rectangle of the clip list that is on
+   the screen, or the screen itself if there is no clip list.
+------------------------------------------------------------------------*/
+
+bool FC Graphics::GetLockedClipRect(int index, RECT& clipRect)
+{
+   if(!clipping)
+   {
+      clipRect = screenRect;
+      return true;
+   }
+
+   clipRect = clippingRegion.GetRects()[index];
+
+   if(clipRect.left < screenRect.left)
+      clipRect.left = screenRect.left;
+   if(clipRect.top < screenRect.top)
+      clipRect.top = screenRect.top;
+   if(clipRect.right > screenRect.right)
+      clipRect.right = screenRect.right;
+   if(clipRect.bottom > screenRect.bottom)
+      clipRect.bottom = screenRect.bottom;
+
+   return clipRect.left < clipRect.right && clipRect.top < clipRect.bottom;
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetOutCode()
+Parameters:
+   Point& point : the point to be tested
+   RECT& clipRect : the clipping rectangle, with an exclusive right and
+      bottom
+Returns:
+   A combination of OC_LEFT, OC_RIGHT, OC_TOP and OC_BOTTOM, or 0 if the
+   point is within the clipping rectangle
+Description:
+   This function calculates the Cohen-Sutherland outcode of a point, 
+   which lets whole lines be accepted or rejected without clipping them.
+------------------------------------------------------------------------*/
+
+UINT FC Graphics::GetOutCode(Point& point, RECT& clipRect)
+{
+   UINT outCode = 0;
+
+   if(point.x < clipRect.left)
+      outCode |= OC_LEFT;
+   else if(point.x >= clipRect.right)
+      outCode |= OC_RIGHT;
+
+   if(point.y < clipRect.top)
+      outCode |= OC_TOP;
+   else if(point.y >= clipRect.bottom)
+      outCode |= OC_BOTTOM;
+
+   return outCode;
+}
+
 /*------------------------------------------------------------------------
 Function Name: HandleDDrawError()
 Parameters:
@@ -10,6 +10,13 @@ Version:
 
 #pragma once
 
+//The outcodes of a point, which tell on which sides of a clipping 
+//rectangle the point is
+#define OC_LEFT      0x00000001
+#define OC_RIGHT     0x00000002
+#define OC_TOP       0x00000004
+#define OC_BOTTOM    0x00000008
+
 namespace DG
 {
    class Surface;
@@ -19,11 +26,16 @@ namespace DG
       friend HRESULT CALLBACK EnumDisplayModes(LPDDSURFACEDESC2 lpDDSurfaceDesc,  
          LPVOID lpContext);
       friend class Bitmap;
+      friend class BackingStore;
+      friend class TileRasterizer;
+      friend class BitmapAtlas;
 
    public:
-      Graphics();
+      Graphics(UINT backend = RB_DIRECTDRAW);
       virtual ~Graphics();
 
+      UINT GetRenderBackend(void) {return renderBackend;}
+
       void SetResolution(Point res);
       void SetResolution(int hRes, int vRes);
       const Point& GetResolution(void) {return screenRes;}
@@ -33,12 +45,22 @@ namespace DG
 
       void SetColorDepth(UINT clrDepth);
       UINT GetColorDepth() {return colorDepth;}
+      int GetBytesPerPixel(void) {return bytesPerPixel;}
 
       void SetBufferingMode(UINT bufferMode);
       UINT GetBufferingMode(void) {return bufferingMode;}
 
       void SetSurfacePersistence(bool persistence);
       bool GetSurfacePersistence(void) {return SSPersistence;}
+      bool IsDrawingSurfacePersistent(void)
+      {return bufferingMode == BT_SINGLE || SSPersistence;}
+      int GetDrawingSurfaceAge(void);
+      UINT GetSurfaceGeneration(void) {return surfaceGeneration;}
+
+      //Whether BeginFrame() clears the drawing surface when it isn't
+      //persistent. Whoever turns it off has to clear what it draws.
+      void SetFrameClearing(bool clear) {frameClearing = clear;}
+      bool GetFrameClearing(void) {return frameClearing;}
 
       void SetClientRect(RECT& rect) {clientRect = rect;}
 
@@ -48,6 +70,10 @@ namespace DG
       void BeginFrame(void);
       void EndFrame(void);
 
+      void EnableTileRendering(bool enable, int numOfThreads = 0);
+      bool IsTileRenderingEnabled(void) {return tileRasterizer != NULL;}
+      void FC FlushDrawing(void);
+
       //Bitmap functions
       Bitmap* FC GetBitmap(UINT bitmapID);
       void LoadBitmap(UINT bitmapID, UINT priority);
@@ -56,6 +82,19 @@ namespace DG
          Area& area);
       void LoadBitmapDimensions(UINT bitmapID, UINT priority,
          Area& area, const char* fileName);
+      void LoadAlphaBitmap(UINT bitmapID, UINT priority, 
+         const char* fileName, bool premultiplied = false);
+      void LoadPackedBitmap(UINT bitmapID, UINT priority, 
+         const char* fileName);
+      void LoadBitmapView(UINT bitmapID, UINT priority, Area& area,
+         const char* fileName);
+      void LoadTiledBitmap(UINT bitmapID, UINT priority, 
+         const char* fileName);
+      void LoadBitmapAsync(UINT bitmapID, UINT priority, 
+         const char* fileName, UINT windowID = IDW_NONE);
+      bool GetFinishedBitmapLoad(UINT& bitmapID, UINT& windowID);
+      void SetPlaceholderColor(Color& color) {placeholderColor = color;}
+      Color& GetPlaceholderColor(void) {return placeholderColor;}
       void RemoveBitmap(UINT bitmapID);
       void RemoveAllBitmaps(void);
       void DeleteBitmap(UINT bitmapID);
@@ -70,11 +109,18 @@ namespace DG
       UINT GetMaxBitmaps(void) {return maxNumOfBitmaps;}
       void SetMaxBitmapMemory(UINT maxMem);
       UINT GetMaxBitmapMemory(void) {return maxAmountOfMemory;}
-      UINT GetCurrentNumOfBitmaps(void) {return curNumOfBitmaps;}
-      UINT GetCurrentBitmapMemory(void) {return curAmountOfMemory;}
+      UINT GetCurrentNumOfBitmaps(void) 
+      {return bitmapList.GetNumOfLoadedBitmaps();}
+      UINT GetCurrentBitmapMemory(void);
       void SetTransparentColor(UINT bitmapID, Color& transparentColor);
       bool BitmapFileExists(const char* fileName);
 
+      //An asset pack holds bitmaps that are already converted to the
+      //common pixel formats. While one is open, the bitmaps that are in
+      //it are copied from it instead of being loaded from their files.
+      void OpenAssetPack(const char* fileName);
+      void CloseAssetPack(void);
+
       //Drawing Functions
       void FC LockSurface(void);
       void FC UnlockSurface(void);
@@ -99,6 +145,14 @@ namespace DG
          Color& transparentColor);
       void FC DrawTransparentBitmap(Point& location, UINT bitmapID);
       void FC DrawTransparentScaledBitmap(Area& area, UINT bitmapID);   
+      void FC DrawAlphaBitmap(Point& location, UINT bitmapID);
+      void FC DrawAlphaBitmap(Point& location, UINT bitmapID, 
+         BYTE opacity);
+      void SetScaleFilter(UINT filter) {scaleFilter = filter;}
+      UINT GetScaleFilter(void) {return scaleFilter;}
+      bool FC DrawBackingStore(Point& location, BackingStore* store);
+      bool FC CopyToBackingStore(ClipRegion& region, Point& location,
+         BackingStore* store);
 
       //GDI Drawing Functions
       void FlipToGDISurface(void);
@@ -107,9 +161,16 @@ namespace DG
       void FC SetTextColor(Color& color);
       void FC SetTextBackgroundColor(Color& color);
       void FC DrawText(char* text, Rectangle& rect, UINT flags);
+      void EnableGlyphText(bool enable) {glyphText = enable;}
+      bool IsGlyphTextEnabled(void) {return glyphText;}
 
       //Clipping Functions
       void FC AddClippingArea(Rectangle& area);
+      void FC IntersectClippingArea(Rectangle& area);
+      void FC SubtractClippingArea(Rectangle& area);
+      void FC SetClippingRegion(ClipRegion& region);
+      ClipRegion& GetClippingRegion(void) {return clippingRegion;}
+      bool IsClipping(void) {return clipping;}
       void FC RemoveClippingArea(void);
       void FC ClearClippingAreas(void);
 
@@ -120,6 +181,9 @@ namespace DG
       void FC ReleaseSurface(Surface* surface = NULL);
       Surface* GetCurrentSurface(void) {return currentSurface;}
 
+      //Software backend functions
+      PixelBuffer* GetPrimaryBuffer(void) {return primaryBuffer;}
+
       //DirectX-related functions
       void HandleDDrawError(UINT errorCode, HRESULT error, 
          char* fileName, UINT lineNumber);
@@ -129,6 +193,70 @@ namespace DG
       void FC DestroyAllSurfaces(void);
       void FC ClearPrimarySurface(void);
 
+      void CreateSoftwareSurfaces(Point res, UINT winState, UINT clrDepth,
+         UINT bufferMode);
+      void FC PresentSoftwareSurface(void);
+      void FC DrawSoftwareText(char* text, Rectangle& rect, UINT flags);
+      void FC DrawGlyphText(char* text, Rectangle& rect, UINT flags);
+      void FC DrawGlyphLine(GlyphAtlas* atlas, TextLayout* layout,
+         TextLine& line, int x, int y, UINT pixel, RECT& clipRect);
+      GlyphAtlas* FC GetGlyphAtlas(void);
+      UINT FC ColorToPixel(Color& color);
+      UCHAR* FC GetBufferAddress(int x, int y);
+      void FC ApplyClippingRegion(void);
+      bool FC ClipToRect(int& left, int& top, int& right, int& bottom,
+         RECT& clipRect);
+      void FC DrawClippedLine(Point& p1, Point& p2, RECT& clipRect, 
+         UINT pixel);
+      void FC DrawUnclippedLine(Point& p1, Point& p2, UINT pixel);
+      BitmapAtlas* FC AllocateAtlasArea(int width, int height, 
+         RECT& rect);
+      BitmapAtlas* FC FindBitmapSheet(const char* fileName);
+      void FC ReloadAtlasBitmaps(BitmapAtlas* atlas);
+      UCHAR* FC FindPackedPixels(const char* fileName, Point& size,
+         LONG& pitch);
+      void FC DrawPlaceholder(Area& area);
+      void FC BlendBitmap(Point& location, Bitmap* bitmap, UINT opacity);
+      void FC BlendRect(int x, int y, PixelBuffer* source, UINT opacity,
+         RECT& clipRect);
+      bool FC BlitBitmap(Point& location, Bitmap* bitmap);
+      void FC DrawTiles(Point& location, Bitmap* bitmap);
+      void FC CheckNotTiled(Bitmap* bitmap);
+      void FC CheckNotAlpha(Bitmap* bitmap);
+      bool FC LockScaleSource(Bitmap* bitmap, ScaleSetup& setup);
+      void FC UnlockScaleSource(Bitmap* bitmap);
+      Bitmap* FC GetScaledCopy(Bitmap* bitmap, int width, int height);
+      void FC StretchBitmap(Area& area, Bitmap* bitmap, bool transparent,
+         UINT key);
+      void FC StretchRect(RECT& destRect, ScaleSetup setup, UINT filter,
+         RECT& clipRect);
+      void FC DrawGlyph(GlyphAtlas* atlas, UCHAR character, int x, int y,
+         UINT pixel, RECT& clipRect);
+      void FC RecordGlyphText(GlyphAtlas* atlas, TextLayout* layout,
+         Rectangle& rect, UINT flags, int y, UINT pixel, 
+         UINT backgroundPixel);
+      bool FC RecordClipRects(TileCommand& command, RECT* limitRect);
+      void FC RecordCommand(TileCommand& command);
+      void FC RasterCommand(TileCommand& command, RECT& clipRect);
+      UINT FC GetOutCode(Point& point, RECT& clipRect);
+      bool FC GetLockedClipRect(int index, RECT& clipRect);
+      RECT* FC GetSoftwareClipRect(int index);
+
+      //The locked primitives always clip, against the clip list if 
+      //there is one and against the screen if there isn't. The software
+      //backend draws once for every rectangle in the clip list the same
+      //way, or once without clipping if there is no clip list.
+      int GetNumOfLockedClipRects(void)
+      {return clipping ? clippingRegion.GetNumOfRects() : 1;}
+
+      //Nothing can be drawn when the clip list is empty
+      bool IsClippedAway(void) {return clipping && clippingRegion.IsEmpty();}
+
+      //Whether the surfaces are DirectDraw surfaces or pixel buffers in
+      //system memory. This is set when the object is constructed and 
+      //never changes.
+      UINT renderBackend;
+
       //Pointer to DirectDraw object
       LPDIRECTDRAW7 lpDD;
 
@@ -144,6 +272,11 @@ namespace DG
       LPDIRECTDRAWSURFACE7 lpDDSSecondary;
       LPDIRECTDRAWSURFACE7 lpDDSDrawingSurface;
 
+      //The primary and secondary surfaces of the software backend
+      PixelBuffer* primaryBuffer;
+      PixelBuffer* secondaryBuffer;
+      PixelBuffer* drawingBuffer;
+
       //MS Windows info
       HWND hWnd;
 
@@ -160,6 +293,12 @@ namespace DG
       //blitting, but there is less redrawing involved, so it may save time
       //in the long run.
       bool SSPersistence;
+      bool frameClearing;
+
+      //Counts how often the surfaces have been created or restored, so
+      //that anyone who relies on what is on the drawing surface knows
+      //when it has been lost
+      UINT surfaceGeneration;
 
       //When in windowed mode, we must know where the client area is so
       //that we can update the clipper and draw in the right place
@@ -168,22 +307,46 @@ namespace DG
       //The list of supported display modes
       DisplayModeList displayModeList;  
 
+      //The atlases that small bitmaps are packed into. The list is 
+      //declared before the bitmap list, so that the bitmaps are destroyed
+      //before their atlases.
+      LinkedList<BitmapAtlas> bitmapAtlasList;
+
       //The list which stores and manages the bitmaps
       BitmapList bitmapList;
 
+      //Decodes the bitmaps of LoadBitmapAsync() on other threads. It is
+      //only created when the first bitmap is loaded that way.
+      BitmapLoader* bitmapLoader;
+
+      //The open asset pack, or NULL
+      AssetPack* assetPack;
+
+      //What a bitmap is drawn as while the bitmap loader is decoding it
+      Color placeholderColor;
+
       bool autoClean;
       bool maxBitmaps;
       bool maxMemory;
       UINT maxNumOfBitmaps;
       UINT maxAmountOfMemory;
-      UINT curNumOfBitmaps;
-      UINT curAmountOfMemory;
+
+      //The bytes of all the bitmap surfaces, which the bitmaps and 
+      //atlases add to and take from themselves
+      UINT bitmapMemory;
 
       bool surfaceLocked;
       int bytesPerPixel;
 
       //Text information
       Font currentGDIFont;
+
+      //Whether text is drawn from glyph atlases instead of with GDI
+      bool glyphText;
+      //The glyph atlases of the fonts that text has been drawn with
+      LinkedList<GlyphAtlas> glyphAtlasList;
+      //The atlas of the current font, which is found when text is drawn
+      GlyphAtlas* currentGlyphAtlas;
       int textTransparencyMode;
       Color textColor;
       Color textBackgroundColor;
@@ -196,15 +359,34 @@ namespace DG
 
       //Whether there is clipping on the drawing surface
       bool clipping;
-      //The current clipping area
-      RGNDATA* clippingArea;
-      Rectangle clippingRect;
+      //The current clip list, which is only used when clipping is true
+      ClipRegion clippingRegion;
+      //The rectangle of the screen, which limits the clip list of the
+      //locked primitives
+      RECT screenRect;
 
       //The current Surface
       Surface* currentSurface;
 
       UCHAR* videoBuffer;
       LONG bufferPitch;
+
+      //The pixel format of the drawing surface
+      DDPIXELFORMAT pixelFormat;
+
+      //How scaled bitmaps are filtered: SF_NEAREST or SF_BILINEAR
+      UINT scaleFilter;
+
+      //The drawing kernels for the current color depth
+      SpanKernelTable spanKernels;
+
+      //Records the drawing of the software backend and rasterizes it in
+      //tiles on several threads, or NULL if tile rendering is off
+      TileRasterizer* tileRasterizer;
+      //Where the rectangles of the current clip list start in the
+      //rasterizer, or -1 if they haven't been added since they changed
+      int tileClipStart;
+      int tileClipCount;
    };
 
    //The callback function used to enumerate the supported display modes.
@@ -24,7 +24,13 @@ Description:
 Gui::Gui() :
    mainWindow(NULL),
    mouseCaptureWinID(IDW_NONE),
-   prevMouseCursorWinID(IDW_NONE)
+   prevMouseCursorWinID(IDW_NONE),
+   numOfDirtyAreas(0),
+   drawnSurfaceGeneration(0),
+   frameNumber(0),
+   backingStoreList(false),
+   maxBackingStoreMemory(GUI_DEFAULT_BACKING_STORE_MEMORY),
+   curBackingStoreMemory(0)
 {
    //The main window can't be constructed here; when the application is
    //created, the DG::Graphics object hasn't been created yet, so there
@@ -33,6 +39,9 @@ Gui::Gui() :
    windowList.SetGrowAmount(GUI_WINLIST_GROWTH);
    windowList.SetInitialValue(NULL);
    windowList.SetSize(GUI_INITIAL_WINLIST_SIZE);
+
+   for(int i = 0; i < GUI_MAX_DRAWN_FRAMES; i++)
+      numOfRecentDirtyAreas[i] = 0;
 }
 
 /*Destructor*/
@@ -78,6 +87,12 @@ void Gui::SetMainWindow(MainWindow* mainWin)
    mainWindow->Create();
 
    SetWindowFocus(mainWindow->GetWindowID());
+
+   //The GUI clears the areas it draws itself, so the rest of the drawing
+   //surface can be kept from the frames before
+   dgGraphics->SetFrameClearing(false);
+
+   InvalidateAll();
 }
 
 /*------------------------------------------------------------------------
@@ -318,6 +333,20 @@ void Gui::GenerateMessages(void)
             break;
       }
    }
+
+   //Hand the bitmaps that the bitmap loader has finished to their 
+   //bitmaps and tell the windows that loaded them
+   UINT bitmapID;
+   UINT loadWindowID;
+   while(dgGraphics->GetFinishedBitmapLoad(bitmapID, loadWindowID))
+   {
+      if(loadWindowID != IDW_NONE)
+      {
+         message = new Message(GM_BITMAPLOADED, loadWindowID, 0, 0, 
+            bitmapID);
+         PostMessage(message);
+      }
+   }
 }
 
 /*------------------------------------------------------------------------
@@ -491,15 +520,319 @@ void Gui::DestroyTimer(UINT timerID)
    timerTable.erase(timerID);
 }
 
+/*------------------------------------------------------------------------
+Function Name: InvalidateArea
+Parameters:
+   Area& area : the area of the screen that needs to be redrawn, in 
+      absolute coordinates
+Description:
+   This function adds an area to the areas that will be redrawn in the 
+   next frame. An area that overlaps areas that are already dirty is
+   merged with them, so that no part of the screen is drawn twice.
+------------------------------------------------------------------------*/
+
+void Gui::InvalidateArea(Area& area)
+{
+   Point screenRes = dgGraphics->GetResolution();
+   Area screenArea(0, 0, screenRes.x, screenRes.y);
+
+   Area newArea(area);
+   newArea.Intersect(screenArea);
+
+   if(newArea.IsEmpty())
+      return;
+
+   //Merge the new area with every dirty area that it overlaps. Merging
+   //makes the new area larger, so we start over after each merge.
+   int i = 0;
+   while(i < numOfDirtyAreas)
+   {
+      if(dirtyAreas[i].Intersects(newArea))
+      {
+         newArea.Union(dirtyAreas[i]);
+
+         numOfDirtyAreas--;
+         dirtyAreas[i] = dirtyAreas[numOfDirtyAreas];
+         i = 0;
+      }
+      else
+         i++;
+   }
+
+   //If there's no room left, everything is merged into a single area
+   if(numOfDirtyAreas == GUI_MAX_DIRTY_AREAS)
+   {
+      for(i = 0; i < numOfDirtyAreas; i++)
+         newArea.Union(dirtyAreas[i]);
+
+      numOfDirtyAreas = 0;
+   }
+
+   dirtyAreas[numOfDirtyAreas] = newArea;
+   numOfDirtyAreas++;
+}
+
+/*------------------------------------------------------------------------
+Function Name: InvalidateAll
+Parameters:
+Description:
+   This function causes the entire screen to be redrawn in the next 
+   frame.
+------------------------------------------------------------------------*/
+
+void Gui::InvalidateAll()
+{
+   Point screenRes = dgGraphics->GetResolution();
+   Area screenArea(0, 0, screenRes.x, screenRes.y);
+
+   numOfDirtyAreas = 0;
+   InvalidateArea(screenArea);
+}
+
 /*------------------------------------------------------------------------
 Function Name: DrawGUI
 Parameters:
 Description:
    This function causes the windows of the GUI to draw themselves on the
-   screen.
+   screen. Only the windows within the dirty areas are drawn, and they
+   are clipped to those areas. When the drawing surface is one of the 
+   buffers of a flip chain, it was last drawn on one or two frames 
+   before the previous frame, so the areas that were dirty in those 
+   frames are drawn again as well. Windows with backing stores draw 
+   their stores wherever nothing has changed.
 ------------------------------------------------------------------------*/
 
 void Gui::DrawGUI()
 {
-   mainWindow->DrawWindow();
-}
\ No newline at end of file
+   frameNumber++;
+
+   //If the surfaces have been recreated, nothing that was drawn before
+   //is left on them, and the backing stores may not match the new mode
+   if(drawnSurfaceGeneration != dgGraphics->GetSurfaceGeneration())
+   {
+      drawnSurfaceGeneration = dgGraphics->GetSurfaceGeneration();
+      ReleaseAllBackingStores();
+      InvalidateAll();
+   }
+
+   //A window that isn't opaque has whatever is under it in its backing
+   //store, which may have changed within the dirty areas
+   for(int k = 0; k < numOfDirtyAreas; k++)
+      InvalidateBackingStores(dirtyAreas[k]);
+
+   //Remember what changed in this frame for the other surfaces of a 
+   //flip chain, and add what changed on them since this surface was 
+   //last drawn on. The areas of the frame two frames ago are read 
+   //before they are replaced with the ones of this frame.
+   int slot = frameNumber % GUI_MAX_DRAWN_FRAMES;
+   Area newAreas[GUI_MAX_DIRTY_AREAS];
+   int numOfNewAreas = numOfDirtyAreas;
+   int m;
+
+   for(m = 0; m < numOfNewAreas; m++)
+      newAreas[m] = dirtyAreas[m];
+
+   int surfaceAge = dgGraphics->GetDrawingSurfaceAge();
+
+   for(int age = 1; age < surfaceAge && age <= GUI_MAX_DRAWN_FRAMES; age++)
+   {
+      int previous = (frameNumber - age) % GUI_MAX_DRAWN_FRAMES;
+
+      for(m = 0; m < numOfRecentDirtyAreas[previous]; m++)
+         InvalidateArea(recentDirtyAreas[previous][m]);
+   }
+
+   for(m = 0; m < numOfNewAreas; m++)
+      recentDirtyAreas[slot][m] = newAreas[m];
+
+   numOfRecentDirtyAreas[slot] = numOfNewAreas;
+
+   //Take the dirty areas for this frame, so that any window invalidated
+   //while drawing will be drawn in the next frame
+   Area drawAreas[GUI_MAX_DIRTY_AREAS];
+   int numOfDrawAreas = numOfDirtyAreas;
+
+   for(int i = 0; i < numOfDrawAreas; i++)
+      drawAreas[i] = dirtyAreas[i];
+
+   numOfDirtyAreas = 0;
+
+   Color backgroundColor(0, 0, 0);
+
+   for(int j = 0; j < numOfDrawAreas; j++)
+   {
+      //Clear the area the same way BeginFrame() would clear the whole
+      //surface when it isn't persistent
+      Rectangle areaRect(drawAreas[j].left, drawAreas[j].top, 
+         drawAreas[j].Right(), drawAreas[j].Bottom());
+      dgGraphics->FillArea(areaRect, backgroundColor);
+
+      mainWindow->DrawWindow(drawAreas[j]);
+   }
+}
+/*------------------------------------------------------------------------
+Function Name: CreateBackingStore
+Parameters:
+   Window* window : the window whose backing store is to be created
+Returns:
+   true if the backing store was created, false if it doesn't fit in 
+   the memory set aside for backing stores
+Description:
+   This function creates the backing store of a window, which must have
+   backing stores enabled. If there isn't enough memory left for it, the
+   backing stores that were used the least recently are destroyed.
+------------------------------------------------------------------------*/
+
+bool Gui::CreateBackingStore(Window* window)
+{
+   BackingStore* store = window->GetBackingStore();
+   Point size = window->GetSize();
+
+   assert(store != NULL);
+
+   ReleaseBackingStore(window);
+
+   //Don't bother destroying other stores if this one can't fit anyway
+   if(size.x <= 0 || size.y <= 0 || UINT(size.x * size.y * 
+      dgGraphics->GetBytesPerPixel()) > maxBackingStoreMemory)
+      return false;
+
+   store->Create(size.x, size.y);
+
+   while(curBackingStoreMemory + store->GetMemoryUsage() > 
+      maxBackingStoreMemory)
+   {
+      Window* leastRecentWindow = FindLeastRecentBackingStore();
+
+      if(leastRecentWindow == NULL)
+      {
+         store->Destroy();
+         return false;
+      }
+
+      ReleaseBackingStore(leastRecentWindow);
+   }
+
+   curBackingStoreMemory += store->GetMemoryUsage();
+   store->SetLastUsedFrame(frameNumber);
+   //Window IDs aren't unique, so the windows are found by their address
+   backingStoreList.Append(window);
+
+   return true;
+}
+
+/*------------------------------------------------------------------------
+Function Name: ReleaseBackingStore
+Parameters:
+   Window* window : the window whose backing store is to be released
+Description:
+   This function destroys the backing store of a window and frees its 
+   memory. The window keeps backing stores enabled, so its store will be
+   created again the next time the window is drawn.
+------------------------------------------------------------------------*/
+
+void Gui::ReleaseBackingStore(Window* window)
+{
+   ListIterator<Window> iterator = backingStoreList.Begin();
+
+   while(!iterator.EndOfList() && iterator.GetData() != window)
+      iterator++;
+
+   if(iterator.EndOfList())
+      return;
+
+   backingStoreList.RemoveByIndex(iterator.GetPosition());
+
+   BackingStore* store = window->GetBackingStore();
+
+   curBackingStoreMemory -= store->GetMemoryUsage();
+   store->Destroy();
+}
+
+/*------------------------------------------------------------------------
+Function Name: ReleaseAllBackingStores
+Parameters:
+Description:
+   This function destroys the backing stores of all windows.
+------------------------------------------------------------------------*/
+
+void Gui::ReleaseAllBackingStores()
+{
+   while(backingStoreList.GetNumOfItems() > 0)
+      ReleaseBackingStore(backingStoreList.GetFirstItem());
+}
+
+/*------------------------------------------------------------------------
+Function Name: SetMaxBackingStoreMemory
+Parameters:
+   UINT maxMem : the number of bytes that the backing stores may use
+Description:
+   This function sets the amount of memory that the backing stores of 
+   all windows together may use. If they already use more, the backing
+   stores that were used the least recently are destroyed.
+------------------------------------------------------------------------*/
+
+void Gui::SetMaxBackingStoreMemory(UINT maxMem)
+{
+   maxBackingStoreMemory = maxMem;
+
+   while(curBackingStoreMemory > maxBackingStoreMemory)
+      ReleaseBackingStore(FindLeastRecentBackingStore());
+}
+
+/*------------------------------------------------------------------------
+Function Name: InvalidateBackingStores
+Parameters:
+   Area& area : the area of the screen that will be redrawn, in 
+      absolute coordinates
+Description:
+   This function marks the area as out of date in the backing stores of
+   the windows that aren't opaque. What those windows stored includes
+   what was under them, and that is drawn again.
+------------------------------------------------------------------------*/
+
+void Gui::InvalidateBackingStores(Area& area)
+{
+   ListIterator<Window> iterator = backingStoreList.Begin();
+
+   while(!iterator.EndOfList())
+   {
+      Window* window = iterator.GetData();
+
+      if(!window->IsOpaque())
+         window->InvalidateBackingStore(area);
+
+      iterator++;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: FindLeastRecentBackingStore
+Parameters:
+Returns:
+   The window whose backing store was used the least recently, or NULL 
+   if no backing stores have been created
+Description:
+   This function finds the backing store to be destroyed first when
+   the backing stores use too much memory.
+------------------------------------------------------------------------*/
+
+Window* Gui::FindLeastRecentBackingStore()
+{
+   Window* leastRecentWindow = NULL;
+   ListIterator<Window> iterator = backingStoreList.Begin();
+
+   while(!iterator.EndOfList())
+   {
+      Window* window = iterator.GetData();
+
+      if(leastRecentWindow == NULL || 
+         window->GetBackingStore()->GetLastUsedFrame() < 
+         leastRecentWindow->GetBackingStore()->GetLastUsedFrame())
+         leastRecentWindow = window;
+
+      iterator++;
+   }
+
+   return leastRecentWindow;
+}
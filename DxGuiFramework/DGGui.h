@@ -19,6 +19,18 @@ Version:
 //is necessary
 #define  GUI_WINLIST_GROWTH         50
 
+//The number of separate dirty areas that are kept track of in a frame.
+//When there are more, they are merged into a single area.
+#define  GUI_MAX_DIRTY_AREAS        16
+
+//The number of earlier frames whose dirty areas are kept, which is 
+//enough for the oldest surface of a triple-buffered flip chain
+#define  GUI_MAX_DRAWN_FRAMES       2
+
+//The default amount of memory that the backing stores of the windows
+//may use
+#define  GUI_DEFAULT_BACKING_STORE_MEMORY    4000000
+
 namespace DG
 {
    class Gui
@@ -48,9 +60,25 @@ namespace DG
       void CreateTimer(UINT timerID, UINT windowID, UINT interval);
       void DestroyTimer(UINT timerID);
 
+      void InvalidateArea(Area& area);
+      void InvalidateAll(void);
+
       void DrawGUI(void);
+      UINT GetFrameNumber(void) {return frameNumber;}
+
+      //Backing store functions
+      bool CreateBackingStore(Window* window);
+      void ReleaseBackingStore(Window* window);
+      void ReleaseAllBackingStores(void);
+      void SetMaxBackingStoreMemory(UINT maxMem);
+      UINT GetMaxBackingStoreMemory(void) {return maxBackingStoreMemory;}
+      UINT GetCurrentBackingStoreMemory(void) 
+      {return curBackingStoreMemory;}
 
    private:
+      void InvalidateBackingStores(Area& area);
+      Window* FindLeastRecentBackingStore(void);
+
       //The main windows for the GUI
       MainWindow* mainWindow;
 
@@ -74,6 +102,29 @@ namespace DG
       int prevXPos;
       int prevYPos;
 
+      //The areas of the screen that need to be redrawn in the next frame,
+      //in absolute coordinates. No two of them overlap.
+      Area dirtyAreas[GUI_MAX_DIRTY_AREAS];
+      int numOfDirtyAreas;
+
+      //The areas that became dirty in each of the last frames, by frame
+      //number. A surface of a flip chain last had the GUI drawn on it a
+      //few frames ago, so it is also missing what changed since then.
+      Area recentDirtyAreas[GUI_MAX_DRAWN_FRAMES][GUI_MAX_DIRTY_AREAS];
+      int numOfRecentDirtyAreas[GUI_MAX_DRAWN_FRAMES];
+
+      //The surface generation of the graphics object when the GUI was
+      //last drawn
+      UINT drawnSurfaceGeneration;
+
+      //The number of times the GUI has been drawn
+      UINT frameNumber;
+
+      //The windows whose backing stores have been created, by window ID
+      LinkedList<Window> backingStoreList;
+      UINT maxBackingStoreMemory;
+      UINT curBackingStoreMemory;
+
       std::map<UINT, UINT> timerTable;
       typedef std::map<UINT, UINT>::value_type TimerEntry;
 
@@ -6,6 +6,7 @@ Version:
    1.0.0    09.09.2001  Created the file
    2.0.0    02.06.2002  Changed the file to use namespaces and adapt
       to Visual Studio .NET
+   2.1.0    15.12.2002  Images can show tiled bitmaps
 ------------------------------------------------------------------------*/
 
 #include "DxGuiFramework.h"
@@ -113,6 +114,72 @@ void Image::LoadBitmapFile(const char* bitmapName, int priority)
       bitmapOrigin.y = 0;*/
 
    OnWindowSized();
+
+   Invalidate();
+}
+
+/*------------------------------------------------------------------------
+Function Name: LoadBitmapFileAsync
+Description:
+   This function loads a bitmap file like LoadBitmapFile(), but the 
+   bitmap is decoded by the bitmap loader while the GUI keeps running.
+   The size of the bitmap is known right away, so the bitmap is placed
+   in the control at once, and a placeholder is drawn until the bitmap
+   has been loaded.
+Parameters: const char* bitmapName - the name of a bitmap file from 
+               which a bitmap is to be loaded.
+            int priority - the priority of the bitmap to be loaded
+Preconditions: bitmapName points to a null-terminated character array
+------------------------------------------------------------------------*/
+
+void Image::LoadBitmapFileAsync(const char* bitmapName, int priority)
+{
+   //If there is a bitmap with this ID already in the bitmap list, 
+   //then unload it
+   dgGraphics->DeleteBitmap(bitmapID);
+
+   dgGraphics->LoadBitmapAsync(bitmapID, priority, bitmapName, 
+      GetWindowID());
+   strcpy(bitmapFileName, bitmapName);
+
+   if(transparentBitmap)
+   {
+      Bitmap* bitmap = dgGraphics->GetBitmap(bitmapID);
+      assert(bitmap != NULL);
+      bitmap->SetTransparentColor(transparentColor);
+   }
+
+   OnWindowSized();
+
+   Invalidate();
+}
+
+/*------------------------------------------------------------------------
+Function Name: LoadTiledBitmapFile
+Description:
+   This function loads a bitmap file like LoadBitmapFile(), but as a 
+   tiled bitmap, so that only the tiles that are shown in the control
+   are loaded. This is meant for bitmaps that are much larger than the
+   control and are scrolled through by moving the bitmap origin. Tiled
+   bitmaps are always drawn without a transparent color.
+Parameters: const char* bitmapName - the name of a bitmap file from 
+               which a bitmap is to be loaded.
+            int priority - the priority of the bitmap to be loaded
+Preconditions: bitmapName points to a null-terminated character array
+------------------------------------------------------------------------*/
+
+void Image::LoadTiledBitmapFile(const char* bitmapName, int priority)
+{
+   //If there is a bitmap with this ID already in the bitmap list, 
+   //then unload it
+   dgGraphics->DeleteBitmap(bitmapID);
+
+   dgGraphics->LoadTiledBitmap(bitmapID, priority, bitmapName);
+   strcpy(bitmapFileName, bitmapName);
+
+   OnWindowSized();
+
+   Invalidate();
 }
 
 /*------------------------------------------------------------------------
@@ -134,6 +201,8 @@ void Image::SetTransparency(bool transparent)
       if(bitmap != NULL)
          bitmap->SetTransparentColor(transparentColor);
    }   
+
+   Invalidate();
 }
 
 /*------------------------------------------------------------------------
@@ -156,6 +225,8 @@ void Image::SetTransparentColor(Color color)
       if(bitmap != NULL)
          bitmap->SetTransparentColor(transparentColor);
    }
+
+   Invalidate();
 }
 
 /*------------------------------------------------------------------------
@@ -170,6 +241,7 @@ Parameters: Point coords - the window coordinates of where the
 void Image::SetBitmapOrigin(Point coords)
 {
    bitmapOrigin = coords;
+   Invalidate();
 }
 
 /*------------------------------------------------------------------------
@@ -198,7 +270,7 @@ void FC Image::OnDrawWindow(WindowSurface* surface)
 
    if(bitmap != NULL)
    {
-      if(transparentBitmap)
+      if(transparentBitmap && !bitmap->IsTiled())
          surface->DrawTransparentBitmap(bitmapOrigin, bitmapID);
       else
          surface->DrawBitmap(bitmapOrigin, bitmapID);
@@ -377,6 +449,16 @@ void FC Image::OnMouseMove(int x, int y, BYTE* keyboardState)
    }
 }
 
+void FC Image::OnBitmapLoaded(UINT loadedBitmapID)
+{
+   //The bitmap of the control may have changed since it was loaded
+   if(loadedBitmapID != bitmapID)
+      return;
+
+   //The bitmap has applied its transparent color to the loaded pixels
+   Invalidate();
+}
+
 void FC Image::OnWindowSized()
 {
    //Set the origin of the bitmap depending on whether it is smaller or
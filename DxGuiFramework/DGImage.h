@@ -6,6 +6,7 @@ Version:
    1.0.0    09.09.2001  Created the file
    2.0.0    02.06.2002  Changed the file to use namespaces and adapt
       to Visual Studio .NET
+   2.1.0    15.12.2002  Images can show tiled bitmaps
 ------------------------------------------------------------------------*/
 
 #pragma once
@@ -32,6 +33,8 @@ namespace DG
          bool _parentNotify = true);
 
       void LoadBitmapFile(const char* bitmapName, int priority = 1);
+      void LoadBitmapFileAsync(const char* bitmapName, int priority = 1);
+      void LoadTiledBitmapFile(const char* bitmapName, int priority = 1);
       char* const GetBitmapFileName(void) {return bitmapFileName;}
 
       void SetTransparency(bool transparent);
@@ -43,7 +46,7 @@ namespace DG
       void SetTransparentColor(Color color);
       Color GetTransparentColor(void) {return transparentColor;}
 
-      void SetBitmapID(UINT id) {bitmapID = id;}
+      void SetBitmapID(UINT id) {bitmapID = id; Invalidate();}
       UINT GetBitmapID(void) {return bitmapID;}
 
       void SetBitmapOrigin(Point coords);
@@ -64,6 +67,7 @@ namespace DG
       void FC OnRButtonDblClk(int x, int y, BYTE* keyboardState);
       void FC OnMouseMove(int x, int y, BYTE* keyboardState);
       void FC OnWindowSized(void);
+      void FC OnBitmapLoaded(UINT loadedBitmapID);
 
    private:
       bool transparentBitmap;
@@ -45,25 +45,29 @@ namespace DG
          bool _parentNotify = true);
 
       void SetTransparency(bool transparent)
-      {transparentBackground = transparent;}
+      {transparentBackground = transparent; Invalidate();}
       bool GetTransparency(void) {return transparentBackground;}
 
+      bool FC IsOpaque(void) {return !transparentBackground;}
+
       void SetParentNotify(bool notify) {parentNotify = notify;}
       bool GetParentNotify(void) {return parentNotify;}
 
-      void SetForegroundColor(Color color) {foregroundColor = color;}
+      void SetForegroundColor(Color color)
+      {foregroundColor = color; Invalidate();}
       Color GetForegroundColor(void) {return foregroundColor;}
 
-      void SetBackgroundColor(Color color) {backgroundColor = color;}
+      void SetBackgroundColor(Color color)
+      {backgroundColor = color; Invalidate();}
       Color GetBackgroundColor(void) {return backgroundColor;}
 
-      void SetFlags(UINT flags) {textFlags = flags;}
+      void SetFlags(UINT flags) {textFlags = flags; Invalidate();}
       UINT GetFlags(void) {return textFlags;}
 
-      void SetFont(Font aFont) {font = aFont;}
+      void SetFont(Font aFont) {font = aFont; Invalidate();}
       Font GetFont(void) {return font;}
 
-      void SetText(const char* aText) {strcpy(text, aText);}
+      void SetText(const char* aText) {strcpy(text, aText); Invalidate();}
       char* const GetText(void) {return text;}
 
    protected:
@@ -299,6 +299,13 @@ GM_TIMER - This message is received by a window then a timer exists
 Data required:
 data3 - the ID of the timer
 
+GM_BITMAPLOADED - This message is received by a window that loaded a
+   bitmap with DG::Graphics::LoadBitmapAsync() when the bitmap loader
+   has finished the bitmap
+
+Data required:
+data3 - the ID of the bitmap
+
 -----Control Messages-----
 
 -DGLabel-
@@ -0,0 +1,361 @@
+/*------------------------------------------------------------------------
+File Name: DGPixelBuffer.cpp
+Description: This file contains the implementation of the DG::PixelBuffer
+   class, which is a block of pixels in system memory. It is used by the
+   software render backend in place of a DirectDraw surface.
+Version:
+   1.0.0    14.07.2002  Created the file
+   1.1.0    25.08.2002  StretchBlit() uses the scale kernels
+   1.2.0    01.09.2002  Added BlitRunLength()
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+
+using namespace DG;
+
+/*Default Constructor*/
+PixelBuffer::PixelBuffer()
+{
+   bits = NULL;
+   width = 0;
+   height = 0;
+   bytesPerPixel = 0;
+   pitch = 0;
+   colorKey = 0;
+   fillKernel = NULL;
+   scaleKernel = NULL;
+}
+
+PixelBuffer::PixelBuffer(int bufferWidth, int bufferHeight,
+                         int bufferBytesPerPixel)
+{
+   bits = NULL;
+   colorKey = 0;
+
+   Create(bufferWidth, bufferHeight, bufferBytesPerPixel);
+}
+
+/*Destructor*/
+PixelBuffer::~PixelBuffer()
+{
+   Destroy();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Create
+Parameters:
+   int bufferWidth : the width of the buffer in pixels
+   int bufferHeight : the height of the buffer in pixels
+   int bufferBytesPerPixel : the size of a pixel, which is 2, 3, or 4
+Description:
+   This function allocates the memory for the buffer. Any memory that
+   the buffer previously held is freed. The contents of the new buffer
+   are cleared to 0.
+------------------------------------------------------------------------*/
+
+void PixelBuffer::Create(int bufferWidth, int bufferHeight,
+                         int bufferBytesPerPixel)
+{
+   assert(bufferWidth > 0 && bufferHeight > 0);
+   assert(bufferBytesPerPixel >= 2 && bufferBytesPerPixel <= 4);
+
+   Destroy();
+
+   width = bufferWidth;
+   height = bufferHeight;
+   bytesPerPixel = bufferBytesPerPixel;
+
+   //Scanlines are padded to the 32-bit boundary, just like a DIB
+   pitch = ((width * bytesPerPixel) + 3) & ~3;
+
+   bits = new UCHAR[pitch * height];
+   memset(bits, 0, pitch * height);
+
+   fillKernel = FillKernels::Select(bytesPerPixel);
+   scaleKernel = ScaleKernels::Select(bytesPerPixel, 0, SF_NEAREST);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Destroy
+Parameters:
+Description:
+   This function frees the memory held by the buffer.
+------------------------------------------------------------------------*/
+
+void PixelBuffer::Destroy()
+{
+   if(bits != NULL)
+   {
+      delete[] bits;
+      bits = NULL;
+   }
+
+   width = 0;
+   height = 0;
+   pitch = 0;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Fill
+Parameters:
+   RECT* destRect : the area to be filled, or NULL for the entire buffer
+   UINT pixel : the pixel value to fill the area with, which must
+      already be in the pixel format of the buffer
+   RECT* clipRect : the rectangle that the fill is clipped to, or NULL
+      if there is no clipping
+Description:
+   This function fills an area of the buffer with a pixel value, the
+   same as a DDBLT_COLORFILL blit would.
+------------------------------------------------------------------------*/
+
+void FC PixelBuffer::Fill(RECT* destRect, UINT pixel, RECT* clipRect)
+{
+   RECT rect = {0, 0, width, height};
+
+   if(destRect != NULL)
+      rect = *destRect;
+
+   if(!ClipToBuffer(rect, clipRect))
+      return;
+
+   fillKernel(GetScanLine(rect.top) + (rect.left * bytesPerPixel), pitch,
+      rect.right - rect.left, rect.bottom - rect.top, pixel);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Blit
+Parameters:
+   int x : the x coordinate that the source is to be copied to
+   int y : the y coordinate that the source is to be copied to
+   PixelBuffer* source : the buffer to be copied
+   RECT* srcRect : the area of the source to be copied, or NULL for the
+      entire source
+   RECT* clipRect : the rectangle that the blit is clipped to, or NULL
+      if there is no clipping
+Description:
+   This function copies an area of another buffer into this buffer. Both
+   buffers must have the same pixel format.
+------------------------------------------------------------------------*/
+
+void FC PixelBuffer::Blit(int x, int y, PixelBuffer* source, RECT* srcRect,
+                          RECT* clipRect)
+{
+   assert(source != NULL && source->bytesPerPixel == bytesPerPixel);
+
+   RECT sourceRect = {0, 0, source->width, source->height};
+
+   if(srcRect != NULL)
+      sourceRect = *srcRect;
+
+   RECT rect = {x, y, x + (sourceRect.right - sourceRect.left),
+      y + (sourceRect.bottom - sourceRect.top)};
+
+   if(!ClipToBuffer(rect, clipRect))
+      return;
+
+   //Move the source origin by as much as the destination was clipped
+   int srcX = sourceRect.left + (rect.left - x);
+   int srcY = sourceRect.top + (rect.top - y);
+   int lineSize = (rect.right - rect.left) * bytesPerPixel;
+
+   for(int line = rect.top; line < rect.bottom; line++, srcY++)
+   {
+      memcpy(GetScanLine(line) + (rect.left * bytesPerPixel),
+         source->GetScanLine(srcY) + (srcX * bytesPerPixel), lineSize);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: BlitTransparent
+Parameters:
+   int x : the x coordinate that the source is to be copied to
+   int y : the y coordinate that the source is to be copied to
+   PixelBuffer* source : the buffer to be copied
+   UINT key : the pixel value in the source which is not to be copied
+   RECT* srcRect : the area of the source to be copied, or NULL for the
+      entire source
+   RECT* clipRect : the rectangle that the blit is clipped to, or NULL
+      if there is no clipping
+Description:
+   This function copies an area of another buffer into this buffer,
+   skipping every source pixel that matches the color key. Both buffers
+   must have the same pixel format.
+------------------------------------------------------------------------*/
+
+void FC PixelBuffer::BlitTransparent(int x, int y, PixelBuffer* source,
+                                     UINT key, RECT* srcRect,
+                                     RECT* clipRect)
+{
+   assert(source != NULL && source->bytesPerPixel == bytesPerPixel);
+
+   RECT sourceRect = {0, 0, source->width, source->height};
+
+   if(srcRect != NULL)
+      sourceRect = *srcRect;
+
+   RECT rect = {x, y, x + (sourceRect.right - sourceRect.left),
+      y + (sourceRect.bottom - sourceRect.top)};
+
+   if(!ClipToBuffer(rect, clipRect))
+      return;
+
+   int srcX = sourceRect.left + (rect.left - x);
+   int srcY = sourceRect.top + (rect.top - y);
+   int blitWidth = rect.right - rect.left;
+
+   for(int line = rect.top; line < rect.bottom; line++, srcY++)
+   {
+      UCHAR* dest = GetScanLine(line) + (rect.left * bytesPerPixel);
+      UCHAR* src = source->GetScanLine(srcY) + (srcX * bytesPerPixel);
+
+      switch(bytesPerPixel)
+      {
+         case 2:
+            for(int i = 0; i < blitWidth; i++)
+            {
+               if(((USHORT*)src)[i] != USHORT(key))
+                  ((USHORT*)dest)[i] = ((USHORT*)src)[i];
+            }
+            break;
+         case 3:
+            for(int i = 0; i < blitWidth; i++, src += 3, dest += 3)
+            {
+               UINT pixel = src[0] | (src[1] << 8) | (src[2] << 16);
+
+               if(pixel != (key & 0x00FFFFFF))
+               {
+                  dest[0] = src[0];
+                  dest[1] = src[1];
+                  dest[2] = src[2];
+               }
+            }
+            break;
+         case 4:
+            for(int i = 0; i < blitWidth; i++)
+            {
+               if(((UINT*)src)[i] != key)
+                  ((UINT*)dest)[i] = ((UINT*)src)[i];
+            }
+            break;
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: BlitRunLength
+Parameters:
+   int x : the x coordinate that the sprite is to be copied to
+   int y : the y coordinate that the sprite is to be copied to
+   RunLengthSprite* sprite : the encoded buffer to be copied
+   RECT* clipRect : the rectangle that the blit is clipped to, or NULL
+      if there is no clipping
+Description:
+   This function does the same as BlitTransparent() with the key that
+   the sprite was encoded with, but only copies the runs of opaque 
+   pixels instead of testing each pixel.
+------------------------------------------------------------------------*/
+
+void FC PixelBuffer::BlitRunLength(int x, int y, RunLengthSprite* sprite,
+                                   RECT* clipRect)
+{
+   assert(sprite != NULL && sprite->IsEncoded() && 
+      sprite->GetBuffer()->bytesPerPixel == bytesPerPixel);
+
+   PixelBuffer* source = sprite->GetBuffer();
+
+   RECT rect = {x, y, x + source->width, y + source->height};
+
+   if(!ClipToBuffer(rect, clipRect))
+      return;
+
+   RECT sourceRect = {rect.left - x, rect.top - y, rect.right - x,
+      rect.bottom - y};
+
+   sprite->Draw(GetScanLine(rect.top) + (rect.left * bytesPerPixel), pitch,
+      sourceRect);
+}
+
+/*------------------------------------------------------------------------
+Function Name: StretchBlit
+Parameters:
+   RECT* destRect : the area that the source is to be scaled into
+   PixelBuffer* source : the buffer to be copied
+   RECT* clipRect : the rectangle that the blit is clipped to, or NULL
+      if there is no clipping
+   bool transparent : whether pixels matching the color key are skipped
+   UINT key : the pixel value in the source which is not to be copied
+Description:
+   This function copies the entire source buffer into this buffer,
+   scaling it to fit the destination area. Pixels are sampled with
+   16.16 fixed-point steps. Both buffers must have the same pixel format.
+------------------------------------------------------------------------*/
+
+void FC PixelBuffer::StretchBlit(RECT* destRect, PixelBuffer* source,
+                                 RECT* clipRect, bool transparent, UINT key)
+{
+   assert(source != NULL && source->bytesPerPixel == bytesPerPixel);
+
+   int destWidth = destRect->right - destRect->left;
+   int destHeight = destRect->bottom - destRect->top;
+
+   if(destWidth <= 0 || destHeight <= 0)
+      return;
+
+   RECT rect = *destRect;
+
+   if(!ClipToBuffer(rect, clipRect))
+      return;
+
+   ScaleSetup setup;
+   setup.source = source->bits;
+   setup.sourcePitch = source->pitch;
+   setup.sourceWidth = source->width;
+   setup.sourceHeight = source->height;
+   setup.transparent = transparent;
+   setup.key = key & ((bytesPerPixel == 3) ? 0x00FFFFFF : 0xFFFFFFFF);
+   setup.SetArea(*destRect, rect.left, rect.top, SF_NEAREST);
+
+   scaleKernel(GetScanLine(rect.top) + (rect.left * bytesPerPixel), pitch,
+      rect.right - rect.left, rect.bottom - rect.top, setup);
+}
+
+//Private Functions
+
+/*------------------------------------------------------------------------
+Function Name: ClipToBuffer
+Parameters:
+   RECT& rect : the rectangle to be clipped
+   RECT* clipRect : the clipping rectangle, or NULL if there is none
+Returns:
+   true if anything is left of the rectangle, false if the rectangle has
+   been clipped away entirely
+Description:
+   This function clips a rectangle to the clipping rectangle and to the
+   edges of the buffer.
+------------------------------------------------------------------------*/
+
+bool FC PixelBuffer::ClipToBuffer(RECT& rect, RECT* clipRect)
+{
+   if(rect.left < 0)
+      rect.left = 0;
+   if(rect.top < 0)
+      rect.top = 0;
+   if(rect.right > width)
+      rect.right = width;
+   if(rect.bottom > height)
+      rect.bottom = height;
+
+   if(clipRect != NULL)
+   {
+      if(rect.left < clipRect->left)
+         rect.left = clipRect->left;
+      if(rect.top < clipRect->top)
+         rect.top = clipRect->top;
+      if(rect.right > clipRect->right)
+         rect.right = clipRect->right;
+      if(rect.bottom > clipRect->bottom)
+         rect.bottom = clipRect->bottom;
+   }
+
+   return rect.left < rect.right && rect.top < rect.bottom;
+}
@@ -0,0 +1,73 @@
+/*------------------------------------------------------------------------
+File Name: DGPixelBuffer.h
+Description: This file contains the DG::PixelBuffer class, which is a
+   block of pixels in system memory. It is used by the software render
+   backend in place of a DirectDraw surface.
+Version:
+   1.0.0    14.07.2002  Created the file
+------------------------------------------------------------------------*/
+
+#pragma once
+
+namespace DG
+{
+   class RunLengthSprite;
+
+   class PixelBuffer
+   {
+   public:
+      PixelBuffer();
+      PixelBuffer(int bufferWidth, int bufferHeight, int bufferBytesPerPixel);
+      virtual ~PixelBuffer();
+
+      void Create(int bufferWidth, int bufferHeight, int bufferBytesPerPixel);
+      void Destroy(void);
+
+      bool IsCreated(void) {return bits != NULL;}
+      UCHAR* GetBits(void) {return bits;}
+      UCHAR* GetScanLine(int y) {return bits + (y * pitch);}
+      int GetWidth(void) {return width;}
+      int GetHeight(void) {return height;}
+      LONG GetPitch(void) {return pitch;}
+      int GetBytesPerPixel(void) {return bytesPerPixel;}
+      UINT GetMemoryUsage(void) {return UINT(pitch * height);}
+
+      void SetColorKey(UINT key) {colorKey = key;}
+      UINT GetColorKey(void) {return colorKey;}
+
+      //Drawing functions, all rectangles have an exclusive right and
+      //bottom like the RECTs passed to DirectDraw
+      void FC Fill(RECT* destRect, UINT pixel, RECT* clipRect = NULL);
+      void FC Blit(int x, int y, PixelBuffer* source, RECT* srcRect = NULL,
+         RECT* clipRect = NULL);
+      void FC BlitTransparent(int x, int y, PixelBuffer* source,
+         UINT key, RECT* srcRect = NULL, RECT* clipRect = NULL);
+      void FC StretchBlit(RECT* destRect, PixelBuffer* source,
+         RECT* clipRect = NULL, bool transparent = false, UINT key = 0);
+      void FC BlitRunLength(int x, int y, RunLengthSprite* sprite,
+         RECT* clipRect = NULL);
+
+   private:
+      bool FC ClipToBuffer(RECT& rect, RECT* clipRect);
+
+      //The pixels, stored top-down
+      UCHAR* bits;
+
+      int width;
+      int height;
+      int bytesPerPixel;
+
+      //The number of bytes in a scanline, which is always a multiple of 4
+      //so that the buffer can be handed to GDI as a DIB
+      LONG pitch;
+
+      //The transparent pixel value for transparent blits
+      UINT colorKey;
+
+      //The kernel that fills rectangles in this buffer
+      FillKernel fillKernel;
+
+      //The kernel that stretches other buffers into this buffer
+      ScaleKernel scaleKernel;
+   };
+}
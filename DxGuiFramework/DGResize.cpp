@@ -24,7 +24,8 @@ Resize::Resize(UINT winID, Window* parentWin) :
    Bitmap* bitmap = dgGraphics->GetBitmap(IDB_RESIZE);
    if(bitmap == NULL)
    {
-      dgGraphics->LoadBitmap(IDB_RESIZE, 1, "Bitmaps/ResizeControl.bmp");
+      dgGraphics->LoadPackedBitmap(IDB_RESIZE, 1, 
+         "Bitmaps/ResizeControl.bmp");
       bitmap = dgGraphics->GetBitmap(IDB_RESIZE);
       bitmap->SetTransparentColor(Color(255, 255, 255));
    }
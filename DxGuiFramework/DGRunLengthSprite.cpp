@@ -0,0 +1,200 @@
+/*------------------------------------------------------------------------
+File Name: DGRunLengthSprite.cpp
+Description: This file contains the implementation of the
+   DG::RunLengthSprite class, which draws a color-keyed pixel buffer by
+   copying its runs of opaque pixels.
+Version:
+   1.0.0    01.09.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+
+using namespace DG;
+
+//Reads a pixel of the given size in bytes
+static inline UINT ReadPixel(UCHAR* source, int size)
+{
+   switch(size)
+   {
+      case 2:
+         return *(USHORT*)source;
+      case 3:
+         return source[0] | (source[1] << 8) | (source[2] << 16);
+      default:
+         return *(UINT*)source;
+   }
+}
+
+/*Constructor*/
+RunLengthSprite::RunLengthSprite()
+{
+   sourceBuffer = NULL;
+   colorKey = 0;
+   runs = NULL;
+   lineStarts = NULL;
+   memoryUsage = 0;
+}
+
+/*Destructor*/
+RunLengthSprite::~RunLengthSprite()
+{
+   Destroy();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Encode
+Parameters:
+   PixelBuffer* buffer : the buffer to be encoded
+   UINT key : the pixel value in the buffer which is transparent
+Description:
+   This function finds the runs of pixels in the buffer which don't
+   match the key. The buffer is read twice: once to count the runs and
+   once to store them. The sprite refers to the buffer, so it has to be
+   encoded again if the buffer changes.
+------------------------------------------------------------------------*/
+
+void FC RunLengthSprite::Encode(PixelBuffer* buffer, UINT key)
+{
+   assert(buffer != NULL && buffer->GetWidth() <= 0xFFFF);
+
+   Destroy();
+
+   sourceBuffer = buffer;
+
+   int size = buffer->GetBytesPerPixel();
+   int width = buffer->GetWidth();
+   int height = buffer->GetHeight();
+
+   colorKey = key & ((size == 3) ? 0x00FFFFFF :
+      ((size == 2) ? 0x0000FFFF : 0xFFFFFFFF));
+
+   lineStarts = new UINT[height];
+
+   //Count the runs, so that the exact amount of memory can be allocated
+   UINT numOfEntries = 0;
+
+   for(int countY = 0; countY < height; countY++)
+   {
+      UCHAR* pixel = buffer->GetScanLine(countY);
+      bool inRun = false;
+
+      lineStarts[countY] = numOfEntries;
+      numOfEntries++;
+
+      for(int x = 0; x < width; x++, pixel += size)
+      {
+         bool opaque = (ReadPixel(pixel, size) != colorKey);
+
+         if(opaque && !inRun)
+            numOfEntries += 2;
+
+         inRun = opaque;
+      }
+   }
+
+   runs = new USHORT[numOfEntries];
+
+   //Store the runs of each line
+   for(int y = 0; y < height; y++)
+   {
+      UCHAR* pixel = buffer->GetScanLine(y);
+      USHORT* numOfRuns = &runs[lineStarts[y]];
+      USHORT* run = numOfRuns + 1;
+      int runStart = -1;
+
+      *numOfRuns = 0;
+
+      for(int x = 0; x <= width; x++, pixel += size)
+      {
+         bool opaque = (x < width) && (ReadPixel(pixel, size) != colorKey);
+
+         if(opaque && runStart < 0)
+            runStart = x;
+
+         else if(!opaque && runStart >= 0)
+         {
+            run[0] = USHORT(runStart);
+            run[1] = USHORT(x - runStart);
+            run += 2;
+            (*numOfRuns)++;
+
+            runStart = -1;
+         }
+      }
+   }
+
+   memoryUsage = (numOfEntries * sizeof(USHORT)) + (height * sizeof(UINT));
+}
+
+/*------------------------------------------------------------------------
+Function Name: Destroy
+Parameters:
+Description:
+   This function frees the runs.
+------------------------------------------------------------------------*/
+
+void FC RunLengthSprite::Destroy(void)
+{
+   if(runs != NULL)
+   {
+      delete[] runs;
+      runs = NULL;
+   }
+
+   if(lineStarts != NULL)
+   {
+      delete[] lineStarts;
+      lineStarts = NULL;
+   }
+
+   sourceBuffer = NULL;
+   memoryUsage = 0;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Draw
+Parameters:
+   UCHAR* dest : the destination of the upper-left pixel of srcRect
+   LONG destPitch : the number of bytes from one destination line to
+      the next
+   RECT& srcRect : the part of the sprite to be drawn, which must be
+      within the sprite, with an exclusive right and bottom
+Description:
+   This function copies the opaque runs within srcRect. The transparent
+   pixels between the runs are skipped without being looked at.
+------------------------------------------------------------------------*/
+
+void FC RunLengthSprite::Draw(UCHAR* dest, LONG destPitch, RECT& srcRect)
+{
+   assert(IsEncoded());
+
+   int size = sourceBuffer->GetBytesPerPixel();
+
+   for(int y = srcRect.top; y < srcRect.bottom; y++, dest += destPitch)
+   {
+      UCHAR* source = sourceBuffer->GetScanLine(y);
+      USHORT* run = &runs[lineStarts[y]];
+      int numOfRuns = *run++;
+
+      for(int i = 0; i < numOfRuns; i++, run += 2)
+      {
+         int start = run[0];
+         int end = start + run[1];
+
+         //The runs are in order, so none of the others can be visible
+         if(start >= srcRect.right)
+            break;
+
+         if(end <= srcRect.left)
+            continue;
+
+         if(start < srcRect.left)
+            start = srcRect.left;
+         if(end > srcRect.right)
+            end = srcRect.right;
+
+         memcpy(dest + ((start - srcRect.left) * size),
+            source + (start * size), (end - start) * size);
+      }
+   }
+}
@@ -0,0 +1,45 @@
+/*------------------------------------------------------------------------
+File Name: DGRunLengthSprite.h
+Description: This file contains the DG::RunLengthSprite class, which
+   stores the opaque pixels of a color-keyed pixel buffer as runs, so
+   that it can be drawn transparently without testing every pixel.
+Version:
+   1.0.0    01.09.2002  Created the file
+------------------------------------------------------------------------*/
+
+#pragma once
+
+namespace DG
+{
+   class RunLengthSprite
+   {
+   public:
+      RunLengthSprite();
+      virtual ~RunLengthSprite();
+
+      void FC Encode(PixelBuffer* buffer, UINT key);
+      void FC Destroy(void);
+
+      bool IsEncoded(void) {return lineStarts != NULL;}
+      PixelBuffer* GetBuffer(void) {return sourceBuffer;}
+      UINT GetKey(void) {return colorKey;}
+      UINT GetMemoryUsage(void) {return memoryUsage;}
+
+      void FC Draw(UCHAR* dest, LONG destPitch, RECT& srcRect);
+
+   private:
+      //The buffer that was encoded. The runs only say where the opaque
+      //pixels are, the pixels themselves are copied from this buffer.
+      PixelBuffer* sourceBuffer;
+      UINT colorKey;
+
+      //For every line, the number of opaque runs followed by the start
+      //and the length of each run
+      USHORT* runs;
+
+      //The index in runs at which each line begins
+      UINT* lineStarts;
+
+      UINT memoryUsage;
+   };
+}
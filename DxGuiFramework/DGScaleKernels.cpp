@@ -0,0 +1,362 @@
+/*------------------------------------------------------------------------
+File Name: DGScaleKernels.cpp
+Description: This file contains the implementation of the scale kernels,
+   which stretch a block of pixels into a locked surface or pixel buffer
+   with nearest-neighbor or bilinear filtering.
+Version:
+   1.0.0    25.08.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+
+using namespace DG;
+
+//The pixel formats that the kernels are specialized with. Besides
+//reading and writing a pixel, each one can convert a pixel to 8 bits per
+//channel in the layout 0x00RRGGBB and back, which is what the bilinear
+//filter works with.
+class Format565
+{
+public:
+   enum {size = 2};
+
+   static UINT Read(UCHAR* source) {return *(USHORT*)source;}
+   static void Write(UCHAR* dest, UINT pixel) {*(USHORT*)dest = USHORT(pixel);}
+
+   //The highest bits of each channel are repeated in the new low bits,
+   //so that converting a pixel there and back doesn't change it
+   static UINT ToRGB(UINT pixel)
+   {
+      UINT red = (pixel >> 11) & 0x1F;
+      UINT green = (pixel >> 5) & 0x3F;
+      UINT blue = pixel & 0x1F;
+
+      return (((red << 3) | (red >> 2)) << 16) |
+         (((green << 2) | (green >> 4)) << 8) | ((blue << 3) | (blue >> 2));
+   }
+
+   static UINT FromRGB(UINT rgb)
+   {
+      return ((rgb >> 8) & 0xF800) | ((rgb >> 5) & 0x07E0) |
+         ((rgb >> 3) & 0x001F);
+   }
+};
+
+class Format555
+{
+public:
+   enum {size = 2};
+
+   static UINT Read(UCHAR* source) {return *(USHORT*)source;}
+   static void Write(UCHAR* dest, UINT pixel) {*(USHORT*)dest = USHORT(pixel);}
+
+   static UINT ToRGB(UINT pixel)
+   {
+      UINT red = (pixel >> 10) & 0x1F;
+      UINT green = (pixel >> 5) & 0x1F;
+      UINT blue = pixel & 0x1F;
+
+      return (((red << 3) | (red >> 2)) << 16) |
+         (((green << 3) | (green >> 2)) << 8) | ((blue << 3) | (blue >> 2));
+   }
+
+   static UINT FromRGB(UINT rgb)
+   {
+      return ((rgb >> 9) & 0x7C00) | ((rgb >> 6) & 0x03E0) |
+         ((rgb >> 3) & 0x001F);
+   }
+};
+
+class Format24
+{
+public:
+   enum {size = 3};
+
+   static UINT Read(UCHAR* source)
+   {
+      return source[0] | (source[1] << 8) | (source[2] << 16);
+   }
+
+   static void Write(UCHAR* dest, UINT pixel)
+   {
+      dest[0] = UCHAR(pixel);
+      dest[1] = UCHAR(pixel >> 8);
+      dest[2] = UCHAR(pixel >> 16);
+   }
+
+   static UINT ToRGB(UINT pixel) {return pixel;}
+   static UINT FromRGB(UINT rgb) {return rgb;}
+};
+
+class Format32
+{
+public:
+   enum {size = 4};
+
+   static UINT Read(UCHAR* source) {return *(UINT*)source;}
+   static void Write(UCHAR* dest, UINT pixel) {*(UINT*)dest = pixel;}
+
+   //The highest byte is filtered like a channel, so it isn't lost
+   static UINT ToRGB(UINT pixel) {return pixel;}
+   static UINT FromRGB(UINT rgb) {return rgb;}
+};
+
+/*------------------------------------------------------------------------
+Function Name: Interpolate
+Parameters:
+   UINT first : the first pixel, 8 bits per channel
+   UINT second : the second pixel, 8 bits per channel
+   UINT weight : the weight of the second pixel, from 0 to 255
+Returns:
+   The pixel weight/256 of the way from the first pixel to the second
+Description:
+   Two channels are interpolated with each multiplication, since there
+   are 8 spare bits above each of them.
+------------------------------------------------------------------------*/
+
+static inline UINT Interpolate(UINT first, UINT second, UINT weight)
+{
+   UINT inverseWeight = 256 - weight;
+
+   UINT redBlue = ((((first & 0x00FF00FF) * inverseWeight) +
+      ((second & 0x00FF00FF) * weight)) >> 8) & 0x00FF00FF;
+   UINT alphaGreen = ((((first >> 8) & 0x00FF00FF) * inverseWeight) +
+      (((second >> 8) & 0x00FF00FF) * weight)) & 0xFF00FF00;
+
+   return redBlue | alphaGreen;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Select
+Parameters:
+   int pixelSize : the size of a pixel in bytes, which is 2, 3, or 4
+   DWORD greenBitMask : the green bits of a pixel, which tell 5-6-5
+      pixels from 5-5-5 pixels
+   UINT filter : SF_NEAREST or SF_BILINEAR
+Returns:
+   The scale kernel for the pixel format and the filter
+------------------------------------------------------------------------*/
+
+ScaleKernel FC ScaleKernels::Select(int pixelSize, DWORD greenBitMask,
+   UINT filter)
+{
+   if(filter == SF_BILINEAR)
+   {
+      switch(pixelSize)
+      {
+         case 2:
+            if(greenBitMask == 0x03E0)
+               return Bilinear555;
+            return Bilinear565;
+         case 3:
+            return Bilinear24;
+         default:
+            return Bilinear32;
+      }
+   }
+
+   switch(pixelSize)
+   {
+      case 2:
+         return Nearest16;
+      case 3:
+         return Nearest24;
+      default:
+         return Nearest32;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: NearestKernel
+Parameters:
+   UCHAR* dest : the first destination pixel
+   LONG destPitch : the number of bytes from one destination line to
+      the next
+   int width : the width of the area in pixels
+   int height : the height of the area in pixels
+   ScaleSetup& setup : the source and the steps through it
+Description:
+   This function draws the source pixel nearest to each destination
+   pixel. The source column of each destination column is worked out
+   once, so the inner loop only copies pixels.
+------------------------------------------------------------------------*/
+
+template <class Format>
+static void NearestKernel(UCHAR* dest, LONG destPitch, int width,
+   int height, ScaleSetup& setup)
+{
+   LONG* columns = new LONG[width];
+
+   int sourceX = setup.xStart;
+   for(int x = 0; x < width; x++, sourceX += setup.xStep)
+      columns[x] = (sourceX >> 16) * Format::size;
+
+   int sourceY = setup.yStart;
+
+   for(int y = 0; y < height; y++, dest += destPitch,
+      sourceY += setup.yStep)
+   {
+      UCHAR* sourceLine = setup.source + ((sourceY >> 16) *
+         setup.sourcePitch);
+      UCHAR* destPixel = dest;
+
+      if(setup.transparent)
+      {
+         for(int x = 0; x < width; x++, destPixel += Format::size)
+         {
+            UINT pixel = Format::Read(sourceLine + columns[x]);
+
+            if(pixel != setup.key)
+               Format::Write(destPixel, pixel);
+         }
+      }
+
+      else
+      {
+         for(int x = 0; x < width; x++, destPixel += Format::size)
+            Format::Write(destPixel, Format::Read(sourceLine + columns[x]));
+      }
+   }
+
+   delete [] columns;
+}
+
+/*------------------------------------------------------------------------
+Function Name: BilinearKernel
+Parameters:
+   The same as NearestKernel
+Description:
+   This function draws a weighted average of the 4 source pixels around
+   each destination pixel. The samples are clamped to the edges of the
+   source. With a color key, a destination pixel is only drawn if the
+   nearest source pixel isn't transparent, and transparent neighbors
+   are replaced by the nearest pixel so that the key color doesn't
+   bleed into the edges.
+------------------------------------------------------------------------*/
+
+template <class Format>
+static void BilinearKernel(UCHAR* dest, LONG destPitch, int width,
+   int height, ScaleSetup& setup)
+{
+   int maxX = (setup.sourceWidth - 1) << 16;
+   int maxY = (setup.sourceHeight - 1) << 16;
+
+   //For each destination column: the offset of the left source pixel,
+   //the offset to the right one, and the weight of the right one
+   LONG* columns = new LONG[width * 3];
+
+   int sourceX = setup.xStart;
+   for(int x = 0; x < width; x++, sourceX += setup.xStep)
+   {
+      int clampedX = (sourceX < 0) ? 0 : ((sourceX > maxX) ? maxX : sourceX);
+
+      columns[(x * 3)] = (clampedX >> 16) * Format::size;
+      columns[(x * 3) + 1] = (clampedX < maxX) ? Format::size : 0;
+      columns[(x * 3) + 2] = (clampedX >> 8) & 0xFF;
+   }
+
+   int sourceY = setup.yStart;
+
+   for(int y = 0; y < height; y++, dest += destPitch,
+      sourceY += setup.yStep)
+   {
+      int clampedY = (sourceY < 0) ? 0 : ((sourceY > maxY) ? maxY : sourceY);
+
+      UCHAR* topLine = setup.source + ((clampedY >> 16) *
+         setup.sourcePitch);
+      UCHAR* bottomLine = (clampedY < maxY) ?
+         topLine + setup.sourcePitch : topLine;
+      UINT yWeight = (clampedY >> 8) & 0xFF;
+
+      UCHAR* destPixel = dest;
+      LONG* column = columns;
+
+      for(int x = 0; x < width; x++, destPixel += Format::size, column += 3)
+      {
+         UINT topLeft = Format::Read(topLine + column[0]);
+         UINT topRight = Format::Read(topLine + column[0] + column[1]);
+         UINT bottomLeft = Format::Read(bottomLine + column[0]);
+         UINT bottomRight = Format::Read(bottomLine + column[0] + column[1]);
+         UINT xWeight = column[2];
+
+         if(setup.transparent)
+         {
+            UINT nearest = (yWeight < 128) ?
+               ((xWeight < 128) ? topLeft : topRight) :
+               ((xWeight < 128) ? bottomLeft : bottomRight);
+
+            if(nearest == setup.key)
+               continue;
+
+            if(topLeft == setup.key)
+               topLeft = nearest;
+            if(topRight == setup.key)
+               topRight = nearest;
+            if(bottomLeft == setup.key)
+               bottomLeft = nearest;
+            if(bottomRight == setup.key)
+               bottomRight = nearest;
+         }
+
+         //Pixels that are all the same don't need to be filtered
+         if(topLeft == topRight && topLeft == bottomLeft &&
+            topLeft == bottomRight)
+         {
+            Format::Write(destPixel, topLeft);
+            continue;
+         }
+
+         UINT top = Interpolate(Format::ToRGB(topLeft),
+            Format::ToRGB(topRight), xWeight);
+         UINT bottom = Interpolate(Format::ToRGB(bottomLeft),
+            Format::ToRGB(bottomRight), xWeight);
+
+         Format::Write(destPixel,
+            Format::FromRGB(Interpolate(top, bottom, yWeight)));
+      }
+   }
+
+   delete [] columns;
+}
+
+void FC ScaleKernels::Nearest16(UCHAR* dest, LONG destPitch, int width,
+   int height, ScaleSetup& setup)
+{
+   NearestKernel<Format565>(dest, destPitch, width, height, setup);
+}
+
+void FC ScaleKernels::Nearest24(UCHAR* dest, LONG destPitch, int width,
+   int height, ScaleSetup& setup)
+{
+   NearestKernel<Format24>(dest, destPitch, width, height, setup);
+}
+
+void FC ScaleKernels::Nearest32(UCHAR* dest, LONG destPitch, int width,
+   int height, ScaleSetup& setup)
+{
+   NearestKernel<Format32>(dest, destPitch, width, height, setup);
+}
+
+void FC ScaleKernels::Bilinear565(UCHAR* dest, LONG destPitch, int width,
+   int height, ScaleSetup& setup)
+{
+   BilinearKernel<Format565>(dest, destPitch, width, height, setup);
+}
+
+void FC ScaleKernels::Bilinear555(UCHAR* dest, LONG destPitch, int width,
+   int height, ScaleSetup& setup)
+{
+   BilinearKernel<Format555>(dest, destPitch, width, height, setup);
+}
+
+void FC ScaleKernels::Bilinear24(UCHAR* dest, LONG destPitch, int width,
+   int height, ScaleSetup& setup)
+{
+   BilinearKernel<Format24>(dest, destPitch, width, height, setup);
+}
+
+void FC ScaleKernels::Bilinear32(UCHAR* dest, LONG destPitch, int width,
+   int height, ScaleSetup& setup)
+{
+   BilinearKernel<Format32>(dest, destPitch, width, height, setup);
+}
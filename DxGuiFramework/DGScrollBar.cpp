@@ -116,11 +116,13 @@ void FC ScrollBar::OnCreate()
    {
       Bitmap* bitmap = dgGraphics->GetBitmap(IDB_UP_ARROW);
       if(bitmap == NULL)
-         dgGraphics->LoadBitmap(IDB_UP_ARROW, 1, "Bitmaps\\Arrow_Up.bmp");
+         dgGraphics->LoadPackedBitmap(IDB_UP_ARROW, 1, 
+            "Bitmaps\\Arrow_Up.bmp");
 
       bitmap = dgGraphics->GetBitmap(IDB_DOWN_ARROW);
       if(bitmap == NULL)
-         dgGraphics->LoadBitmap(IDB_DOWN_ARROW, 1, "Bitmaps\\Arrow_Down.bmp");
+         dgGraphics->LoadPackedBitmap(IDB_DOWN_ARROW, 1, 
+            "Bitmaps\\Arrow_Down.bmp");
 
       upButton->SetBitmapID(IDB_UP_ARROW);
       downButton->SetBitmapID(IDB_DOWN_ARROW);
@@ -131,11 +133,13 @@ void FC ScrollBar::OnCreate()
    {
       Bitmap* bitmap = dgGraphics->GetBitmap(IDB_LEFT_ARROW);
       if(bitmap == NULL)
-         dgGraphics->LoadBitmap(IDB_LEFT_ARROW, 1, "Bitmaps\\Arrow_Left.bmp");
+         dgGraphics->LoadPackedBitmap(IDB_LEFT_ARROW, 1, 
+            "Bitmaps\\Arrow_Left.bmp");
 
       bitmap = dgGraphics->GetBitmap(IDB_RIGHT_ARROW);
       if(bitmap == NULL)
-         dgGraphics->LoadBitmap(IDB_RIGHT_ARROW, 1, "Bitmaps\\Arrow_Right.bmp");
+         dgGraphics->LoadPackedBitmap(IDB_RIGHT_ARROW, 1, 
+            "Bitmaps\\Arrow_Right.bmp");
 
       upButton->SetBitmapID(IDB_LEFT_ARROW);
       downButton->SetBitmapID(IDB_RIGHT_ARROW);
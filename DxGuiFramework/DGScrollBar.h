@@ -47,6 +47,8 @@ namespace DG
       void SetLineValue(int value);
       int GetLineValue(void) {return lineValue;}
 
+      bool FC IsOpaque(void) {return true;}
+
    protected:
       void FC OnCreate(void);
       void FC OnDrawWindow(WindowSurface* surface);
@@ -131,6 +131,18 @@ namespace DG
          return rect;
       }
 
+      //Returns the rectangle with the corners in the right order and an
+      //exclusive right and bottom, which is what clip lists are made of
+      RECT ToClipRECT(void)
+      {
+         RECT rect;
+         rect.left = (left < right) ? left : right;
+         rect.right = ((left < right) ? right : left) + 1;
+         rect.top = (top < bottom) ? top : bottom;
+         rect.bottom = ((top < bottom) ? bottom : top) + 1;
+         return rect;
+      }
+
       void Offset(int dx, int dy)
       {
          left += dx;
@@ -236,6 +248,58 @@ namespace DG
          left += dx;
          top += dy;
       }
+
+      bool IsEmpty(void) {return width <= 0 || height <= 0;}
+
+      bool Intersects(Area& area)
+      {
+         if(!IsEmpty() && !area.IsEmpty() &&
+            left <= area.Right() && area.left <= Right() &&
+            top <= area.Bottom() && area.top <= Bottom())
+            return true;
+         else
+            return false;
+      }
+
+      //Shrinks the area to the part that is also within the other area.
+      //If the areas don't overlap, the area will be empty.
+      void Intersect(Area& area)
+      {
+         int right = (Right() < area.Right()) ? Right() : area.Right();
+         int bottom = (Bottom() < area.Bottom()) ? Bottom() : area.Bottom();
+
+         if(area.left > left)
+            left = area.left;
+         if(area.top > top)
+            top = area.top;
+
+         width = (right - left) + 1;
+         height = (bottom - top) + 1;
+      }
+
+      //Grows the area so that it also covers the other area
+      void Union(Area& area)
+      {
+         if(area.IsEmpty())
+            return;
+
+         if(IsEmpty())
+         {
+            SetArea(area.left, area.top, area.width, area.height);
+            return;
+         }
+
+         int right = (Right() > area.Right()) ? Right() : area.Right();
+         int bottom = (Bottom() > area.Bottom()) ? Bottom() : area.Bottom();
+
+         if(area.left < left)
+            left = area.left;
+         if(area.top < top)
+            top = area.top;
+
+         width = (right - left) + 1;
+         height = (bottom - top) + 1;
+      }
    };
 
    class WindowSettings
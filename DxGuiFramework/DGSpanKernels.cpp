@@ -0,0 +1,327 @@
+/*------------------------------------------------------------------------
+File Name: DGSpanKernels.cpp
+Description: This file contains the implementation of the fill kernels,
+   which fill rectangles in a locked surface or pixel buffer. There is a
+   plain version and an SSE2 version for every pixel size.
+Version:
+   1.0.0    28.07.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+#include <emmintrin.h>
+
+using namespace DG;
+
+/*------------------------------------------------------------------------
+Function Name: Select
+Parameters:
+   int pixelSize : the size of a pixel in bytes, which is 2, 3, or 4
+Returns:
+   The fastest fill kernel for the pixel size that the processor supports
+Description:
+   This function chooses the fill kernel for a pixel size. The SSE2
+   kernels are only chosen when the processor supports SSE2.
+------------------------------------------------------------------------*/
+
+FillKernel FC FillKernels::Select(int pixelSize)
+{
+   bool sse2 = IsSSE2Supported();
+
+   switch(pixelSize)
+   {
+      case 2:
+         return sse2 ? Fill16SSE2 : Fill16;
+      case 3:
+         return sse2 ? Fill24SSE2 : Fill24;
+      default:
+         return sse2 ? Fill32SSE2 : Fill32;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: IsSSE2Supported
+Parameters:
+Returns:
+   true if the processor supports SSE2, false if it doesn't
+Description:
+   This function asks the processor whether it supports SSE2. The
+   answer is only looked up the first time the function is called.
+------------------------------------------------------------------------*/
+
+bool FC FillKernels::IsSSE2Supported()
+{
+   static int sse2Support = -1;
+
+   if(sse2Support == -1)
+   {
+#if defined(_M_IX86)
+      UINT features = 0;
+
+      //Processors which don't know the cpuid instruction don't have SSE2
+      //either, so an exception just means that there is no SSE2
+      __try
+      {
+         __asm
+         {
+            mov eax, 1
+            cpuid
+            mov features, edx
+         }
+      }
+      __except(EXCEPTION_EXECUTE_HANDLER)
+      {
+         features = 0;
+      }
+
+      //SSE2 support is bit 26 of the feature flags
+      sse2Support = (features & (1 << 26)) ? 1 : 0;
+#elif defined(_M_X64) || defined(__x86_64__)
+      //Every 64-bit processor supports SSE2
+      sse2Support = 1;
+#else
+      sse2Support = 0;
+#endif
+   }
+
+   return sse2Support == 1;
+}
+
+//Plain Kernels
+
+/*------------------------------------------------------------------------
+Function Name: Fill16
+Parameters:
+   UCHAR* dest : the first pixel of the area to be filled
+   LONG pitch : the number of bytes from one line to the next
+   int width : the width of the area in pixels
+   int height : the height of the area in pixels
+   UINT pixel : the 16-bit pixel value to fill the area with
+Description:
+   This function fills an area of 16-bit pixels, writing 2 pixels at a
+   time wherever it can.
+------------------------------------------------------------------------*/
+
+void FC FillKernels::Fill16(UCHAR* dest, LONG pitch, int width, int height,
+                            UINT pixel)
+{
+   UINT pixelPair = (pixel & 0xFFFF) | (pixel << 16);
+
+   for(int y = 0; y < height; y++, dest += pitch)
+   {
+      USHORT* line = (USHORT*)dest;
+      int count = width;
+
+      //Write a single pixel first if the line doesn't start on a 32-bit
+      //boundary
+      if((UINT_PTR(line) & 2) && count > 0)
+      {
+         *line++ = USHORT(pixel);
+         count--;
+      }
+
+      UINT* pairs = (UINT*)line;
+      for(; count >= 2; count -= 2)
+         *pairs++ = pixelPair;
+
+      if(count > 0)
+         *(USHORT*)pairs = USHORT(pixel);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Fill24
+Parameters:
+   UCHAR* dest : the first pixel of the area to be filled
+   LONG pitch : the number of bytes from one line to the next
+   int width : the width of the area in pixels
+   int height : the height of the area in pixels
+   UINT pixel : the 24-bit pixel value to fill the area with
+Description:
+   This function fills an area of 24-bit pixels. 4 pixels fit exactly
+   into 3 32-bit words, so the pixels are written as groups of 3 words
+   rather than one byte at a time.
+------------------------------------------------------------------------*/
+
+void FC FillKernels::Fill24(UCHAR* dest, LONG pitch, int width, int height,
+                            UINT pixel)
+{
+   pixel &= 0x00FFFFFF;
+
+   //The 3 words which hold 4 pixels
+   UINT word0 = pixel | (pixel << 24);
+   UINT word1 = (pixel >> 8) | (pixel << 16);
+   UINT word2 = (pixel >> 16) | (pixel << 8);
+
+   for(int y = 0; y < height; y++, dest += pitch)
+   {
+      UINT* words = (UINT*)dest;
+      int count = width;
+
+      for(; count >= 4; count -= 4)
+      {
+         words[0] = word0;
+         words[1] = word1;
+         words[2] = word2;
+         words += 3;
+      }
+
+      SpanKernels<Pixel24>::HorizontalSpan((UCHAR*)words, count, pixel);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Fill32
+Parameters:
+   UCHAR* dest : the first pixel of the area to be filled
+   LONG pitch : the number of bytes from one line to the next
+   int width : the width of the area in pixels
+   int height : the height of the area in pixels
+   UINT pixel : the 32-bit pixel value to fill the area with
+Description:
+   This function fills an area of 32-bit pixels.
+------------------------------------------------------------------------*/
+
+void FC FillKernels::Fill32(UCHAR* dest, LONG pitch, int width, int height,
+                            UINT pixel)
+{
+   for(int y = 0; y < height; y++, dest += pitch)
+   {
+      UINT* line = (UINT*)dest;
+
+      for(int x = 0; x < width; x++)
+         line[x] = pixel;
+   }
+}
+
+//SSE2 Kernels
+
+/*------------------------------------------------------------------------
+Function Name: Fill16SSE2
+Parameters:
+   UCHAR* dest : the first pixel of the area to be filled
+   LONG pitch : the number of bytes from one line to the next
+   int width : the width of the area in pixels
+   int height : the height of the area in pixels
+   UINT pixel : the 16-bit pixel value to fill the area with
+Description:
+   This function fills an area of 16-bit pixels, writing 8 pixels at a
+   time with aligned SSE2 stores. The pixels before the first 16-byte
+   boundary and after the last one are written one at a time.
+------------------------------------------------------------------------*/
+
+void FC FillKernels::Fill16SSE2(UCHAR* dest, LONG pitch, int width,
+                                int height, UINT pixel)
+{
+   __m128i pixels = _mm_set1_epi16(short(pixel));
+
+   for(int y = 0; y < height; y++, dest += pitch)
+   {
+      USHORT* line = (USHORT*)dest;
+      int count = width;
+
+      while((UINT_PTR(line) & 15) && count > 0)
+      {
+         *line++ = USHORT(pixel);
+         count--;
+      }
+
+      for(; count >= 8; count -= 8, line += 8)
+         _mm_store_si128((__m128i*)line, pixels);
+
+      while(count-- > 0)
+         *line++ = USHORT(pixel);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Fill24SSE2
+Parameters:
+   UCHAR* dest : the first pixel of the area to be filled
+   LONG pitch : the number of bytes from one line to the next
+   int width : the width of the area in pixels
+   int height : the height of the area in pixels
+   UINT pixel : the 24-bit pixel value to fill the area with
+Description:
+   This function fills an area of 24-bit pixels. 16 pixels fit exactly
+   into 3 SSE2 registers, so the pixels are written as groups of 3
+   stores. What is left over is written as groups of 3 32-bit words and
+   then one pixel at a time.
+------------------------------------------------------------------------*/
+
+void FC FillKernels::Fill24SSE2(UCHAR* dest, LONG pitch, int width,
+                                int height, UINT pixel)
+{
+   pixel &= 0x00FFFFFF;
+
+   //The 3 words which hold 4 pixels
+   UINT word0 = pixel | (pixel << 24);
+   UINT word1 = (pixel >> 8) | (pixel << 16);
+   UINT word2 = (pixel >> 16) | (pixel << 8);
+
+   //The 3 registers which hold 16 pixels
+   __m128i pixels0 = _mm_setr_epi32(word0, word1, word2, word0);
+   __m128i pixels1 = _mm_setr_epi32(word1, word2, word0, word1);
+   __m128i pixels2 = _mm_setr_epi32(word2, word0, word1, word2);
+
+   for(int y = 0; y < height; y++, dest += pitch)
+   {
+      UCHAR* line = dest;
+      int count = width;
+
+      //A 24-bit line can't be aligned to the pattern, so the stores
+      //are unaligned
+      for(; count >= 16; count -= 16, line += 48)
+      {
+         _mm_storeu_si128((__m128i*)line, pixels0);
+         _mm_storeu_si128((__m128i*)(line + 16), pixels1);
+         _mm_storeu_si128((__m128i*)(line + 32), pixels2);
+      }
+
+      for(; count >= 4; count -= 4, line += 12)
+      {
+         ((UINT*)line)[0] = word0;
+         ((UINT*)line)[1] = word1;
+         ((UINT*)line)[2] = word2;
+      }
+
+      SpanKernels<Pixel24>::HorizontalSpan(line, count, pixel);
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Fill32SSE2
+Parameters:
+   UCHAR* dest : the first pixel of the area to be filled
+   LONG pitch : the number of bytes from one line to the next
+   int width : the width of the area in pixels
+   int height : the height of the area in pixels
+   UINT pixel : the 32-bit pixel value to fill the area with
+Description:
+   This function fills an area of 32-bit pixels, writing 4 pixels at a
+   time with aligned SSE2 stores. The pixels before the first 16-byte
+   boundary and after the last one are written one at a time.
+------------------------------------------------------------------------*/
+
+void FC FillKernels::Fill32SSE2(UCHAR* dest, LONG pitch, int width,
+                                int height, UINT pixel)
+{
+   __m128i pixels = _mm_set1_epi32(int(pixel));
+
+   for(int y = 0; y < height; y++, dest += pitch)
+   {
+      UINT* line = (UINT*)dest;
+      int count = width;
+
+      while((UINT_PTR(line) & 15) && count > 0)
+      {
+         *line++ = pixel;
+         count--;
+      }
+
+      for(; count >= 4; count -= 4, line += 4)
+         _mm_store_si128((__m128i*)line, pixels);
+
+      while(count-- > 0)
+         *line++ = pixel;
+   }
+}
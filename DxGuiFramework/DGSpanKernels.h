@@ -0,0 +1,427 @@
+/*------------------------------------------------------------------------
+File Name: DGSpanKernels.h
+Description: This file contains the DG::SpanKernels template class, which
+   holds the inner loops of the non-blit drawing functions. The kernels
+   are specialized at compile time for each pixel size, so the color
+   depth is only looked at once when a kernel is chosen and the pixel
+   value is only converted once per drawing call.
+Version:
+   1.0.0    21.07.2002  Created the file
+   1.1.0    28.07.2002  Added the fill kernels, which use SSE2 when the
+      processor supports it
+   1.2.0    04.08.2002  Added the line span kernel, which can start 
+      drawing a line in the middle so that lines can be clipped
+   1.3.0    18.08.2002  Added the blend kernels, which draw bitmaps with
+      an alpha channel
+   1.4.0    25.08.2002  Added the scale kernels, which stretch bitmaps
+      with nearest-neighbor or bilinear filtering
+   1.5.0    13.10.2002  Added the convert kernels, which turn the pixels
+      of a bitmap file into the pixel format of the screen
+------------------------------------------------------------------------*/
+
+#pragma once
+
+namespace DG
+{
+   //The pixel types that the kernels are specialized with. Each one
+   //knows its size in bytes and how to write a pixel value.
+   class Pixel16
+   {
+   public:
+      enum {size = 2};
+
+      static void Write(UCHAR* dest, UINT pixel)
+      {
+         *(USHORT*)dest = USHORT(pixel);
+      }
+   };
+
+   class Pixel24
+   {
+   public:
+      enum {size = 3};
+
+      //Due to the way an int is stored, the first byte is the *least*
+      //significant byte of the pixel value
+      static void Write(UCHAR* dest, UINT pixel)
+      {
+         dest[0] = UCHAR(pixel);
+         dest[1] = UCHAR(pixel >> 8);
+         dest[2] = UCHAR(pixel >> 16);
+      }
+   };
+
+   class Pixel32
+   {
+   public:
+      enum {size = 4};
+
+      static void Write(UCHAR* dest, UINT pixel)
+      {
+         *(UINT*)dest = pixel;
+      }
+   };
+
+   //A kernel which fills height lines of width pixels, starting at dest
+   typedef void (FC *FillKernel)(UCHAR* dest, LONG pitch, int width, 
+      int height, UINT pixel);
+
+   //The rectangle fill kernels. There is a plain version and an SSE2
+   //version for every pixel size, and Select() picks the fastest one
+   //that the processor supports.
+   class FillKernels
+   {
+   public:
+      static FillKernel FC Select(int pixelSize);
+      static bool FC IsSSE2Supported(void);
+
+      static void FC Fill16(UCHAR* dest, LONG pitch, int width, int height,
+         UINT pixel);
+      static void FC Fill24(UCHAR* dest, LONG pitch, int width, int height,
+         UINT pixel);
+      static void FC Fill32(UCHAR* dest, LONG pitch, int width, int height,
+         UINT pixel);
+
+      static void FC Fill16SSE2(UCHAR* dest, LONG pitch, int width, 
+         int height, UINT pixel);
+      static void FC Fill24SSE2(UCHAR* dest, LONG pitch, int width, 
+         int height, UINT pixel);
+      static void FC Fill32SSE2(UCHAR* dest, LONG pitch, int width, 
+         int height, UINT pixel);
+   };
+
+   //A kernel which blends height lines of width premultiplied 32-bit
+   //source pixels into the pixels at dest. The opacity from 0 to 255 is
+   //applied to the whole bitmap.
+   typedef void (FC *BlendKernel)(UCHAR* dest, LONG destPitch, 
+      UCHAR* source, LONG sourcePitch, int width, int height, UINT opacity);
+
+   //The alpha blend kernels. 16-bit pixels can be 5-6-5 or 5-5-5, so 
+   //Select() needs the green bits of the pixel format as well.
+   class BlendKernels
+   {
+   public:
+      static BlendKernel FC Select(int pixelSize, DWORD greenBitMask);
+
+      static void FC Blend565(UCHAR* dest, LONG destPitch, UCHAR* source,
+         LONG sourcePitch, int width, int height, UINT opacity);
+      static void FC Blend555(UCHAR* dest, LONG destPitch, UCHAR* source,
+         LONG sourcePitch, int width, int height, UINT opacity);
+      static void FC Blend24(UCHAR* dest, LONG destPitch, UCHAR* source,
+         LONG sourcePitch, int width, int height, UINT opacity);
+      static void FC Blend32(UCHAR* dest, LONG destPitch, UCHAR* source,
+         LONG sourcePitch, int width, int height, UINT opacity);
+
+      static void FC Blend565SSE2(UCHAR* dest, LONG destPitch, 
+         UCHAR* source, LONG sourcePitch, int width, int height, 
+         UINT opacity);
+      static void FC Blend555SSE2(UCHAR* dest, LONG destPitch, 
+         UCHAR* source, LONG sourcePitch, int width, int height, 
+         UINT opacity);
+      static void FC Blend24SSE2(UCHAR* dest, LONG destPitch, 
+         UCHAR* source, LONG sourcePitch, int width, int height, 
+         UINT opacity);
+      static void FC Blend32SSE2(UCHAR* dest, LONG destPitch, 
+         UCHAR* source, LONG sourcePitch, int width, int height, 
+         UINT opacity);
+   };
+
+   //Describes the source of a scaled blit and how it is stepped through.
+   //The positions and steps are in source pixels, in 16.16 fixed point.
+   class ScaleSetup
+   {
+   public:
+      UCHAR* source;
+      LONG sourcePitch;
+      int sourceWidth;
+      int sourceHeight;
+
+      //The source position of the first destination pixel
+      int xStart;
+      int yStart;
+
+      //The distance in the source between 2 destination pixels
+      int xStep;
+      int yStep;
+
+      //Whether source pixels equal to the key are skipped
+      bool transparent;
+      UINT key;
+
+      void SetArea(RECT& destRect, int left, int top, UINT filter);
+   };
+
+   //A kernel which fills height lines of width pixels at dest with the
+   //scaled source
+   typedef void (FC *ScaleKernel)(UCHAR* dest, LONG destPitch, int width,
+      int height, ScaleSetup& setup);
+
+   //The scale kernels. The nearest-neighbor kernels only copy pixels, so
+   //they only depend on the pixel size, but the bilinear kernels need to
+   //know how the channels of 16-bit pixels are laid out.
+   class ScaleKernels
+   {
+   public:
+      static ScaleKernel FC Select(int pixelSize, DWORD greenBitMask,
+         UINT filter);
+
+      static void FC Nearest16(UCHAR* dest, LONG destPitch, int width,
+         int height, ScaleSetup& setup);
+      static void FC Nearest24(UCHAR* dest, LONG destPitch, int width,
+         int height, ScaleSetup& setup);
+      static void FC Nearest32(UCHAR* dest, LONG destPitch, int width,
+         int height, ScaleSetup& setup);
+
+      static void FC Bilinear565(UCHAR* dest, LONG destPitch, int width,
+         int height, ScaleSetup& setup);
+      static void FC Bilinear555(UCHAR* dest, LONG destPitch, int width,
+         int height, ScaleSetup& setup);
+      static void FC Bilinear24(UCHAR* dest, LONG destPitch, int width,
+         int height, ScaleSetup& setup);
+      static void FC Bilinear32(UCHAR* dest, LONG destPitch, int width,
+         int height, ScaleSetup& setup);
+   };
+
+   //The color lookup tables that the plain convert kernels use. The 
+   //tables of DG::Color are made again when the graphics mode changes, so
+   //each thread that converts pixels has tables of its own.
+   class ConvertTables
+   {
+   public:
+      UINT red[256];
+      UINT green[256];
+      UINT blue[256];
+
+      void Create(DDPIXELFORMAT& pixelFormat)
+      {
+         Color::Create24Or32BitLookupTable(pixelFormat.dwRBitMask, red);
+         Color::Create24Or32BitLookupTable(pixelFormat.dwGBitMask, green);
+         Color::Create24Or32BitLookupTable(pixelFormat.dwBBitMask, blue);
+      }
+   };
+
+   //A kernel which converts width 24-bit pixels from a bitmap file, with
+   //blue, green and red in that order, to the pixel format at dest,
+   //looking the channels up in tables
+   typedef void (FC *ConvertKernel)(UCHAR* dest, UCHAR* source, int width,
+      ConvertTables* tables);
+
+   //The convert kernels, which are used when bitmaps are loaded. The
+   //plain kernels work with any pixel format, while the SSE2 kernels and
+   //Copy24() give the same results for the common ones.
+   class ConvertKernels
+   {
+   public:
+      static ConvertKernel FC Select(int pixelSize, 
+         DDPIXELFORMAT& pixelFormat);
+
+      static void FC Convert16(UCHAR* dest, UCHAR* source, int width,
+         ConvertTables* tables);
+      static void FC Convert24(UCHAR* dest, UCHAR* source, int width,
+         ConvertTables* tables);
+      static void FC Convert32(UCHAR* dest, UCHAR* source, int width,
+         ConvertTables* tables);
+      static void FC Copy24(UCHAR* dest, UCHAR* source, int width,
+         ConvertTables* tables);
+
+      static void FC Convert565SSE2(UCHAR* dest, UCHAR* source, 
+         int width, ConvertTables* tables);
+      static void FC Convert555SSE2(UCHAR* dest, UCHAR* source, 
+         int width, ConvertTables* tables);
+      static void FC Convert32SSE2(UCHAR* dest, UCHAR* source, int width,
+         ConvertTables* tables);
+   };
+
+   template <class PixelType>
+   class SpanKernels
+   {
+   public:
+      //Draws length pixels from dest to the right
+      static void FC HorizontalSpan(UCHAR* dest, int length, UINT pixel);
+
+      //Draws length pixels from dest downwards
+      static void FC VerticalSpan(UCHAR* dest, int length, LONG pitch,
+         UINT pixel);
+
+      //Draws a line starting at dest. dx and dy are the positive distances
+      //along each axis, xStep and yStep are the byte offsets to the next
+      //pixel and the next line in the direction of the line.
+      static void FC Line(UCHAR* dest, int dx, int dy, int xStep,
+         LONG yStep, UINT pixel);
+
+      //Draws length pixels of a line starting at dest. major and minor 
+      //are the distances along the axis that is stepped along every pixel
+      //and the other axis, and errorFactor is the error of the line at
+      //dest. majorStep and minorStep are the byte offsets to the next 
+      //pixel along each axis.
+      static void FC LineSpan(UCHAR* dest, int length, int major, 
+         int minor, int errorFactor, LONG majorStep, LONG minorStep, 
+         UINT pixel);
+   };
+
+   //The kernels for one color depth, chosen when the graphics mode is set
+   class SpanKernelTable
+   {
+   public:
+      void (FC *HorizontalSpan)(UCHAR* dest, int length, UINT pixel);
+      void (FC *VerticalSpan)(UCHAR* dest, int length, LONG pitch,
+         UINT pixel);
+      void (FC *Line)(UCHAR* dest, int dx, int dy, int xStep, LONG yStep,
+         UINT pixel);
+      void (FC *LineSpan)(UCHAR* dest, int length, int major, int minor,
+         int errorFactor, LONG majorStep, LONG minorStep, UINT pixel);
+      FillKernel FillRect;
+      BlendKernel BlendRect;
+      ScaleKernel ScaleNearest;
+      ScaleKernel ScaleBilinear;
+      ConvertKernel ConvertLine;
+
+      //The tables that ConvertLine uses on the thread that draws
+      ConvertTables convertTables;
+
+      //The size of a pixel in bytes
+      int pixelSize;
+
+      void SelectKernels(UINT colorDepth, DDPIXELFORMAT& pixelFormat);
+   };
+
+   template <class PixelType>
+   void FC SpanKernels<PixelType>::HorizontalSpan(UCHAR* dest, int length,
+      UINT pixel)
+   {
+      for(int i = 0; i < length; i++)
+      {
+         PixelType::Write(dest, pixel);
+         dest += PixelType::size;
+      }
+   }
+
+   template <class PixelType>
+   void FC SpanKernels<PixelType>::VerticalSpan(UCHAR* dest, int length,
+      LONG pitch, UINT pixel)
+   {
+      for(int i = 0; i < length; i++)
+      {
+         PixelType::Write(dest, pixel);
+         dest += pitch;
+      }
+   }
+
+   template <class PixelType>
+   void FC SpanKernels<PixelType>::Line(UCHAR* dest, int dx, int dy,
+      int xStep, LONG yStep, UINT pixel)
+   {
+      //The error factor which tells us when to move to the next
+      //pixel line/column starts halfway, so that the steps are
+      //centered along the line and the line ends on its end point
+      if(dx > dy)
+         LineSpan(dest, dx + 1, dx, dy, dx >> 1, xStep, yStep, pixel);
+      else
+         LineSpan(dest, dy + 1, dy, dx, dy >> 1, yStep, xStep, pixel);
+   }
+
+   template <class PixelType>
+   void FC SpanKernels<PixelType>::LineSpan(UCHAR* dest, int length,
+      int major, int minor, int errorFactor, LONG majorStep, 
+      LONG minorStep, UINT pixel)
+   {
+      for(int i = 0; i < length; i++)
+      {
+         PixelType::Write(dest, pixel);
+
+         //Test to see if error has overflowed
+         errorFactor = errorFactor + minor;
+         if(errorFactor >= major)
+         {
+            errorFactor = errorFactor - major;
+            dest += minorStep;
+         }
+
+         dest += majorStep;
+      }
+   }
+
+   /*---------------------------------------------------------------------
+   Function Name: SelectKernels
+   Parameters:
+      UINT colorDepth : the color depth to choose the kernels for, which
+         can be CD_16BIT, CD_24BIT, or CD_32BIT
+      DDPIXELFORMAT& pixelFormat : the pixel format of the screen
+   Description:
+      This function fills the table with the kernels that match the
+      color depth.
+   ---------------------------------------------------------------------*/
+
+   inline void SpanKernelTable::SelectKernels(UINT colorDepth, 
+      DDPIXELFORMAT& pixelFormat)
+   {
+      DWORD greenBitMask = pixelFormat.dwGBitMask;
+
+      switch(colorDepth)
+      {
+         case CD_16BIT:
+            HorizontalSpan = SpanKernels<Pixel16>::HorizontalSpan;
+            VerticalSpan = SpanKernels<Pixel16>::VerticalSpan;
+            Line = SpanKernels<Pixel16>::Line;
+            LineSpan = SpanKernels<Pixel16>::LineSpan;
+            pixelSize = Pixel16::size;
+            break;
+         case CD_24BIT:
+            HorizontalSpan = SpanKernels<Pixel24>::HorizontalSpan;
+            VerticalSpan = SpanKernels<Pixel24>::VerticalSpan;
+            Line = SpanKernels<Pixel24>::Line;
+            LineSpan = SpanKernels<Pixel24>::LineSpan;
+            pixelSize = Pixel24::size;
+            break;
+         default:
+            HorizontalSpan = SpanKernels<Pixel32>::HorizontalSpan;
+            VerticalSpan = SpanKernels<Pixel32>::VerticalSpan;
+            Line = SpanKernels<Pixel32>::Line;
+            LineSpan = SpanKernels<Pixel32>::LineSpan;
+            pixelSize = Pixel32::size;
+            break;
+      }
+
+      FillRect = FillKernels::Select(pixelSize);
+      BlendRect = BlendKernels::Select(pixelSize, greenBitMask);
+      ScaleNearest = ScaleKernels::Select(pixelSize, greenBitMask, 
+         SF_NEAREST);
+      ScaleBilinear = ScaleKernels::Select(pixelSize, greenBitMask, 
+         SF_BILINEAR);
+      ConvertLine = ConvertKernels::Select(pixelSize, pixelFormat);
+      convertTables.Create(pixelFormat);
+   }
+
+   /*---------------------------------------------------------------------
+   Function Name: SetArea
+   Parameters:
+      RECT& destRect : the whole destination rectangle that the source is
+         stretched over, with an exclusive right and bottom
+      int left : the first destination column that is drawn
+      int top : the first destination line that is drawn
+      UINT filter : SF_NEAREST or SF_BILINEAR
+   Description:
+      This function works out the steps through the source and where in
+      the source to start, when the destination rectangle has been 
+      clipped to begin at left and top. Nearest-neighbor filtering 
+      samples from the upper-left corner of each source pixel like the
+      DirectDraw blitter, while bilinear filtering samples from the 
+      centers of the pixels so that the edges of the bitmap stay even.
+   ---------------------------------------------------------------------*/
+
+   inline void ScaleSetup::SetArea(RECT& destRect, int left, int top,
+      UINT filter)
+   {
+      xStep = (sourceWidth << 16) / (destRect.right - destRect.left);
+      yStep = (sourceHeight << 16) / (destRect.bottom - destRect.top);
+
+      xStart = (left - destRect.left) * xStep;
+      yStart = (top - destRect.top) * yStep;
+
+      if(filter == SF_BILINEAR)
+      {
+         xStart += (xStep >> 1) - 0x8000;
+         yStart += (yStep >> 1) - 0x8000;
+      }
+   }
+}
@@ -88,6 +88,18 @@ namespace DG
          dgGraphics->DrawTransparentScaledBitmap(area, bitmapID);
       }
 
+      void FC DrawAlphaBitmap(Point location, UINT bitmapID)
+      {
+         location.Offset(screenArea.left, screenArea.top);
+         dgGraphics->DrawAlphaBitmap(location, bitmapID);
+      }
+
+      void FC DrawAlphaBitmap(Point location, UINT bitmapID, BYTE opacity)
+      {
+         location.Offset(screenArea.left, screenArea.top);
+         dgGraphics->DrawAlphaBitmap(location, bitmapID, opacity);
+      }
+
       //GDI Drawing Functions
       void FC SetGDIFont(Font& font)
       {dgGraphics->SetGDIFont(font);}
@@ -113,15 +125,17 @@ namespace DG
       }
 
 
-      //The clipping functions for a DG::Surface will be implemented once
-      //DG::Graphics is capable of doing multiple clipping areas.
-
       //Clipping Functions
-      //void FC AddClippingArea(Rectangle& area);
-      //void FC RemoveClippingArea(void);
-      //void FC ClearClippingAreas(void);
+      void FC AddClippingArea(Rectangle& area);
+      void FC IntersectClippingArea(Rectangle& area);
+      void FC SubtractClippingArea(Rectangle& area);
+      void FC RemoveClippingArea(void);
+      void FC ClearClippingAreas(void);
+      void FC ExcludeScreenArea(Area& area);
 
    protected:
+      void FC ApplyClipping(void);
+
       //Stores the area on the screen that the surface represents,
       //surfaceArea.left and surfaceArea.top describe upper-left corner of 
       //the surface, surfaceArea.right and surfaceArea.bottom describe the
@@ -135,5 +149,14 @@ namespace DG
       //surface, which isn't the case when the upper-left portion of the window
       //being drawn is clipped.
       Point* windowOrg;
+
+      //The part of the surface that isn't covered by anything drawn on
+      //top of it, in screen coordinates
+      ClipRegion visibleRegion;
+
+      //The clipping areas added to the surface, in screen coordinates
+      ClipRegion clipList;
+      //Whether any clipping areas have been added to the surface
+      bool hasClipList;
    };
 }
@@ -0,0 +1,249 @@
+/*------------------------------------------------------------------------
+File Name: DGTextLayout.cpp
+Description: This file contains the implementation of the DG::TextLayout
+   class, which holds the line breaks and glyph positions of a string.
+Version:
+   1.0.0    15.09.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+
+using namespace DG;
+
+/*Constructor*/
+TextLayout::TextLayout()
+{
+   text = NULL;
+   maxWidth = 0;
+   flags = 0;
+   hash = 0;
+
+   width = 0;
+   height = 0;
+
+   lines = NULL;
+   numOfLines = 0;
+
+   glyphs = NULL;
+   numOfGlyphs = 0;
+
+   memoryUsage = 0;
+}
+
+/*Destructor*/
+TextLayout::~TextLayout()
+{
+   Destroy();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Hash
+Parameters:
+   char* text : the text to be laid out
+   int maxWidth : the width that lines are broken at
+   UINT flags : the layout flags, within TL_LAYOUT_FLAGS
+Returns:
+   A hash of everything that a layout is made from
+------------------------------------------------------------------------*/
+
+UINT FC TextLayout::Hash(char* text, int maxWidth, UINT flags)
+{
+   UINT value = (UINT(maxWidth) * 31) ^ flags;
+
+   for(UCHAR* character = (UCHAR*)text; *character != '\0'; character++)
+      value = (value * 33) ^ *character;
+
+   return value;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Create
+Parameters:
+   GlyphAtlas* atlas : the atlas of the font the text is drawn with
+   char* aText : the text to be laid out
+   int aMaxWidth : the width of the bounding rectangle, which only 
+      matters with DT_WORDBREAK
+   UINT aFlags : the layout flags, within TL_LAYOUT_FLAGS
+   UINT aHash : the hash of the text, the width and the flags
+Description:
+   This function breaks the text into lines and works out the pen 
+   position of each glyph. Unless DT_SINGLELINE is set, a line ends at a
+   carriage return, a line feed, or both. With DT_WORDBREAK, a line also
+   ends at the last space before the text gets wider than the maximum 
+   width, and the spaces there are skipped. Tabs are always expanded, 
+   like the GDI path does.
+------------------------------------------------------------------------*/
+
+void FC TextLayout::Create(GlyphAtlas* atlas, char* aText, int aMaxWidth,
+   UINT aFlags, UINT aHash)
+{
+   Destroy();
+
+   int textLength = (int)strlen(aText);
+
+   text = new char[textLength + 1];
+   strcpy(text, aText);
+   maxWidth = aMaxWidth;
+   flags = aFlags;
+   hash = aHash;
+
+   //There can't be more lines or glyphs than there are characters
+   lines = new TextLine[textLength + 1];
+   glyphs = new PlacedGlyph[textLength + 1];
+
+   bool singleLine = (flags & DT_SINGLELINE) != 0;
+   bool wordBreak = !singleLine && (flags & DT_WORDBREAK) != 0;
+   bool expandTabs = (flags & DT_EXPANDTABS) != 0;
+
+   char* line = text;
+
+   while(line != NULL)
+   {
+      TextLine& textLine = lines[numOfLines++];
+      textLine.firstGlyph = numOfGlyphs;
+
+      int penX = 0;
+      UCHAR previous = 0;
+      char* next = NULL;
+
+      //Where the line ends if it has to be broken at a space
+      char* breakPoint = NULL;
+      int breakWidth = 0;
+      int breakGlyph = 0;
+
+      for(char* position = line;; position++)
+      {
+         UCHAR character = UCHAR(*position);
+
+         if(character == '\0')
+         {
+            next = NULL;
+            break;
+         }
+
+         if(!singleLine && (character == '\r' || character == '\n'))
+         {
+            next = position + 1;
+
+            if(character == '\r' && *next == '\n')
+               next++;
+
+            break;
+         }
+
+         if(character == ' ')
+         {
+            breakPoint = position;
+            breakWidth = penX;
+            breakGlyph = numOfGlyphs;
+         }
+
+         if(character == '\t' && expandTabs)
+         {
+            penX = ((penX / atlas->GetTabWidth()) + 1) * 
+               atlas->GetTabWidth();
+            previous = 0;
+            continue;
+         }
+
+         if(character < GA_FIRST_CHAR)
+            continue;
+
+         penX += atlas->GetKerning(previous, character);
+         previous = character;
+
+         Glyph& glyph = atlas->GetGlyph(character);
+
+         if(glyph.numOfRuns > 0)
+         {
+            glyphs[numOfGlyphs].x = penX;
+            glyphs[numOfGlyphs].character = character;
+            numOfGlyphs++;
+         }
+
+         penX += glyph.advance;
+
+         if(wordBreak && penX > maxWidth && character != ' ' && 
+            breakPoint != NULL)
+         {
+            numOfGlyphs = breakGlyph;
+            penX = breakWidth;
+
+            next = breakPoint;
+
+            while(*next == ' ')
+               next++;
+
+            if(*next == '\0')
+               next = NULL;
+
+            break;
+         }
+      }
+
+      textLine.width = penX;
+      textLine.numOfGlyphs = numOfGlyphs - textLine.firstGlyph;
+
+      if(penX > width)
+         width = penX;
+
+      line = next;
+   }
+
+   height = numOfLines * atlas->GetLineHeight();
+
+   memoryUsage = (textLength + 1) * (1 + sizeof(TextLine) + 
+      sizeof(PlacedGlyph));
+}
+
+/*------------------------------------------------------------------------
+Function Name: Destroy
+Parameters:
+Description:
+   This function frees the layout.
+------------------------------------------------------------------------*/
+
+void FC TextLayout::Destroy(void)
+{
+   if(text != NULL)
+   {
+      delete[] text;
+      text = NULL;
+   }
+
+   if(lines != NULL)
+   {
+      delete[] lines;
+      lines = NULL;
+   }
+
+   if(glyphs != NULL)
+   {
+      delete[] glyphs;
+      glyphs = NULL;
+   }
+
+   numOfLines = 0;
+   numOfGlyphs = 0;
+   width = 0;
+   height = 0;
+   memoryUsage = 0;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Matches
+Parameters:
+   char* aText : a text
+   int aMaxWidth : the width that lines are broken at
+   UINT aFlags : the layout flags
+   UINT aHash : the hash of the text, the width and the flags
+Returns:
+   true if the layout was made from the same text, width and flags
+------------------------------------------------------------------------*/
+
+bool FC TextLayout::Matches(char* aText, int aMaxWidth, UINT aFlags,
+   UINT aHash)
+{
+   return text != NULL && hash == aHash && maxWidth == aMaxWidth && 
+      flags == aFlags && strcmp(text, aText) == 0;
+}
@@ -0,0 +1,80 @@
+/*------------------------------------------------------------------------
+File Name: DGTextLayout.h
+Description: This file contains the DG::TextLayout class, which holds
+   where the lines of a string break and where each of its glyphs goes,
+   so that text that is drawn again doesn't have to be laid out again.
+Version:
+   1.0.0    15.09.2002  Created the file
+------------------------------------------------------------------------*/
+
+#pragma once
+
+//The DrawText() flags that change how text is laid out. Alignment only
+//moves whole lines, so it isn't part of the layout.
+#define TL_LAYOUT_FLAGS    (DT_SINGLELINE | DT_WORDBREAK | DT_EXPANDTABS)
+
+namespace DG
+{
+   class GlyphAtlas;
+
+   //A glyph of a laid out string
+   class PlacedGlyph
+   {
+   public:
+      //The pen position of the glyph from the left of its line
+      int x;
+      UCHAR character;
+   };
+
+   //A line of a laid out string
+   class TextLine
+   {
+   public:
+      int width;
+
+      //The glyphs of the line in the layout. Glyphs without any
+      //covered pixels, like spaces, are left out.
+      int firstGlyph;
+      int numOfGlyphs;
+   };
+
+   class TextLayout
+   {
+   public:
+      TextLayout();
+      virtual ~TextLayout();
+
+      static UINT FC Hash(char* text, int maxWidth, UINT flags);
+
+      void FC Create(GlyphAtlas* atlas, char* aText, int aMaxWidth, 
+         UINT aFlags, UINT aHash);
+      void FC Destroy(void);
+      bool FC Matches(char* aText, int aMaxWidth, UINT aFlags, UINT aHash);
+
+      int GetWidth(void) {return width;}
+      int GetHeight(void) {return height;}
+      int GetNumOfLines(void) {return numOfLines;}
+      TextLine& GetLine(int index) {return lines[index];}
+      PlacedGlyph& GetGlyph(int index) {return glyphs[index];}
+      UINT GetMemoryUsage(void) {return memoryUsage;}
+
+   private:
+      //What the layout was made from. The text is copied, so that the
+      //layout can't be matched by a buffer that has changed since.
+      char* text;
+      int maxWidth;
+      UINT flags;
+      UINT hash;
+
+      int width;
+      int height;
+
+      TextLine* lines;
+      int numOfLines;
+
+      PlacedGlyph* glyphs;
+      int numOfGlyphs;
+
+      UINT memoryUsage;
+   };
+}
@@ -0,0 +1,448 @@
+/*------------------------------------------------------------------------
+File Name: DGTileRasterizer.cpp
+Description: This file contains the implementation of the 
+   DG::TileRasterizer class, which rasterizes the recorded drawing of a
+   frame in tiles on several threads at once.
+Version:
+   1.0.0    29.09.2002  Created the file
+------------------------------------------------------------------------*/
+
+#include "DxGuiFramework.h"
+#include <process.h>
+
+using namespace DG;
+
+/*------------------------------------------------------------------------
+Function Name: Constructor
+Parameters:
+   Graphics* aGraphics : the object whose drawing is rasterized
+   int threads : the number of threads to rasterize with, including the
+      thread that draws, or 0 for one for each processor
+Description:
+   The worker threads are started here and wait until there is a frame
+   to rasterize.
+------------------------------------------------------------------------*/
+
+TileRasterizer::TileRasterizer(Graphics* aGraphics, int threads)
+{
+   graphics = aGraphics;
+
+   maxNumOfCommands = 1024;
+   commands = new TileCommand[maxNumOfCommands];
+   numOfCommands = 0;
+
+   maxNumOfClipRects = 256;
+   clipRects = new RECT[maxNumOfClipRects];
+   numOfClipRects = 0;
+
+   frameWidth = 0;
+   frameHeight = 0;
+   tilesAcross = 0;
+   numOfTiles = 0;
+
+   maxNumOfTiles = 0;
+   firstEntries = NULL;
+   lastEntries = NULL;
+
+   maxNumOfEntries = 4096;
+   entries = new TileEntry[maxNumOfEntries];
+   numOfEntries = 0;
+
+   if(threads <= 0)
+   {
+      SYSTEM_INFO systemInfo;
+      GetSystemInfo(&systemInfo);
+      threads = systemInfo.dwNumberOfProcessors;
+   }
+
+   if(threads > TR_MAX_THREADS)
+      threads = TR_MAX_THREADS;
+
+   numOfWorkers = threads;
+   terminate = false;
+
+   for(int i = 0; i < numOfWorkers; i++)
+   {
+      TileWorker& worker = workers[i];
+
+      worker.rasterizer = this;
+      worker.index = i;
+      worker.thread = NULL;
+      worker.startEvent = NULL;
+      worker.doneEvent = NULL;
+      worker.firstTile = 0;
+      worker.lastTile = 0;
+      InitializeCriticalSection(&worker.queueLock);
+
+      //The first worker is the thread that calls Rasterize()
+      if(i == 0)
+         continue;
+
+      worker.startEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+      worker.doneEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+      unsigned threadID;
+      worker.thread = (HANDLE)_beginthreadex(NULL, 0, WorkerThread, 
+         &worker, 0, &threadID);
+
+      if(worker.thread == NULL)
+      {
+         CloseHandle(worker.startEvent);
+         CloseHandle(worker.doneEvent);
+         DeleteCriticalSection(&worker.queueLock);
+
+         //Rasterize with the threads that could be started
+         numOfWorkers = i;
+         break;
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: Destructor
+Description:
+   The worker threads are told to end and waited for.
+------------------------------------------------------------------------*/
+
+TileRasterizer::~TileRasterizer()
+{
+   terminate = true;
+
+   for(int i = 0; i < numOfWorkers; i++)
+   {
+      TileWorker& worker = workers[i];
+
+      if(worker.thread != NULL)
+      {
+         SetEvent(worker.startEvent);
+         WaitForSingleObject(worker.thread, INFINITE);
+
+         CloseHandle(worker.thread);
+         CloseHandle(worker.startEvent);
+         CloseHandle(worker.doneEvent);
+      }
+
+      DeleteCriticalSection(&worker.queueLock);
+   }
+
+   delete[] commands;
+   delete[] clipRects;
+   delete[] entries;
+   delete[] firstEntries;
+   delete[] lastEntries;
+}
+
+/*------------------------------------------------------------------------
+Function Name: AddClipRect
+Parameters:
+   RECT& clipRect : a clipping rectangle, with an exclusive right and 
+      bottom
+Description:
+   This function adds a clipping rectangle that commands can refer to.
+------------------------------------------------------------------------*/
+
+void FC TileRasterizer::AddClipRect(RECT& clipRect)
+{
+   if(numOfClipRects == maxNumOfClipRects)
+   {
+      RECT* newClipRects = new RECT[maxNumOfClipRects * 2];
+      memcpy(newClipRects, clipRects, maxNumOfClipRects * sizeof(RECT));
+      delete[] clipRects;
+
+      clipRects = newClipRects;
+      maxNumOfClipRects *= 2;
+   }
+
+   clipRects[numOfClipRects++] = clipRect;
+}
+
+/*------------------------------------------------------------------------
+Function Name: AddCommand
+Parameters:
+   TileCommand& command : the command to be recorded
+Description:
+   This function adds a command to the end of the frame, and to the end
+   of the lists of the tiles that its bounds reach. The first command of
+   a frame takes the size of the frame from the resolution of the 
+   graphics object, which can't change until the frame is rasterized or
+   cleared.
+------------------------------------------------------------------------*/
+
+void FC TileRasterizer::AddCommand(TileCommand& command)
+{
+   if(numOfCommands == 0)
+   {
+      const Point& res = graphics->GetResolution();
+      SetFrameSize(res.x, res.y);
+   }
+
+   if(numOfCommands == maxNumOfCommands)
+   {
+      TileCommand* newCommands = new TileCommand[maxNumOfCommands * 2];
+      memcpy(newCommands, commands, 
+         maxNumOfCommands * sizeof(TileCommand));
+      delete[] commands;
+
+      commands = newCommands;
+      maxNumOfCommands *= 2;
+   }
+
+   commands[numOfCommands] = command;
+
+   int left = max(command.bounds.left, 0);
+   int top = max(command.bounds.top, 0);
+   int right = min(command.bounds.right, frameWidth);
+   int bottom = min(command.bounds.bottom, frameHeight);
+
+   if(left < right && top < bottom)
+   {
+      int lastColumn = (right - 1) / TR_TILE_SIZE;
+      int lastRow = (bottom - 1) / TR_TILE_SIZE;
+
+      for(int row = top / TR_TILE_SIZE; row <= lastRow; row++)
+      {
+         for(int column = left / TR_TILE_SIZE; column <= lastColumn; 
+            column++)
+            AddEntry((row * tilesAcross) + column, numOfCommands);
+      }
+   }
+
+   numOfCommands++;
+}
+
+//Sets up the tiles of a frame of a new size, with no commands in them
+void FC TileRasterizer::SetFrameSize(int width, int height)
+{
+   frameWidth = max(width, 0);
+   frameHeight = max(height, 0);
+   tilesAcross = (frameWidth + TR_TILE_SIZE - 1) / TR_TILE_SIZE;
+   numOfTiles = tilesAcross * 
+      ((frameHeight + TR_TILE_SIZE - 1) / TR_TILE_SIZE);
+
+   if(numOfTiles > maxNumOfTiles)
+   {
+      delete[] firstEntries;
+      delete[] lastEntries;
+
+      maxNumOfTiles = numOfTiles;
+      firstEntries = new int[maxNumOfTiles];
+      lastEntries = new int[maxNumOfTiles];
+   }
+
+   for(int i = 0; i < numOfTiles; i++)
+   {
+      firstEntries[i] = -1;
+      lastEntries[i] = -1;
+   }
+
+   numOfEntries = 0;
+}
+
+//Adds a command to the end of the list of a tile
+void FC TileRasterizer::AddEntry(int tile, int command)
+{
+   if(numOfEntries == maxNumOfEntries)
+   {
+      TileEntry* newEntries = new TileEntry[maxNumOfEntries * 2];
+      memcpy(newEntries, entries, maxNumOfEntries * sizeof(TileEntry));
+      delete[] entries;
+
+      entries = newEntries;
+      maxNumOfEntries *= 2;
+   }
+
+   TileEntry& entry = entries[numOfEntries];
+   entry.command = command;
+   entry.next = -1;
+
+   if(lastEntries[tile] < 0)
+      firstEntries[tile] = numOfEntries;
+   else
+      entries[lastEntries[tile]].next = numOfEntries;
+
+   lastEntries[tile] = numOfEntries;
+   numOfEntries++;
+}
+
+/*------------------------------------------------------------------------
+Function Name: Rasterize
+Parameters:
+Description:
+   This function rasterizes the recorded commands and then forgets them.
+   The buffer is split into tiles, and each tile runs through the list
+   of commands that reach it, clipped to the tile, in the order they 
+   were recorded. Since no two threads draw in the same tile, and clipping 
+   doesn't change what the drawing functions draw, the result is the
+   same as drawing the commands one after another. Each worker starts 
+   with a run of tiles that are next to each other and steals from the
+   other workers when it is done. The drawing buffer must be locked.
+------------------------------------------------------------------------*/
+
+void FC TileRasterizer::Rasterize(void)
+{
+   if(numOfCommands == 0 || numOfTiles == 0)
+   {
+      Clear();
+      return;
+   }
+
+   int i;
+
+   for(i = 0; i < numOfWorkers; i++)
+   {
+      workers[i].firstTile = (numOfTiles * i) / numOfWorkers;
+      workers[i].lastTile = (numOfTiles * (i + 1)) / numOfWorkers;
+   }
+
+   for(i = 1; i < numOfWorkers; i++)
+      SetEvent(workers[i].startEvent);
+
+   RasterizeTiles(workers[0]);
+
+   for(i = 1; i < numOfWorkers; i++)
+      WaitForSingleObject(workers[i].doneEvent, INFINITE);
+
+   Clear();
+}
+
+/*------------------------------------------------------------------------
+Function Name: Clear
+Parameters:
+Description:
+   This function forgets the recorded commands without drawing them.
+------------------------------------------------------------------------*/
+
+void FC TileRasterizer::Clear(void)
+{
+   numOfCommands = 0;
+   numOfClipRects = 0;
+   numOfEntries = 0;
+}
+
+/*------------------------------------------------------------------------
+Function Name: WorkerThread
+Parameters:
+   void* parameter : the TileWorker of the thread
+Returns:
+   0
+Description:
+   This is the function of each worker thread, which rasterizes tiles
+   whenever it is told to.
+------------------------------------------------------------------------*/
+
+unsigned __stdcall TileRasterizer::WorkerThread(void* parameter)
+{
+   TileWorker* worker = (TileWorker*)parameter;
+   TileRasterizer* rasterizer = worker->rasterizer;
+
+   while(true)
+   {
+      WaitForSingleObject(worker->startEvent, INFINITE);
+
+      if(rasterizer->terminate)
+         break;
+
+      rasterizer->RasterizeTiles(*worker);
+
+      SetEvent(worker->doneEvent);
+   }
+
+   return 0;
+}
+
+/*------------------------------------------------------------------------
+Function Name: RasterizeTiles
+Parameters:
+   TileWorker& worker : the worker that the calling thread belongs to
+Description:
+   This function rasterizes tiles until there are none left anywhere.
+------------------------------------------------------------------------*/
+
+void FC TileRasterizer::RasterizeTiles(TileWorker& worker)
+{
+   int tile;
+
+   while(GetTile(worker, tile))
+      RasterizeTile(tile);
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetTile
+Parameters:
+   TileWorker& worker : the worker that needs a tile
+   int& tile : receives the index of the tile
+Returns:
+   true if there was a tile left, false if all the tiles have been taken
+Description:
+   This function takes the next tile from the front of the worker's own
+   queue, or steals the last tile of another worker's queue if its own
+   is empty.
+------------------------------------------------------------------------*/
+
+bool FC TileRasterizer::GetTile(TileWorker& worker, int& tile)
+{
+   bool found = false;
+
+   EnterCriticalSection(&worker.queueLock);
+
+   if(worker.firstTile < worker.lastTile)
+   {
+      tile = worker.firstTile++;
+      found = true;
+   }
+
+   LeaveCriticalSection(&worker.queueLock);
+
+   for(int i = 1; i < numOfWorkers && !found; i++)
+   {
+      TileWorker& victim = workers[(worker.index + i) % numOfWorkers];
+
+      EnterCriticalSection(&victim.queueLock);
+
+      if(victim.firstTile < victim.lastTile)
+      {
+         tile = --victim.lastTile;
+         found = true;
+      }
+
+      LeaveCriticalSection(&victim.queueLock);
+   }
+
+   return found;
+}
+
+/*------------------------------------------------------------------------
+Function Name: RasterizeTile
+Parameters:
+   int tile : the index of the tile
+Description:
+   This function draws the commands in the list of a tile, clipped to 
+   the tile, in the order they were recorded.
+------------------------------------------------------------------------*/
+
+void FC TileRasterizer::RasterizeTile(int tile)
+{
+   RECT tileRect;
+   tileRect.left = (tile % tilesAcross) * TR_TILE_SIZE;
+   tileRect.top = (tile / tilesAcross) * TR_TILE_SIZE;
+   tileRect.right = min(tileRect.left + TR_TILE_SIZE, frameWidth);
+   tileRect.bottom = min(tileRect.top + TR_TILE_SIZE, frameHeight);
+
+   for(int i = firstEntries[tile]; i >= 0; i = entries[i].next)
+   {
+      TileCommand& command = commands[entries[i].command];
+      int lastClipRect = command.firstClipRect + command.numOfClipRects;
+
+      for(int j = command.firstClipRect; j < lastClipRect; j++)
+      {
+         RECT clipRect;
+         clipRect.left = max(clipRects[j].left, tileRect.left);
+         clipRect.top = max(clipRects[j].top, tileRect.top);
+         clipRect.right = min(clipRects[j].right, tileRect.right);
+         clipRect.bottom = min(clipRects[j].bottom, tileRect.bottom);
+
+         if(clipRect.left < clipRect.right && clipRect.top < clipRect.bottom)
+            graphics->RasterCommand(command, clipRect);
+      }
+   }
+}
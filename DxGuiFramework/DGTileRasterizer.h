@@ -0,0 +1,164 @@
+/*------------------------------------------------------------------------
+File Name: DGTileRasterizer.h
+Description: This file contains the DG::TileRasterizer class, which 
+   records the drawing of a frame and then rasterizes it in tiles on 
+   several threads at once.
+Version:
+   1.0.0    29.09.2002  Created the file
+   1.1.0    03.11.2002  Blits can draw part of their pixel buffer
+   1.2.0    15.12.2002  Commands are sorted into the tiles they reach
+      when they are recorded
+------------------------------------------------------------------------*/
+
+#pragma once
+
+//The width and height of a tile in pixels
+#define TR_TILE_SIZE          64
+
+//The most threads that a tile rasterizer can have
+#define TR_MAX_THREADS        32
+
+//The types of tile commands
+#define TC_FILL               1
+#define TC_LINE               2
+#define TC_BLIT               3
+#define TC_TRANSPARENTBLIT    4
+#define TC_RUNLENGTHBLIT      5
+#define TC_BLEND              6
+#define TC_STRETCH            7
+#define TC_GLYPH              8
+
+namespace DG
+{
+   class Graphics;
+   class TileRasterizer;
+
+   //A drawing call that has been recorded. Which members are used 
+   //depends on the type of the command.
+   class TileCommand
+   {
+   public:
+      UINT type;
+
+      //The pixels that the command can change, with an exclusive right
+      //and bottom. The tiles that this doesn't reach skip the command.
+      RECT bounds;
+
+      //The clipping rectangles of the command in the rasterizer, which
+      //are all on the screen
+      int firstClipRect;
+      int numOfClipRects;
+
+      //The location of a blit or a glyph, or the ends of a line
+      int x1, y1;
+      int x2, y2;
+
+      //The pixel value of a fill, a line or a glyph, or the transparent
+      //pixel value of a blit
+      UINT pixel;
+
+      //The opacity of a blend, the filter of a scaled blit, or the 
+      //character of a glyph
+      UINT parameter;
+
+      //Whether a scaled blit is transparent
+      bool transparent;
+
+      //The pixel buffer of a blit, the run-length sprite of a run-length
+      //blit, or the glyph atlas of a glyph
+      void* source;
+
+      //The part of the pixel buffer of a blit or a scaled blit that is 
+      //drawn, or NULL for all of it. This is where a packed bitmap is in
+      //its atlas.
+      RECT* sourceRect;
+   };
+
+   //A command in the list of the commands that reach a tile
+   class TileEntry
+   {
+   public:
+      int command;
+
+      //The next entry of the same tile, or -1 for the last one
+      int next;
+   };
+
+   //A thread of the rasterizer and the tiles it has left. When a worker
+   //runs out of tiles, it takes them from the back of the queues of the
+   //other workers.
+   class TileWorker
+   {
+   public:
+      TileRasterizer* rasterizer;
+      int index;
+
+      HANDLE thread;
+      HANDLE startEvent;
+      HANDLE doneEvent;
+
+      CRITICAL_SECTION queueLock;
+      int firstTile;
+      int lastTile;
+   };
+
+   class TileRasterizer
+   {
+   public:
+      TileRasterizer(Graphics* aGraphics, int threads);
+      virtual ~TileRasterizer();
+
+      int GetNumOfThreads(void) {return numOfWorkers;}
+      bool IsEmpty(void) {return numOfCommands == 0;}
+      int GetNumOfClipRects(void) {return numOfClipRects;}
+
+      void FC AddClipRect(RECT& clipRect);
+      void FC AddCommand(TileCommand& command);
+      void FC Rasterize(void);
+      void FC Clear(void);
+
+   private:
+      void FC SetFrameSize(int width, int height);
+      void FC AddEntry(int tile, int command);
+      static unsigned __stdcall WorkerThread(void* parameter);
+      void FC RasterizeTiles(TileWorker& worker);
+      bool FC GetTile(TileWorker& worker, int& tile);
+      void FC RasterizeTile(int tile);
+
+      Graphics* graphics;
+
+      //The commands of the frame, in the order they were recorded
+      TileCommand* commands;
+      int numOfCommands;
+      int maxNumOfCommands;
+
+      //The clipping rectangles of the commands
+      RECT* clipRects;
+      int numOfClipRects;
+      int maxNumOfClipRects;
+
+      //The size of the frame being recorded, and how many tiles it has
+      int frameWidth;
+      int frameHeight;
+      int tilesAcross;
+      int numOfTiles;
+
+      //The first and last entries of the commands that reach each tile,
+      //or -1 if there are none, so that a tile only goes through its own
+      //commands instead of all of them
+      int* firstEntries;
+      int* lastEntries;
+      int maxNumOfTiles;
+
+      TileEntry* entries;
+      int numOfEntries;
+      int maxNumOfEntries;
+
+      //The first worker is the thread that calls Rasterize()
+      TileWorker workers[TR_MAX_THREADS];
+      int numOfWorkers;
+
+      //Tells the worker threads to end
+      volatile bool terminate;
+   };
+}
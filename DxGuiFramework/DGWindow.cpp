@@ -36,6 +36,9 @@ Window::Window(UINT winID, bool control)
    windowShowing = false;
    drawChildWindows = true;
    parentClipping = true;
+   opaque = false;
+   backingStore = NULL;
+   displayList = NULL;
 
    parentWindow = NULL;
 
@@ -71,6 +74,9 @@ Window::Window(UINT winID, bool control, const Area& dimensions)
    windowShowing = true;
    drawChildWindows = true;
    parentClipping = true;
+   opaque = false;
+   backingStore = NULL;
+   displayList = NULL;
 
    parentWindow = NULL;
 
@@ -108,6 +114,9 @@ Window::Window(UINT winID, bool control, const Point& position,
    windowShowing = true;
    drawChildWindows = true;
    parentClipping = true;
+   opaque = false;
+   backingStore = NULL;
+   displayList = NULL;
 
    parentWindow = NULL;
 
@@ -149,6 +158,9 @@ Window::Window(UINT winID, bool control, int xPos, int yPos,
    windowShowing = true;
    drawChildWindows = true;
    parentClipping = true;
+   opaque = false;
+   backingStore = NULL;
+   displayList = NULL;
 
    parentWindow = NULL;
 
@@ -162,6 +174,9 @@ Window::Window(UINT winID, bool control, int xPos, int yPos,
 /*Destructor*/
 Window::~Window()
 {
+   EnableBackingStore(false);
+   EnableDisplayList(false);
+
    //Destroy the child windows
    windowList.DeleteAll();
    controlList.DeleteAll();
@@ -192,6 +207,11 @@ Description:
 
 void FC Window::SetPosition(const Point& position)
 {
+   //The area where the window was needs to be redrawn, but what the 
+   //window draws doesn't change when it moves
+   Area windowArea(0, 0, windowSize.x, windowSize.y);
+   InvalidateDrawnArea(windowArea);
+
    windowPosition = position;
 
    //Recalculate the absolute coordinates of this window
@@ -223,6 +243,8 @@ void FC Window::SetPosition(const Point& position)
       iterator++;
    }
 
+   InvalidateDrawnArea(windowArea);
+
    OnWindowMoved();
 }
 
@@ -237,6 +259,11 @@ Description:
 
 void FC Window::SetPosition(int xPos, int yPos)
 {
+   //The area where the window was needs to be redrawn, but what the 
+   //window draws doesn't change when it moves
+   Area windowArea(0, 0, windowSize.x, windowSize.y);
+   InvalidateDrawnArea(windowArea);
+
    windowPosition.SetPoint(xPos, yPos);
 
    CalculateAbsCoords();
@@ -267,6 +294,8 @@ void FC Window::SetPosition(int xPos, int yPos)
       iterator++;
    }
 
+   InvalidateDrawnArea(windowArea);
+
    OnWindowMoved();
 }  
 
@@ -283,7 +312,9 @@ Description:
 void FC Window::SetSize(const Point& size)
 {
    assert(size.y >= 0 && size.y >= 0);
+   Invalidate();
    windowSize = size;
+   Invalidate();
    OnWindowSized();
 }
 
@@ -300,7 +331,9 @@ Description:
 void FC Window::SetSize(int width, int height)
 {
    assert(width >= 0 && height >= 0);
+   Invalidate();
    windowSize.SetPoint(width, height);
+   Invalidate();
    OnWindowSized();
 }
 
@@ -375,6 +408,7 @@ Description:
 void FC Window::HideWindow()
 {
    windowShowing = false;
+   Invalidate();
 
    if(parentWindow != NULL)
    {
@@ -394,6 +428,7 @@ Description:
 void FC Window::ShowWindow()
 {
    windowShowing = true;
+   Invalidate();
 
    if(parentWindow != NULL)
    {
@@ -413,8 +448,184 @@ Description:
 
 void FC Window::DrawWindow()
 {
-   Area windowArea(absWindowPosition, windowSize);
-   Area clippedArea = windowArea;
+   Point screenRes = dgGraphics->GetResolution();
+   Area screenArea(0, 0, screenRes.x, screenRes.y);
+
+   DrawWindow(screenArea);
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawWindow
+Parameters:
+   Area& updateArea : the area of the screen to be redrawn, in absolute
+      coordinates
+Description:
+   This function tells the window and its child windows to draw the part
+   of themselves that is within the update area. Windows which are 
+   entirely outside the update area aren't drawn at all.
+------------------------------------------------------------------------*/
+
+void FC Window::DrawWindow(Area& updateArea)
+{
+   Area clippedArea;
+
+   //If the window is entirely outside of its parent, neither it nor its
+   //child windows are drawn
+   if(!GetDrawnArea(clippedArea))
+      return;
+
+   //Only the part of the window within the update area is drawn
+   clippedArea.Intersect(updateArea);
+
+   if(!clippedArea.IsEmpty())
+   {
+      //Get the drawing surface for this window
+      //The window position is in relative coords, so we need to get the
+      //absolute coords of its upper-left corner
+      Surface* surface = dgGraphics->GetSurface(clippedArea);
+
+      //If the surface is NULL, someone else has not released their surface
+      assert(surface != NULL);
+
+      //Don't draw where opaque windows will be drawn on top of this one
+      ExcludeWindowsOnTop(surface, clippedArea);
+
+      //Calculate the window origin in surface coordinates
+      Point windowOrigin(absWindowPosition.x - clippedArea.left, 
+         absWindowPosition.y - clippedArea.top);
+  
+      WindowSurface* windowSurface = new WindowSurface(surface, windowOrigin);
+
+      //Send the surface to be drawn upon
+      if(backingStore != NULL)
+         DrawWithBackingStore(windowSurface);
+      else if(displayList != NULL)
+         DrawWithDisplayList(windowSurface);
+      else
+         OnDrawWindow(windowSurface);
+
+      delete windowSurface;
+
+      //Release the drawing surface
+      dgGraphics->ReleaseSurface(surface);
+   }
+
+   //If we aren't supposed to draw any child windows, then don't
+   if(drawChildWindows)
+   {
+      //Iterate through the child windows and draw them in the 
+      //correct z-order
+
+      //Draw the controls first, since they must be under the windows
+      ListIterator<Window> iterator = controlList.Begin();
+      while(!iterator.EndOfList())
+      {
+         iterator.GetData()->DrawWindow(updateArea);
+         iterator++;
+      }
+
+      iterator = windowList.Begin();
+      while(!iterator.EndOfList())
+      {
+         iterator.GetData()->DrawWindow(updateArea);
+         iterator++;
+      }
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawWithBackingStore
+Parameters:
+   WindowSurface* surface : the surface that the window draws on
+Description:
+   This function draws the backing store of the window if nothing has 
+   changed within the part of the window that is being drawn. Otherwise
+   the window draws itself and what it drew is copied into the store.
+------------------------------------------------------------------------*/
+
+void FC Window::DrawWithBackingStore(WindowSurface* surface)
+{
+   //The part of the screen that the window is drawn on
+   ClipRegion drawRegion(dgGraphics->GetClippingRegion());
+   Point screenRes = dgGraphics->GetResolution();
+   RECT screenRect = {0, 0, screenRes.x, screenRes.y};
+   drawRegion.Intersect(screenRect);
+
+   if(drawRegion.IsEmpty())
+      return;
+
+   //A store that was created before the window was resized doesn't fit
+   if(backingStore->IsCreated() && 
+      (backingStore->GetWidth() != windowSize.x || 
+      backingStore->GetHeight() != windowSize.y))
+      GetGui()->ReleaseBackingStore(this);
+
+   if(backingStore->Covers(drawRegion, absWindowPosition) &&
+      dgGraphics->DrawBackingStore(absWindowPosition, backingStore))
+   {
+      backingStore->SetLastUsedFrame(GetGui()->GetFrameNumber());
+      return;
+   }
+
+   if(displayList != NULL)
+      DrawWithDisplayList(surface);
+   else
+      OnDrawWindow(surface);
+
+   //If there's no memory for the store, the window will simply draw 
+   //itself again next time
+   if(!backingStore->IsCreated() && !GetGui()->CreateBackingStore(this))
+      return;
+
+   dgGraphics->CopyToBackingStore(drawRegion, absWindowPosition, 
+      backingStore);
+   backingStore->SetLastUsedFrame(GetGui()->GetFrameNumber());
+}
+
+/*------------------------------------------------------------------------
+Function Name: DrawWithDisplayList
+Parameters:
+   WindowSurface* surface : the surface that the window draws on
+Description:
+   This function replays the display list of the window. If the window
+   has drawn something else since the list was recorded, OnDrawWindow 
+   is recorded into the list first. The list is relative to the window,
+   so a window that has only moved is drawn without OnDrawWindow.
+------------------------------------------------------------------------*/
+
+void FC Window::DrawWithDisplayList(WindowSurface* surface)
+{
+   if(!displayList->IsValid())
+   {
+      displayList->Clear();
+
+      surface->BeginRecording(displayList);
+      OnDrawWindow(surface);
+      surface->EndRecording();
+
+      displayList->Validate();
+   }
+
+   displayList->Replay(surface);
+}
+
+/*------------------------------------------------------------------------
+Function Name: GetDrawnArea
+Parameters:
+   Area& drawnArea : receives the area of the screen that the window is
+      drawn in, in absolute coordinates
+Returns:
+   false if the window is entirely outside of its parent and isn't drawn
+   at all, true otherwise
+Description:
+   This function calculates the area that the window is drawn in. If 
+   parent clipping is enabled, this is the part of the window that is 
+   within its parent.
+------------------------------------------------------------------------*/
+
+bool FC Window::GetDrawnArea(Area& drawnArea)
+{
+   drawnArea.SetArea(absWindowPosition, windowSize);
 
    //If parent clipping is enabled, we need to clip the window to the 
    //boundaries of its parent
@@ -426,15 +637,15 @@ void FC Window::DrawWindow()
 
       //Check to see if this window will even be drawn, if not, we
       //can exit this function
-      if((clippedArea.left > parentRect.right && 
-         clippedArea.Right() > parentRect.right) ||
-         (clippedArea.left < parentRect.left &&
-         clippedArea.Right() < parentRect.left) ||
-         (clippedArea.top > parentRect.bottom &&
-         clippedArea.Bottom() > parentRect.bottom) ||
-         (clippedArea.top < parentRect.top &&
-         clippedArea.Bottom() < parentRect.top))
-         return;
+      if((drawnArea.left > parentRect.right && 
+         drawnArea.Right() > parentRect.right) ||
+         (drawnArea.left < parentRect.left &&
+         drawnArea.Right() < parentRect.left) ||
+         (drawnArea.top > parentRect.bottom &&
+         drawnArea.Bottom() > parentRect.bottom) ||
+         (drawnArea.top < parentRect.top &&
+         drawnArea.Bottom() < parentRect.top))
+         return false;
 
       //Clip the left and top of this window
 
@@ -442,71 +653,226 @@ void FC Window::DrawWindow()
       //width or height, since part of the window is now hidden
       int numOfClippedPixels;
 
-      if(clippedArea.left < parentRect.left)
+      if(drawnArea.left < parentRect.left)
       {
-         numOfClippedPixels = parentRect.left - clippedArea.left;
-         clippedArea.left = parentRect.left;
-         clippedArea.width -= numOfClippedPixels;
+         numOfClippedPixels = parentRect.left - drawnArea.left;
+         drawnArea.left = parentRect.left;
+         drawnArea.width -= numOfClippedPixels;
       }
 
-      if(clippedArea.top < parentRect.top)
+      if(drawnArea.top < parentRect.top)
       {
-         numOfClippedPixels = parentRect.top - clippedArea.top;
-         clippedArea.top = parentRect.top;
-         clippedArea.height -= numOfClippedPixels;
+         numOfClippedPixels = parentRect.top - drawnArea.top;
+         drawnArea.top = parentRect.top;
+         drawnArea.height -= numOfClippedPixels;
       }
 
       //Clip the bottom and right of this window
 
-      if(clippedArea.Right() > parentRect.right)
-         clippedArea.width = (parentRect.right - clippedArea.left) + 1;
-      if(clippedArea.Bottom() > parentRect.bottom)
-         clippedArea.height = (parentRect.bottom - clippedArea.top) + 1;
+      if(drawnArea.Right() > parentRect.right)
+         drawnArea.width = (parentRect.right - drawnArea.left) + 1;
+      if(drawnArea.Bottom() > parentRect.bottom)
+         drawnArea.height = (parentRect.bottom - drawnArea.top) + 1;
    }
 
-   //Get the drawing surface for this window
-   //The window position is in relative coords, so we need to get the
-   //absolute coords of its upper-left corner
-   Surface* surface = dgGraphics->GetSurface(clippedArea);
+   return true;
+}
+
+/*------------------------------------------------------------------------
+Function Name: ExcludeWindowsOnTop
+Parameters:
+   Surface* surface : the surface that the window is drawn on
+   Area& area : the area of the screen that the window is drawn in
+Description:
+   This function removes the areas of the opaque windows that will be 
+   drawn on top of this window from the surface, so that the window
+   isn't drawn where it will be covered anyway. The windows on top are
+   the ones after this window in the z-order of its parent and the ones
+   after each of its ancestors in their parents.
+------------------------------------------------------------------------*/
+
+void FC Window::ExcludeWindowsOnTop(Surface* surface, Area& area)
+{
+   Window* window = this;
+   Window* parent = parentWindow;
+   Area coveredArea;
 
-   //If the surface is NULL, someone else has not released their surface
-   assert(surface != NULL);
+   while(parent != NULL)
+   {
+      //The controls are drawn before the windows
+      LinkedList<Window>* childLists[2] = 
+         {&parent->controlList, &parent->windowList};
+      bool onTop = false;
 
-   //Calculate the window origin in surface coordinates
-   Point windowOrigin(absWindowPosition.x - clippedArea.left, 
-      absWindowPosition.y - clippedArea.top);
-  
-   WindowSurface* windowSurface = new WindowSurface(surface, windowOrigin);
+      for(int i = 0; i < 2; i++)
+      {
+         ListIterator<Window> iterator = childLists[i]->Begin();
+         while(!iterator.EndOfList())
+         {
+            Window* sibling = iterator.GetData();
+
+            if(sibling == window)
+               onTop = true;
+            else if(onTop && sibling->IsWindowShowing() && 
+               sibling->IsOpaque() && sibling->GetDrawnArea(coveredArea))
+            {
+               coveredArea.Intersect(area);
 
-   //Send the surface to be drawn upon
-   OnDrawWindow(windowSurface);
+               if(!coveredArea.IsEmpty())
+                  surface->ExcludeScreenArea(coveredArea);
+            }
 
-   delete windowSurface;
+            iterator++;
+         }
+      }
 
-   //Release the drawing surface
-   dgGraphics->ReleaseSurface(surface);
+      window = parent;
+      parent = parent->parentWindow;
+   }
+}
 
-   //If we aren't supposed to draw any child windows, then don't
-   if(drawChildWindows)
+/*------------------------------------------------------------------------
+Function Name: Invalidate
+Parameters:
+Description:
+   This function marks the entire window as needing to be redrawn. The
+   window will be redrawn in the next frame.
+------------------------------------------------------------------------*/
+
+void FC Window::Invalidate()
+{
+   Area windowArea(0, 0, windowSize.x, windowSize.y);
+   Invalidate(windowArea);
+}
+
+/*------------------------------------------------------------------------
+Function Name: Invalidate
+Parameters:
+   Area& area : the area of the window that needs to be redrawn, in
+      coordinates relative to the upper-left corner of the window
+Description:
+   This function marks an area of the window as needing to be redrawn.
+   Any window that overlaps the area will be redrawn in the next frame.
+   Windows that haven't been created yet don't cause anything to be 
+   redrawn, since they aren't on the screen.
+------------------------------------------------------------------------*/
+
+void FC Window::Invalidate(Area& area)
+{
+   //The window will draw something else, so its display list has to be
+   //recorded again, and what it drew in the area is out of date
+   if(displayList != NULL)
+      displayList->Invalidate();
+
+   if(backingStore != NULL)
    {
-      //Iterate through the child windows and draw them in the 
-      //correct z-order
+      RECT storeRect = {area.left, area.top, area.Right() + 1, 
+         area.Bottom() + 1};
+      backingStore->Invalidate(storeRect);
+   }
 
-      //Draw the controls first, since they must be under the windows
-      ListIterator<Window> iterator = controlList.Begin();
-      while(!iterator.EndOfList())
-      {
-         iterator.GetData()->DrawWindow();
-         iterator++;
-      }
+   InvalidateDrawnArea(area);
+}
 
-      iterator = windowList.Begin();
-      while(!iterator.EndOfList())
-      {
-         iterator.GetData()->DrawWindow();
-         iterator++;
-      }
+/*------------------------------------------------------------------------
+Function Name: InvalidateDrawnArea
+Parameters:
+   Area& area : the area of the window that needs to be redrawn, in
+      coordinates relative to the upper-left corner of the window
+Description:
+   This function marks an area of the window as needing to be redrawn
+   on the screen without marking its display list or its backing store
+   as out of date. It is used when the window moves, which doesn't 
+   change what it draws, so the store is drawn at the new position.
+------------------------------------------------------------------------*/
+
+void FC Window::InvalidateDrawnArea(Area& area)
+{
+   if(!isCreated)
+      return;
+
+   Area absArea(area.left + absWindowPosition.x, 
+      area.top + absWindowPosition.y, area.width, area.height);
+
+   GetGui()->InvalidateArea(absArea);
+}
+
+/*------------------------------------------------------------------------
+Function Name: EnableBackingStore
+Parameters:
+   bool enable : true to give the window a backing store, false to take
+      it away
+Description:
+   This function turns the backing store of the window on or off. The 
+   store uses memory that the GUI sets aside for backing stores, so it 
+   is best used for windows that seldom change. The store is created 
+   the first time the window is drawn.
+------------------------------------------------------------------------*/
+
+void FC Window::EnableBackingStore(bool enable)
+{
+   if(enable)
+   {
+      if(backingStore == NULL)
+         backingStore = new BackingStore;
+   }
+
+   else if(backingStore != NULL)
+   {
+      GetGui()->ReleaseBackingStore(this);
+      delete backingStore;
+      backingStore = NULL;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: EnableDisplayList
+Parameters:
+   bool enable : true to give the window a display list, false to take
+      it away
+Description:
+   This function turns the display list of the window on or off. With a
+   display list, the window records what OnDrawWindow draws and replays
+   it until the window is invalidated. The window must call Invalidate()
+   whenever what it draws changes, and OnDrawWindow must only draw 
+   through the window surface it is given.
+------------------------------------------------------------------------*/
+
+void FC Window::EnableDisplayList(bool enable)
+{
+   if(enable)
+   {
+      if(displayList == NULL)
+         displayList = new DisplayList;
    }
+
+   else if(displayList != NULL)
+   {
+      delete displayList;
+      displayList = NULL;
+   }
+}
+
+/*------------------------------------------------------------------------
+Function Name: InvalidateBackingStore
+Parameters:
+   Area& area : the area that is out of date, in absolute coordinates
+Description:
+   This function marks part of the backing store as out of date without
+   redrawing anything. The GUI calls it for windows that aren't opaque 
+   when something under them is redrawn.
+------------------------------------------------------------------------*/
+
+void FC Window::InvalidateBackingStore(Area& area)
+{
+   if(backingStore == NULL)
+      return;
+
+   RECT storeRect = {area.left - absWindowPosition.x, 
+      area.top - absWindowPosition.y, 
+      (area.Right() + 1) - absWindowPosition.x, 
+      (area.Bottom() + 1) - absWindowPosition.y};
+   backingStore->Invalidate(storeRect);
 }
 
 //Child Window Functions
@@ -540,6 +906,7 @@ void FC Window::AddChildWindow(Window* childWindow)
    childWindow->SetParent(this);
 
    childWindow->Create();
+   childWindow->Invalidate();
 
    //Send the newly created window a size message, so that it can 
    //resize as necessary
@@ -628,6 +995,7 @@ bool FC Window::DestroyWindow(UINT winID)
       window = windowList.RemoveById(winID);
       if(window != NULL)
       {
+         window->Invalidate();
          Destroy();
          delete window;
          found = true;
@@ -638,6 +1006,7 @@ bool FC Window::DestroyWindow(UINT winID)
          window = controlList.RemoveById(winID);
          if(window != NULL)
          {
+            window->Invalidate();
             Destroy();
             delete window;
             found = true;
@@ -648,6 +1017,7 @@ bool FC Window::DestroyWindow(UINT winID)
             window = hiddenWindowList.RemoveById(winID);
             if(window != NULL)
             {
+               window->Invalidate();
                Destroy();
                delete window;
                found = true;
@@ -687,6 +1057,10 @@ void FC Window::SetTopMostChildWindow(UINT winID)
       if(window != NULL)
          controlList.Append(window, window->GetWindowID());
    }
+
+   //The window may now cover other windows
+   if(window != NULL)
+      window->Invalidate();
 }
 
 //Message Functions
@@ -1029,6 +1403,9 @@ void FC Window::HandleMessage(Message* msg)
       case GM_TIMER:
          OnTimer(msg->data3);
          break;
+      case GM_BITMAPLOADED:
+         OnBitmapLoaded(msg->data3);
+         break;
       default:
          //If the message was not a basic framework message, then look
          //for it in the message table
@@ -1652,6 +2029,21 @@ void FC Window::OnTimer(UINT timerID)
    //Do nothing
 }
 
+/*------------------------------------------------------------------------
+Function Name: OnBitmapLoaded
+Description:
+   This function is called when a GM_BITMAPLOADED message is received, 
+   meaning that a bitmap this window loaded with 
+   DG::Graphics::LoadBitmapAsync() is ready to be drawn.
+Parameters:
+   UINT bitmapID: the ID of the bitmap that has been loaded
+------------------------------------------------------------------------*/
+
+void FC Window::OnBitmapLoaded(UINT bitmapID)
+{
+   //Do nothing
+}
+
 /*------------------------------------------------------------------------
 Function Name: OnDrawWindow
 Parameters:
@@ -46,6 +46,28 @@ namespace DG
       virtual void FC ShowWindow(void);
 
       virtual void FC DrawWindow(void);
+      virtual void FC DrawWindow(Area& updateArea);
+
+      //An opaque window draws over every pixel in its area, so nothing 
+      //under it needs to be drawn
+      virtual bool FC IsOpaque(void) {return opaque;}
+      void FC SetOpaque(bool isOpaque) {opaque = isOpaque;}
+
+      void FC Invalidate(void);
+      void FC Invalidate(Area& area);
+
+      //A window with a backing store keeps a copy of what it drew and
+      //draws that copy until it is invalidated
+      void FC EnableBackingStore(bool enable);
+      bool IsBackingStoreEnabled(void) {return backingStore != NULL;}
+      BackingStore* GetBackingStore(void) {return backingStore;}
+      void FC InvalidateBackingStore(Area& area);
+
+      //A window with a display list records what it draws and replays
+      //it until it is invalidated
+      void FC EnableDisplayList(bool enable);
+      bool IsDisplayListEnabled(void) {return displayList != NULL;}
+      DisplayList* GetDisplayList(void) {return displayList;}
 
       bool IsWindowShowing(void) {return windowShowing;}
       bool IsControl(void) {return isControl;}
@@ -129,6 +151,7 @@ namespace DG
       virtual void FC OnHideChildWindow(UINT winID);
       virtual void FC OnParentReposition(void);
       virtual void FC OnTimer(UINT timerID);
+      virtual void FC OnBitmapLoaded(UINT bitmapID);
       virtual void FC OnDrawWindow(WindowSurface* surface);
 
       /*Handlers for control messages*/
@@ -136,6 +159,11 @@ namespace DG
 
    private:
       void CalculateAbsCoords(void);
+      bool FC GetDrawnArea(Area& drawnArea);
+      void FC ExcludeWindowsOnTop(Surface* surface, Area& area);
+      void FC DrawWithBackingStore(WindowSurface* surface);
+      void FC DrawWithDisplayList(WindowSurface* surface);
+      void FC InvalidateDrawnArea(Area& area);
 
       Point windowPosition;
       Point windowSize;
@@ -162,5 +190,14 @@ namespace DG
       bool isDestroyed;
       bool drawChildWindows;
       bool parentClipping;
+      bool opaque;
+
+      //The copy of what the window drew, which is NULL if backing 
+      //stores aren't enabled for this window
+      BackingStore* backingStore;
+
+      //The recorded drawing of the window, which is NULL if display 
+      //lists aren't enabled for this window
+      DisplayList* displayList;
    };
 }
\ No newline at end of file
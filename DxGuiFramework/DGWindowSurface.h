@@ -35,6 +35,7 @@ namespace DG
       {
          screenSurface = surface;
          windowOrigin = winOrigin;
+         displayList = NULL;
       }
 
       Point GetWindowOrigin(void) {return windowOrigin;}
@@ -43,30 +44,73 @@ namespace DG
       Surface* GetScreenSurface(void) {return screenSurface;}
       void SetScreenSurface(Surface* surface) {screenSurface = surface;}
 
+      //While the surface is recording, the drawing functions add 
+      //commands to a display list instead of drawing
+      void BeginRecording(DisplayList* list) {displayList = list;}
+      void EndRecording(void) {displayList = NULL;}
+      bool IsRecording(void) {return displayList != NULL;}
+
       //Drawing Functions
-      void FC LockSurface(void) {screenSurface->LockSurface();}
-      void FC UnlockSurface(void) {screenSurface->UnlockSurface();}
+      void FC LockSurface(void)
+      {
+         if(displayList != NULL)
+            displayList->Add(DL_LOCK);
+         else
+            screenSurface->LockSurface();
+      }
+
+      void FC UnlockSurface(void)
+      {
+         if(displayList != NULL)
+            displayList->Add(DL_UNLOCK);
+         else
+            screenSurface->UnlockSurface();
+      }
 
       //Non-Blit Drawing Functions
       void FC SetPixel(int x, int y, Color& color)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_PIXEL, x, y, 0, 0, color);
+            return;
+         }
+
          screenSurface->SetPixel(x + windowOrigin.x, y + windowOrigin.y, color);
       }
 
       void FC DrawHorizontalLine(int x1, int x2, int y, Color& color)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_HORIZONTALLINE, x1, y, x2, y, color);
+            return;
+         }
+
          screenSurface->DrawHorizontalLine(x1 + windowOrigin.x, x2 + windowOrigin.x,
          y + windowOrigin.y, color);
       }
 
       void FC DrawVerticalLine(int x, int y1, int y2, Color& color)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_VERTICALLINE, x, y1, x, y2, color);
+            return;
+         }
+
          screenSurface->DrawVerticalLine(x + windowOrigin.x, y1 + windowOrigin.y,
          y2 + windowOrigin.y, color);
       }
 
       void FC DrawLine(Point p1, Point p2, Color& color)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_LINE, p1.x, p1.y, p2.x, p2.y, color);
+            return;
+         }
+
          p1.Offset(windowOrigin.x, windowOrigin.y);
          p2.Offset(windowOrigin.x, windowOrigin.y);
          screenSurface->DrawLine(p1, p2, color);
@@ -74,12 +118,26 @@ namespace DG
 
       void FC DrawRectangle(Rectangle rect, Color& color)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_RECTANGLE, rect.left, rect.top, 
+               rect.right, rect.bottom, color);
+            return;
+         }
+
          rect.Offset(windowOrigin.x, windowOrigin.y);
          screenSurface->DrawRectangle(rect, color);
       }
 
       void FC DrawFilledRectangle(Rectangle rect, Color& color)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_FILLEDRECTANGLE, rect.left, rect.top, 
+               rect.right, rect.bottom, color);
+            return;
+         }
+
          rect.Offset(windowOrigin.x, windowOrigin.y);
          screenSurface->DrawRectangle(rect, color);
       }
@@ -87,23 +145,50 @@ namespace DG
       //Blit Drawing Functions
       void FC FillArea(Area area, Color& color)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_FILLAREA, area.left, area.top, 
+               area.width, area.height, color);
+            return;
+         }
+
          area.Offset(windowOrigin.x, windowOrigin.y);
          screenSurface->FillArea(area, color);
       } 
       
       void FC FillSurface(Color& color) 
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_FILLSURFACE, 0, 0, 0, 0, color);
+            return;
+         }
+
          screenSurface->FillSurface(color);
       }
 
       void FC DrawBitmap(Point location, UINT bitmapID)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_BITMAP, location.x, location.y, 0, 0, 
+               bitmapID);
+            return;
+         }
+
          location.Offset(windowOrigin.x, windowOrigin.y);
          screenSurface->DrawBitmap(location, bitmapID);
       }
 
       void FC DrawScaledBitmap(Area area, UINT bitmapID)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_SCALEDBITMAP, area.left, area.top, 
+               area.width, area.height, bitmapID);
+            return;
+         }
+
          area.Offset(windowOrigin.x, windowOrigin.y);
          screenSurface->DrawScaledBitmap(area, bitmapID);
       }
@@ -111,6 +196,13 @@ namespace DG
       void FC DrawTransparentBitmap(Point location, UINT bitmapID,
          Color& transparentColor)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_TRANSPARENTBITMAP, location.x, location.y,
+               0, 0, bitmapID, transparentColor);
+            return;
+         }
+
          location.Offset(windowOrigin.x, windowOrigin.y);
          screenSurface->DrawTransparentBitmap(location, bitmapID, 
             transparentColor);
@@ -119,6 +211,14 @@ namespace DG
       void FC DrawTransparentScaledBitmap(Area area, UINT bitmapID,
          Color& transparentColor)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_TRANSPARENTSCALEDBITMAP, area.left, 
+               area.top, area.width, area.height, bitmapID, 
+               transparentColor);
+            return;
+         }
+
          area.Offset(windowOrigin.x, windowOrigin.y);
          screenSurface->DrawTransparentScaledBitmap(area, bitmapID,
             transparentColor);
@@ -126,31 +226,98 @@ namespace DG
 
       void FC DrawTransparentBitmap(Point location, UINT bitmapID)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_KEYEDBITMAP, location.x, location.y, 0, 0,
+               bitmapID);
+            return;
+         }
+
          location.Offset(windowOrigin.x, windowOrigin.y);
          screenSurface->DrawTransparentBitmap(location, bitmapID);
       }
 
       void FC DrawTransparentScaledBitmap(Area area, UINT bitmapID)
       {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_KEYEDSCALEDBITMAP, area.left, area.top, 
+               area.width, area.height, bitmapID);
+            return;
+         }
+
          area.Offset(windowOrigin.x, windowOrigin.y);
          screenSurface->DrawTransparentScaledBitmap(area, bitmapID);
       }
 
+      void FC DrawAlphaBitmap(Point location, UINT bitmapID)
+      {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_ALPHABITMAP, location.x, location.y, 0, 0,
+               bitmapID);
+            return;
+         }
+
+         location.Offset(windowOrigin.x, windowOrigin.y);
+         screenSurface->DrawAlphaBitmap(location, bitmapID);
+      }
+
+      void FC DrawAlphaBitmap(Point location, UINT bitmapID, BYTE opacity)
+      {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_FADEDALPHABITMAP, location.x, location.y, 
+               0, 0, bitmapID, opacity);
+            return;
+         }
+
+         location.Offset(windowOrigin.x, windowOrigin.y);
+         screenSurface->DrawAlphaBitmap(location, bitmapID, opacity);
+      }
+
       //GDI Drawing Functions
       void FC SetGDIFont(Font& font)
-      {screenSurface->SetGDIFont(font);}
+      {
+         if(displayList != NULL)
+            displayList->AddFont(font);
+         else
+            screenSurface->SetGDIFont(font);
+      }
 
       void FC SetTextTransparency(int mode)
-      {screenSurface->SetTextTransparency(mode);}
+      {
+         if(displayList != NULL)
+            displayList->Add(DL_TEXTTRANSPARENCY, 0, 0, 0, 0, UINT(mode));
+         else
+            screenSurface->SetTextTransparency(mode);
+      }
 
       void FC SetTextColor(Color& color)
-      {screenSurface->SetTextColor(color);}
+      {
+         if(displayList != NULL)
+            displayList->Add(DL_TEXTCOLOR, 0, 0, 0, 0, color);
+         else
+            screenSurface->SetTextColor(color);
+      }
 
       void FC SetTextBackgroundColor(Color& color)
-      {screenSurface->SetTextBackgroundColor(color);}
+      {
+         if(displayList != NULL)
+            displayList->Add(DL_TEXTBACKGROUNDCOLOR, 0, 0, 0, 0, color);
+         else
+            screenSurface->SetTextBackgroundColor(color);
+      }
 
       void FC DrawText(char* text, Rectangle& rect, UINT flags)
       {
+         //Measuring text doesn't draw anything, so it is done right away
+         if(displayList != NULL && !(flags & DT_CALCRECT))
+         {
+            displayList->AddText(text, rect, flags);
+            return;
+         }
+
          rect.Offset(windowOrigin.x, windowOrigin.y);
          screenSurface->DrawText(text, rect, flags);
 
@@ -160,9 +327,69 @@ namespace DG
             rect.Offset(-windowOrigin.x, -windowOrigin.y);
       }
 
+      //Clipping Functions
+      void FC AddClippingArea(Rectangle rect)
+      {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_ADDCLIPPING, rect.left, rect.top, 
+               rect.right, rect.bottom, 0);
+            return;
+         }
+
+         rect.Offset(windowOrigin.x, windowOrigin.y);
+         screenSurface->AddClippingArea(rect);
+      }
+
+      void FC IntersectClippingArea(Rectangle rect)
+      {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_INTERSECTCLIPPING, rect.left, rect.top, 
+               rect.right, rect.bottom, 0);
+            return;
+         }
+
+         rect.Offset(windowOrigin.x, windowOrigin.y);
+         screenSurface->IntersectClippingArea(rect);
+      }
+
+      void FC SubtractClippingArea(Rectangle rect)
+      {
+         if(displayList != NULL)
+         {
+            displayList->Add(DL_SUBTRACTCLIPPING, rect.left, rect.top, 
+               rect.right, rect.bottom, 0);
+            return;
+         }
+
+         rect.Offset(windowOrigin.x, windowOrigin.y);
+         screenSurface->SubtractClippingArea(rect);
+      }
+
+      void FC RemoveClippingArea(void) 
+      {
+         if(displayList != NULL)
+            displayList->Add(DL_REMOVECLIPPING);
+         else
+            screenSurface->RemoveClippingArea();
+      }
+
+      void FC ClearClippingAreas(void) 
+      {
+         if(displayList != NULL)
+            displayList->Add(DL_CLEARCLIPPING);
+         else
+            screenSurface->ClearClippingAreas();
+      }
+
    protected:
       Surface* screenSurface;
       
       Point windowOrigin;
+
+      //The list that the drawing is recorded in, or NULL if the surface
+      //draws right away
+      DisplayList* displayList;
    };
 }
\ No newline at end of file
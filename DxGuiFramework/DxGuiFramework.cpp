@@ -69,7 +69,7 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 
       //Allocate the global DG::Graphics and DG::Input objects
       //This must be done *after* the window is created
-      DG::dgGraphics = new DG::Graphics();
+      DG::dgGraphics = new DG::Graphics(application->renderBackend);
       DG::dgInput = new DG::Input();
 
       //Now that the DG::Graphics object has been created, set the 
@@ -96,7 +96,10 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
    }
 
    if(DG::dgGraphics != NULL)
+   {
       delete DG::dgGraphics;
+      DG::dgGraphics = NULL;
+   }
    if(DG::dgInput != NULL)
       delete DG::dgInput;
 
@@ -29,11 +29,24 @@ Version:
 #include "DGDynamicArray.h"
 #include "DGColor.h"
 #include "DGDisplayModeList.h"
+#include "DGSpanKernels.h"
+#include "DGClipRegion.h"
+#include "DGPixelBuffer.h"
+#include "DGRunLengthSprite.h"
+#include "DGBackingStore.h"
+#include "DGBitmapFile.h"
+#include "DGAssetPack.h"
+#include "DGBitmapAtlas.h"
 #include "DGBitmap.h"
 #include "DGBitmapList.h"
+#include "DGBitmapLoader.h"
 #include "DGFont.h"
+#include "DGTextLayout.h"
+#include "DGGlyphAtlas.h"
+#include "DGTileRasterizer.h"
 #include "DGGraphics.h"
 #include "DGSurface.h"
+#include "DGDisplayList.h"
 #include "DGWindowSurface.h"
 #include "DGInput.h"
 #include "DGMessage.h"
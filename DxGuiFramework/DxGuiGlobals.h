@@ -45,6 +45,7 @@ Version:
 #define  GM_CHARACTER               30
 #define  GM_PARENTREPOSITION        31
 #define  GM_TIMER                   40
+#define  GM_BITMAPLOADED            41
 
 //DGLabel messages
 #define  GM_LABEL_LBUTTONDOWN       100
@@ -108,6 +109,7 @@ Version:
 //Timer IDs (0-99 are reserved for the framework)
 #define  SB_UP_TIMER          0
 #define  SB_DOWN_TIMER        1
+#define  ED_BLINK_TIMER       2
          
 //Data Type Definitions
 namespace DG
@@ -129,6 +131,14 @@ namespace DG
 #define  WS_WINDOWED          1
 #define  WS_FULLSCREEN        2
 
+//Render Backend Definitions
+#define  RB_DIRECTDRAW        1
+#define  RB_SOFTWARE          2
+
+//Scale Filter Definitions
+#define  SF_NEAREST           1
+#define  SF_BILINEAR          2
+
 //Color Depth Definitions
 #define  CD_8BIT              1
 #define  CD_16BIT             2
@@ -161,9 +171,13 @@ namespace DG
 #define  EC_DDCOLORKEY        11
 #define  EC_DDTEXT            12
 #define  EC_DDCLIPPING        13
+#define  EC_DDBACKINGSTORE    14
 
 #define  EC_BMBITMAPSIZE      1
 #define  EC_BMBITMAPLOAD      2
+#define  EC_BMASSETPACK       3
+#define  EC_BMTILED           4
+#define  EC_BMALPHA           5
 
 #define  EC_CREATEFONT        1
 
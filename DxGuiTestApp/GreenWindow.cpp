@@ -35,8 +35,10 @@ void FC GreenWindow::OnCreate()
    imageCtrl = new Image(IDI_IMAGE, this, Area(40, 10, 220, 200),
       IDB_IMAGEBITMAP);
 
-   //imageCtrl->LoadBitmapFile("Bitmaps/Stones Large.bmp");
-   imageCtrl->LoadBitmapFile("Bitmaps/persview.bmp");
+   //The stones are much larger than the image control, so only the 
+   //tiles that are scrolled into view are loaded
+   imageCtrl->LoadTiledBitmapFile("Bitmaps/Stones Large.bmp");
+   //imageCtrl->LoadBitmapFile("Bitmaps/persview.bmp");
    //imageCtrl->LoadBitmapFile("Bitmaps/stars.bmp");
 
    //imageCtrl->SetTransparency(true);
@@ -64,6 +66,7 @@ void FC GreenWindow::OnCreate()
 
    horizontalBar->SetLineValue(SCROLLBAR_LINE_VAL);
    verticalBar->SetLineValue(SCROLLBAR_LINE_VAL);
+   SetScrollRanges();
 
    AddChildWindow(imageCtrl);
    AddChildWindow(inputCtrl);
@@ -147,6 +150,36 @@ void FC GreenWindow::OnWindowSized()
 
    verticalBar->SetDimensions(Area(IMAGE_OFFSET_X + imageCtrlWidth, 
       IMAGE_OFFSET_Y + TITLEBAR_HEIGHT, SCROLLBAR_WIDTH, imageCtrl->GetSize().y));
+
+   //The image control has a new size, so less or more of the bitmap is 
+   //left to scroll through
+   SetScrollRanges();
+}
+
+//Lets the scroll bars scroll through the part of the bitmap that doesn't
+//fit in the image control, and moves the bitmap to where they are
+void GreenWindow::SetScrollRanges()
+{
+   Point bitmapSize = imageCtrl->GetBitmapSize();
+   Point imageCtrlSize = imageCtrl->GetSize();
+
+   horizontalBar->SetMinValue(0);
+   verticalBar->SetMinValue(0);
+
+   //If the bitmap is smaller than the image control, set the max value
+   //of the scroll bar to 0
+   if(bitmapSize.x < imageCtrlSize.x)
+      horizontalBar->SetMaxValue(0);
+   else
+      horizontalBar->SetMaxValue(bitmapSize.x - imageCtrlSize.x);
+
+   if(bitmapSize.y < imageCtrlSize.y)
+      verticalBar->SetMaxValue(0);
+   else
+      verticalBar->SetMaxValue(bitmapSize.y - imageCtrlSize.y);
+
+   imageCtrl->SetBitmapOrigin(Point(-horizontalBar->GetPosition(), 
+      -verticalBar->GetPosition()));
 }
 
 void GreenWindow::OnLoadBitmap(Message* msg)
@@ -166,28 +199,14 @@ void GreenWindow::OnLoadBitmap(Message* msg)
 
       else
       {
-         imageCtrl->LoadBitmapFile(fileName);
+         //The image shows a placeholder until the bitmap is decoded, but
+         //its size is known right away
+         imageCtrl->LoadBitmapFileAsync(fileName);
          
          //Set the ranges on the scroll bars
-         Point bitmapSize = imageCtrl->GetBitmapSize();
-         Point imageCtrlSize = imageCtrl->GetSize();
-
-         horizontalBar->SetMinValue(0);
          horizontalBar->SetPosition(0);
-         verticalBar->SetMinValue(0);
          verticalBar->SetPosition(0);
-
-         //If the bitmap is smaller than the image control, set the max value
-         //of the scroll bar to 0
-         if(bitmapSize.x < imageCtrlSize.x)
-            horizontalBar->SetMaxValue(0);
-         else
-            horizontalBar->SetMaxValue(imageCtrlSize.x - bitmapSize.x);
-
-         if(bitmapSize.y < imageCtrlSize.y)
-            verticalBar->SetMaxValue(0);
-         else
-            verticalBar->SetMaxValue(imageCtrlSize.y - bitmapSize.y);
+         SetScrollRanges();
       }
    }
 }
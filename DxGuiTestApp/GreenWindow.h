@@ -19,6 +19,8 @@ protected:
    void OnSBLineDown(DG::Message* msg);
 
 private:
+   void SetScrollRanges(void);
+
    DG::Point previousPosition;
 
    bool windowFocused;